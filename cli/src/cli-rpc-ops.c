@@ -7826,6 +7826,9 @@ cmd_heal_volume_statistics_out(dict_t *dict, int brick)
     char *start_time_str = NULL;
     char *end_time_str = NULL;
     char *crawl_type = NULL;
+    char *heal_order = NULL;
+    uint64_t queue_depth = 0;
+    uint64_t hot_count = 0;
     int progress = -1;
 
     snprintf(key, sizeof key, "%d-hostname", brick);
@@ -7887,6 +7890,25 @@ cmd_heal_volume_statistics_out(dict_t *dict, int brick)
         cli_out("No. of entries healed: %" PRIu64, healed_count);
         cli_out("No. of entries in split-brain: %" PRIu64, split_brain_count);
         cli_out("No. of heal failed entries: %" PRIu64, heal_failed_count);
+
+        /* Only reported by prioritized index crawls */
+        snprintf(key, sizeof key, "statistics_heal_order-%d-%" PRIu64, brick,
+                 i);
+        if (dict_get_str(dict, key, &heal_order))
+            continue;
+        snprintf(key, sizeof key, "statistics_queue_depth-%d-%" PRIu64, brick,
+                 i);
+        ret = dict_get_uint64(dict, key, &queue_depth);
+        if (ret)
+            goto out;
+        snprintf(key, sizeof key, "statistics_hot_cnt-%d-%" PRIu64, brick, i);
+        ret = dict_get_uint64(dict, key, &hot_count);
+        if (ret)
+            goto out;
+
+        cli_out("Heal order: %s", heal_order);
+        cli_out("No. of entries queued: %" PRIu64, queue_depth);
+        cli_out("No. of entries in use by clients: %" PRIu64, hot_count);
     }
 
 out:
@@ -14,6 +14,9 @@
 #include <stdint.h>
 #include <string.h>
 
+#define XXH_INLINE_ALL
+#include "xxhash.h"
+
 /*
  * The "weak" checksum required for the rsync algorithm.
  *
@@ -42,3 +45,13 @@ gf_rsync_md5_checksum(unsigned char *data, size_t len, unsigned char *md5)
 {
     MD5(data, len, md5);
 }
+
+/*
+ * A non-cryptographic checksum, good enough to tell whether two copies of
+ * the same block differ and an order of magnitude cheaper than MD5.
+ */
+uint64_t
+gf_rsync_fast_checksum(unsigned char *data, size_t len)
+{
+    return XXH64(data, len, 0);
+}
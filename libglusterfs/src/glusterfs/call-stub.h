@@ -138,6 +138,9 @@ typedef struct _call_stub {
     glusterfs_fop_t fop;
     gf_boolean_t poison;
     char wind;
+    /* in usecs of the monotonic clock, set when io-threads queues the stub */
+    uint64_t queued;
+    uint64_t deadline;
     default_args_t args;
     default_args_cbk_t args_cbk;
 } call_stub_t;
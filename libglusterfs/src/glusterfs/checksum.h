@@ -19,4 +19,7 @@ gf_rsync_strong_checksum(unsigned char *buf, size_t len, unsigned char *sum);
 
 void
 gf_rsync_md5_checksum(unsigned char *data, size_t len, unsigned char *md5);
+
+uint64_t
+gf_rsync_fast_checksum(unsigned char *data, size_t len);
 #endif /* __CHECKSUM_H__ */
@@ -243,6 +243,30 @@ enum gf_internal_fop_indicator {
 #define GF_XATTROP_ENTRY_OUT_KEY "glusterfs.xattrop-entry-delete"
 #define GF_INDEX_IA_TYPE_GET_REQ "glusterfs.index-ia-type-get-req"
 #define GF_INDEX_IA_TYPE_GET_RSP "glusterfs.index-ia-type-get-rsp"
+/* Data regions written while some replica was bad. The xattrop xdata key
+ * holds the offset and length of the written region as two uint64_t in
+ * network byte order: a length of 0 means no data was written and
+ * GF_XATTROP_DIRTY_REGION_ALL that the whole file may have changed. The
+ * getxattr key returns the region size as a uint32_t in network byte order
+ * followed by a bitmap of the regions written since the file became bad. */
+#define GF_XATTROP_DIRTY_REGION "glusterfs.xattrop-dirty-region"
+#define GF_XATTROP_DIRTY_REGIONS "glusterfs.xattrop-dirty-regions"
+#define GF_XATTROP_DIRTY_REGION_ALL UINT64_MAX
+/* Lookup xdata key asking the index for heal ordering hints of a pending
+ * gfid. The reply carries, as uint64 seconds since the epoch, the time the
+ * gfid entered the xattrop index and the time of the last client xattrop
+ * seen on it while it was pending (0 when unknown). */
+#define GF_XATTROP_HEAL_HINT "glusterfs.xattrop-heal-hint"
+#define GF_XATTROP_PENDING_SINCE "glusterfs.xattrop-pending-since"
+#define GF_XATTROP_LAST_ACTIVITY "glusterfs.xattrop-last-activity"
+/* Changelog carried in the xdata of a data or metadata fop, or of the unlock
+ * ending its transaction, instead of in a separate xattrop. The value is the
+ * prefix of the xdata keys holding the changelog: the brick applies them as
+ * a GF_XATTROP_ADD_ARRAY before the fop and fails the fop if that fails. */
+#define GF_XATTROP_PIGGYBACK "glusterfs.xattrop-piggyback"
+/* Asked for in a lookup, and set in its reply by bricks which can apply a
+ * GF_XATTROP_PIGGYBACK changelog. */
+#define GF_XATTROP_PIGGYBACK_SUPPORTED "glusterfs.xattrop-piggyback-supported"
 
 #define GF_HEAL_INFO "glusterfs.heal-info"
 #define GF_AFR_HEAL_SBRAIN "glusterfs.heal-sbrain"
@@ -379,6 +403,11 @@ enum gf_internal_fop_indicator {
 #define GF_CS_OBJECT_STATUS "trusted.glusterfs.cs.status"
 #define GF_CS_OBJECT_REPAIR "trusted.glusterfs.cs.repair"
 
+/* rchecksum: fast checksums of each block of the range in a single reply */
+#define GF_RCHECKSUM_FAST_BLOCK_SIZE "rchecksum-fast-block-size"
+#define GF_RCHECKSUM_FAST_SUMS "rchecksum-fast-sums"
+#define GF_RCHECKSUM_FAST_ZEROES "rchecksum-fast-zeroes"
+
 #define gf_boolean_t bool
 #define _gf_false false
 #define _gf_true true
@@ -40,6 +40,10 @@
 
 #define UP_INVAL_ATTR 0x00002000 /* Request to invalidate iatt and xatt */
 
+/* Sent in the dict of the UP_TIMES invalidation of a directory, with the
+ * name of the entry that was just created in it */
+#define UP_ENTRY_CREATED "glusterfs.upcall.entry-created"
+
 /* for fops - open, read, lk, */
 #define UP_UPDATE_CLIENT (UP_ATIME)
 
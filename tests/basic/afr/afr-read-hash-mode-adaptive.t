@@ -0,0 +1,50 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup
+
+function reads_brick_count {
+        $CLI volume profile $V0 info incremental | grep -w READ | wc -l
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 3 arbiter 1 $H0:$B0/${V0}{0..2}
+
+TEST $CLI volume set $V0 cluster.choose-local off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 cluster.read-hash-mode 6
+TEST $CLI volume set $V0 cluster.read-probe-interval 1
+TEST ! $CLI volume set $V0 cluster.read-hash-mode 7
+TEST $CLI volume start $V0
+
+TEST glusterfs --entry-timeout=0 --attribute-timeout=0 -s $H0 --volfile-id $V0 $M0
+EXPECT "6" mount_get_option_value $M0 $V0-replicate-0 read-hash-mode
+TEST dd if=/dev/urandom of=$M0/FILE bs=1M count=8
+md5=$(md5sum $M0/FILE | awk '{print $1}')
+
+# Both data bricks get measured, so both end up serving reads.
+TEST $CLI volume profile $V0 start
+for i in {1..5}; do
+        TEST dd if=$M0/FILE of=/dev/null bs=1M
+        sleep 1
+done
+count=`reads_brick_count`
+TEST [ $count -eq 2 ]
+
+# The arbiter never serves reads.
+arbiter_reads=$($CLI volume top $V0 read brick $H0:$B0/${V0}2|grep FILE|awk '{print $1}')
+TEST [ -z $arbiter_reads ]
+
+# Reads keep working when one of the data bricks goes away.
+TEST kill_brick $V0 $H0 $B0/${V0}0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "0" afr_child_up_status $V0 0
+EXPECT "$md5" echo $(md5sum $M0/FILE | awk '{print $1}')
+
+cleanup;
@@ -0,0 +1,48 @@
+#!/bin/bash
+
+#Checks that the diff self-heal algorithm with fast checksums copies only the
+#blocks that differ and leaves the files identical on all bricks.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 3 $H0:$B0/${V0}{0,1,2}
+TEST $CLI volume set $V0 cluster.data-self-heal-algorithm diff
+TEST $CLI volume set $V0 cluster.data-self-heal-checksum fast
+TEST ! $CLI volume set $V0 cluster.data-self-heal-checksum md5
+TEST $CLI volume set $V0 cluster.self-heal-daemon off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+TEST dd if=/dev/urandom of=$M0/FILE bs=1M count=20
+TEST dd if=/dev/urandom of=$M0/small bs=1k count=100
+
+TEST kill_brick $V0 $H0 $B0/${V0}0
+
+#Change a few scattered blocks, one of them straddling two batches, and
+#extend the file.
+TEST dd if=/dev/urandom of=$M0/FILE bs=4k count=1 seek=10 conv=notrunc
+TEST dd if=/dev/urandom of=$M0/FILE bs=4k count=4 seek=2046 conv=notrunc
+TEST dd if=/dev/urandom of=$M0/FILE bs=1M count=1 seek=20 conv=notrunc
+TEST dd if=/dev/urandom of=$M0/small bs=1k count=1 seek=5 conv=notrunc
+
+md5_file=$(md5sum $M0/FILE | awk '{print $1}')
+md5_small=$(md5sum $M0/small | awk '{print $1}')
+
+TEST $CLI volume set $V0 cluster.self-heal-daemon on
+$CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 0
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" glustershd_up_status
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 0
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "0" get_pending_heal_count $V0
+
+for i in {0..2}; do
+        EXPECT "$md5_file" echo $(md5sum $B0/${V0}$i/FILE | awk '{print $1}')
+        EXPECT "$md5_small" echo $(md5sum $B0/${V0}$i/small | awk '{print $1}')
+done
+
+cleanup;
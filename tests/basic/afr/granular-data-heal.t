@@ -0,0 +1,52 @@
+#!/bin/bash
+
+#Checks that with granular-data-heal the bricks record the regions written
+#while a replica was down and that heal copies only those regions.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 3 $H0:$B0/${V0}{0,1,2}
+TEST $CLI volume set $V0 cluster.granular-data-heal on
+TEST $CLI volume set $V0 cluster.data-self-heal-algorithm full
+TEST $CLI volume set $V0 cluster.self-heal-daemon off
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+TEST dd if=/dev/urandom of=$M0/FILE bs=1M count=16
+gfid=$(gf_get_gfid_xattr $B0/${V0}1/FILE)
+gfid_str=$(gf_gfid_xattr_to_str $gfid)
+
+TEST kill_brick $V0 $H0 $B0/${V0}0
+TEST dd if=/dev/urandom of=$M0/FILE bs=64k count=2 seek=40 conv=notrunc
+TEST dd if=/dev/urandom of=$M0/FILE bs=1M count=1 seek=16 conv=notrunc
+md5=$(md5sum $M0/FILE | awk '{print $1}')
+
+#The good bricks keep a bitmap of the written regions
+TEST [ -f $B0/${V0}1/.glusterfs/indices/dirty-regions/$gfid_str ]
+TEST [ -f $B0/${V0}2/.glusterfs/indices/dirty-regions/$gfid_str ]
+
+#Change a clean region behind gluster's back on the down brick: granular
+#heal must leave it alone, which shows that only dirty regions are copied.
+TEST dd if=/dev/zero of=$B0/${V0}0/FILE bs=1M count=1 seek=8 conv=notrunc
+
+TEST $CLI volume set $V0 cluster.self-heal-daemon on
+$CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 0
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" glustershd_up_status
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 0
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "0" get_pending_heal_count $V0
+
+TEST [ ! -f $B0/${V0}1/.glusterfs/indices/dirty-regions/$gfid_str ]
+TEST [ ! -f $B0/${V0}2/.glusterfs/indices/dirty-regions/$gfid_str ]
+EXPECT "$md5" echo $(md5sum $B0/${V0}1/FILE | awk '{print $1}')
+TEST cmp -i 0:0 -n 8388608 $B0/${V0}0/FILE $B0/${V0}1/FILE
+TEST cmp -i 9437184:9437184 $B0/${V0}0/FILE $B0/${V0}1/FILE
+EXPECT "^0$" echo $(cmp -s -i 8388608:8388608 -n 1048576 /dev/zero $B0/${V0}0/FILE; echo $?)
+
+cleanup;
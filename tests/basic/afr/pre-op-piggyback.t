@@ -0,0 +1,46 @@
+#!/bin/bash
+
+#Checks that with pre-op-compat off the changelog travels with the fop and
+#the unlock, is applied on the bricks and still marks pending heals.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 3 $H0:$B0/${V0}{0,1,2}
+TEST $CLI volume set $V0 cluster.pre-op-compat off
+TEST $CLI volume set $V0 cluster.eager-lock off
+TEST $CLI volume set $V0 cluster.self-heal-daemon off
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+TEST dd if=/dev/urandom of=$M0/FILE bs=128k count=8
+TEST truncate -s 512k $M0/FILE
+TEST chmod 600 $M0/FILE
+
+#The dirty flag was set by the fops and cleared by the unlocks
+for i in {0..2}; do
+        EXPECT "000000000000000000000000" get_hex_xattr trusted.afr.dirty $B0/${V0}$i/FILE
+done
+EXPECT "^0$" get_pending_heal_count $V0
+
+TEST kill_brick $V0 $H0 $B0/${V0}0
+TEST dd if=/dev/urandom of=$M0/FILE bs=128k count=2 conv=notrunc
+md5=$(md5sum $M0/FILE | awk '{print $1}')
+EXPECT_NOT "000000000000000000000000" get_hex_xattr trusted.afr.$V0-client-0 $B0/${V0}1/FILE
+EXPECT "000000000000000000000000" get_hex_xattr trusted.afr.dirty $B0/${V0}1/FILE
+
+TEST $CLI volume set $V0 cluster.self-heal-daemon on
+$CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 0
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" glustershd_up_status
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 0
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "^0$" get_pending_heal_count $V0
+EXPECT "$md5" echo $(md5sum $B0/${V0}0/FILE | awk '{print $1}')
+
+cleanup;
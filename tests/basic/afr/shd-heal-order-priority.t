@@ -0,0 +1,50 @@
+#!/bin/bash
+
+#Checks that with shd-heal-order set to priority the self-heal daemon heals
+#all pending files and reports its heal queue in the crawl statistics.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+function heal_order_reported {
+        $CLI volume heal $V0 statistics | grep -c "Heal order: priority"
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 3 $H0:$B0/${V0}{0,1,2}
+TEST $CLI volume set $V0 cluster.shd-heal-order priority
+TEST $CLI volume set $V0 cluster.shd-max-threads 4
+TEST ! $CLI volume set $V0 cluster.shd-heal-order random
+TEST $CLI volume set $V0 cluster.self-heal-daemon off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+TEST mkdir $M0/dir
+TEST kill_brick $V0 $H0 $B0/${V0}0
+
+#Files of different sizes, some of them in a directory created while the
+#brick was down, so that entry and data heals are queued together.
+for i in {1..4}; do
+        TEST dd if=/dev/urandom of=$M0/big$i bs=1M count=$((i * 4))
+        TEST dd if=/dev/urandom of=$M0/dir/small$i bs=4k count=$i
+done
+TEST mkdir $M0/dir/newdir
+TEST dd if=/dev/urandom of=$M0/dir/newdir/file bs=1M count=2
+md5_big=$(md5sum $M0/big4 | awk '{print $1}')
+md5_new=$(md5sum $M0/dir/newdir/file | awk '{print $1}')
+
+TEST $CLI volume set $V0 cluster.self-heal-daemon on
+$CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 0
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" glustershd_up_status
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 0
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "0" get_pending_heal_count $V0
+
+EXPECT "$md5_big" echo $(md5sum $B0/${V0}0/big4 | awk '{print $1}')
+EXPECT "$md5_new" echo $(md5sum $B0/${V0}0/dir/newdir/file | awk '{print $1}')
+TEST [ $(heal_order_reported) -gt 0 ]
+
+cleanup;
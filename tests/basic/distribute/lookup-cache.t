@@ -0,0 +1,60 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+. $(dirname $0)/../../dht.rc
+
+# Checks that lookup misses and linkto targets cached by DHT never hide a
+# namespace change done through the same client, and expire for changes
+# done through another one.
+
+cleanup;
+
+function file_exists {
+        stat $1 >/dev/null 2>&1 && echo "Y" || echo "N"
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}{1..3}
+TEST $CLI volume set $V0 cluster.lookup-optimize off
+TEST $CLI volume set $V0 cluster.lookup-cache-timeout 5
+TEST ! $CLI volume set $V0 cluster.lookup-cache-timeout 3601
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 --entry-timeout=0 --negative-timeout=0 $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 --entry-timeout=0 --negative-timeout=0 $M1
+
+TEST mkdir $M0/dir
+
+# Misses are answered from the cache until this client creates the name
+EXPECT "N" file_exists $M0/dir/file
+EXPECT "N" file_exists $M0/dir/file
+TEST touch $M0/dir/file
+EXPECT "Y" file_exists $M0/dir/file
+TEST mkdir $M0/dir/subdir
+EXPECT "Y" file_exists $M0/dir/subdir
+
+# A name created through another client shows up once the entry expires
+EXPECT "N" file_exists $M0/dir/other
+TEST touch $M1/dir/other
+EXPECT_WITHIN 10 "Y" file_exists $M0/dir/other
+
+# Renamed files are found on their new hashed subvol or through linkto
+for i in {1..20}; do
+        echo $i > $M0/dir/src$i
+        TEST mv $M0/dir/src$i $M0/dir/dst$i
+done
+# Drop the inodes so that the next lookups are fresh ones
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 --entry-timeout=0 --negative-timeout=0 $M0
+for i in {1..20}; do
+        EXPECT "^$i$" cat $M0/dir/dst$i
+        EXPECT "N" file_exists $M0/dir/src$i
+done
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 --entry-timeout=0 --negative-timeout=0 $M0
+for i in {1..20}; do
+        EXPECT "^$i$" cat $M0/dir/dst$i
+done
+
+cleanup;
@@ -0,0 +1,63 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+. $(dirname $0)/../../dht.rc
+
+# Checks that directories pinned to a device class only place new files on
+# the subvolumes of that class, and that weighted placement still spreads
+# files over all the subvolumes.
+
+cleanup;
+
+function brick_file_count {
+        ls $B0/${V0}$1/$2 2>/dev/null | wc -l
+}
+
+TEST glusterd;
+TEST pidof glusterd;
+TEST $CLI volume create $V0 $H0:$B0/${V0}{0..3};
+TEST $CLI volume set $V0 cluster.subvol-device-classes \
+        "$V0-client-0:nvme,$V0-client-1:nvme,$V0-client-2:hdd,$V0-client-3:hdd"
+TEST $CLI volume set $V0 cluster.device-class-weights "nvme:4,hdd:1"
+TEST $CLI volume set $V0 cluster.device-class-pins "/fast:nvme,/fast/cold:hdd"
+TEST $CLI volume set $V0 cluster.placement-weighting on
+TEST $CLI volume start $V0;
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+
+TEST mkdir -p $M0/fast/sub $M0/fast/cold $M0/fastest $M0/any
+for d in fast fast/sub fast/cold fastest any; do
+        for i in {1..100}; do
+                echo $i > $M0/$d/file$i
+        done
+done
+
+# The pin applies to the tree below the path
+for d in fast fast/sub; do
+        EXPECT "^0$" brick_file_count 2 $d
+        EXPECT "^0$" brick_file_count 3 $d
+        EXPECT "^100$" echo $(( $(brick_file_count 0 $d) + $(brick_file_count 1 $d) ))
+done
+
+# The longest matching pin wins
+EXPECT "^0$" brick_file_count 0 fast/cold
+EXPECT "^0$" brick_file_count 1 fast/cold
+EXPECT "^100$" echo $(( $(brick_file_count 2 fast/cold) + $(brick_file_count 3 fast/cold) ))
+
+# "/fast" does not pin "/fastest", every subvolume gets files there
+for d in fastest any; do
+        for b in {0..3}; do
+                EXPECT_NOT "^0$" brick_file_count $b $d
+        done
+done
+
+# Pins survive a fix-layout
+TEST $CLI volume rebalance $V0 fix-layout start
+EXPECT_WITHIN $REBALANCE_TIMEOUT "completed" fix-layout_status_field $V0
+for i in {101..200}; do
+        echo $i > $M0/fast/file$i
+done
+EXPECT "^0$" brick_file_count 2 fast
+EXPECT "^0$" brick_file_count 3 fast
+
+cleanup;
@@ -0,0 +1,97 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+
+/* readdir-merge-seek <dir> <count>
+ *
+ * Reads the whole directory, remembering telldir() after every entry, then
+ * seeks back to the position after the first <count> entries and checks
+ * that the next entry is the one read there the first time.
+ *
+ * readdir-merge-seek <dir> -1
+ *
+ * Seeks a freshly opened directory to an offset it never returned.
+ *
+ * Prints "ok", "mismatch" or the name of the error the seek ended with. */
+
+static const char *
+error_name(int error)
+{
+    switch (error) {
+        case EINVAL:
+            return "EINVAL";
+        case ESTALE:
+            return "ESTALE";
+        default:
+            return strerror(error);
+    }
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct dirent *entry;
+    char **names = NULL;
+    long *offsets = NULL;
+    long count, total = 0, max = 0;
+    DIR *dir;
+
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <dir> <count>\n", argv[0]);
+        return 1;
+    }
+    count = strtol(argv[2], NULL, 0);
+
+    dir = opendir(argv[1]);
+    if (dir == NULL) {
+        printf("%s\n", error_name(errno));
+        return 1;
+    }
+
+    if (count < 0) {
+        seekdir(dir, 1L << 40);
+        errno = 0;
+        entry = readdir(dir);
+        printf("%s\n", entry ? "mismatch" : error_name(errno));
+        return 0;
+    }
+
+    while ((entry = readdir(dir)) != NULL) {
+        if (total == max) {
+            max = max ? max * 2 : 1024;
+            names = realloc(names, max * sizeof(*names));
+            offsets = realloc(offsets, max * sizeof(*offsets));
+            if (!names || !offsets) {
+                printf("ENOMEM\n");
+                return 1;
+            }
+        }
+        names[total] = strdup(entry->d_name);
+        offsets[total] = telldir(dir);
+        total++;
+    }
+
+    if (count >= total) {
+        printf("only %ld entries\n", total);
+        return 1;
+    }
+
+    if (count == 0)
+        seekdir(dir, 0);
+    else
+        seekdir(dir, offsets[count - 1]);
+    errno = 0;
+    entry = readdir(dir);
+    if (entry == NULL)
+        printf("%s\n", errno ? error_name(errno) : "eof");
+    else if (strcmp(entry->d_name, names[count]) != 0)
+        printf("mismatch\n");
+    else
+        printf("ok\n");
+
+    return 0;
+}
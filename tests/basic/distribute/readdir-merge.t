@@ -0,0 +1,76 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+. $(dirname $0)/../../dht.rc
+
+# Checks that a directory read from all the subvolumes at once lists every
+# name exactly once, without linkto files, and that the offsets it returns
+# can be seeked back to as long as they are in the history of the fd.
+
+cleanup;
+
+SEEK=$(dirname $0)/readdir-merge-seek
+build_tester $(dirname $0)/readdir-merge-seek.c -o ${SEEK}
+
+function list_count {
+        ls -a $1 | wc -l
+}
+
+function list_dups {
+        ls -a $1 | sort | uniq -d | wc -l
+}
+
+TEST glusterd;
+TEST pidof glusterd;
+TEST $CLI volume create $V0 $H0:$B0/${V0}{1..4};
+TEST $CLI volume set $V0 cluster.readdir-merge on
+TEST $CLI volume start $V0;
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+
+TEST mkdir $M0/dir
+for i in {1..1000}; do
+        echo $i > $M0/dir/file$i
+done
+TEST mkdir $M0/dir/sub{1..20}
+
+# 1020 names plus . and ..
+EXPECT "^1022$" list_count $M0/dir
+EXPECT "^0$" list_dups $M0/dir
+TEST mkdir $M0/empty
+EXPECT "^2$" list_count $M0/empty
+
+# Renames leave linkto files on the new hashed subvolumes
+for i in {1..200}; do
+        mv $M0/dir/file$i $M0/dir/renamed$i
+done
+EXPECT "^1022$" list_count $M0/dir
+EXPECT "^0$" list_dups $M0/dir
+EXPECT "^800$" echo $(ls $M0/dir | grep -c "^file")
+
+# telldir() offsets lead back to the same entry
+EXPECT "^ok$" ${SEEK} $M0/dir 0
+EXPECT "^ok$" ${SEEK} $M0/dir 1
+EXPECT "^ok$" ${SEEK} $M0/dir 500
+EXPECT "^ok$" ${SEEK} $M0/dir 1021
+# An offset this fd never returned is refused
+EXPECT "^EINVAL$" ${SEEK} $M0/dir -1
+
+# The fd only remembers the last 1024 entries it returned
+TEST mkdir $M0/big
+TEST touch $M0/big/file{1..3000}
+EXPECT "^3002$" list_count $M0/big
+EXPECT "^ok$" ${SEEK} $M0/big $((3002 - 1024))
+EXPECT "^EINVAL$" ${SEEK} $M0/big $((3002 - 1025))
+EXPECT "^ok$" ${SEEK} $M0/big 0
+
+# Same listing as reading the subvolumes one after the other
+ls -a $M0/dir | sort > $B0/merged.list
+TEST $CLI volume set $V0 cluster.readdir-merge off
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+ls -a $M0/dir | sort > $B0/sequential.list
+TEST cmp $B0/merged.list $B0/sequential.list
+
+rm -f ${SEEK}
+cleanup;
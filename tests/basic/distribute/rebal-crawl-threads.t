@@ -0,0 +1,78 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+. $(dirname $0)/../../dht.rc
+
+# Checks that a rebalance crawling the tree with several threads fixes the
+# layout of every directory and migrates the files, and that a restarted
+# rebalance skips the subtrees checkpointed before it was interrupted.
+
+CHECKPOINT=trusted.distribute.rebalance-checkpoint
+
+cleanup;
+
+TEST glusterd;
+TEST pidof glusterd;
+TEST $CLI volume create $V0 $H0:$B0/${V0}{1,2};
+TEST $CLI volume set $V0 cluster.rebal-crawl-threads 4
+TEST ! $CLI volume set $V0 cluster.rebal-crawl-threads 0
+TEST ! $CLI volume set $V0 cluster.rebal-crawl-threads 33
+TEST $CLI volume start $V0;
+TEST glusterfs --volfile-id=$V0 --volfile-server=$H0 --entry-timeout=0 $M0;
+
+for i in {1..5}; do
+        for j in {1..4}; do
+                TEST mkdir -p $M0/dir$i/sub$j/leaf
+                for k in {1..5}; do
+                        echo "$i-$j-$k" > $M0/dir$i/sub$j/leaf/file$k
+                done
+        done
+done
+
+TEST $CLI volume add-brick $V0 $H0:$B0/${V0}3;
+TEST $CLI volume rebalance $V0 start;
+EXPECT_WITHIN $REBALANCE_TIMEOUT "0" rebalance_completed;
+
+# Every directory got a range on the new brick
+for i in {1..5}; do
+        for j in {1..4}; do
+                EXPECT_NOT "^$" get_layout $B0/${V0}3/dir$i/sub$j/leaf
+        done
+done
+
+# The checkpoints are removed once the rebalance completed
+TEST ! getfattr -n $CHECKPOINT $B0/${V0}3/dir1
+TEST ! getfattr -n $CHECKPOINT $B0/${V0}3/dir1/sub1
+
+# glusterd restarts a rebalance it stored as in progress, with the same
+# commit hash. Fake one interrupted after dir1 was checkpointed, and check
+# that the restarted rebalance skips dir1 only and clears its checkpoint.
+hash=$(sed -n 's/^commit-hash=//p' $GLUSTERD_WORKDIR/vols/$V0/node_state.info)
+TEST [ -n "$hash" ]
+TEST pkill -9 -x glusterd
+for i in {1..3}; do
+        TEST setfattr -n $CHECKPOINT -v $hash $B0/${V0}$i/dir1
+done
+TEST sed -i 's/^status=.*/status=1/' $GLUSTERD_WORKDIR/vols/$V0/node_state.info
+TEST glusterd
+TEST pidof glusterd
+EXPECT_WITHIN $REBALANCE_TIMEOUT "0" rebalance_completed
+log=$LOGDIR/$V0-rebalance.log
+EXPECT "^1$" grep -c "/dir1 was rebalanced before the restart" $log
+EXPECT "^0$" grep -c "/dir2 was rebalanced before the restart" $log
+for i in {1..3}; do
+        TEST ! getfattr -n $CHECKPOINT $B0/${V0}$i/dir1
+done
+
+TEST umount $M0
+TEST glusterfs --volfile-id=$V0 --volfile-server=$H0 --entry-timeout=0 $M0;
+for i in {1..5}; do
+        for j in {1..4}; do
+                for k in {1..5}; do
+                        EXPECT "^$i-$j-$k$" cat $M0/dir$i/sub$j/leaf/file$k
+                done
+        done
+done
+
+cleanup;
@@ -0,0 +1,48 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+. $(dirname $0)/../../dht.rc
+
+# Checks that files migrated with several chunks in flight, dense and
+# sparse, are identical after rebalance and that holes stay unallocated.
+
+cleanup;
+
+TEST glusterd;
+TEST pidof glusterd;
+TEST $CLI volume create $V0 $H0:$B0/${V0}{1,2};
+TEST $CLI volume set $V0 cluster.rebal-io-window 8
+TEST ! $CLI volume set $V0 cluster.rebal-io-window 0
+TEST ! $CLI volume set $V0 cluster.rebal-io-window 65
+TEST $CLI volume start $V0;
+TEST glusterfs --volfile-id=$V0 --volfile-server=$H0 --entry-timeout=0 $M0;
+
+for i in {1..10}; do
+        TEST dd if=/dev/urandom of=$M0/dense$i bs=1M count=$((i * 3)) status=none
+        TEST dd if=/dev/urandom of=$M0/sparse$i bs=1M count=1 seek=$((i * 10)) status=none
+        TEST dd if=/dev/urandom of=$M0/sparse$i bs=64k count=3 conv=notrunc status=none
+done
+for i in {1..10}; do
+        md5_dense[$i]=$(md5sum $M0/dense$i | awk '{print $1}')
+        md5_sparse[$i]=$(md5sum $M0/sparse$i | awk '{print $1}')
+done
+
+TEST $CLI volume add-brick $V0 $H0:$B0/${V0}3;
+TEST $CLI volume rebalance $V0 start force;
+EXPECT_WITHIN $REBALANCE_TIMEOUT "0" rebalance_completed;
+
+TEST umount $M0
+TEST glusterfs --volfile-id=$V0 --volfile-server=$H0 --entry-timeout=0 $M0;
+for i in {1..10}; do
+        EXPECT "${md5_dense[$i]}" echo $(md5sum $M0/dense$i | awk '{print $1}')
+        EXPECT "${md5_sparse[$i]}" echo $(md5sum $M0/sparse$i | awk '{print $1}')
+done
+
+# Sparse files that moved to the new brick must still be sparse there
+for f in $B0/${V0}3/sparse*; do
+        [ -f $f ] || continue
+        EXPECT "^Y$" echo $([ $(du -k $f | awk '{print $1}') -lt 4096 ] && echo Y)
+done
+
+cleanup;
@@ -0,0 +1,53 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+. $(dirname $0)/../../ec.rc
+
+# This test checks that data heal with several blocks in flight, hole
+# skipping and bandwidth throttling rebuilds files correctly.
+
+cleanup
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 disperse 6 redundancy 2 $H0:$B0/${V0}{0..5}
+TEST $CLI volume set $V0 disperse.self-heal-window-size 1
+TEST $CLI volume set $V0 disperse.heal-pipeline-window 8
+TEST $CLI volume set $V0 disperse.heal-skip-holes on
+TEST $CLI volume set $V0 disperse.heal-bandwidth-limit 64MB
+TEST ! $CLI volume set $V0 disperse.heal-pipeline-window 0
+TEST ! $CLI volume set $V0 disperse.heal-pipeline-window 65
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "6" ec_child_up_count $V0 0
+
+TEST kill_brick $V0 $H0 $B0/${V0}0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "5" ec_child_up_count $V0 0
+
+# Dense file bigger than a whole pipeline window
+TEST dd if=/dev/urandom of=$M0/dense bs=1M count=20
+# Sparse file with data at both ends and a big hole in the middle
+TEST dd if=/dev/urandom of=$M0/sparse bs=1M count=2
+TEST dd if=/dev/urandom of=$M0/sparse bs=1M count=2 seek=200 conv=notrunc
+
+md5_dense=$(md5sum $M0/dense | awk '{print $1}')
+md5_sparse=$(md5sum $M0/sparse | awk '{print $1}')
+
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "6" ec_child_up_count $V0 0
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "^0$" get_pending_heal_count $V0
+
+# Read the files from the healed brick and the minimum number of others
+TEST kill_brick $V0 $H0 $B0/${V0}1
+TEST kill_brick $V0 $H0 $B0/${V0}2
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "4" ec_child_up_count $V0 0
+EXPECT "$md5_dense" echo $(md5sum $M0/dense | awk '{print $1}')
+EXPECT "$md5_sparse" echo $(md5sum $M0/sparse | awk '{print $1}')
+
+# The hole must not have been allocated on the healed brick
+EXPECT "^Y$" echo $([ $(du -k $B0/${V0}0/sparse | awk '{print $1}') -lt 4096 ] && echo Y)
+
+cleanup
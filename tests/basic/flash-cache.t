@@ -0,0 +1,74 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+# Checks that the data cached by flash-cache on the local disk is read back
+# after a remount, and that it is dropped when another client changes the
+# file.
+
+cleanup;
+
+function cached_size {
+        local gfid=$(get_gfid_string $M1/$1)
+        stat -c %s $B0/fcache/${gfid:0:2}/$gfid 2>/dev/null || echo 0
+}
+
+# The flags of the index, 0 once written back clean
+function index_flags {
+        local gfid=$(get_gfid_string $M1/$1)
+        od -An -tu4 -j8 -N4 $B0/fcache/${gfid:0:2}/$gfid.idx 2>/dev/null | \
+                tr -d ' '
+}
+
+function read_md5 {
+        drop_cache $1
+        md5sum $1/$2 | awk '{print $1}'
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.flash-cache on
+TEST $CLI volume set $V0 performance.flash-cache-dir $B0/fcache
+TEST ! $CLI volume set $V0 performance.flash-cache-write-policy write-back
+TEST ! $CLI volume set $V0 performance.flash-cache-block-size 1KB
+TEST $CLI volume set $V0 features.cache-invalidation on
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.open-behind off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M1
+
+TEST dd if=/dev/urandom of=$M1/data bs=1M count=4
+md5=$(md5sum $M1/data | awk '{print $1}')
+
+# The first read fills the cache, in the background
+EXPECT "$md5" read_md5 $M0 data
+EXPECT_WITHIN 5 "^4194304$" cached_size data
+EXPECT_WITHIN 5 "^0$" index_flags data
+
+# And the data is served from it after a remount
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+EXPECT "$md5" read_md5 $M0 data
+EXPECT_NOT "^0$" get_value_from_mount_statedump $V0 $M0 hit_count
+
+# Changed from the other mount
+TEST dd if=/dev/urandom of=$M1/data bs=1M count=1 seek=1 conv=notrunc
+md5=$(md5sum $M1/data | awk '{print $1}')
+EXPECT_WITHIN 5 "$md5" read_md5 $M0 data
+
+# Written through the cache
+TEST $CLI volume set $V0 performance.flash-cache-write-policy write-through
+TEST dd if=/dev/urandom of=$M0/data bs=1M count=1 seek=2 conv=notrunc
+md5=$(md5sum $M1/data | awk '{print $1}')
+EXPECT "$md5" read_md5 $M0 data
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M1
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
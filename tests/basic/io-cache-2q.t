@@ -0,0 +1,61 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+# Checks that with the 2q policy of io-cache, pages read again after being
+# evicted once stay cached while a large file is read through.
+
+cleanup;
+
+function hot_hits {
+        local statedump=$(generate_mount_statedump $V0)
+        grep -B3 "^path=/hot$" $statedump | grep "inode.hits" | cut -f2 -d'='
+        rm -f $statedump
+}
+
+function read_file {
+        drop_cache $M0
+        cat $M0/$1 > /dev/null
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.io-cache on
+TEST $CLI volume set $V0 performance.io-cache-size 4MB
+TEST $CLI volume set $V0 performance.io-cache-policy 2q
+TEST ! $CLI volume set $V0 performance.io-cache-policy mru
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.open-behind off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+
+TEST dd if=/dev/urandom of=$M0/hot bs=128k count=4
+TEST dd if=/dev/urandom of=$M0/filler bs=128k count=36
+TEST dd if=/dev/urandom of=$M0/big bs=1M count=32
+
+# Read once, pushed out of the cache by the filler and read again: the
+# pages of hot are now known to be reused
+TEST read_file hot
+TEST read_file filler
+TEST read_file hot
+
+statedump=$(generate_mount_statedump $V0)
+EXPECT "2q" echo $(grep "^cache-policy=" $statedump | cut -f2 -d'=')
+EXPECT_NOT "^0$" echo $(grep "^ghost_hits=" $statedump | cut -f2 -d'=')
+rm -f $statedump
+
+# A scan through a file eight times as large as the cache leaves them alone
+hits=$(hot_hits)
+TEST read_file big
+TEST read_file hot
+EXPECT "Y" echo $([ $(hot_hits) -ge $((hits + 4)) ] && echo Y)
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
@@ -0,0 +1,57 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+# Checks that the bricks serve requests with the deadline scheduler of
+# io-threads, and that the statedump has the targets and the histograms of
+# the time the requests waited in the queues.
+
+cleanup;
+
+function iot_stat {
+        get_value_from_brick_statedump $V0 $H0 $B0/${V0}0 "^$1="
+}
+
+function iot_waited {
+        local statedump=$(generate_brick_statedump $V0 $H0 $B0/${V0}0)
+        grep "^$1_priority_queue_wait_" $statedump | cut -f2 -d'=' | \
+                awk '{s += $1} END {print s + 0}'
+        rm -f $statedump
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.iot-scheduler deadline
+TEST ! $CLI volume set $V0 performance.iot-high-prio-deadline 0
+TEST $CLI volume set $V0 performance.iot-high-prio-deadline 5
+TEST $CLI volume start $V0
+
+EXPECT "deadline" iot_stat scheduler
+EXPECT "^5$" iot_stat fast_priority_deadline_msecs
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+
+TEST mkdir $M0/dir
+for i in {1..8}; do
+        dd if=/dev/urandom of=$M0/dir/file$i bs=128k count=16 2>/dev/null &
+done
+for i in {1..100}; do
+        stat $M0/dir/missing$i >/dev/null 2>&1
+done
+wait
+
+EXPECT "^8$" echo $(ls $M0/dir | wc -l)
+EXPECT_NOT "^0$" iot_waited fast
+EXPECT_NOT "^0$" iot_waited slow
+
+# The targets can be changed while the brick runs
+TEST $CLI volume set $V0 performance.iot-low-prio-deadline 1000
+EXPECT_WITHIN 5 "^1000$" iot_stat slow_priority_deadline_msecs
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
@@ -0,0 +1,59 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+# Checks that the bricks serve requests with the per-worker scheduler of
+# io-threads, from several clients at once, and report it in the statedump.
+
+cleanup;
+
+function iot_stat {
+        get_value_from_brick_statedump $V0 $H0 $B0/${V0}0 "^$1="
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST ! $CLI volume set $V0 performance.iot-scheduler fifo
+TEST $CLI volume set $V0 performance.iot-scheduler per-worker
+TEST $CLI volume set $V0 performance.io-thread-count 4
+TEST $CLI volume start $V0
+
+EXPECT "per-worker" iot_stat scheduler
+EXPECT "^4$" iot_stat current_threads_count
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M1
+
+TEST mkdir $M0/dir
+for i in {1..8}; do
+        dd if=/dev/urandom of=$M0/dir/file$i bs=128k count=16 2>/dev/null &
+        dd if=/dev/urandom of=$M1/dir/other$i bs=128k count=16 2>/dev/null &
+done
+wait
+TEST touch $M1/dir/file{9..200}
+
+# file1..8 and other1..8 from dd, file9..200 from touch
+EXPECT "^208$" echo $(ls $M0/dir | wc -l)
+TEST cmp $M0/dir/file1 $M1/dir/file1
+
+# Requests are handed to the workers in turns, whatever they are. With a few
+# slow writes among a lot of quick lookups, the workers done with the quick
+# ones take those queued behind the slow ones.
+for i in {1..4}; do
+        dd if=/dev/zero of=$M0/dir/slow$i bs=128k count=64 oflag=sync \
+           2>/dev/null &
+done
+for i in {1..500}; do
+        stat $M1/dir/missing$i >/dev/null 2>&1
+done
+wait
+EXPECT "^[1-9][0-9]*$" iot_stat stolen_requests
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M1
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
@@ -0,0 +1,49 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+# Checks that md-cache answers the getxattrs of missing xattrs from its cache
+# once cache-absent-xattrs is on, forgets them when they are set, and stays
+# within md-cache-size.
+
+cleanup;
+
+function get_xattr {
+        getfattr --only-values -n $2 $1 2>/dev/null || echo "missing"
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.stat-prefetch on
+TEST $CLI volume set $V0 performance.md-cache-timeout 60
+TEST $CLI volume set $V0 performance.cache-absent-xattrs on
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+
+TEST touch $M0/file
+TEST stat $M0/file
+
+EXPECT "missing" get_xattr $M0/file user.missing
+EXPECT "missing" get_xattr $M0/file user.missing
+EXPECT_NOT "^0$" get_value_from_mount_statedump $V0 $M0 xattr_absent_hit_count
+
+# Set through the mount, seen at once
+TEST setfattr -n user.missing -v present $M0/file
+EXPECT "present" get_xattr $M0/file user.missing
+
+# Every inode cached takes some room, a tiny limit keeps evicting them
+TEST $CLI volume set $V0 performance.md-cache-size 4KB
+for i in $(seq 1 64); do
+        TEST touch $M0/f$i
+        TEST stat $M0/f$i
+done
+EXPECT_NOT "^0$" get_value_from_mount_statedump $V0 $M0 evictions
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
@@ -0,0 +1,54 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+# Checks that nl-cache builds a filter of the names of a directory after
+# listing it, serves lookups of missing names from it, and keeps it up to
+# date with the entries created from here and from another client.
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}{0..1}
+TEST $CLI volume set $V0 group nl-cache
+TEST $CLI volume set $V0 nl-cache-readdir-filter on
+TEST $CLI volume start $V0
+
+TEST glusterfs --volfile-id=/$V0 --volfile-server=$H0 $M0
+TEST glusterfs --volfile-id=/$V0 --volfile-server=$H0 $M1
+
+TEST mkdir $M1/dir
+TEST touch $M1/dir/file{1..500}
+
+# A complete listing builds the filter
+TEST ls $M0/dir
+EXPECT "^1$" get_value_from_mount_statedump $V0 $M0 readdir_filters_built
+
+# Missing names are answered from it
+for i in {1..20}; do
+        TEST ! stat $M0/dir/missing$i
+done
+EXPECT_NOT "^0$" get_value_from_mount_statedump $V0 $M0 readdir_filter_hit_count
+TEST stat $M0/dir/file250
+
+# Entries created here and by the other client are found
+TEST touch $M0/dir/local
+TEST stat $M0/dir/local
+TEST touch $M1/dir/remote
+EXPECT_WITHIN 5 "Y" path_exists $M0/dir/remote
+EXPECT_NOT "^0$" get_value_from_mount_statedump $V0 $M0 dentry_updates_received
+TEST mkdir $M1/dir/subdir
+EXPECT_WITHIN 5 "Y" path_exists $M0/dir/subdir
+
+# Removed entries are not found
+TEST rm -f $M1/dir/file1
+EXPECT_WITHIN 5 "N" path_exists $M0/dir/file1
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M1
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
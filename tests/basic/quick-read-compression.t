@@ -0,0 +1,51 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+# Checks that quick-read keeps compressible files compressed, serves reads
+# at any offset from them, and keeps files that do not compress as they are.
+
+cleanup;
+
+function read_md5 {
+        md5sum $M0/$1 | awk '{print $1}'
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.quick-read on
+TEST $CLI volume set $V0 performance.quick-read-cache-compression on
+TEST $CLI volume set $V0 performance.quick-read-cache-timeout 60
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.open-behind off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 --direct-io-mode=yes $M0
+
+for i in {1..200}; do echo "line $i of some text that compresses"; done \
+        > $M0/text
+text_md5=$(md5sum $M0/text | awk '{print $1}')
+TEST dd if=/dev/urandom of=$M0/random bs=4k count=4
+random_md5=$(md5sum $M0/random | awk '{print $1}')
+
+# Looked up afresh, the content comes with the lookup and is cached
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 --direct-io-mode=yes $M0
+TEST stat $M0/text $M0/random
+
+EXPECT "$text_md5" read_md5 text
+EXPECT "$random_md5" read_md5 random
+EXPECT "^1$" get_value_from_mount_statedump $V0 $M0 compressed_files_cached
+EXPECT_NOT "^0$" get_value_from_mount_statedump $V0 $M0 cache-hit
+
+# Reads in the middle of the compressed file
+EXPECT "line 150 of" echo $(dd if=$M0/text bs=1 skip=$(grep -b "^line 150 " \
+        $M0/text | cut -f1 -d:) count=11 2>/dev/null)
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
@@ -0,0 +1,76 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+# Checks that read-ahead follows interleaved sequential streams and strided
+# reads through a single fd, and reports them in the statedump.
+
+cleanup;
+
+# The pattern and the offset of the last read of every stream
+function streams {
+        local statedump=$(generate_mount_statedump $V0)
+        grep -E "^(pattern|offset)=" $statedump | cut -f2 -d'=' | \
+                paste -d: - - | sort | xargs
+        rm -f $statedump
+}
+
+function stream_hits {
+        local statedump=$(generate_mount_statedump $V0)
+        grep "^hits=" $statedump | cut -f2 -d'=' | awk '{s += $1} END {print s}'
+        rm -f $statedump
+}
+
+# Reads <count> blocks of 4k from fd 9, <step> blocks apart from <first>.
+# With pread, the offsets don't depend on where the fd was left.
+function read_blocks {
+        $PYTHON -c "
+import os, sys
+first, step, count = map(int, sys.argv[1:])
+for i in range(count):
+    if len(os.pread(9, 4096, (first + i * step) * 4096)) != 4096:
+        sys.exit(1)
+" $1 $2 $3
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.read-ahead on
+TEST $CLI volume set $V0 performance.read-ahead-stream-count 4
+TEST ! $CLI volume set $V0 performance.read-ahead-stream-count 17
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.open-behind off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 --direct-io-mode=yes $M0
+
+TEST dd if=/dev/urandom of=$M0/data bs=1M count=64
+md5=$(md5sum $M0/data | awk '{print $1}')
+
+exec 9<$M0/data
+
+# Two sequential streams, far apart, read in turns
+for i in $(seq 0 15); do
+        TEST read_blocks $i 1 1
+        TEST read_blocks $((4096 + i)) 1 1
+done
+EXPECT "^sequential:16838656 sequential:61440$" streams
+EXPECT_NOT "^0$" stream_hits
+
+# Blocks 1MB apart, from 32MB on
+TEST read_blocks 8192 256 16
+EXPECT "^sequential:16838656 sequential:61440 strided:49283072$" streams
+
+exec 9<&-
+
+# And the data read is still right
+EXPECT "$md5" echo $(md5sum $M0/data | awk '{print $1}')
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
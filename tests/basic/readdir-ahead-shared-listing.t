@@ -0,0 +1,60 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+# Checks that readdir-ahead serves the fds opened on a directory from the
+# listing read by an earlier one, and drops the listing when entries are
+# created or removed in the directory, here and from another client.
+
+cleanup;
+
+function count_entries {
+        ls $1 | wc -l
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}{0..1}
+TEST $CLI volume set $V0 performance.readdir-ahead on
+TEST $CLI volume set $V0 performance.rda-listing-timeout 60
+TEST ! $CLI volume set $V0 performance.rda-listing-timeout 601
+TEST $CLI volume set $V0 features.cache-invalidation on
+TEST $CLI volume start $V0
+
+TEST glusterfs --volfile-id=/$V0 --volfile-server=$H0 $M0
+TEST glusterfs --volfile-id=/$V0 --volfile-server=$H0 $M1
+
+TEST mkdir $M1/dir
+TEST touch $M1/dir/file{1..500}
+
+# The first listing is kept, the next ones are served from it
+EXPECT "^500$" count_entries $M0/dir
+EXPECT_NOT "^0$" get_value_from_mount_statedump $V0 $M0 listings_built
+EXPECT "^500$" count_entries $M0/dir
+EXPECT "^500$" count_entries $M0/dir
+EXPECT_NOT "^0$" get_value_from_mount_statedump $V0 $M0 listing_hits
+
+# Entries created here and by the other client are listed
+TEST touch $M0/dir/local
+EXPECT "^501$" count_entries $M0/dir
+TEST touch $M1/dir/remote
+EXPECT_WITHIN 5 "^502$" count_entries $M0/dir
+
+# Removed entries are not
+TEST rm -f $M1/dir/file1
+EXPECT_WITHIN 5 "^501$" count_entries $M0/dir
+TEST rm -f $M0/dir/file2
+EXPECT "^500$" count_entries $M0/dir
+
+# Turned off, the listings are dropped
+TEST $CLI volume set $V0 performance.rda-listing-timeout 0
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "^0$" get_value_from_mount_statedump $V0 $M0 listings
+EXPECT "^500$" count_entries $M0/dir
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M1
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
@@ -0,0 +1,68 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+# Checks that write-behind sends small sequential writes in larger chunks,
+# merges concurrent fsyncs of a file, and reports both in the statedump.
+
+cleanup;
+
+# Calls of <fop> the brick got since the stats were last cleared
+function brick_calls {
+        $CLI volume profile $V0 info cumulative | \
+                awk -v fop=$1 '$NF == fop {s += $(NF - 1)} END {print s + 0}'
+}
+
+# Writes <count> blocks of 4k to the file from block <first> on, with an
+# fsync after each of them
+function write_fsync {
+        $PYTHON -c "
+import os, sys
+path, first, count = sys.argv[1], int(sys.argv[2]), int(sys.argv[3])
+fd = os.open(path, os.O_WRONLY)
+for i in range(first, first + count):
+    os.pwrite(fd, b'\\0' * 4096, i * 4096)
+    os.fsync(fd)
+os.close(fd)
+" $1 $2 $3
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.write-behind on
+TEST $CLI volume set $V0 performance.aggregate-size-max 1MB
+TEST $CLI volume start $V0
+TEST $CLI volume profile $V0 start
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+
+# 4k writes go out larger, the brick gets fewer of them
+TEST $CLI volume profile $V0 info clear
+TEST dd if=/dev/urandom of=$M0/data bs=4k count=1024 conv=fsync
+md5=$(md5sum $M0/data | awk '{print $1}')
+EXPECT_NOT "^0$" get_value_from_mount_statedump $V0 $M0 writes_received_upto_4KB
+EXPECT_NOT "^0$" get_value_from_mount_statedump $V0 $M0 writes_sent_upto_256KB
+writes=$(brick_calls WRITE)
+TEST [ $writes -gt 0 -a $writes -lt 1024 ]
+
+# 256 concurrent fsyncs of the same file, the brick gets fewer of them
+TEST $CLI volume profile $V0 info clear
+for i in $(seq 0 7); do
+        write_fsync $M0/data $((1024 + i * 32)) 32 &
+done
+wait
+fsyncs=$(brick_calls FSYNC)
+TEST [ $fsyncs -gt 0 -a $fsyncs -lt 256 ]
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+EXPECT "$md5" echo $(head -c 4194304 $M0/data | md5sum | awk '{print $1}')
+EXPECT "5242880" stat -c %s $M0/data
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
@@ -0,0 +1,60 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+# Checks that the shards of deleted files are removed by the bricks in bulk,
+# and that shards still open are left to the regular deletion.
+
+cleanup
+
+function file_shard_count {
+        for i in $(seq 0 $2); do
+                ls $B0/${V0}$i/.shard 2>/dev/null
+        done | grep -c "^$1"
+}
+
+function bulk_deleted {
+        get_value_from_brick_statedump $V0 $H0 $B0/${V0}$1 \
+                "^shard_bulk_deleted="
+}
+
+function marker_count {
+        ls $B0/${V0}0/.shard/.remove_me 2>/dev/null | wc -l
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 2 $H0:$B0/${V0}{0..3}
+TEST $CLI volume set $V0 features.shard on
+TEST $CLI volume set $V0 features.shard-block-size 4MB
+TEST $CLI volume set $V0 features.shard-bulk-delete on
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+TEST dd if=/dev/zero of=$M0/foo bs=1M count=100
+gfid_foo=$(get_gfid_string $M0/foo)
+EXPECT "^48$" file_shard_count $gfid_foo 3
+
+TEST unlink $M0/foo
+EXPECT_WITHIN 30 "^0$" file_shard_count $gfid_foo 3
+EXPECT_WITHIN 30 "^0$" marker_count
+# Deleted by the bricks, not one by one through the client
+EXPECT "^[1-9][0-9]*$" bulk_deleted 0
+EXPECT "^[1-9][0-9]*$" bulk_deleted 2
+
+# With a brick down the bulk deletion is refused and the client unlinks the
+# shards one by one
+TEST dd if=/dev/zero of=$M0/bar bs=1M count=40
+gfid_bar=$(get_gfid_string $M0/bar)
+TEST kill_brick $V0 $H0 $B0/${V0}3
+TEST unlink $M0/bar
+EXPECT_WITHIN 30 "^0$" file_shard_count $gfid_bar 2
+EXPECT_WITHIN 30 "^0$" marker_count
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup
@@ -0,0 +1,58 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+# Checks that reads and writes fanned out shard by shard through a small
+# window give the same data as when all the shards are resolved up front.
+
+cleanup
+
+function shard_count {
+        ls $B0/${V0}$1/.shard | grep -c "^$(get_gfid_string $M0/$2)"
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 features.shard on
+TEST $CLI volume set $V0 features.shard-block-size 4MB
+TEST $CLI volume set $V0 features.shard-fanout-window 2
+TEST ! $CLI volume set $V0 features.shard-fanout-window 1025
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+# Writes crossing the boundaries of the shards, and shards created by writes
+# past EOF
+TEST dd if=/dev/urandom of=$B0/data bs=1M count=30
+TEST dd if=$B0/data of=$M0/dense bs=3M oflag=direct
+TEST dd if=$B0/data of=$M0/sparse bs=1M count=2 seek=37 oflag=direct
+EXPECT "^7$" echo $(( $(shard_count 0 dense) + $(shard_count 1 dense) ))
+
+md5_dense=$(md5sum $B0/data | awk '{print $1}')
+EXPECT "$md5_dense" echo $(dd if=$M0/dense bs=5M iflag=direct 2>/dev/null | md5sum | awk '{print $1}')
+
+# Reads over holes return zeros
+head -c 37M /dev/zero > $B0/sparse
+head -c 2M $B0/data >> $B0/sparse
+md5_sparse=$(md5sum $B0/sparse | awk '{print $1}')
+EXPECT "$md5_sparse" echo $(dd if=$M0/sparse bs=7M iflag=direct 2>/dev/null | md5sum | awk '{print $1}')
+
+# Same data with the shards looked up before any I/O
+TEST $CLI volume set $V0 features.shard-fanout-window 0
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+EXPECT "$md5_dense" echo $(dd if=$M0/dense bs=5M iflag=direct 2>/dev/null | md5sum | awk '{print $1}')
+EXPECT "$md5_sparse" echo $(dd if=$M0/sparse bs=7M iflag=direct 2>/dev/null | md5sum | awk '{print $1}')
+
+rm -f $B0/data $B0/sparse
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup
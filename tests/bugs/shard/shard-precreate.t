@@ -0,0 +1,76 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+# Checks that shards are created ahead of a sequential writer, that they
+# read back as holes, that the size xattr records the last of them and that
+# they are deleted by truncate and along with the file.
+
+cleanup
+
+function shard_exists {
+        [ -f $B0/${V0}0/.shard/$1.$2 ] && echo "Y" || echo "N"
+}
+
+function file_shard_count {
+        ls $B0/${V0}0/.shard 2>/dev/null | grep -c "^$1"
+}
+
+# The second 64 bits of the size xattr hold the last pre-created shard
+function precreated_mark {
+        local size=$(getfattr -n trusted.glusterfs.shard.file-size -e hex \
+                     $B0/${V0}0/$1 2>/dev/null | sed -n 's/.*=0x//p')
+        echo $((16#${size:16:16}))
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 features.shard on
+TEST $CLI volume set $V0 features.shard-block-size 4MB
+TEST $CLI volume set $V0 features.shard-fanout-window 4
+TEST $CLI volume set $V0 features.shard-precreate-count 3
+TEST ! $CLI volume set $V0 features.shard-precreate-count 65
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+# Blocks 0 to 2 are written, 3 to 5 are created ahead of the writes
+TEST dd if=/dev/urandom of=$M0/foo bs=1M count=10
+gfid=$(get_gfid_string $M0/foo)
+EXPECT_WITHIN 10 "Y" shard_exists $gfid 5
+EXPECT "N" shard_exists $gfid 6
+EXPECT "^5$" precreated_mark foo
+EXPECT "^0$" stat -c %s $B0/${V0}0/.shard/$gfid.4
+
+# The file size is not affected and the data reads back
+EXPECT "^10485760$" stat -c %s $M0/foo
+md5=$(md5sum $M0/foo | awk '{print $1}')
+TEST dd if=/dev/urandom of=$M0/foo bs=1M count=10 seek=10 conv=notrunc
+EXPECT "^20971520$" stat -c %s $M0/foo
+EXPECT "$md5" echo $(head -c 10M $M0/foo | md5sum | awk '{print $1}')
+EXPECT_WITHIN 10 "Y" shard_exists $gfid 7
+EXPECT "^7$" precreated_mark foo
+
+# Truncate deletes the shards up to the mark and clears it
+TEST truncate -s 4M $M0/foo
+EXPECT "^0$" file_shard_count $gfid
+EXPECT "^0$" precreated_mark foo
+EXPECT "^4194304$" stat -c %s $M0/foo
+
+TEST dd if=/dev/urandom of=$M0/foo bs=1M count=10 seek=4 conv=notrunc
+EXPECT_WITHIN 10 "Y" shard_exists $gfid 6
+EXPECT "N" shard_exists $gfid 7
+EXPECT "^6$" precreated_mark foo
+
+# Shards created past EOF go away with the file
+TEST unlink $M0/foo
+EXPECT_WITHIN 30 "^0$" file_shard_count $gfid
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup
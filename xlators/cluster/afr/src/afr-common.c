@@ -1931,6 +1931,7 @@ afr_inode_refresh_subvol_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
         if (ret) {
             gf_msg_debug(this->name, -ret, "Unable to get link count");
         }
+        afr_piggyback_capability_update(this, call_child, xdata);
     }
 
     local->replies[call_child].need_heal = need_heal;
@@ -2054,6 +2055,8 @@ afr_inode_refresh_do(call_frame_t *frame, xlator_t *this)
         gf_msg_debug(this->name, -ret, "Unable to set link-count in dict ");
     }
 
+    afr_piggyback_capability_req(this, xdata);
+
     ret = dict_set_str_sizen(xdata, GLUSTERFS_INODELK_DOM_COUNT, this->name);
     if (ret) {
         gf_msg_debug(this->name, -ret,
@@ -2127,6 +2130,32 @@ afr_inode_refresh(call_frame_t *frame, xlator_t *this, inode_t *inode,
     return 0;
 }
 
+/* With pre-op-compat off, lookups ask every brick whether it can apply a
+ * changelog piggybacked on a fop. Older bricks would silently ignore it. */
+void
+afr_piggyback_capability_req(xlator_t *this, dict_t *xattr_req)
+{
+    afr_private_t *priv = this->private;
+    int ret = 0;
+
+    if (priv->pre_op_compat || priv->arbiter_count || priv->thin_arbiter_count)
+        return;
+
+    ret = dict_set_int8(xattr_req, GF_XATTROP_PIGGYBACK_SUPPORTED, 1);
+    if (ret)
+        gf_msg_debug(this->name, -ret, "Unable to set %s in dict",
+                     GF_XATTROP_PIGGYBACK_SUPPORTED);
+}
+
+void
+afr_piggyback_capability_update(xlator_t *this, int child, dict_t *xdata)
+{
+    afr_private_t *priv = this->private;
+
+    if (xdata && dict_get_sizen(xdata, GF_XATTROP_PIGGYBACK_SUPPORTED))
+        priv->piggyback_capable[child] = 1;
+}
+
 int
 afr_xattr_req_prepare(xlator_t *this, dict_t *xattr_req)
 {
@@ -2203,6 +2232,8 @@ afr_lookup_xattr_req_prepare(afr_local_t *local, xlator_t *this,
         gf_msg_debug(this->name, -ret, "Unable to set link-count in dict ");
     }
 
+    afr_piggyback_capability_req(this, local->xattr_req);
+
     ret = 0;
 out:
     return ret;
@@ -2274,6 +2305,53 @@ afr_least_latency_times_pending_reads_child(afr_private_t *priv,
     return child;
 }
 
+/* Pick the readable child with the lowest smoothed latency for this class of
+ * read, weighted by the reads of that class already in flight on it. Children
+ * without samples are tried first, and a child not chosen for
+ * read-probe-interval seconds for this class of read is probed once so that
+ * its estimate does not go stale after it recovers. @probe, if given, tells
+ * whether the child was picked as such a probe. */
+int
+afr_adaptive_read_child(afr_private_t *priv, unsigned char *readable,
+                        afr_read_class_t class, gf_boolean_t *probe)
+{
+    afr_read_stats_t *stats = NULL;
+    int i = 0;
+    int child = -1;
+    uint64_t score = 0;
+    uint64_t least_score = 0;
+    time_t now = gf_time();
+    gf_boolean_t probing = _gf_false;
+
+    for (i = 0; i < priv->child_count; i++) {
+        if (AFR_IS_ARBITER_BRICK(priv, i) || !readable[i])
+            continue;
+
+        stats = &priv->read_stats[i];
+        if (priv->read_probe_interval &&
+            (now - stats->last_chosen[class] >= priv->read_probe_interval)) {
+            child = i;
+            probing = _gf_true;
+            break;
+        }
+
+        score = GF_ATOMIC_GET(stats->ewma_usecs[class]) *
+                (GF_ATOMIC_GET(stats->outstanding[class]) + 1);
+        if (child == -1 || score < least_score) {
+            least_score = score;
+            child = i;
+        }
+    }
+
+    if (child >= 0)
+        priv->read_stats[child].last_chosen[class] = now;
+
+    if (probe)
+        *probe = probing;
+
+    return child;
+}
+
 int
 afr_hash_child(afr_read_subvol_args_t *args, afr_private_t *priv,
                unsigned char *readable)
@@ -2320,6 +2398,10 @@ afr_hash_child(afr_read_subvol_args_t *args, afr_private_t *priv,
         case AFR_READ_POLICY_LOAD_LATENCY_HYBRID:
             child = afr_least_latency_times_pending_reads_child(priv, readable);
             break;
+        case AFR_READ_POLICY_ADAPTIVE_LATENCY:
+            child = afr_adaptive_read_child(priv, readable,
+                                            AFR_READ_CLASS_METADATA, NULL);
+            break;
     }
 
     return child;
@@ -2462,6 +2544,9 @@ afr_local_transaction_cleanup(afr_local_t *local, xlator_t *this)
         GF_FREE(local->transaction.changelog_xdata);
     }
 
+    if (local->transaction.unlock_xdata)
+        dict_unref(local->transaction.unlock_xdata);
+
     GF_FREE(local->transaction.failed_subvols);
 
     GF_FREE(local->transaction.basename);
@@ -3601,6 +3686,7 @@ afr_lookup_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
     if (xdata) {
         ret = dict_get_int8(xdata, "link-count", &need_heal);
         local->replies[child_index].need_heal = need_heal;
+        afr_piggyback_capability_update(this, child_index, xdata);
     } else {
         local->replies[child_index].need_heal = need_heal;
     }
@@ -3800,6 +3886,7 @@ afr_discover_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
     if (xdata) {
         ret = dict_get_int8(xdata, "link-count", &need_heal);
         local->replies[child_index].need_heal = need_heal;
+        afr_piggyback_capability_update(this, child_index, xdata);
     } else {
         local->replies[child_index].need_heal = need_heal;
     }
@@ -4138,6 +4225,7 @@ __afr_fd_ctx_set(xlator_t *this, fd_t *fd)
     }
 
     fd_ctx->readdir_subvol = -1;
+    fd_ctx->read_subvol = -1;
     fd_ctx->lk_heal_info = NULL;
 
     ret = __fd_ctx_set(fd, this, (uint64_t)(long)fd_ctx);
@@ -5667,6 +5755,16 @@ afr_priv_dump(xlator_t *this)
         gf_proc_dump_write(key, "%" PRId64, priv->child_latency[i]);
         sprintf(key, "halo_child_up[%d]", i);
         gf_proc_dump_write(key, "%d", priv->halo_child_up[i]);
+        if (priv->hash_mode != AFR_READ_POLICY_ADAPTIVE_LATENCY)
+            continue;
+        sprintf(key, "read_latency_data[%d]", i);
+        gf_proc_dump_write(
+            key, "%" PRIu64,
+            GF_ATOMIC_GET(priv->read_stats[i].ewma_usecs[AFR_READ_CLASS_DATA]));
+        sprintf(key, "read_latency_metadata[%d]", i);
+        gf_proc_dump_write(key, "%" PRIu64,
+                           GF_ATOMIC_GET(priv->read_stats[i].ewma_usecs
+                                             [AFR_READ_CLASS_METADATA]));
     }
     gf_proc_dump_write("data_self_heal", "%d", priv->data_self_heal);
     gf_proc_dump_write("metadata_self_heal", "%d", priv->metadata_self_heal);
@@ -5679,6 +5777,7 @@ afr_priv_dump(xlator_t *this)
                        priv->background_self_heal_count);
     gf_proc_dump_write("healers", "%d", priv->healers);
     gf_proc_dump_write("read-hash-mode", "%d", priv->hash_mode);
+    gf_proc_dump_write("read-probe-interval", "%u", priv->read_probe_interval);
     gf_proc_dump_write("use-anonymous-inode", "%d", priv->use_anon_inode);
     if (priv->quorum_count == AFR_QUORUM_AUTO) {
         gf_proc_dump_write("quorum-type", "auto");
@@ -6094,6 +6193,8 @@ __afr_handle_child_down_event(xlator_t *this, xlator_t *child_xlator, int idx,
         priv->halo_child_up[idx] = 0;
     }
     priv->child_up[idx] = 0;
+    /* The brick may come back with another version, ask it again */
+    priv->piggyback_capable[idx] = 0;
 
     up_children = __afr_get_up_children_count(priv);
     /*
@@ -6614,7 +6715,8 @@ afr_transaction_local_init(afr_local_t *local, xlator_t *this)
         goto out;
 
     ret = -ENOMEM;
-    local->pre_op_compat = priv->pre_op_compat;
+    local->pre_op_compat = priv->pre_op_compat ||
+                           !afr_changelog_can_piggyback(this, local);
 
     local->transaction.pre_op = GF_CALLOC(sizeof(*local->transaction.pre_op),
                                           priv->child_count, gf_afr_mt_char);
@@ -6678,6 +6780,8 @@ afr_priv_destroy(afr_private_t *priv)
     }
 
     GF_FREE(priv->pending_reads);
+    GF_FREE(priv->read_stats);
+    GF_FREE(priv->piggyback_capable);
     GF_FREE(priv->local);
     GF_FREE(priv->pending_key);
     GF_FREE(priv->children);
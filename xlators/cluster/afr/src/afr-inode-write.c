@@ -1542,6 +1542,77 @@ out:
     return ret;
 }
 
+static int
+afr_shard_bulk_delete_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                          int32_t op_ret, int32_t op_errno, dict_t *xdata)
+{
+    afr_local_t *local = NULL;
+    int call_count = 0;
+
+    local = frame->local;
+
+    /* A brick not knowing the request stores it as an xattr instead */
+    if ((op_ret == 0) &&
+        (!xdata || !dict_get_sizen(xdata, GF_XATTR_SHARD_BULK_DELETE))) {
+        op_ret = -1;
+        op_errno = EOPNOTSUPP;
+    }
+
+    LOCK(&frame->lock);
+    {
+        if (op_ret < 0) {
+            local->op_ret = op_ret;
+            local->op_errno = op_errno;
+        }
+    }
+    UNLOCK(&frame->lock);
+
+    call_count = afr_frame_return(frame);
+    if (call_count == 0)
+        AFR_STACK_UNWIND(setxattr, frame, local->op_ret, local->op_errno,
+                         (local->op_ret == 0) ? xdata : NULL);
+
+    return 0;
+}
+
+/* Shard removes the shards of a deleted file directly on the bricks. This is
+ * not replicated as a transaction: it only succeeds if every brick deleted
+ * its copies, otherwise shard falls back to unlinking them one by one,
+ * which self-heal then tracks as usual. */
+static int
+afr_handle_shard_bulk_delete(xlator_t *this, call_frame_t *frame, loc_t *loc,
+                             dict_t *dict)
+{
+    afr_private_t *priv = this->private;
+    afr_local_t *local = NULL;
+    int op_errno = ENOTCONN;
+    int i = 0;
+
+    if (!dict_get_sizen(dict, GF_XATTR_SHARD_BULK_DELETE))
+        return -1;
+
+    if (AFR_COUNT(priv->child_up, priv->child_count) != priv->child_count)
+        goto out;
+
+    local = AFR_FRAME_INIT(frame, op_errno);
+    if (!local)
+        goto out;
+
+    local->op_ret = 0;
+    local->op_errno = 0;
+    for (i = 0; i < priv->child_count; i++) {
+        STACK_WIND_COOKIE(frame, afr_shard_bulk_delete_cbk,
+                          (void *)(long)i, priv->children[i],
+                          priv->children[i]->fops->setxattr, loc, dict, 0,
+                          NULL);
+    }
+    return 0;
+
+out:
+    AFR_STACK_UNWIND(setxattr, frame, -1, op_errno, NULL);
+    return 0;
+}
+
 static int
 afr_handle_special_xattr(xlator_t *this, call_frame_t *frame, loc_t *loc,
                          dict_t *dict)
@@ -1556,6 +1627,10 @@ afr_handle_special_xattr(xlator_t *this, call_frame_t *frame, loc_t *loc,
     if (ret == 0)
         goto out;
 
+    ret = afr_handle_shard_bulk_delete(this, frame, loc, dict);
+    if (ret == 0)
+        goto out;
+
     /* Applicable for replace-brick and add-brick commands */
     ret = afr_handle_empty_brick(this, frame, loc, dict);
 out:
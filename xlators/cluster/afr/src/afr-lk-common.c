@@ -324,6 +324,7 @@ afr_internal_lock_wind(call_frame_t *frame,
     struct gf_flock flock = {
         0,
     };
+    dict_t *xdata = NULL;
 
     switch (local->transaction.type) {
         case AFR_ENTRY_TRANSACTION:
@@ -362,16 +363,19 @@ afr_internal_lock_wind(call_frame_t *frame,
                 cmd1 = F_SETLKW;
             }
 
+            if (unlock)
+                xdata = local->transaction.unlock_xdata;
+
             if (local->fd) {
                 STACK_WIND_COOKIE(
                     frame, cbk, cookie, priv->children[child],
                     priv->children[child]->fops->finodelk, int_lock->domain,
-                    int_lock->lockee[lockee_num].fd, cmd1, &flock, NULL);
+                    int_lock->lockee[lockee_num].fd, cmd1, &flock, xdata);
             } else {
                 STACK_WIND_COOKIE(
                     frame, cbk, cookie, priv->children[child],
                     priv->children[child]->fops->inodelk, int_lock->domain,
-                    &int_lock->lockee[lockee_num].loc, cmd1, &flock, NULL);
+                    &int_lock->lockee[lockee_num].loc, cmd1, &flock, xdata);
             }
             break;
     }
@@ -33,6 +33,10 @@ enum gf_afr_mem_types_ {
     gf_afr_mt_atomic_t,
     gf_afr_mt_lk_heal_info_t,
     gf_afr_mt_gf_lock,
+    gf_afr_mt_read_stats_t,
+    gf_afr_mt_sh_block_t,
+    gf_afr_mt_sh_write_t,
+    gf_afr_mt_shd_queue_t,
     gf_afr_mt_end
 };
 #endif
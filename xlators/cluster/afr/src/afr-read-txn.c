@@ -12,22 +12,133 @@
 #include "afr-transaction.h"
 #include "afr-messages.h"
 
+static afr_read_class_t
+afr_read_class_get(afr_local_t *local)
+{
+    switch (local->op) {
+        case GF_FOP_READ:
+        case GF_FOP_SEEK:
+            return AFR_READ_CLASS_DATA;
+        default:
+            return AFR_READ_CLASS_METADATA;
+    }
+}
+
 void
-afr_pending_read_increment(afr_private_t *priv, int child_index)
+afr_pending_read_increment(afr_private_t *priv, afr_local_t *local,
+                           int child_index)
 {
+    afr_read_stats_t *stats = NULL;
+
     if (child_index < 0 || child_index > priv->child_count)
         return;
 
     GF_ATOMIC_INC(priv->pending_reads[child_index]);
+
+    if (priv->hash_mode != AFR_READ_POLICY_ADAPTIVE_LATENCY)
+        return;
+
+    stats = &priv->read_stats[child_index];
+    local->read_class = afr_read_class_get(local);
+    local->read_timed = _gf_true;
+    GF_ATOMIC_INC(stats->outstanding[local->read_class]);
+    timespec_now(&local->read_start);
 }
 
 void
-afr_pending_read_decrement(afr_private_t *priv, int child_index)
+afr_pending_read_decrement(afr_private_t *priv, afr_local_t *local,
+                           int child_index)
 {
+    afr_read_stats_t *stats = NULL;
+    struct timespec now;
+    uint64_t sample = 0;
+    uint64_t ewma = 0;
+    uint64_t next = 0;
+
     if (child_index < 0 || child_index > priv->child_count)
         return;
 
     GF_ATOMIC_DEC(priv->pending_reads[child_index]);
+
+    if (!local->read_timed)
+        return;
+
+    local->read_timed = _gf_false;
+    stats = &priv->read_stats[child_index];
+    GF_ATOMIC_DEC(stats->outstanding[local->read_class]);
+
+    timespec_now(&now);
+    sample = gf_tsdiff(&local->read_start, &now) / 1000;
+
+    /* Same smoothing factor (1/8) as TCP uses for its RTT estimation. */
+    do {
+        ewma = GF_ATOMIC_GET(stats->ewma_usecs[local->read_class]);
+        if (ewma == 0)
+            next = sample;
+        else
+            next = ewma - (ewma >> 3) + (sample >> 3);
+    } while (
+        !GF_ATOMIC_CMP_SWAP(stats->ewma_usecs[local->read_class], ewma, next));
+    GF_ATOMIC_INC(stats->samples[local->read_class]);
+}
+
+/* Data reads through an fd keep using the same child for a while, so that
+ * read-ahead on the brick is not defeated by spreading sequential reads
+ * over several bricks. A probe is a one-off read and does not stick. */
+static int
+afr_read_txn_adaptive_subvol(call_frame_t *frame, xlator_t *this)
+{
+    afr_local_t *local = frame->local;
+    afr_private_t *priv = this->private;
+    afr_fd_ctx_t *fd_ctx = NULL;
+    afr_read_class_t class = afr_read_class_get(local);
+    time_t now = 0;
+    int subvol = -1;
+    gf_boolean_t probe = _gf_false;
+
+    if (class != AFR_READ_CLASS_DATA || !local->fd)
+        return afr_adaptive_read_child(priv, local->readable, class, NULL);
+
+    fd_ctx = afr_fd_ctx_get(local->fd, this);
+    if (!fd_ctx)
+        return afr_adaptive_read_child(priv, local->readable, class, NULL);
+
+    now = gf_time();
+    LOCK(&local->fd->lock);
+    {
+        subvol = fd_ctx->read_subvol;
+        if ((subvol < 0) || !local->readable[subvol] ||
+            (now - fd_ctx->read_subvol_time >= AFR_READ_STICKY_SECS)) {
+            subvol = afr_adaptive_read_child(priv, local->readable, class,
+                                             &probe);
+            if (!probe) {
+                fd_ctx->read_subvol = subvol;
+                fd_ctx->read_subvol_time = now;
+            }
+        }
+    }
+    UNLOCK(&local->fd->lock);
+
+    return subvol;
+}
+
+static int
+afr_read_txn_select_subvol(call_frame_t *frame, xlator_t *this,
+                           inode_t *inode)
+{
+    afr_local_t *local = frame->local;
+    afr_private_t *priv = this->private;
+    int subvol = -1;
+
+    if ((priv->hash_mode == AFR_READ_POLICY_ADAPTIVE_LATENCY) &&
+        !(priv->read_child >= 0 && local->readable[priv->read_child])) {
+        subvol = afr_read_txn_adaptive_subvol(frame, this);
+        if (subvol >= 0 && local->readable[subvol])
+            return subvol;
+    }
+
+    return afr_read_subvol_select_by_policy(inode, this, local->readable,
+                                            NULL);
 }
 
 void
@@ -39,9 +150,9 @@ afr_read_txn_wind(call_frame_t *frame, xlator_t *this, int subvol)
     local = frame->local;
     priv = this->private;
 
-    afr_pending_read_decrement(priv, local->read_subvol);
+    afr_pending_read_decrement(priv, local, local->read_subvol);
     local->read_subvol = subvol;
-    afr_pending_read_increment(priv, subvol);
+    afr_pending_read_increment(priv, local, subvol);
     local->readfn(frame, this, subvol);
 }
 
@@ -288,8 +399,7 @@ afr_read_txn_refresh_done(call_frame_t *frame, xlator_t *this, int err)
         return 0;
     }
 
-    read_subvol = afr_read_subvol_select_by_policy(inode, this, local->readable,
-                                                   NULL);
+    read_subvol = afr_read_txn_select_subvol(frame, this, inode);
     if (read_subvol == -1) {
         err = EIO;
         goto readfn;
@@ -460,8 +570,7 @@ afr_read_txn(call_frame_t *frame, xlator_t *this, inode_t *inode,
            of copies */
         goto refresh;
 
-    read_subvol = afr_read_subvol_select_by_policy(inode, this, local->readable,
-                                                   NULL);
+    read_subvol = afr_read_txn_select_subvol(frame, this, inode);
 
     if (read_subvol < 0 || read_subvol > priv->child_count) {
         gf_msg_debug(this->name, 0,
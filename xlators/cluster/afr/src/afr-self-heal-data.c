@@ -16,6 +16,61 @@
 #include <glusterfs/events.h>
 
 #define HAS_HOLES(i) ((i->ia_blocks * 512) < (i->ia_size))
+
+/* With data-self-heal-checksum=fast, blocks of AFR_SH_FAST_BLOCK_SIZE are
+ * compared, AFR_SH_FAST_BATCH_BLOCKS of them per rchecksum. */
+#define AFR_SH_FAST_BLOCK_SIZE (128 * 1024)
+#define AFR_SH_FAST_BATCH_BLOCKS 64
+
+typedef enum {
+    AFR_SH_BLOCK_FREE,
+    AFR_SH_BLOCK_READING,
+    AFR_SH_BLOCK_READ,
+    AFR_SH_BLOCK_WRITING,
+    AFR_SH_BLOCK_WRITTEN,
+} afr_sh_block_state_t;
+
+typedef struct afr_sh_pipe afr_sh_pipe_t;
+typedef struct afr_sh_block afr_sh_block_t;
+
+typedef struct {
+    afr_sh_block_t *block;
+    int sink;
+    int op_ret;
+} afr_sh_write_t;
+
+/* A slot of the heal pipeline, holding one block from its read to the end
+ * of its writes */
+struct afr_sh_block {
+    afr_sh_pipe_t *pipe;
+    afr_sh_block_state_t state;
+    off_t offset;
+    size_t size;
+    int op_ret;
+    struct iovec *vector;
+    int count;
+    struct iobref *iobref;
+    afr_sh_write_t *writes; /* one per child */
+    int nwrites;
+    int pending; /* writes in flight */
+};
+
+/* The callbacks change the state of the blocks under lock, and ring the
+ * barrier for the synctask driving the pipeline to look at them */
+struct afr_sh_pipe {
+    gf_lock_t lock;
+    struct syncbarrier barrier;
+};
+
+/* With granular-data-heal, the regions written while the sinks were bad,
+ * as recorded by the index xlator of the source brick. */
+typedef struct {
+    dict_t *xattr;
+    unsigned char *bitmap;
+    size_t len;
+    uint32_t region_size;
+} afr_sh_dirty_regions_t;
+
 static int
 __checksum_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
                int op_errno, uint32_t weak, uint8_t *strong, dict_t *xdata)
@@ -116,6 +171,124 @@ out:
     return _gf_false;
 }
 
+static int
+__fast_checksum_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                    int op_ret, int op_errno, uint32_t weak, uint8_t *strong,
+                    dict_t *xdata)
+{
+    afr_local_t *local = frame->local;
+    int i = (long)cookie;
+
+    local->replies[i].valid = 1;
+    local->replies[i].op_ret = op_ret;
+    local->replies[i].op_errno = op_errno;
+    if (xdata)
+        local->replies[i].xdata = dict_ref(xdata);
+
+    syncbarrier_wake(&local->barrier);
+    return 0;
+}
+
+/* Returns the number of fast checksums in the reply, or -1 if the brick did
+ * not compute them. */
+static int
+__afr_fast_checksums_get(struct afr_reply *reply, uint64_t **sums,
+                         char **zeroes)
+{
+    data_t *data = NULL;
+    int count = 0;
+
+    if (!reply->valid || reply->op_ret != 0 || !reply->xdata ||
+        !dict_get_sizen(reply->xdata, GF_RCHECKSUM_FAST_BLOCK_SIZE))
+        return -1;
+
+    data = dict_get_sizen(reply->xdata, GF_RCHECKSUM_FAST_SUMS);
+    if (data) {
+        *sums = (uint64_t *)data->data;
+        count = data->len / sizeof(uint64_t);
+    }
+
+    if (zeroes) {
+        data = dict_get_sizen(reply->xdata, GF_RCHECKSUM_FAST_ZEROES);
+        *zeroes = (data && data->len >= count) ? data->data : NULL;
+    }
+
+    return count;
+}
+
+/* Marks in dirty[] the blocks of [offset, offset + size) that need to be
+ * copied from source to the sinks and returns how many blocks the source
+ * has in that range. Returns -1 if the source or a sink could not compute
+ * fast checksums, in which case the caller falls back to strong ones. */
+static int
+__afr_selfheal_data_fast_checksums(call_frame_t *frame, xlator_t *this,
+                                   fd_t *fd, int source,
+                                   unsigned char *healed_sinks, off_t offset,
+                                   size_t size, struct iatt *poststat,
+                                   unsigned char *dirty)
+{
+    afr_private_t *priv = this->private;
+    afr_local_t *local = frame->local;
+    unsigned char *wind_subvols = NULL;
+    uint64_t *source_sums = NULL;
+    uint64_t *sums = NULL;
+    char *zeroes = NULL;
+    dict_t *xdata = NULL;
+    int nblocks = -1;
+    int count = 0;
+    int i = 0;
+    int j = 0;
+
+    xdata = dict_new();
+    if (!xdata)
+        return -1;
+    if (dict_set_uint32(xdata, GF_RCHECKSUM_FAST_BLOCK_SIZE,
+                        AFR_SH_FAST_BLOCK_SIZE) ||
+        dict_set_int32_sizen(xdata, "check-zero-filled", 1)) {
+        dict_unref(xdata);
+        return -1;
+    }
+
+    wind_subvols = alloca0(priv->child_count);
+    for (i = 0; i < priv->child_count; i++) {
+        if (i == source || healed_sinks[i])
+            wind_subvols[i] = 1;
+    }
+
+    AFR_ONLIST(wind_subvols, frame, __fast_checksum_cbk, rchecksum, fd, offset,
+               size, xdata);
+    dict_unref(xdata);
+
+    nblocks = __afr_fast_checksums_get(&local->replies[source], &source_sums,
+                                       &zeroes);
+    if (nblocks < 0)
+        return -1;
+
+    /* For non-sparse files, we might be better off writing the zeroes to
+     * sinks to avoid mismatch of disk-usage in bricks. */
+    for (j = 0; j < nblocks; j++)
+        dirty[j] = (!HAS_HOLES(poststat) && zeroes && zeroes[j]);
+
+    for (i = 0; i < priv->child_count; i++) {
+        if (!healed_sinks[i])
+            continue;
+        if (!local->replies[i].valid || local->replies[i].op_ret != 0) {
+            /* Let the writes decide whether this sink is still good. */
+            memset(dirty, 1, nblocks);
+            continue;
+        }
+        count = __afr_fast_checksums_get(&local->replies[i], &sums, NULL);
+        if (count < 0)
+            return -1;
+        for (j = 0; j < nblocks; j++) {
+            if (j >= count || sums[j] != source_sums[j])
+                dirty[j] = 1;
+        }
+    }
+
+    return nblocks;
+}
+
 static gf_boolean_t
 __afr_is_sink_zero_filled(xlator_t *this, fd_t *fd, size_t size, off_t offset,
                           int sink)
@@ -143,6 +316,53 @@ out:
     return zero_filled;
 }
 
+static gf_boolean_t
+__afr_selfheal_data_skip_sink(xlator_t *this, fd_t *fd, int source, int sink,
+                              off_t offset, size_t size, struct iovec *iovec,
+                              int count, struct afr_reply *replies, int type)
+{
+    /*
+     * TODO: Use fiemap() and discard() to heal holes
+     * in the future.
+     *
+     * For now,
+     *
+     * - if the source had any holes at all,
+     * AND
+     * - if we are writing past the original file size
+     *   of the sink
+     * AND
+     * - is NOT the last block of the source file. if
+     *   the block contains EOF, it has to be written
+     *   in order to set the file size even if the
+     *   last block is 0-filled.
+     * AND
+     * - if the read buffer is filled with only 0's
+     *
+     * then, skip writing to this source. We don't depend
+     * on the write to happen to update the size as we
+     * have performed an ftruncate() upfront anyways.
+     */
+#define is_last_block(o, b, s) ((s >= o) && (s <= (o + b)))
+    if (HAS_HOLES((&replies[source].poststat)) &&
+        offset >= replies[sink].poststat.ia_size &&
+        !is_last_block(offset, size, replies[source].poststat.ia_size) &&
+        (iov_0filled(iovec, count) == 0))
+        return _gf_true;
+
+    /* Avoid filling up sparse regions of the sink with 0-filled
+     * writes.*/
+    if (type == AFR_SELFHEAL_DATA_FULL &&
+        HAS_HOLES((&replies[source].poststat)) &&
+        ((offset + size) <= replies[sink].poststat.ia_size) &&
+        (iov_0filled(iovec, count) == 0) &&
+        __afr_is_sink_zero_filled(this, fd, size, offset, sink)) {
+        return _gf_true;
+    }
+
+    return _gf_false;
+}
+
 static int
 __afr_selfheal_data_read_write(call_frame_t *frame, xlator_t *this, fd_t *fd,
                                int source, unsigned char *healed_sinks,
@@ -167,45 +387,10 @@ __afr_selfheal_data_read_write(call_frame_t *frame, xlator_t *this, fd_t *fd,
         if (!healed_sinks[i])
             continue;
 
-            /*
-             * TODO: Use fiemap() and discard() to heal holes
-             * in the future.
-             *
-             * For now,
-             *
-             * - if the source had any holes at all,
-             * AND
-             * - if we are writing past the original file size
-             *   of the sink
-             * AND
-             * - is NOT the last block of the source file. if
-             *   the block contains EOF, it has to be written
-             *   in order to set the file size even if the
-             *   last block is 0-filled.
-             * AND
-             * - if the read buffer is filled with only 0's
-             *
-             * then, skip writing to this source. We don't depend
-             * on the write to happen to update the size as we
-             * have performed an ftruncate() upfront anyways.
-             */
-#define is_last_block(o, b, s) ((s >= o) && (s <= (o + b)))
-        if (HAS_HOLES((&replies[source].poststat)) &&
-            offset >= replies[i].poststat.ia_size &&
-            !is_last_block(offset, size, replies[source].poststat.ia_size) &&
-            (iov_0filled(iovec, count) == 0))
+        if (__afr_selfheal_data_skip_sink(this, fd, source, i, offset, size,
+                                          iovec, count, replies, type))
             continue;
 
-        /* Avoid filling up sparse regions of the sink with 0-filled
-         * writes.*/
-        if (type == AFR_SELFHEAL_DATA_FULL &&
-            HAS_HOLES((&replies[source].poststat)) &&
-            ((offset + size) <= replies[i].poststat.ia_size) &&
-            (iov_0filled(iovec, count) == 0) &&
-            __afr_is_sink_zero_filled(this, fd, size, offset, i)) {
-            continue;
-        }
-
         ret = syncop_writev(priv->children[i], fd, iovec, count, offset, iobref,
                             0, NULL, NULL, NULL, NULL);
         if (ret != iov_length(iovec, count)) {
@@ -283,6 +468,378 @@ unlock:
     return ret;
 }
 
+static int
+__afr_sh_block_readv_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                         int32_t op_ret, int32_t op_errno, struct iovec *vector,
+                         int32_t count, struct iatt *stbuf,
+                         struct iobref *iobref, dict_t *xdata)
+{
+    afr_sh_block_t *block = cookie;
+    afr_sh_pipe_t *pipe = block->pipe;
+
+    LOCK(&pipe->lock);
+    {
+        block->op_ret = (op_ret < 0) ? -op_errno : op_ret;
+        if (op_ret > 0) {
+            block->vector = iov_dup(vector, count);
+            block->count = count;
+            block->iobref = iobref_ref(iobref);
+            if (!block->vector)
+                block->op_ret = -ENOMEM;
+        }
+        block->state = AFR_SH_BLOCK_READ;
+        syncbarrier_wake(&pipe->barrier);
+    }
+    UNLOCK(&pipe->lock);
+
+    return 0;
+}
+
+static int
+__afr_sh_block_writev_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                          int32_t op_ret, int32_t op_errno,
+                          struct iatt *prebuf, struct iatt *postbuf,
+                          dict_t *xdata)
+{
+    afr_sh_write_t *write = cookie;
+    afr_sh_block_t *block = write->block;
+    afr_sh_pipe_t *pipe = block->pipe;
+
+    LOCK(&pipe->lock);
+    {
+        write->op_ret = op_ret;
+        if (--block->pending == 0) {
+            block->state = AFR_SH_BLOCK_WRITTEN;
+            syncbarrier_wake(&pipe->barrier);
+        }
+    }
+    UNLOCK(&pipe->lock);
+
+    return 0;
+}
+
+static void
+__afr_sh_block_reset(afr_sh_block_t *block)
+{
+    GF_FREE(block->vector);
+    block->vector = NULL;
+    if (block->iobref)
+        iobref_unref(block->iobref);
+    block->iobref = NULL;
+    block->count = 0;
+    block->nwrites = 0;
+    block->state = AFR_SH_BLOCK_FREE;
+}
+
+/* Winds the writes of a block just read to the sinks that need it. Returns
+ * the number of writes wound. */
+static int
+__afr_sh_block_write(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                     int source, unsigned char *healed_sinks,
+                     afr_sh_block_t *block, struct afr_reply *replies, int type)
+{
+    afr_private_t *priv = this->private;
+    afr_sh_pipe_t *pipe = block->pipe;
+    afr_sh_write_t *write = NULL;
+    int i = 0;
+
+    block->nwrites = 0;
+    for (i = 0; i < priv->child_count; i++) {
+        if (!healed_sinks[i])
+            continue;
+        if (__afr_selfheal_data_skip_sink(this, fd, source, i, block->offset,
+                                          block->size, block->vector,
+                                          block->count, replies, type))
+            continue;
+        write = &block->writes[block->nwrites++];
+        write->block = block;
+        write->sink = i;
+        write->op_ret = -1;
+    }
+
+    if (!block->nwrites)
+        return 0;
+
+    /* Set before the first write can complete */
+    LOCK(&pipe->lock);
+    {
+        block->pending = block->nwrites;
+        block->state = AFR_SH_BLOCK_WRITING;
+    }
+    UNLOCK(&pipe->lock);
+
+    for (i = 0; i < block->nwrites; i++) {
+        write = &block->writes[i];
+        STACK_WIND_COOKIE(frame, __afr_sh_block_writev_cbk, write,
+                          priv->children[write->sink],
+                          priv->children[write->sink]->fops->writev, fd,
+                          block->vector, block->count, block->offset, 0,
+                          block->iobref, NULL);
+    }
+
+    return block->nwrites;
+}
+
+/* Copies the blocks marked in dirty[] from source to the sinks, with up to
+ * data-self-heal-window-size blocks in flight. A block whose writes are done
+ * frees its slot for the read of the next one, so that reads and writes
+ * overlap. */
+static int
+__afr_selfheal_data_pipeline(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                             int source, unsigned char *healed_sinks,
+                             off_t offset, unsigned char *dirty, int nblocks,
+                             struct afr_reply *replies, int type)
+{
+    afr_private_t *priv = this->private;
+    afr_sh_pipe_t pipe;
+    afr_sh_block_t *blocks = NULL;
+    afr_sh_block_t *block = NULL;
+    afr_sh_write_t *writes = NULL;
+    afr_sh_block_state_t *states = NULL;
+    int window = priv->data_self_heal_window_size;
+    int inflight = 0;
+    int next = 0;
+    int ret = 0;
+    int i = 0;
+    int j = 0;
+
+    blocks = GF_CALLOC(window, sizeof(*blocks), gf_afr_mt_sh_block_t);
+    writes = GF_CALLOC(window * priv->child_count, sizeof(*writes),
+                       gf_afr_mt_sh_write_t);
+    states = alloca0(window * sizeof(*states));
+    if (!blocks || !writes) {
+        ret = -ENOMEM;
+        goto out;
+    }
+
+    LOCK_INIT(&pipe.lock);
+    if (syncbarrier_init(&pipe.barrier)) {
+        LOCK_DESTROY(&pipe.lock);
+        ret = -ENOMEM;
+        goto out;
+    }
+
+    for (i = 0; i < window; i++) {
+        blocks[i].pipe = &pipe;
+        blocks[i].writes = &writes[i * priv->child_count];
+        blocks[i].state = AFR_SH_BLOCK_FREE;
+    }
+
+    for (;;) {
+        /* Refill the free slots, unless healing has to stop */
+        for (i = 0; i < window && ret == 0; i++) {
+            block = &blocks[i];
+            if (block->state != AFR_SH_BLOCK_FREE)
+                continue;
+            while (next < nblocks && !dirty[next])
+                next++;
+            if (next >= nblocks)
+                break;
+
+            block->offset = offset + (off_t)next * AFR_SH_FAST_BLOCK_SIZE;
+            block->size = AFR_SH_FAST_BLOCK_SIZE;
+            block->op_ret = 0;
+            block->state = AFR_SH_BLOCK_READING;
+            next++;
+            inflight++;
+            STACK_WIND_COOKIE(frame, __afr_sh_block_readv_cbk, block,
+                              priv->children[source],
+                              priv->children[source]->fops->readv, fd,
+                              block->size, block->offset, 0, NULL);
+        }
+
+        if (!inflight)
+            break;
+
+        syncbarrier_wait(&pipe.barrier, 1);
+
+        LOCK(&pipe.lock);
+        {
+            for (i = 0; i < window; i++)
+                states[i] = blocks[i].state;
+        }
+        UNLOCK(&pipe.lock);
+
+        for (i = 0; i < window; i++) {
+            block = &blocks[i];
+            if (states[i] == AFR_SH_BLOCK_READ) {
+                if (block->op_ret < 0 && ret == 0)
+                    ret = block->op_ret;
+                if (block->op_ret > 0 && ret == 0 &&
+                    __afr_sh_block_write(frame, this, fd, source,
+                                         healed_sinks, block, replies, type))
+                    continue;
+            } else if (states[i] == AFR_SH_BLOCK_WRITTEN) {
+                for (j = 0; j < block->nwrites; j++) {
+                    /* write() failed on this sink. Do NOT consider it as
+                     * successfully healed. */
+                    if (block->writes[j].op_ret !=
+                        iov_length(block->vector, block->count))
+                        healed_sinks[block->writes[j].sink] = 0;
+                }
+            } else {
+                continue;
+            }
+
+            __afr_sh_block_reset(block);
+            inflight--;
+        }
+
+        if (ret == 0 && AFR_COUNT(healed_sinks, priv->child_count) == 0)
+            ret = -ENOTCONN;
+    }
+
+    /* Every callback rang the barrier under the lock, none is left */
+    syncbarrier_destroy(&pipe.barrier);
+    LOCK_DESTROY(&pipe.lock);
+
+out:
+    GF_FREE(blocks);
+    GF_FREE(writes);
+    return ret;
+}
+
+/* data-self-heal-checksum=fast: one rchecksum returns the checksums of every
+ * block in the range, and only the blocks that differ are copied. */
+static int
+afr_selfheal_data_fast_batch(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                             int source, unsigned char *healed_sinks,
+                             off_t offset, size_t size, int type,
+                             struct afr_reply *replies)
+{
+    afr_private_t *priv = this->private;
+    unsigned char *data_lock = NULL;
+    unsigned char dirty[AFR_SH_FAST_BATCH_BLOCKS] = {
+        0,
+    };
+    off_t off = 0;
+    int nblocks = 0;
+    int ret = -1;
+
+    data_lock = alloca0(priv->child_count);
+
+    gf_msg_debug(this->name, 0, "gfid:%s, offset=%jd, size=%zu",
+                 uuid_utoa(fd->inode->gfid), offset, size);
+
+    ret = afr_selfheal_inodelk(frame, this, fd->inode, this->name, offset, size,
+                               data_lock);
+    {
+        if (!afr_source_sinks_locked(this, data_lock, source, healed_sinks)) {
+            ret = -ENOTCONN;
+            goto unlock;
+        }
+
+        nblocks = __afr_selfheal_data_fast_checksums(
+            frame, this, fd, source, healed_sinks, offset, size,
+            &replies[source].poststat, dirty);
+        if (nblocks >= 0) {
+            ret = __afr_selfheal_data_pipeline(frame, this, fd, source,
+                                               healed_sinks, offset, dirty,
+                                               nblocks, replies, type);
+            goto unlock;
+        }
+
+        /* Some brick can't compute fast checksums, use the strong ones. */
+        ret = 0;
+        for (off = offset; off < offset + size;
+             off += AFR_SH_FAST_BLOCK_SIZE) {
+            if (off >= replies[source].poststat.ia_size)
+                break;
+            if (__afr_can_skip_data_block_heal(
+                    frame, this, fd, source, healed_sinks, off,
+                    AFR_SH_FAST_BLOCK_SIZE, &replies[source].poststat))
+                continue;
+            ret = __afr_selfheal_data_read_write(
+                frame, this, fd, source, healed_sinks, off,
+                AFR_SH_FAST_BLOCK_SIZE, replies, type);
+            if (ret < 0)
+                break;
+        }
+    }
+unlock:
+    afr_selfheal_uninodelk(frame, this, fd->inode, this->name, offset, size,
+                           data_lock);
+    return ret;
+}
+
+static void
+afr_selfheal_data_dirty_regions_get(xlator_t *this, fd_t *fd, int source,
+                                    struct afr_reply *replies,
+                                    afr_sh_dirty_regions_t *regions)
+{
+    afr_private_t *priv = this->private;
+    loc_t loc = {
+        0,
+    };
+    dict_t *xattr = NULL;
+    data_t *data = NULL;
+    int *dirty = NULL;
+    int idx = afr_index_for_transaction_type(AFR_DATA_TRANSACTION);
+    int ret = 0;
+    int i = 0;
+
+    if (!priv->dsh_granular)
+        return;
+
+    /* A dirty data changelog means a write may have reached some bricks
+     * without its post-op recording the region. */
+    dirty = alloca0(priv->child_count * sizeof(*dirty));
+    for (i = 0; i < priv->child_count; i++) {
+        if (!replies[i].valid || replies[i].op_ret != 0 || !replies[i].xdata)
+            continue;
+        afr_selfheal_fill_dirty(this, dirty, i, idx, replies[i].xdata);
+        if (dirty[i])
+            return;
+    }
+
+    loc.inode = inode_ref(fd->inode);
+    gf_uuid_copy(loc.gfid, fd->inode->gfid);
+    ret = syncop_getxattr(priv->children[source], &loc, &xattr,
+                          GF_XATTROP_DIRTY_REGIONS, NULL, NULL);
+    loc_wipe(&loc);
+    if (ret < 0)
+        goto out;
+
+    data = dict_get_sizen(xattr, GF_XATTROP_DIRTY_REGIONS);
+    if (!data || data->len < sizeof(uint32_t))
+        goto out;
+
+    regions->region_size = ntoh32(*(uint32_t *)data->data);
+    if (!regions->region_size)
+        goto out;
+    regions->bitmap = (unsigned char *)data->data + sizeof(uint32_t);
+    regions->len = data->len - sizeof(uint32_t);
+    regions->xattr = xattr;
+    xattr = NULL;
+
+    gf_msg_debug(this->name, 0, "%s: healing only dirty regions of %u bytes",
+                 uuid_utoa(fd->inode->gfid), regions->region_size);
+out:
+    if (xattr)
+        dict_unref(xattr);
+}
+
+static gf_boolean_t
+afr_selfheal_data_range_is_dirty(afr_sh_dirty_regions_t *regions, off_t offset,
+                                 size_t size)
+{
+    uint64_t bit = 0;
+    uint64_t last = 0;
+
+    if (!regions->xattr)
+        return _gf_true;
+
+    last = (offset + size - 1) / regions->region_size;
+    for (bit = offset / regions->region_size; bit <= last; bit++) {
+        if (bit / 8 >= regions->len)
+            break;
+        if (regions->bitmap[bit / 8] & (1 << (bit % 8)))
+            return _gf_true;
+    }
+
+    return _gf_false;
+}
+
 static int
 afr_selfheal_data_fsync(call_frame_t *frame, xlator_t *this, fd_t *fd,
                         unsigned char *healed_sinks)
@@ -333,7 +890,8 @@ afr_data_self_heal_type_get(afr_private_t *priv, unsigned char *healed_sinks,
 
 static int
 afr_selfheal_data_do(call_frame_t *frame, xlator_t *this, fd_t *fd, int source,
-                     unsigned char *healed_sinks, struct afr_reply *replies)
+                     unsigned char *healed_sinks, struct afr_reply *replies,
+                     afr_sh_dirty_regions_t *regions)
 {
     afr_private_t *priv = NULL;
     off_t off = 0;
@@ -342,6 +900,7 @@ afr_selfheal_data_do(call_frame_t *frame, xlator_t *this, fd_t *fd, int source,
     int ret = -1;
     call_frame_t *iter_frame = NULL;
     unsigned char arbiter_sink_status = 0;
+    gf_boolean_t fast = _gf_false;
 
     gf_msg(this->name, GF_LOG_INFO, 0, AFR_MSG_SELF_HEAL_INFO,
            "performing data selfheal on %s", uuid_utoa(fd->inode->gfid));
@@ -361,6 +920,10 @@ afr_selfheal_data_do(call_frame_t *frame, xlator_t *this, fd_t *fd, int source,
     }
 
     type = afr_data_self_heal_type_get(priv, healed_sinks, source, replies);
+    fast = (type == AFR_SELFHEAL_DATA_DIFF &&
+            priv->data_self_heal_fast_checksum);
+    if (fast)
+        block = AFR_SH_FAST_BLOCK_SIZE * AFR_SH_FAST_BATCH_BLOCKS;
 
     iter_frame = afr_copy_frame(frame);
     if (!iter_frame) {
@@ -374,8 +937,17 @@ afr_selfheal_data_do(call_frame_t *frame, xlator_t *this, fd_t *fd, int source,
             goto out;
         }
 
-        ret = afr_selfheal_data_block(iter_frame, this, fd, source,
-                                      healed_sinks, off, block, type, replies);
+        if (!afr_selfheal_data_range_is_dirty(regions, off, block))
+            continue;
+
+        if (fast)
+            ret = afr_selfheal_data_fast_batch(iter_frame, this, fd, source,
+                                               healed_sinks, off, block, type,
+                                               replies);
+        else
+            ret = afr_selfheal_data_block(iter_frame, this, fd, source,
+                                          healed_sinks, off, block, type,
+                                          replies);
         if (ret < 0)
             goto out;
 
@@ -674,6 +1246,9 @@ __afr_selfheal_data(call_frame_t *frame, xlator_t *this, fd_t *fd,
     gf_boolean_t did_sh = _gf_true;
     gf_boolean_t is_arbiter_the_only_sink = _gf_false;
     gf_boolean_t empty_file = _gf_false;
+    afr_sh_dirty_regions_t regions = {
+        0,
+    };
 
     priv = this->private;
 
@@ -734,6 +1309,9 @@ __afr_selfheal_data(call_frame_t *frame, xlator_t *this, fd_t *fd,
             is_arbiter_the_only_sink = _gf_true;
             goto restore_time;
         }
+
+        afr_selfheal_data_dirty_regions_get(this, fd, source, locked_replies,
+                                            &regions);
         ret = 0;
     }
 unlock:
@@ -745,7 +1323,7 @@ unlock:
         goto out;
 
     ret = afr_selfheal_data_do(frame, this, fd, source, healed_sinks,
-                               locked_replies);
+                               locked_replies, &regions);
     if (ret)
         goto out;
 restore_time:
@@ -776,6 +1354,8 @@ out:
 
     if (locked_replies)
         afr_replies_wipe(locked_replies, priv->child_count);
+    if (regions.xattr)
+        dict_unref(regions.xattr);
 
     return ret;
 }
@@ -207,6 +207,10 @@ int
 afr_selfheal_extract_xattr(xlator_t *this, struct afr_reply *replies,
                            afr_transaction_type type, int *dirty, int **matrix);
 
+int
+afr_selfheal_fill_dirty(xlator_t *this, int *dirty, int subvol, int idx,
+                        dict_t *xdata);
+
 int
 afr_sh_generic_fop_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
                        int op_ret, int op_errno, struct iatt *pre,
@@ -18,6 +18,8 @@
 
 #define AFR_EH_SPLIT_BRAIN_LIMIT 1024
 #define AFR_STATISTICS_HISTORY_SIZE 50
+/* A pending file counts as being in use if a client changed it this recently */
+#define AFR_SHD_HOT_SECS 60
 
 #define ASSERT_LOCAL(this, healer)                                             \
     if (!afr_shd_is_subvol_local(this, healer->subvol)) {                      \
@@ -371,6 +373,12 @@ afr_shd_sweep_prepare(struct subvol_healer *healer)
     event->split_brain_count = 0;
     event->heal_failed_count = 0;
 
+    event->index_count = 0;
+    event->purged_count = 0;
+    event->queue_depth = 0;
+    event->hot_count = 0;
+    event->prioritized = _gf_false;
+
     event->start_time = gf_time();
     event->end_time = 0;
     _mask_cancellation();
@@ -434,9 +442,348 @@ afr_shd_index_heal(xlator_t *subvol, gf_dirent_t *entry, loc_t *parent,
          */
         afr_shd_zero_xattrop(healer->this, gfid);
 
+    LOCK(&priv->lock);
+    {
+        healer->crawl_event.index_count++;
+        if (ret == -ENOENT || ret == -ESTALE || ret == 2)
+            healer->crawl_event.purged_count++;
+    }
+    UNLOCK(&priv->lock);
+
+    return 0;
+}
+
+typedef struct {
+    gf_dirent_t *entry;
+    uint64_t size;
+    time_t pending_since;
+    time_t last_activity;
+    gf_boolean_t dir;
+    gf_boolean_t hot;
+} afr_shd_queue_entry_t;
+
+typedef struct _afr_shd_queue afr_shd_queue_t;
+
+typedef int (*afr_shd_queue_fn_t)(afr_shd_queue_t *q,
+                                  afr_shd_queue_entry_t *qe, uint32_t left);
+
+/* One chunk of the index entries of a prioritized sweep. The entries are
+ * first scored, then sorted by heal priority and healed, each step by jobs
+ * which pick the entries of the chunk in turn. */
+struct _afr_shd_queue {
+    struct subvol_healer *healer;
+    xlator_t *subvol;
+    loc_t *parent;
+    fd_t *fd;
+    dict_t *xdata;
+    dict_t *req; /* lookup request for the heal hints of the brick */
+    afr_shd_queue_fn_t fn;
+    afr_shd_queue_entry_t *entries;
+    uint64_t offset; /* where the next chunk starts in the index */
+    time_t now;
+    uint32_t count;
+    uint32_t next;
+    uint32_t jobs_running;
+    int retval;
+    gf_boolean_t eof;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+};
+
+/* Reads the next chunk of at most @max entries from the index. Entries of a
+ * readdir reply which do not fit are read again for the next chunk. */
+static int
+afr_shd_queue_gather(afr_shd_queue_t *q, uint32_t max)
+{
+    gf_dirent_t entries;
+    gf_dirent_t *entry = NULL;
+    gf_dirent_t *tmp = NULL;
+    int ret = 0;
+
+    INIT_LIST_HEAD(&entries.list);
+    while (q->count < max) {
+        ret = syncop_readdir(q->subvol, q->fd, 131072, q->offset, &entries,
+                             q->xdata, NULL);
+        if (ret <= 0) {
+            if (ret == 0)
+                q->eof = _gf_true;
+            break;
+        }
+        ret = 0;
+
+        list_for_each_entry_safe(entry, tmp, &entries.list, list)
+        {
+            if (q->count == max)
+                break;
+            list_del_init(&entry->list);
+            q->offset = entry->d_off;
+            if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) {
+                gf_dirent_entry_free(entry);
+                continue;
+            }
+            q->entries[q->count++].entry = entry;
+        }
+        gf_dirent_free(&entries);
+    }
+
+    return ret;
+}
+
+static int
+afr_shd_queue_score(afr_shd_queue_t *q, afr_shd_queue_entry_t *qe,
+                    uint32_t left)
+{
+    loc_t loc = {0};
+    struct iatt iatt = {0};
+    dict_t *rsp = NULL;
+    uint64_t val = 0;
+
+    if (qe->entry->d_stat.ia_type == IA_IFDIR) {
+        qe->dir = _gf_true;
+        return 0;
+    }
+
+    if (gf_uuid_parse(qe->entry->d_name, loc.gfid))
+        return 0;
+    loc.inode = inode_new(q->healer->this->itable);
+    if (!loc.inode)
+        return 0;
+
+    if (syncop_lookup(q->subvol, &loc, &iatt, NULL, q->req, &rsp) == 0) {
+        qe->size = iatt.ia_size;
+        if (rsp && !dict_get_uint64(rsp, GF_XATTROP_PENDING_SINCE, &val))
+            qe->pending_since = val;
+        if (rsp && !dict_get_uint64(rsp, GF_XATTROP_LAST_ACTIVITY, &val))
+            qe->last_activity = val;
+        qe->hot = (qe->last_activity &&
+                   (q->now - qe->last_activity < AFR_SHD_HOT_SECS));
+    }
+
+    if (rsp)
+        dict_unref(rsp);
+    loc_wipe(&loc);
+    return 0;
+}
+
+static int
+afr_shd_queue_heal(afr_shd_queue_t *q, afr_shd_queue_entry_t *qe,
+                   uint32_t left)
+{
+    struct subvol_healer *healer = q->healer;
+    afr_private_t *priv = healer->this->private;
+
+    LOCK(&priv->lock);
+    {
+        healer->crawl_event.queue_depth = left;
+    }
+    UNLOCK(&priv->lock);
+
+    return afr_shd_index_heal(q->subvol, qe->entry, q->parent, healer);
+}
+
+/* Directories go first as healing them can create the files pending below
+ * them. Files clients are still writing come next, most recently written
+ * first, then larger files before smaller ones so that the long heals get
+ * going while the small ones are done in parallel, and finally entries
+ * which have been pending longer. A pending_since of 0 means the brick was
+ * restarted since, so such entries are treated as the oldest. */
+static int
+afr_shd_queue_entry_cmp(const void *a, const void *b)
+{
+    const afr_shd_queue_entry_t *x = a;
+    const afr_shd_queue_entry_t *y = b;
+
+    if (x->dir != y->dir)
+        return x->dir ? -1 : 1;
+    if (x->hot != y->hot)
+        return x->hot ? -1 : 1;
+    if (x->hot && (x->last_activity != y->last_activity))
+        return (x->last_activity > y->last_activity) ? -1 : 1;
+    if (x->size != y->size)
+        return (x->size > y->size) ? -1 : 1;
+    if (x->pending_since != y->pending_since)
+        return (x->pending_since < y->pending_since) ? -1 : 1;
+    return 0;
+}
+
+static int
+afr_shd_queue_worker(void *data)
+{
+    afr_shd_queue_t *q = data;
+    afr_shd_queue_entry_t *qe = NULL;
+    uint32_t left = 0;
+    int ret = 0;
+
+    for (;;) {
+        qe = NULL;
+        pthread_mutex_lock(&q->mutex);
+        {
+            if (ret && !q->retval)
+                q->retval = ret;
+            if (!q->retval && (q->next < q->count) &&
+                !q->healer->this->cleanup_starting) {
+                qe = &q->entries[q->next++];
+                left = q->count - q->next;
+            } else {
+                q->jobs_running--;
+                pthread_cond_broadcast(&q->cond);
+            }
+        }
+        pthread_mutex_unlock(&q->mutex);
+
+        if (!qe)
+            break;
+
+        ret = q->fn(q, qe, left);
+    }
+
+    return 0;
+}
+
+static int
+afr_shd_queue_worker_done(int ret, call_frame_t *frame, void *opaque)
+{
     return 0;
 }
 
+/* Runs @fn on every entry of the chunk with up to shd-max-threads jobs */
+static int
+afr_shd_queue_run(afr_shd_queue_t *q, call_frame_t *frame,
+                  afr_shd_queue_fn_t fn)
+{
+    afr_private_t *priv = q->healer->this->private;
+    uint32_t jobs = 0;
+    uint32_t i = 0;
+
+    jobs = min(priv->shd.max_threads, q->count);
+    if (!jobs)
+        jobs = 1;
+
+    q->fn = fn;
+    q->next = 0;
+    q->jobs_running = jobs;
+    for (i = 0; i < jobs; i++) {
+        if (synctask_new(q->subvol->ctx->env, afr_shd_queue_worker,
+                         afr_shd_queue_worker_done, frame, q) == 0)
+            continue;
+        pthread_mutex_lock(&q->mutex);
+        {
+            q->jobs_running--;
+        }
+        pthread_mutex_unlock(&q->mutex);
+    }
+
+    pthread_mutex_lock(&q->mutex);
+    {
+        while (q->jobs_running)
+            pthread_cond_wait(&q->cond, &q->mutex);
+    }
+    pthread_mutex_unlock(&q->mutex);
+
+    if (q->next == 0 && q->count) {
+        /* No job could be started, do it from this thread */
+        q->jobs_running = 1;
+        afr_shd_queue_worker(q);
+    }
+
+    return q->retval;
+}
+
+/* Streams the index in chunks of up to shd-wait-qlength entries. Each chunk
+ * is scored with parallel lookups, ordered by heal priority and healed with
+ * shd-max-threads parallel jobs before the next one is read, so the whole
+ * index is crawled with bounded memory. */
+static int
+afr_shd_index_prioritized_sweep(struct subvol_healer *healer,
+                                call_frame_t *frame, xlator_t *subvol,
+                                loc_t *loc, dict_t *xdata)
+{
+    afr_private_t *priv = healer->this->private;
+    afr_shd_queue_t q = {0};
+    uint32_t max = priv->shd.wait_qlength;
+    uint64_t hot = 0;
+    uint32_t i = 0;
+    int ret = 0;
+
+    /* The jobs are synctasks waited upon with a condition variable */
+    if (synctask_get())
+        return -ENOTSUP;
+
+    q.healer = healer;
+    q.subvol = subvol;
+    q.parent = loc;
+    q.xdata = xdata;
+    pthread_mutex_init(&q.mutex, NULL);
+    pthread_cond_init(&q.cond, NULL);
+
+    q.entries = GF_CALLOC(max, sizeof(*q.entries), gf_afr_mt_shd_queue_t);
+    q.req = dict_new();
+    if (!q.entries || !q.req ||
+        dict_set_int32_sizen(q.req, GF_XATTROP_HEAL_HINT, 1)) {
+        ret = -ENOMEM;
+        goto out;
+    }
+
+    ret = syncop_dirfd(subvol, loc, &q.fd, GF_CLIENT_PID_SELF_HEALD);
+    if (ret)
+        goto out;
+
+    LOCK(&priv->lock);
+    {
+        healer->crawl_event.prioritized = _gf_true;
+    }
+    UNLOCK(&priv->lock);
+
+    while (!q.eof && !healer->this->cleanup_starting) {
+        ret = afr_shd_queue_gather(&q, max);
+        if (ret < 0 || !q.count)
+            break;
+
+        q.now = gf_time();
+        afr_shd_queue_run(&q, frame, afr_shd_queue_score);
+
+        hot = 0;
+        for (i = 0; i < q.count; i++) {
+            if (q.entries[i].hot)
+                hot++;
+        }
+        qsort(q.entries, q.count, sizeof(*q.entries), afr_shd_queue_entry_cmp);
+
+        LOCK(&priv->lock);
+        {
+            healer->crawl_event.queue_depth = q.count;
+            healer->crawl_event.hot_count += hot;
+        }
+        UNLOCK(&priv->lock);
+
+        ret = afr_shd_queue_run(&q, frame, afr_shd_queue_heal);
+
+        for (i = 0; i < q.count; i++)
+            gf_dirent_entry_free(q.entries[i].entry);
+        memset(q.entries, 0, q.count * sizeof(*q.entries));
+        q.count = 0;
+        if (ret)
+            break;
+    }
+
+    LOCK(&priv->lock);
+    {
+        healer->crawl_event.queue_depth = 0;
+    }
+    UNLOCK(&priv->lock);
+out:
+    for (i = 0; i < q.count; i++)
+        gf_dirent_entry_free(q.entries[i].entry);
+    GF_FREE(q.entries);
+    if (q.req)
+        dict_unref(q.req);
+    if (q.fd)
+        fd_unref(q.fd);
+    pthread_cond_destroy(&q.cond);
+    pthread_mutex_destroy(&q.mutex);
+    return ret;
+}
+
 int
 afr_shd_index_sweep(struct subvol_healer *healer, char *vgfid)
 {
@@ -471,9 +818,17 @@ afr_shd_index_sweep(struct subvol_healer *healer, char *vgfid)
         goto out;
     }
 
-    ret = syncop_mt_dir_scan(frame, subvol, &loc, GF_CLIENT_PID_SELF_HEALD,
-                             healer, afr_shd_index_heal, xdata,
-                             priv->shd.max_threads, priv->shd.wait_qlength);
+    /* Entry-changes indices are directories of names, heal them in order */
+    ret = -ENOTSUP;
+    if (priv->shd.prioritized && strcmp(vgfid, GF_XATTROP_ENTRY_CHANGES_GFID))
+        ret = afr_shd_index_prioritized_sweep(healer, frame, subvol, &loc,
+                                              xdata);
+
+    /* Whatever made a prioritized sweep fail, crawl in index order */
+    if (ret < 0)
+        ret = syncop_mt_dir_scan(frame, subvol, &loc, GF_CLIENT_PID_SELF_HEALD,
+                                 healer, afr_shd_index_heal, xdata,
+                                 priv->shd.max_threads, priv->shd.wait_qlength);
 
     if (ret == 0)
         ret = healer->crawl_event.healed_count;
@@ -1270,6 +1625,34 @@ afr_shd_dict_add_crawl_event(xlator_t *this, dict_t *output,
         goto out;
     }
 
+    if (crawl_event->prioritized) {
+        keylen = snprintf(key, sizeof(key), "statistics_heal_order-%s",
+                          suffix);
+        ret = dict_set_nstrn(output, key, keylen, "priority",
+                             SLEN("priority"));
+        if (ret) {
+            gf_msg(this->name, GF_LOG_ERROR, -ret, AFR_MSG_DICT_SET_FAILED,
+                   "Could not add statistics_heal_order to output");
+            goto out;
+        }
+
+        snprintf(key, sizeof(key), "statistics_queue_depth-%s", suffix);
+        ret = dict_set_uint64(output, key, crawl_event->queue_depth);
+        if (ret) {
+            gf_msg(this->name, GF_LOG_ERROR, -ret, AFR_MSG_DICT_SET_FAILED,
+                   "Could not add statistics_queue_depth to output");
+            goto out;
+        }
+
+        snprintf(key, sizeof(key), "statistics_hot_cnt-%s", suffix);
+        ret = dict_set_uint64(output, key, crawl_event->hot_count);
+        if (ret) {
+            gf_msg(this->name, GF_LOG_ERROR, -ret, AFR_MSG_DICT_SET_FAILED,
+                   "Could not add statistics_hot_count to output");
+            goto out;
+        }
+    }
+
     keylen = snprintf(key, sizeof(key), "statistics_strt_time-%s", suffix);
     ret = dict_set_dynstrn(output, key, keylen, start_time_str);
     if (ret) {
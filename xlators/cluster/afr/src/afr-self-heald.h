@@ -31,6 +31,15 @@ typedef struct {
     time_t end_time;
     char *crawl_type;
     int child;
+    /* Index sweeps: entries found in the indices, and stale entries
+       removed from them */
+    uint64_t index_count;
+    uint64_t purged_count;
+    /* Prioritized index crawls: entries of the current queue still waiting
+       to be healed, and entries clients were modifying when it was built */
+    uint64_t queue_depth;
+    uint64_t hot_count;
+    gf_boolean_t prioritized;
 } crawl_event_t;
 
 struct subvol_healer {
@@ -57,6 +66,7 @@ typedef struct {
     uint32_t halo_max_latency_msec;
     gf_boolean_t iamshd;
     gf_boolean_t enabled;
+    gf_boolean_t prioritized;
 } afr_self_heald_t;
 
 int
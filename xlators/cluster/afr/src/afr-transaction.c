@@ -1366,6 +1366,67 @@ afr_handle_failure_using_thin_arbiter(call_frame_t *frame, xlator_t *this)
     afr_ta_decide_post_op_state(frame, this);
 }
 
+/* Fops whose changelog the bricks can apply from the fop's own xdata. The
+ * arbiter needs the on-disk changelog returned by a separate pre-op to
+ * arbitrate the fop, so it is never piggybacked there. */
+gf_boolean_t
+afr_changelog_can_piggyback(xlator_t *this, afr_local_t *local)
+{
+    afr_private_t *priv = this->private;
+    int i = 0;
+
+    if (priv->arbiter_count || priv->thin_arbiter_count)
+        return _gf_false;
+
+    /* Until every brick confirmed it applies them, a brick which doesn't
+     * would store the fop without its changelog and nothing gets healed. */
+    for (i = 0; i < priv->child_count; i++) {
+        if (!priv->piggyback_capable[i])
+            return _gf_false;
+    }
+
+    switch (local->op) {
+        case GF_FOP_WRITE:
+        case GF_FOP_TRUNCATE:
+        case GF_FOP_FTRUNCATE:
+        case GF_FOP_FALLOCATE:
+        case GF_FOP_DISCARD:
+        case GF_FOP_ZEROFILL:
+        case GF_FOP_SETATTR:
+        case GF_FOP_FSETATTR:
+            return _gf_true;
+        default:
+            return _gf_false;
+    }
+}
+
+/* When the pre-op travelled with the fop, a post-op which only undoes it on
+ * the same bricks that are about to be unlocked can travel with the unlock.
+ * With eager-lock the unlock may come much later than the post-op, so the
+ * post-op is sent on its own there. */
+static gf_boolean_t
+afr_changelog_post_op_with_unlock(call_frame_t *frame, dict_t *xattr)
+{
+    afr_local_t *local = frame->local;
+    dict_t *xdata = NULL;
+
+    if (local->pre_op_compat || local->transaction.eager_lock_on ||
+        local->internal_lock.lockee_count != 1)
+        return _gf_false;
+
+    xdata = dict_copy_with_ref(xattr, NULL);
+    if (!xdata)
+        return _gf_false;
+    if (dict_set_str_sizen(xdata, GF_XATTROP_PIGGYBACK,
+                           AFR_XATTR_PREFIX ".")) {
+        dict_unref(xdata);
+        return _gf_false;
+    }
+
+    local->transaction.unlock_xdata = xdata;
+    return _gf_true;
+}
+
 void
 afr_changelog_post_op_do(call_frame_t *frame, xlator_t *this)
 {
@@ -1440,6 +1501,11 @@ set_dirty:
         goto out;
     }
 
+    if (nothing_failed && afr_changelog_post_op_with_unlock(frame, xattr)) {
+        afr_changelog_post_op_done(frame, this);
+        goto out;
+    }
+
     afr_changelog_do(frame, this, xattr, afr_changelog_post_op_done,
                      AFR_TRANSACTION_POST_OP);
 out:
@@ -1668,6 +1734,76 @@ afr_changelog_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
     return 0;
 }
 
+/* With granular-data-heal, tell the bricks which data the fop changed when
+ * the post-op marks some replica as bad, so that heal copies only that. */
+static dict_t *
+afr_changelog_dirty_region_xdata(call_frame_t *frame, afr_xattrop_type_t op)
+{
+    afr_local_t *local = frame->local;
+    afr_private_t *priv = frame->this->private;
+    uint64_t *region = NULL;
+    uint64_t offset = 0;
+    uint64_t len = GF_XATTROP_DIRTY_REGION_ALL;
+    dict_t *xdata = NULL;
+    int i = 0;
+
+    if (!priv->dsh_granular || op != AFR_TRANSACTION_POST_OP)
+        return NULL;
+
+    for (i = 0; i < priv->child_count; i++) {
+        if (local->transaction.failed_subvols[i])
+            break;
+    }
+    if (i == priv->child_count)
+        return NULL;
+
+    if (local->transaction.type == AFR_METADATA_TRANSACTION) {
+        len = 0;
+    } else {
+        switch (local->op) {
+            case GF_FOP_WRITE:
+                /* append writes lock, and so report, the whole file */
+                if (local->transaction.len) {
+                    offset = local->transaction.start;
+                    len = local->transaction.len;
+                }
+                break;
+            case GF_FOP_FALLOCATE:
+                offset = local->cont.fallocate.offset;
+                len = local->cont.fallocate.len;
+                break;
+            case GF_FOP_DISCARD:
+                offset = local->cont.discard.offset;
+                len = local->cont.discard.len;
+                break;
+            case GF_FOP_ZEROFILL:
+                offset = local->cont.zerofill.offset;
+                len = local->cont.zerofill.len;
+                break;
+            default:
+                break;
+        }
+    }
+
+    region = GF_MALLOC(2 * sizeof(*region), gf_common_mt_char);
+    if (!region)
+        return NULL;
+    region[0] = hton64(offset);
+    region[1] = hton64(len);
+
+    xdata = dict_new();
+    if (!xdata ||
+        dict_set_bin(xdata, GF_XATTROP_DIRTY_REGION, region,
+                     2 * sizeof(*region))) {
+        GF_FREE(region);
+        if (xdata)
+            dict_unref(xdata);
+        return NULL;
+    }
+
+    return xdata;
+}
+
 void
 afr_changelog_populate_xdata(call_frame_t *frame, afr_xattrop_type_t op,
                              dict_t **xdata, dict_t **newloc_xdata)
@@ -1689,8 +1825,10 @@ afr_changelog_populate_xdata(call_frame_t *frame, afr_xattrop_type_t op,
     priv = this->private;
 
     if (local->transaction.type == AFR_DATA_TRANSACTION ||
-        local->transaction.type == AFR_METADATA_TRANSACTION)
+        local->transaction.type == AFR_METADATA_TRANSACTION) {
+        *xdata = afr_changelog_dirty_region_xdata(frame, op);
         goto out;
+    }
 
     if (!priv->esh_granular)
         goto out;
@@ -1984,7 +2122,20 @@ afr_changelog_pre_op(call_frame_t *frame, xlator_t *this)
         goto next;
 
     if (!local->pre_op_compat) {
+        if (!local->xdata_req) {
+            local->xdata_req = dict_new();
+            if (!local->xdata_req) {
+                op_errno = ENOMEM;
+                goto err;
+            }
+        }
         dict_copy(xdata_req, local->xdata_req);
+        ret = dict_set_str_sizen(local->xdata_req, GF_XATTROP_PIGGYBACK,
+                                 AFR_XATTR_PREFIX ".");
+        if (ret) {
+            op_errno = ENOMEM;
+            goto err;
+        }
         goto next;
     }
 
@@ -40,10 +40,12 @@ int
 afr_read_txn_continue(call_frame_t *frame, xlator_t *this, int subvol);
 
 void
-afr_pending_read_increment(afr_private_t *priv, int child_index);
+afr_pending_read_increment(afr_private_t *priv, afr_local_t *local,
+                           int child_index);
 
 void
-afr_pending_read_decrement(afr_private_t *priv, int child_index);
+afr_pending_read_decrement(afr_private_t *priv, afr_local_t *local,
+                           int child_index);
 
 call_frame_t *
 afr_transaction_detach_fop_frame(call_frame_t *frame);
@@ -51,6 +53,8 @@ gf_boolean_t
 afr_has_quorum(unsigned char *subvols, xlator_t *this, call_frame_t *frame);
 gf_boolean_t
 afr_needs_changelog_update(afr_local_t *local);
+gf_boolean_t
+afr_changelog_can_piggyback(xlator_t *this, afr_local_t *local);
 void
 afr_zero_fill_stat(afr_local_t *local);
 
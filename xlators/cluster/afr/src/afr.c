@@ -169,6 +169,8 @@ reconfigure(xlator_t *this, dict_t *options)
     char *fav_child_policy = NULL;
     char *data_self_heal = NULL;
     char *data_self_heal_algorithm = NULL;
+    char *data_self_heal_checksum = NULL;
+    char *shd_heal_order = NULL;
     char *locking_scheme = NULL;
     gf_boolean_t consistent_io = _gf_false;
     gf_boolean_t choose_local_old = _gf_false;
@@ -202,6 +204,11 @@ reconfigure(xlator_t *this, dict_t *options)
                      options, str, out);
     set_data_self_heal_algorithm(priv, data_self_heal_algorithm);
 
+    GF_OPTION_RECONF("data-self-heal-checksum", data_self_heal_checksum,
+                     options, str, out);
+    priv->data_self_heal_fast_checksum = (strcmp(data_self_heal_checksum,
+                                                 "fast") == 0);
+
     GF_OPTION_RECONF("halo-enabled", priv->halo_enabled, options, bool, out);
 
     GF_OPTION_RECONF("halo-shd-max-latency", priv->shd.halo_max_latency_msec,
@@ -231,6 +238,8 @@ reconfigure(xlator_t *this, dict_t *options)
     }
 
     GF_OPTION_RECONF("read-hash-mode", priv->hash_mode, options, uint32, out);
+    GF_OPTION_RECONF("read-probe-interval", priv->read_probe_interval, options,
+                     uint32, out);
 
     if (read_subvol) {
         index = xlator_subvolume_index(this, read_subvol);
@@ -261,6 +270,8 @@ reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("full-lock", priv->full_lock, options, bool, out);
     GF_OPTION_RECONF("granular-entry-heal", priv->esh_granular, options, bool,
                      out);
+    GF_OPTION_RECONF("granular-data-heal", priv->dsh_granular, options, bool,
+                     out);
 
     GF_OPTION_RECONF("eager-lock", priv->eager_lock, options, bool, out);
     GF_OPTION_RECONF("optimistic-change-log", priv->optimistic_change_log,
@@ -299,6 +310,9 @@ reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("shd-wait-qlength", priv->shd.wait_qlength, options,
                      uint32, out);
 
+    GF_OPTION_RECONF("shd-heal-order", shd_heal_order, options, str, out);
+    priv->shd.prioritized = (strcmp(shd_heal_order, "priority") == 0);
+
     GF_OPTION_RECONF("favorite-child-policy", fav_child_policy, options, str,
                      out);
     if (afr_set_favorite_child_policy(priv, fav_child_policy) == -1)
@@ -426,6 +440,8 @@ init(xlator_t *this)
     char *data_self_heal = NULL;
     char *locking_scheme = NULL;
     char *data_self_heal_algorithm = NULL;
+    char *data_self_heal_checksum = NULL;
+    char *shd_heal_order = NULL;
 
     if (!this->children) {
         gf_msg(this->name, GF_LOG_ERROR, 0, AFR_MSG_CHILD_MISCONFIGURED,
@@ -492,8 +508,19 @@ init(xlator_t *this)
 
     priv->pending_reads = GF_CALLOC(sizeof(*priv->pending_reads),
                                     priv->child_count, gf_afr_mt_atomic_t);
+    priv->read_stats = GF_CALLOC(sizeof(*priv->read_stats), priv->child_count,
+                                 gf_afr_mt_read_stats_t);
+    priv->piggyback_capable = GF_CALLOC(sizeof(unsigned char),
+                                        priv->child_count, gf_afr_mt_char);
+    if (!priv->pending_reads || !priv->read_stats ||
+        !priv->piggyback_capable) {
+        ret = -ENOMEM;
+        goto out;
+    }
 
     GF_OPTION_INIT("read-hash-mode", priv->hash_mode, uint32, out);
+    GF_OPTION_INIT("read-probe-interval", priv->read_probe_interval, uint32,
+                   out);
 
     priv->favorite_child = -1;
 
@@ -505,6 +532,9 @@ init(xlator_t *this)
 
     GF_OPTION_INIT("shd-wait-qlength", priv->shd.wait_qlength, uint32, out);
 
+    GF_OPTION_INIT("shd-heal-order", shd_heal_order, str, out);
+    priv->shd.prioritized = (strcmp(shd_heal_order, "priority") == 0);
+
     GF_OPTION_INIT("background-self-heal-count",
                    priv->background_self_heal_count, uint32, out);
 
@@ -521,6 +551,11 @@ init(xlator_t *this)
     GF_OPTION_INIT("data-self-heal-window-size",
                    priv->data_self_heal_window_size, uint32, out);
 
+    GF_OPTION_INIT("data-self-heal-checksum", data_self_heal_checksum, str,
+                   out);
+    priv->data_self_heal_fast_checksum = (strcmp(data_self_heal_checksum,
+                                                 "fast") == 0);
+
     GF_OPTION_INIT("metadata-self-heal", priv->metadata_self_heal, bool, out);
 
     GF_OPTION_INIT("entry-self-heal", priv->entry_self_heal, bool, out);
@@ -548,6 +583,7 @@ init(xlator_t *this)
     priv->granular_locks = (strcmp(locking_scheme, "granular") == 0);
     GF_OPTION_INIT("full-lock", priv->full_lock, bool, out);
     GF_OPTION_INIT("granular-entry-heal", priv->esh_granular, bool, out);
+    GF_OPTION_INIT("granular-data-heal", priv->dsh_granular, bool, out);
 
     GF_OPTION_INIT("eager-lock", priv->eager_lock, bool, out);
     GF_OPTION_INIT("quorum-type", qtype, str, out);
@@ -847,7 +883,7 @@ struct volume_options options[] = {
     {.key = {"read-hash-mode"},
      .type = GF_OPTION_TYPE_INT,
      .min = 0,
-     .max = 5,
+     .max = 6,
      .default_value = "1",
      .op_version = {2},
      .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
@@ -863,7 +899,23 @@ struct volume_options options[] = {
          "3 = brick having the least outstanding read requests.\n"
          "4 = brick having the least network ping latency.\n"
          "5 = Hybrid mode between 3 and 4, ie least value among "
-         "network-latency multiplied by outstanding-read-requests."},
+         "network-latency multiplied by outstanding-read-requests.\n"
+         "6 = brick having the least measured read latency, tracked "
+         "separately for data and metadata reads and multiplied by "
+         "outstanding-read-requests. Reads on an fd stick to one "
+         "brick for a short while."},
+    {.key = {"read-probe-interval"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = 3600,
+     .default_value = "10",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"replicate"},
+     .description = "With read-hash-mode 6, a brick that has not been "
+                    "chosen for reads for this many seconds is sent one "
+                    "read so that its latency estimate stays current. "
+                    "0 disables probing."},
     {
         .key = {"choose-local"},
         .type = GF_OPTION_TYPE_BOOL,
@@ -991,6 +1043,21 @@ struct volume_options options[] = {
      .tags = {"replicate"},
      .description = "Maximum number of 128KB blocks per file for which "
                     "self-heal process would be applied simultaneously."},
+    {.key = {"data-self-heal-checksum"},
+     .type = GF_OPTION_TYPE_STR,
+     .value = {"strong", "fast"},
+     .default_value = "strong",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"replicate"},
+     .description = "Checksum used by the \"diff\" self-heal algorithm to "
+                    "find the blocks that differ. \"strong\" compares an "
+                    "MD5 (SHA256 in FIPS mode) of each block, one block per "
+                    "request. \"fast\" compares a non-cryptographic hash "
+                    "of every 128KB block, fetching the hashes of many "
+                    "blocks in one request, and copies the differing blocks "
+                    "data-self-heal-window-size at a time. Bricks that do "
+                    "not support it are healed with \"strong\"."},
     {.key = {"metadata-self-heal"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "off",
@@ -1051,8 +1118,18 @@ struct volume_options options[] = {
     {.key = {"pre-op-compat"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "on",
+     .op_version = {GD_OP_VERSION_11_0},
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"replicate"},
      .description = "Use separate pre-op xattrop() FOP rather than "
-                    "overloading xdata of the OP"},
+                    "overloading xdata of the OP. When off, the pre-op of "
+                    "writes, truncates, fallocate, discard, zerofill and "
+                    "setattr travels in the xdata of the fop and, without "
+                    "eager-lock, a post-op that only clears the dirty "
+                    "flag travels with the unlock, saving two round trips "
+                    "per transaction. Ignored for arbiter volumes. The "
+                    "separate pre-op is still used until every brick has "
+                    "reported in a lookup that it supports this."},
     {.key = {"eager-lock"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "on",
@@ -1263,6 +1340,22 @@ struct volume_options options[] = {
         .description = "This option can be used to control number of heals"
                        " that can wait in SHD per subvolume",
     },
+    {
+        .key = {"shd-heal-order"},
+        .type = GF_OPTION_TYPE_STR,
+        .value = {"index", "priority"},
+        .default_value = "index",
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+        .tags = {"replicate"},
+        .description = "Order in which SHD heals the files pending in the "
+                       "index. 'index' heals them in directory order as they "
+                       "are read. 'priority' reads up to shd-wait-qlength "
+                       "entries first and heals files that clients are "
+                       "still modifying before the others, then larger "
+                       "files before smaller ones and older entries before "
+                       "newer ones, using shd-max-threads parallel heals.",
+    },
     {
         .key = {"locking-scheme"},
         .type = GF_OPTION_TYPE_STR,
@@ -1294,6 +1387,18 @@ struct volume_options options[] = {
                        "granular way of recording changelogs and doing entry "
                        "self-heal.",
     },
+    {
+        .key = {"granular-data-heal"},
+        .type = GF_OPTION_TYPE_BOOL,
+        .default_value = "no",
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+        .tags = {"replicate"},
+        .description = "If this option is enabled, the bricks record which "
+                       "regions of a file were written while a replica was "
+                       "bad, and data self-heal copies only those regions "
+                       "instead of the whole file.",
+    },
     {
         .key = {"favorite-child-policy"},
         .type = GF_OPTION_TYPE_STR,
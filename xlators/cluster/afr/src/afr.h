@@ -33,6 +33,7 @@
 #define AFR_DOM_COUNT_MAX 3
 #define AFR_NUM_CHANGE_LOGS 3              /*data + metadata + entry*/
 #define AFR_DEFAULT_SPB_CHOICE_TIMEOUT 300 /*in seconds*/
+#define AFR_READ_STICKY_SECS 1 /* fd reads stay on one child this long */
 
 #define ARBITER_BRICK_INDEX 2
 #define THIN_ARBITER_BRICK_INDEX 2
@@ -115,8 +116,27 @@ typedef enum {
     AFR_READ_POLICY_LESS_LOAD,
     AFR_READ_POLICY_LEAST_LATENCY,
     AFR_READ_POLICY_LOAD_LATENCY_HYBRID,
+    AFR_READ_POLICY_ADAPTIVE_LATENCY,
 } afr_read_hash_mode_t;
 
+/* Classes of read fops whose latency is tracked separately by the
+ * adaptive read policy: a brick with a slow disk hurts data reads much
+ * more than metadata reads, which are usually served from memory. */
+typedef enum {
+    AFR_READ_CLASS_DATA,
+    AFR_READ_CLASS_METADATA,
+    AFR_READ_CLASS_MAX,
+} afr_read_class_t;
+
+typedef struct {
+    gf_atomic_t outstanding[AFR_READ_CLASS_MAX]; /* reads in flight */
+    /* Exponentially weighted moving average of the latency, in usecs. */
+    gf_atomic_uint64_t ewma_usecs[AFR_READ_CLASS_MAX];
+    gf_atomic_t samples[AFR_READ_CLASS_MAX];
+    /* last time the child was picked for a read of each class */
+    time_t last_chosen[AFR_READ_CLASS_MAX];
+} afr_read_stats_t;
+
 typedef enum {
     AFR_FAV_CHILD_NONE,
     AFR_FAV_CHILD_BY_SIZE,
@@ -200,6 +220,7 @@ typedef struct _afr_private {
     afr_data_self_heal_type_t data_self_heal_algorithm;
     unsigned int data_self_heal_window_size; /* max number of pipelined
                                                 read/writes */
+    gf_boolean_t data_self_heal_fast_checksum; /* batched xxhash for diff */
 
     struct list_head heal_waiting; /*queue for files that need heal*/
     uint32_t heal_wait_qlen; /*configurable queue length for heal_waiting*/
@@ -220,6 +241,10 @@ typedef struct _afr_private {
     gf_boolean_t metadata_splitbrain_forced_heal; /* on/off */
     int read_child;                               /* read-subvolume */
     gf_atomic_t *pending_reads; /*No. of pending read cbks per child.*/
+    afr_read_stats_t *read_stats; /* Per child stats for read-hash-mode 6 */
+    uint32_t read_probe_interval; /* secs before retrying a slow child */
+    /* children which reported that they apply piggybacked changelogs */
+    unsigned char *piggyback_capable;
 
     gf_timer_t *timer; /* launched when parent up is received */
 
@@ -273,6 +298,7 @@ typedef struct _afr_private {
 
     gf_boolean_t full_lock;
     gf_boolean_t esh_granular;
+    gf_boolean_t dsh_granular;
     gf_boolean_t consistent_io;
     gf_boolean_t data_self_heal; /* on/off */
     gf_boolean_t use_anon_inode;
@@ -406,6 +432,10 @@ typedef struct {
        arrives, we continue to read off this subvol.
     */
     int readdir_subvol;
+    /* the subvolume data reads stick to with the adaptive read policy, and
+       the time it was chosen. */
+    int read_subvol;
+    time_t read_subvol_time;
     /* lock-healing related members. */
     gf_boolean_t is_fd_bad;
     afr_lk_heal_info_t *lk_heal_info;
@@ -551,6 +581,9 @@ typedef struct _afr_local {
     dict_t *dict;
 
     int read_subvol; /* Current read subvolume */
+    gf_boolean_t read_timed; /* read latency is being tracked */
+    afr_read_class_t read_class;
+    struct timespec read_start;
 
     int optimistic_change_log;
 
@@ -836,6 +869,9 @@ typedef struct _afr_local {
 
         /* Changelog xattr dict for [f]xattrop*/
         dict_t **changelog_xdata;
+
+        /* post-op changelog sent along with the unlock */
+        dict_t *unlock_xdata;
         unsigned char *pre_op_sources;
 
         /* @failed_subvols: subvolumes on which a pre-op or a
@@ -1015,6 +1051,16 @@ afr_read_subvol_select_by_policy(inode_t *inode, xlator_t *this,
                                  unsigned char *readable,
                                  afr_read_subvol_args_t *args);
 
+int
+afr_adaptive_read_child(afr_private_t *priv, unsigned char *readable,
+                        afr_read_class_t class, gf_boolean_t *probe);
+
+void
+afr_piggyback_capability_req(xlator_t *this, dict_t *xattr_req);
+
+void
+afr_piggyback_capability_update(xlator_t *this, int child, dict_t *xdata);
+
 int
 afr_inode_read_subvol_type_get(inode_t *inode, xlator_t *this,
                                unsigned char *readable, int *event_p, int type);
@@ -1119,7 +1165,7 @@ afr_cleanup_fd_ctx(xlator_t *this, fd_t *fd);
             __this = frame->this;                                              \
             afr_handle_inconsistent_fop(frame, &__op_ret, &__op_errno);        \
             if (__local && __local->is_read_txn)                               \
-                afr_pending_read_decrement(__this->private,                    \
+                afr_pending_read_decrement(__this->private, __local,           \
                                            __local->read_subvol);              \
             if (__local && __local->xdata_req &&                               \
                 afr_is_lock_mode_mandatory(__local->xdata_req))                \
@@ -2439,6 +2439,10 @@ dht_lookup_everywhere_done(call_frame_t *frame, xlator_t *this)
                          "unlink on hashed is not skipped %s",
                          local->loc.path);
 
+            /* Only if every subvol said so */
+            if (local->op_errno == ENOENT)
+                dht_ncache_add(this, local, NULL);
+
             DHT_STACK_UNWIND(lookup, frame, -1, ENOENT, NULL, NULL, NULL, NULL);
         }
         return 0;
@@ -2973,7 +2977,13 @@ dht_lookup_linkfile_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
         dht_inode_ctx_time_update(local->loc.parent, this, postparent, 1);
     }
 
+    if (!op_ret && !local->ncache_hit)
+        dht_ncache_add(this, local, prev);
+
 unwind:
+    if (op_ret && local && local->ncache_hit)
+        dht_ncache_invalidate(this, local->loc.parent, local->loc.name);
+
     DHT_STRIP_PHASE1_FLAGS(stbuf);
     dht_set_fixed_dir_stat(postparent);
     DHT_STACK_UNWIND(lookup, frame, op_ret, op_errno, inode, stbuf, xattr,
@@ -2982,6 +2992,11 @@ unwind:
     return 0;
 
 err:
+    if (local->ncache_hit) {
+        /* The cached linkto target is stale */
+        dht_ncache_invalidate(this, loc->parent, loc->name);
+        local->ncache_hit = _gf_false;
+    }
     dht_lookup_everywhere(frame, this, loc);
 out:
     return 0;
@@ -3178,6 +3193,10 @@ out:
         dht_inode_ctx_time_update(local->loc.parent, this, postparent, 1);
     }
 
+    /* ESTALE says nothing about the name, only ENOENT is cached */
+    if (local && (op_ret == -1) && (op_errno == ENOENT))
+        dht_ncache_add(this, local, NULL);
+
     DHT_STRIP_PHASE1_FLAGS(stbuf);
     dht_set_fixed_dir_stat(postparent);
     DHT_STACK_UNWIND(lookup, frame, op_ret, op_errno, inode, stbuf, xattr,
@@ -3272,6 +3291,7 @@ dht_do_fresh_lookup(call_frame_t *frame, xlator_t *this, loc_t *loc)
     int ret = -1;
     dht_conf_t *conf = NULL;
     xlator_t *hashed_subvol = NULL;
+    xlator_t *cached_subvol = NULL;
     dht_local_t *local = NULL;
     int op_errno = -1;
     int call_cnt = 0;
@@ -3350,6 +3370,26 @@ dht_do_fresh_lookup(call_frame_t *frame, xlator_t *this, loc_t *loc)
         return 0;
     }
 
+    ret = dht_ncache_lookup(this, local, &cached_subvol);
+    if (ret == DHT_NCACHE_NEGATIVE) {
+        gf_msg_debug(this->name, 0, "%s: missing as per the lookup cache",
+                     loc->path);
+        DHT_STACK_UNWIND(lookup, frame, -1, ENOENT, NULL, NULL, NULL, NULL);
+        return 0;
+    }
+
+    if (ret == DHT_NCACHE_LINKTO) {
+        /* Skip the linkto file on the hashed subvol, the data file is
+         * checked just as if it had been read from there */
+        gf_msg_debug(this->name, 0,
+                     "%s: Calling lookup on cached linkto target %s",
+                     loc->path, cached_subvol->name);
+        STACK_WIND_COOKIE(frame, dht_lookup_linkfile_cbk, cached_subvol,
+                          cached_subvol, cached_subvol->fops->lookup,
+                          &local->loc, local->xattr_req);
+        return 0;
+    }
+
     /* if the hashed_subvol is non-null, send the lookup there first so
      * as to see whether we have a file or a directory */
     gf_msg_debug(this->name, 0, "%s: Calling fresh lookup on %s", loc->path,
@@ -5712,6 +5752,45 @@ out:
     return 0;
 }
 
+static int
+dht_shard_bulk_delete_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                          int op_ret, int op_errno, dict_t *xdata)
+{
+    dht_local_t *local = NULL;
+    xlator_t *prev = NULL;
+    int this_call_cnt = 0;
+
+    local = frame->local;
+    prev = cookie;
+
+    /* A brick not knowing the request stores it as an xattr instead */
+    if ((op_ret == 0) &&
+        (!xdata || !dict_get_sizen(xdata, GF_XATTR_SHARD_BULK_DELETE))) {
+        op_ret = -1;
+        op_errno = EOPNOTSUPP;
+    }
+
+    /* The shards are spread over all the subvolumes, a failure on any of
+     * them leaves some behind */
+    if (op_ret == -1) {
+        LOCK(&frame->lock);
+        {
+            local->op_ret = -1;
+            local->op_errno = op_errno;
+        }
+        UNLOCK(&frame->lock);
+        gf_msg_debug(this->name, op_errno, "subvolume %s returned -1",
+                     prev->name);
+    }
+
+    this_call_cnt = dht_frame_return(frame);
+    if (is_last_call(this_call_cnt)) {
+        DHT_STACK_UNWIND(setxattr, frame, local->op_ret, local->op_errno,
+                         (local->op_ret == 0) ? xdata : NULL);
+    }
+    return 0;
+}
+
 static int
 dht_nuke_dir_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
                  int32_t op_ret, int32_t op_errno, struct iatt *preparent,
@@ -5962,6 +6041,30 @@ dht_setxattr(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xattr,
         goto err;
     }
 
+    tmp = dict_get(xattr, GF_XATTR_SHARD_BULK_DELETE);
+    if (tmp) {
+        if (!IA_ISDIR(loc->inode->ia_type)) {
+            op_errno = ENOTSUP;
+            goto err;
+        }
+        for (i = 0; i < conf->subvolume_cnt; i++) {
+            if (!conf->subvolume_status[i]) {
+                op_errno = ENOTCONN;
+                goto err;
+            }
+        }
+
+        local->op_ret = 0;
+        local->call_cnt = conf->subvolume_cnt;
+        for (i = 0; i < conf->subvolume_cnt; i++) {
+            STACK_WIND_COOKIE(frame, dht_shard_bulk_delete_cbk,
+                              conf->subvolumes[i], conf->subvolumes[i],
+                              conf->subvolumes[i]->fops->setxattr, loc, xattr,
+                              flags, xdata);
+        }
+        return 0;
+    }
+
     tmp = dict_get(xattr, "glusterfs.dht.nuke");
     if (tmp) {
         return dht_nuke_dir(frame, this, loc, tmp);
@@ -6713,6 +6816,165 @@ dht_queue_readdirp(call_frame_t *frame, xlator_t *xl, off_t offset,
     }
 }
 
+/* DHT lists each name once: linkto files are never listed, and directories,
+ * which exist on all the subvolumes, only from their hashed subvolume (or
+ * from the first up subvolume when the hashed one can not list them). */
+static gf_boolean_t
+dht_readdirp_is_listed(xlator_t *this, dht_layout_t *layout, xlator_t *prev,
+                       xlator_t *first_up_subvol, gf_dirent_t *orig_entry)
+{
+    dht_conf_t *conf = this->private;
+    xlator_t *hashed_subvol = NULL;
+
+    gf_msg_debug(this->name, 0, "%s: entry = %s, type = %d", prev->name,
+                 orig_entry->d_name, orig_entry->d_type);
+
+    if (IA_ISINVAL(orig_entry->d_stat.ia_type)) {
+        /*stat failed somewhere- display this entry but the data may
+         * be inaccurate.
+         */
+        gf_msg_debug(this->name, EINVAL, "Invalid stat for %s (gfid %s)",
+                     orig_entry->d_name, uuid_utoa(orig_entry->d_stat.ia_gfid));
+    }
+
+    if (check_is_linkfile(NULL, (&orig_entry->d_stat), orig_entry->dict,
+                          conf->link_xattr_name)) {
+        gf_msg_debug(this->name, 0, "%s: %s is a linkto file", prev->name,
+                     orig_entry->d_name);
+        return _gf_false;
+    }
+
+    /* Why aren't we skipping DHT entirely in case of a single subvol?
+     * Because if this was a larger volume earlier and all but one subvol
+     * was removed, there might be stale linkto files on the subvol.
+     */
+    if (conf->subvolume_cnt == 1) {
+        /* return all directory and file entries except
+         * linkto files for a single child DHT
+         */
+        return _gf_true;
+    }
+
+    if (check_is_dir(NULL, (&orig_entry->d_stat), NULL)) {
+        /*Directory entries filtering :
+         * a) If rebalance is running, pick from first_up_subvol
+         * b) (rebalance not running)hashed subvolume is NULL or
+         * down then filter in first_up_subvolume. Other wise the
+         * corresponding hashed subvolume will take care of the
+         * directory entry.
+         */
+        if (conf->readdir_optimize == _gf_true)
+            return (prev == first_up_subvol);
+
+        hashed_subvol = conf->methods.layout_search(this, layout,
+                                                    orig_entry->d_name);
+
+        if (prev == hashed_subvol)
+            return _gf_true;
+        if ((hashed_subvol && dht_subvol_status(conf, hashed_subvol)) ||
+            (prev != first_up_subvol))
+            return _gf_false;
+    }
+
+    return _gf_true;
+}
+
+/* Copies an entry read from prev to be returned by DHT, and links the layout
+ * of the files into their inodes */
+static gf_dirent_t *
+dht_readdirp_entry_dup(xlator_t *this, dht_layout_t *layout, xlator_t *prev,
+                       inode_table_t *itable, gf_dirent_t *orig_entry)
+{
+    dht_conf_t *conf = this->private;
+    gf_dirent_t *entry = NULL;
+    xlator_t *subvol = NULL;
+    inode_t *inode = NULL;
+    int ret = 0;
+
+    entry = gf_dirent_for_name(orig_entry->d_name);
+    if (!entry) {
+        return NULL;
+    }
+
+    /* Do this if conf->search_unhashed is set to "auto" */
+    if (conf->search_unhashed == GF_DHT_LOOKUP_UNHASHED_AUTO) {
+        subvol = conf->methods.layout_search(this, layout, orig_entry->d_name);
+        if (!subvol || (subvol != prev)) {
+            /* TODO: Count the number of entries which need
+               linkfile to prove its existence in fs */
+            layout->search_unhashed++;
+        }
+    }
+
+    entry->d_off = orig_entry->d_off;
+    entry->d_stat = orig_entry->d_stat;
+    entry->d_ino = orig_entry->d_ino;
+    entry->d_type = orig_entry->d_type;
+    entry->d_len = orig_entry->d_len;
+
+    if (orig_entry->dict)
+        entry->dict = dict_ref(orig_entry->dict);
+
+    /* making sure we set the inode ctx right with layout,
+       currently possible only for non-directories, so for
+       directories don't set entry inodes */
+    if (IA_ISDIR(entry->d_stat.ia_type)) {
+        entry->d_stat.ia_blocks = DHT_DIR_STAT_BLOCKS;
+        entry->d_stat.ia_size = DHT_DIR_STAT_SIZE;
+        if (orig_entry->inode) {
+            dht_inode_ctx_time_update(orig_entry->inode, this, &entry->d_stat,
+                                      1);
+
+            if (conf->subvolume_cnt == 1) {
+                dht_populate_inode_for_dentry(this, prev, entry, orig_entry);
+            }
+        }
+    } else {
+        if (orig_entry->dict &&
+            dict_get(orig_entry->dict, conf->link_xattr_name)) {
+            /* Strip out the S and T flags set by rebalance*/
+            DHT_STRIP_PHASE1_FLAGS(&entry->d_stat);
+        }
+
+        if (orig_entry->inode) {
+            ret = dht_layout_preset(this, prev, orig_entry->inode);
+            if (ret)
+                gf_msg(this->name, GF_LOG_WARNING, 0, DHT_MSG_LAYOUT_SET_FAILED,
+                       "failed to link the layout "
+                       "in inode for %s",
+                       orig_entry->d_name);
+
+            entry->inode = inode_ref(orig_entry->inode);
+        } else if (itable) {
+            /*
+             * orig_entry->inode might be null if any upper
+             * layer xlators below client set to null, to
+             * force a lookup on the inode even if the inode
+             * is present in the inode table. In that case
+             * we just update the ctx to make sure we didn't
+             * missed anything.
+             */
+            inode = inode_find(itable, orig_entry->d_stat.ia_gfid);
+            if (inode) {
+                ret = dht_layout_preset(this, prev, inode);
+                if (ret)
+                    gf_msg(this->name, GF_LOG_WARNING, 0,
+                           DHT_MSG_LAYOUT_SET_FAILED,
+                           "failed to link the layout"
+                           " in inode for %s",
+                           orig_entry->d_name);
+                inode_unref(inode);
+                inode = NULL;
+            }
+        }
+    }
+
+    gf_msg_debug(this->name, 0, "%s: Adding entry = %s", prev->name,
+                 entry->d_name);
+
+    return entry;
+}
+
 /* Posix returns op_errno = ENOENT to indicate that there are no more
  * entries
  */
@@ -6730,14 +6992,8 @@ dht_readdirp_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
     int count = 0;
     dht_layout_t *layout = NULL;
     dht_conf_t *conf = NULL;
-    dht_methods_t *methods = NULL;
-    xlator_t *subvol = 0;
-    xlator_t *hashed_subvol = 0;
     int ret = 0;
-    int readdir_optimize = 0;
     inode_table_t *itable = NULL;
-    inode_t *inode = NULL;
-    gf_boolean_t skip_hashed_check = _gf_false;
 
     INIT_LIST_HEAD(&entries.list);
 
@@ -6750,23 +7006,10 @@ dht_readdirp_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
     conf = this->private;
     GF_VALIDATE_OR_GOTO(this->name, conf, unwind);
 
-    methods = &(conf->methods);
-
     if (op_ret <= 0) {
         goto done;
     }
 
-    /* Why aren't we skipping DHT entirely in case of a single subvol?
-     * Because if this was a larger volume earlier and all but one subvol
-     * was removed, there might be stale linkto files on the subvol.
-     */
-    if (conf->subvolume_cnt == 1) {
-        /* return all directory and file entries except
-         * linkto files for a single child DHT
-         */
-        skip_hashed_check = _gf_true;
-    }
-
     if (!local->layout)
         local->layout = dht_layout_get(this, local->fd->inode);
 
@@ -6779,149 +7022,21 @@ dht_readdirp_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
     if (layout == NULL)
         goto done;
 
-    if (conf->readdir_optimize == _gf_true)
-        readdir_optimize = 1;
-
     gf_msg_debug(this->name, 0, "Processing entries from %s", prev->name);
 
     list_for_each_entry(orig_entry, (&orig_entries->list), list)
     {
         next_offset = orig_entry->d_off;
 
-        gf_msg_debug(this->name, 0, "%s: entry = %s, type = %d", prev->name,
-                     orig_entry->d_name, orig_entry->d_type);
-
-        if (IA_ISINVAL(orig_entry->d_stat.ia_type)) {
-            /*stat failed somewhere- display this entry but the data may
-             * be inaccurate.
-             */
-            gf_msg_debug(this->name, EINVAL, "Invalid stat for %s (gfid %s)",
-                         orig_entry->d_name,
-                         uuid_utoa(orig_entry->d_stat.ia_gfid));
-        }
-
-        if (check_is_linkfile(NULL, (&orig_entry->d_stat), orig_entry->dict,
-                              conf->link_xattr_name)) {
-            gf_msg_debug(this->name, 0, "%s: %s is a linkto file", prev->name,
-                         orig_entry->d_name);
+        if (!dht_readdirp_is_listed(this, layout, prev, local->first_up_subvol,
+                                    orig_entry))
             continue;
-        }
 
-        if (skip_hashed_check) {
-            goto list;
-        }
-
-        if (check_is_dir(NULL, (&orig_entry->d_stat), NULL)) {
-            /*Directory entries filtering :
-             * a) If rebalance is running, pick from first_up_subvol
-             * b) (rebalance not running)hashed subvolume is NULL or
-             * down then filter in first_up_subvolume. Other wise the
-             * corresponding hashed subvolume will take care of the
-             * directory entry.
-             */
-            if (readdir_optimize) {
-                if (prev == local->first_up_subvol)
-                    goto list;
-                else
-                    continue;
-            }
-
-            hashed_subvol = methods->layout_search(this, layout,
-                                                   orig_entry->d_name);
-
-            if (prev == hashed_subvol)
-                goto list;
-            if ((hashed_subvol && dht_subvol_status(conf, hashed_subvol)) ||
-                (prev != local->first_up_subvol))
-                continue;
-
-            goto list;
-        }
-
-    list:
-        entry = gf_dirent_for_name(orig_entry->d_name);
+        entry = dht_readdirp_entry_dup(this, layout, prev, itable, orig_entry);
         if (!entry) {
             goto unwind;
         }
 
-        /* Do this if conf->search_unhashed is set to "auto" */
-        if (conf->search_unhashed == GF_DHT_LOOKUP_UNHASHED_AUTO) {
-            subvol = methods->layout_search(this, layout, orig_entry->d_name);
-            if (!subvol || (subvol != prev)) {
-                /* TODO: Count the number of entries which need
-                   linkfile to prove its existence in fs */
-                layout->search_unhashed++;
-            }
-        }
-
-        entry->d_off = orig_entry->d_off;
-        entry->d_stat = orig_entry->d_stat;
-        entry->d_ino = orig_entry->d_ino;
-        entry->d_type = orig_entry->d_type;
-        entry->d_len = orig_entry->d_len;
-
-        if (orig_entry->dict)
-            entry->dict = dict_ref(orig_entry->dict);
-
-        /* making sure we set the inode ctx right with layout,
-           currently possible only for non-directories, so for
-           directories don't set entry inodes */
-        if (IA_ISDIR(entry->d_stat.ia_type)) {
-            entry->d_stat.ia_blocks = DHT_DIR_STAT_BLOCKS;
-            entry->d_stat.ia_size = DHT_DIR_STAT_SIZE;
-            if (orig_entry->inode) {
-                dht_inode_ctx_time_update(orig_entry->inode, this,
-                                          &entry->d_stat, 1);
-
-                if (conf->subvolume_cnt == 1) {
-                    dht_populate_inode_for_dentry(this, prev, entry,
-                                                  orig_entry);
-                }
-            }
-        } else {
-            if (orig_entry->dict &&
-                dict_get(orig_entry->dict, conf->link_xattr_name)) {
-                /* Strip out the S and T flags set by rebalance*/
-                DHT_STRIP_PHASE1_FLAGS(&entry->d_stat);
-            }
-
-            if (orig_entry->inode) {
-                ret = dht_layout_preset(this, prev, orig_entry->inode);
-                if (ret)
-                    gf_msg(this->name, GF_LOG_WARNING, 0,
-                           DHT_MSG_LAYOUT_SET_FAILED,
-                           "failed to link the layout "
-                           "in inode for %s",
-                           orig_entry->d_name);
-
-                entry->inode = inode_ref(orig_entry->inode);
-            } else if (itable) {
-                /*
-                 * orig_entry->inode might be null if any upper
-                 * layer xlators below client set to null, to
-                 * force a lookup on the inode even if the inode
-                 * is present in the inode table. In that case
-                 * we just update the ctx to make sure we didn't
-                 * missed anything.
-                 */
-                inode = inode_find(itable, orig_entry->d_stat.ia_gfid);
-                if (inode) {
-                    ret = dht_layout_preset(this, prev, inode);
-                    if (ret)
-                        gf_msg(this->name, GF_LOG_WARNING, 0,
-                               DHT_MSG_LAYOUT_SET_FAILED,
-                               "failed to link the layout"
-                               " in inode for %s",
-                               orig_entry->d_name);
-                    inode_unref(inode);
-                    inode = NULL;
-                }
-            }
-        }
-
-        gf_msg_debug(this->name, 0, "%s: Adding entry = %s", prev->name,
-                     entry->d_name);
-
         list_add_tail(&entry->list, &entries.list);
         count++;
     }
@@ -7166,6 +7281,425 @@ unwind:
     return 0;
 }
 
+/* Returns the entries read ahead on the subvolumes for the waiting readdirp,
+ * taking them from each subvolume in turn. Returns _gf_false if it has to
+ * keep waiting. */
+static gf_boolean_t
+__dht_rdm_fill(dht_rdm_cursor_t *cursor, gf_dirent_t *entries, int *count,
+               int *op_errno)
+{
+    dht_rdm_subvol_t *subvol = NULL;
+    gf_dirent_t *entry = NULL;
+    gf_dirent_t *tmp = NULL;
+    size_t size = 0;
+    int oldest = 0;
+    int slot = 0;
+    int done = 0;
+    int i = 0;
+    int k = 0;
+
+    *count = 0;
+    *op_errno = 0;
+
+    for (k = 0; k < cursor->cnt; k++) {
+        i = (cursor->next + k) % cursor->cnt;
+        subvol = &cursor->subvols[i];
+
+        list_for_each_entry_safe(entry, tmp, &subvol->entries.list, list)
+        {
+            size += gf_dirent_size(entry->d_name);
+            if (*count && (size > cursor->size))
+                goto out;
+
+            list_del_init(&entry->list);
+            list_add_tail(&entry->list, &entries->list);
+            subvol->entry_cnt--;
+            (*count)++;
+
+            /* Remember where this entry leaves every subvolume */
+            if (cursor->hist_cnt == DHT_RDM_HISTORY) {
+                oldest = cursor->hist_start;
+                slot = cursor->hist_subvol[oldest];
+                cursor->subvols[slot].base_off = cursor->hist_off[oldest];
+                cursor->hist_start = (oldest + 1) % DHT_RDM_HISTORY;
+                cursor->hist_seq++;
+                cursor->hist_cnt--;
+            }
+            slot = (cursor->hist_start + cursor->hist_cnt) % DHT_RDM_HISTORY;
+            cursor->hist_subvol[slot] = i;
+            cursor->hist_off[slot] = entry->d_off;
+            cursor->hist_cnt++;
+
+            subvol->emit_off = entry->d_off;
+            entry->d_off = ++cursor->seq;
+        }
+        cursor->next = (i + 1) % cursor->cnt;
+    }
+
+out:
+    if (*count)
+        return _gf_true;
+
+    for (i = 0; i < cursor->cnt; i++) {
+        subvol = &cursor->subvols[i];
+        if (subvol->op_errno) {
+            *op_errno = subvol->op_errno;
+            subvol->op_errno = 0;
+            return _gf_true;
+        }
+        if (subvol->eod)
+            done++;
+    }
+
+    if (done == cursor->cnt) {
+        *op_errno = ENOENT;
+        return _gf_true;
+    }
+
+    return _gf_false;
+}
+
+static void
+__dht_rdm_restart(dht_rdm_cursor_t *cursor)
+{
+    dht_rdm_subvol_t *subvol = NULL;
+    int i = 0;
+
+    for (i = 0; i < cursor->cnt; i++) {
+        subvol = &cursor->subvols[i];
+        gf_dirent_free(&subvol->entries);
+        subvol->entry_cnt = 0;
+        subvol->read_off = subvol->emit_off;
+        subvol->op_errno = 0;
+        subvol->eod = _gf_false;
+        if (subvol->inflight)
+            subvol->discard = _gf_true;
+    }
+}
+
+/* Moves the cursor just after the entry returned with d_off == yoff */
+static int
+__dht_rdm_seek(xlator_t *this, dht_rdm_cursor_t *cursor, off_t yoff)
+{
+    dht_rdm_subvol_t *subvol = NULL;
+    uint64_t seq = yoff;
+    int slot = 0;
+    int i = 0;
+
+    if (yoff == 0) {
+        for (i = 0; i < cursor->cnt; i++) {
+            cursor->subvols[i].base_off = 0;
+            cursor->subvols[i].emit_off = 0;
+        }
+        cursor->seq = 0;
+        cursor->hist_seq = 1;
+        cursor->hist_start = 0;
+        cursor->hist_cnt = 0;
+        cursor->next = 0;
+        cursor->first_up_subvol = dht_first_up_subvol(this);
+        __dht_rdm_restart(cursor);
+        return 0;
+    }
+
+    if (seq == cursor->seq)
+        return 0;
+
+    if ((yoff < 0) || (seq > cursor->seq) || (seq + 1 < cursor->hist_seq))
+        return -1;
+
+    for (i = 0; i < cursor->cnt; i++)
+        cursor->subvols[i].emit_off = cursor->subvols[i].base_off;
+
+    cursor->hist_cnt = seq + 1 - cursor->hist_seq;
+    for (i = 0; i < cursor->hist_cnt; i++) {
+        slot = (cursor->hist_start + i) % DHT_RDM_HISTORY;
+        subvol = &cursor->subvols[cursor->hist_subvol[slot]];
+        subvol->emit_off = cursor->hist_off[slot];
+    }
+    cursor->seq = seq;
+    __dht_rdm_restart(cursor);
+
+    return 0;
+}
+
+/* A subvolume is read when it has nothing left to return, either for a
+ * waiting readdirp or to read ahead once for the next one */
+static int
+__dht_rdm_pick(dht_rdm_cursor_t *cursor)
+{
+    dht_rdm_subvol_t *subvol = NULL;
+    int i = 0;
+
+    if (!cursor->waiter && !cursor->prefetch)
+        return -1;
+
+    for (i = 0; i < cursor->cnt; i++) {
+        subvol = &cursor->subvols[i];
+        if (!subvol->inflight && !subvol->eod && !subvol->op_errno &&
+            !subvol->entry_cnt)
+            return i;
+    }
+
+    return -1;
+}
+
+static int
+dht_rdm_readdirp_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                     int op_ret, int op_errno, gf_dirent_t *orig_entries,
+                     dict_t *xdata);
+
+/* Answers the waiting readdirp and sends the readdirps it needs. Only one
+ * thread does it at a time, the others leave their work to it. */
+static void
+dht_rdm_run(call_frame_t *frame, xlator_t *this, fd_t *fd,
+            dht_rdm_cursor_t *cursor, gf_boolean_t prefetch)
+{
+    dht_conf_t *conf = this->private;
+    call_frame_t *waiter = NULL;
+    call_frame_t *rframe = NULL;
+    dht_local_t *rlocal = NULL;
+    xlator_t *subvol = NULL;
+    dict_t *xattr = NULL;
+    gf_dirent_t entries;
+    off_t offset = 0;
+    size_t size = 0;
+    int op_errno = 0;
+    int count = 0;
+    int i = -1;
+
+    INIT_LIST_HEAD(&entries.list);
+
+    LOCK(&cursor->lock);
+    if (prefetch)
+        cursor->prefetch = _gf_true;
+    if (cursor->running) {
+        UNLOCK(&cursor->lock);
+        return;
+    }
+    cursor->running = _gf_true;
+
+    for (;;) {
+        waiter = NULL;
+        i = -1;
+
+        if (cursor->waiter &&
+            __dht_rdm_fill(cursor, &entries, &count, &op_errno)) {
+            waiter = cursor->waiter;
+            cursor->waiter = NULL;
+            /* Read ahead what this reply consumed */
+            cursor->prefetch = _gf_true;
+        } else {
+            i = __dht_rdm_pick(cursor);
+            if (i < 0) {
+                cursor->prefetch = _gf_false;
+                cursor->running = _gf_false;
+                break;
+            }
+
+            subvol = conf->subvolumes[i];
+            cursor->subvols[i].inflight = _gf_true;
+            offset = cursor->subvols[i].read_off;
+            size = cursor->size;
+            xattr = cursor->xattr;
+            if (cursor->xattr_skip_dirs && (subvol != cursor->first_up_subvol))
+                xattr = cursor->xattr_skip_dirs;
+            dict_ref(xattr);
+        }
+        UNLOCK(&cursor->lock);
+
+        if (waiter) {
+            if (op_errno && (op_errno != ENOENT))
+                count = -1;
+            DHT_STACK_UNWIND(readdirp, waiter, count, op_errno, &entries,
+                             NULL);
+            gf_dirent_free(&entries);
+            INIT_LIST_HEAD(&entries.list);
+            LOCK(&cursor->lock);
+            continue;
+        }
+
+        rframe = copy_frame(frame);
+        if (rframe) {
+            rlocal = dht_local_init(rframe, NULL, fd, GF_FOP_READDIRP);
+            if (!rlocal) {
+                DHT_STACK_DESTROY(rframe);
+                rframe = NULL;
+            }
+        }
+
+        if (rframe) {
+            STACK_WIND_COOKIE(rframe, dht_rdm_readdirp_cbk, subvol, subvol,
+                              subvol->fops->readdirp, fd, size, offset, xattr);
+        }
+        dict_unref(xattr);
+
+        LOCK(&cursor->lock);
+        if (!rframe) {
+            cursor->subvols[i].inflight = _gf_false;
+            cursor->subvols[i].op_errno = ENOMEM;
+        }
+    }
+    UNLOCK(&cursor->lock);
+}
+
+static int
+dht_rdm_readdirp_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                     int op_ret, int op_errno, gf_dirent_t *orig_entries,
+                     dict_t *xdata)
+{
+    dht_rdm_cursor_t *cursor = NULL;
+    dht_rdm_subvol_t *subvol = NULL;
+    dht_local_t *local = NULL;
+    gf_dirent_t *orig_entry = NULL;
+    gf_dirent_t *entry = NULL;
+    xlator_t *prev = cookie;
+    inode_table_t *itable = NULL;
+    gf_dirent_t entries;
+    off_t next_offset = 0;
+    int count = 0;
+    int i = 0;
+
+    INIT_LIST_HEAD(&entries.list);
+
+    local = frame->local;
+    itable = local->fd->inode->table;
+
+    cursor = dht_rdm_cursor_get(this, local->fd, _gf_false, NULL);
+    i = dht_subvol_cnt(this, prev);
+    if (!cursor || (i < 0) || (i >= cursor->cnt))
+        goto out;
+
+    if (op_ret < 0) {
+        /* Same as a sequential readdirp: the subvolume is skipped */
+        gf_msg_debug(this->name, op_errno, "%s: readdirp failed, skipping it",
+                     prev->name);
+    }
+
+    if (op_ret > 0) {
+        list_for_each_entry(orig_entry, (&orig_entries->list), list)
+        {
+            next_offset = orig_entry->d_off;
+
+            /* Without a layout the entries are skipped, like in
+             * dht_readdirp_cbk() */
+            if (!local->layout)
+                continue;
+
+            /* Linkto files and duplicate directories are dropped as they
+             * arrive */
+            if (!dht_readdirp_is_listed(this, local->layout, prev,
+                                        cursor->first_up_subvol, orig_entry))
+                continue;
+
+            entry = dht_readdirp_entry_dup(this, local->layout, prev, itable,
+                                           orig_entry);
+            if (!entry) {
+                op_ret = -1;
+                op_errno = ENOMEM;
+                break;
+            }
+            list_add_tail(&entry->list, &entries.list);
+            count++;
+        }
+    }
+
+    LOCK(&cursor->lock);
+    {
+        subvol = &cursor->subvols[i];
+        subvol->inflight = _gf_false;
+
+        if (subvol->discard) {
+            subvol->discard = _gf_false;
+        } else if ((op_ret < 0) && (op_errno == ENOMEM)) {
+            subvol->op_errno = op_errno;
+        } else {
+            if ((op_ret <= 0) || (op_errno == ENOENT))
+                subvol->eod = _gf_true;
+            else
+                subvol->read_off = next_offset;
+
+            /* Appended after the entries still queued */
+            list_splice_init(&entries.list, subvol->entries.list.prev);
+            subvol->entry_cnt += count;
+        }
+    }
+    UNLOCK(&cursor->lock);
+
+    dht_rdm_run(frame, this, local->fd, cursor, _gf_false);
+
+out:
+    gf_dirent_free(&entries);
+    DHT_STACK_DESTROY(frame);
+    return 0;
+}
+
+/* readdirp in merged mode: readdirps are sent to all the subvolumes at
+ * once and entries are returned as soon as any of them answers */
+static int
+dht_rdm_readdirp(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+                 off_t yoff, dict_t *xdata)
+{
+    dht_rdm_cursor_t *cursor = NULL;
+    call_frame_t *tframe = NULL;
+    dht_local_t *local = NULL;
+    int op_errno = 0;
+    int ret = 0;
+
+    local = dht_local_init(frame, NULL, fd, GF_FOP_READDIRP);
+    if (!local) {
+        op_errno = ENOMEM;
+        goto err;
+    }
+
+    /* frame may be unwound by another thread as soon as it is queued, the
+     * readdirps to the subvolumes are sent from a copy */
+    tframe = copy_frame(frame);
+    if (!tframe) {
+        op_errno = ENOMEM;
+        goto err;
+    }
+
+    cursor = dht_rdm_cursor_get(this, fd, _gf_true, xdata);
+    if (!cursor) {
+        op_errno = ENOMEM;
+        goto err;
+    }
+
+    LOCK(&cursor->lock);
+    {
+        if (cursor->waiter) {
+            op_errno = EBUSY;
+        } else {
+            ret = __dht_rdm_seek(this, cursor, yoff);
+            if (ret) {
+                op_errno = EINVAL;
+            } else {
+                cursor->waiter = frame;
+                cursor->size = size;
+            }
+        }
+    }
+    UNLOCK(&cursor->lock);
+
+    if (op_errno) {
+        gf_msg(this->name, GF_LOG_WARNING, op_errno, DHT_MSG_INVALID_VALUE,
+               "merged readdirp at offset %" PRId64 " on %s failed", yoff,
+               uuid_utoa(fd->inode->gfid));
+        goto err;
+    }
+
+    dht_rdm_run(tframe, this, fd, cursor, _gf_false);
+    STACK_DESTROY(tframe->root);
+
+    return 0;
+
+err:
+    if (tframe)
+        STACK_DESTROY(tframe->root);
+    DHT_STACK_UNWIND(readdirp, frame, -1, op_errno, NULL, NULL);
+    return 0;
+}
+
 static int
 dht_do_readdir(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
                off_t yoff, int whichop, dict_t *dict)
@@ -7183,6 +7717,16 @@ dht_do_readdir(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
 
     conf = this->private;
 
+    /* Offsets of a merged listing mean nothing to dht_deitransform(), so
+     * every readdirp goes to the merged path while the option is on, and
+     * a listing started in merged mode stays in it for the life of the fd.
+     * The merged path fails the offsets it does not know with EINVAL. */
+    if ((whichop == GF_FOP_READDIRP) && (conf->subvolume_cnt > 1) &&
+        (conf->readdir_merge ||
+         dht_rdm_cursor_get(this, fd, _gf_false, NULL))) {
+        return dht_rdm_readdirp(frame, this, fd, size, yoff, dict);
+    }
+
     local = dht_local_init(frame, NULL, NULL, whichop);
     if (!local) {
         op_errno = ENOMEM;
@@ -10938,11 +11482,49 @@ dht_forget(xlator_t *this, inode_t *inode)
     layout = ctx->layout;
     ctx->layout = NULL;
     dht_layout_unref(layout);
+    dht_ncache_destroy(ctx->ncache);
     GF_FREE(ctx);
 
     return 0;
 }
 
+/* Drops the lookup caches of the directories named in a cache
+ * invalidation */
+static void
+dht_ncache_upcall(xlator_t *this, struct gf_upcall *up_data)
+{
+    struct gf_upcall_cache_invalidation *up_ci = NULL;
+    inode_table_t *itable = NULL;
+    inode_t *inode = NULL;
+    uuid_t gfids[3];
+    int i = 0;
+
+    if (!this->graph || !this->graph->top)
+        return;
+
+    itable = ((xlator_t *)this->graph->top)->itable;
+    if (!itable)
+        return;
+
+    up_ci = (struct gf_upcall_cache_invalidation *)up_data->data;
+
+    gf_uuid_copy(gfids[0], up_data->gfid);
+    gf_uuid_copy(gfids[1], up_ci->p_stat.ia_gfid);
+    gf_uuid_copy(gfids[2], up_ci->oldp_stat.ia_gfid);
+
+    for (i = 0; i < 3; i++) {
+        if (gf_uuid_is_null(gfids[i]))
+            continue;
+
+        inode = inode_find(itable, gfids[i]);
+        if (!inode)
+            continue;
+
+        dht_ncache_invalidate(this, inode, NULL);
+        inode_unref(inode);
+    }
+}
+
 int
 dht_notify(xlator_t *this, int event, void *data, ...)
 {
@@ -11140,6 +11722,9 @@ dht_notify(xlator_t *this, int event, void *data, ...)
             if (IS_DHT_LINKFILE_MODE(&up_ci->stat))
                 up_ci->flags |= UP_EXPLICIT_LOOKUP;
 
+            /* Entries were added or removed by another client */
+            dht_ncache_upcall(this, up_data);
+
             propagate = 1;
             break;
         default:
@@ -11379,6 +11964,12 @@ dht_release(xlator_t *this, fd_t *fd)
     return dht_fd_ctx_destroy(this, fd);
 }
 
+int32_t
+dht_releasedir(xlator_t *this, fd_t *fd)
+{
+    return dht_fd_ctx_destroy(this, fd);
+}
+
 static int
 dht_pt_mkdir_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
                  int op_errno, inode_t *inode, struct iatt *stbuf,
@@ -25,6 +25,7 @@
 
 #define GF_XATTR_FIX_LAYOUT_KEY "distribute.fix.layout"
 #define GF_XATTR_FILE_MIGRATE_KEY "trusted.distribute.migrate-data"
+#define DHT_REBAL_CHECKPOINT_KEY "trusted.distribute.rebalance-checkpoint"
 #define DHT_MDS_STR "mds"
 #define GF_DHT_LOOKUP_UNHASHED_OFF 0
 #define GF_DHT_LOOKUP_UNHASHED_ON 1
@@ -88,6 +89,12 @@ struct dht_layout {
     int type;
     gf_atomic_t ref; /* use with dht_conf_t->layout_lock */
     uint32_t search_unhashed;
+    /* Built by dht_layout_compile(): the starts of the non-empty ranges in
+     * ascending order and the index in list[] of each one. search_cnt is 0
+     * when the table is not usable and list[] has to be scanned. */
+    gf_atomic_t search_cnt;
+    uint32_t *search_start;
+    int *search_idx;
     struct {
         int err; /* 0 = normal
                     -1 = dir exists and no xattr
@@ -112,11 +119,42 @@ struct dht_stat_time {
 
 typedef struct dht_stat_time dht_stat_time_t;
 
+#define DHT_NCACHE_BUCKETS 16
+#define DHT_NCACHE_MAX_ENTRIES 256
+
+/* Return values of dht_ncache_lookup() */
+#define DHT_NCACHE_NEGATIVE 1
+#define DHT_NCACHE_LINKTO 2
+
+/* Outcome of a fresh lookup of a name: a miss, or a file that was reached
+ * through a linkto file on its hashed subvolume */
+typedef struct dht_ncache_entry {
+    struct list_head hash;
+    struct list_head lru;
+    xlator_t *cached_subvol; /* NULL for a miss */
+    uuid_t gfid;
+    time_t expire;
+    char name[];
+} dht_ncache_entry_t;
+
+/* Per directory cache of those outcomes. It is only good for the layout
+ * the directory had when it was filled. */
+typedef struct dht_ncache {
+    gf_lock_t lock;
+    struct list_head buckets[DHT_NCACHE_BUCKETS];
+    struct list_head lru;
+    uint32_t commit_hash;
+    int layout_gen;
+    int count;
+    uint64_t version; /* bumped by every invalidation */
+} dht_ncache_t;
+
 struct dht_inode_ctx {
     dht_layout_t *layout;
     dht_stat_time_t time;
     xlator_t *lock_subvol;
     xlator_t *mds_subvol; /* This is only used for directories */
+    dht_ncache_t *ncache; /* This is only used for directories */
 };
 
 typedef struct dht_inode_ctx dht_inode_ctx_t;
@@ -347,6 +385,9 @@ struct dht_local {
     /* rename rollback */
     int *ret_cache;
 
+    /* when a writev was wound, for placement-weighting */
+    struct timespec wind_time;
+
     loc_t loc2_copy;
 
     int rename_inodelk_bc_count;
@@ -371,6 +412,12 @@ struct dht_local {
     gf_boolean_t locked;
     gf_boolean_t dont_create_linkto;
     gf_boolean_t gfid_missing;
+
+    /* lookup cache of the parent: its version when the lookup was wound,
+     * whether the outcome may be cached and whether it came from there */
+    uint64_t ncache_version;
+    gf_boolean_t ncache_armed;
+    gf_boolean_t ncache_hit;
 };
 typedef struct dht_local dht_local_t;
 
@@ -384,9 +431,20 @@ struct dht_du {
     uint32_t total_blocks;
     uint32_t avail_blocks;
     uint32_t frsize; /*fragment size*/
+    /* Measured speed, for placement-weighting. Only kept in memory: it
+     * changes with the load, layouts written to disk must not. */
+    struct timespec probe_start; /* of the last statfs */
+    double probe_usec;           /* statfs latency */
+    gf_atomic_t write_usec;      /* time spent in writevs... */
+    gf_atomic_t write_bytes;     /* ...to write these many bytes */
 };
 typedef struct dht_du dht_du_t;
 
+#define DHT_PLACEMENT_MAX_WEIGHT 1024
+/* Write samples are summed until this many bytes, then halved, so the
+ * speed follows the recent load */
+#define DHT_PLACEMENT_WRITE_WINDOW (1ULL << 30)
+
 enum gf_defrag_type {
     GF_DEFRAG_CMD_NONE = 0,
     GF_DEFRAG_CMD_START = 1,
@@ -430,6 +488,19 @@ struct gf_defrag_pattern_list {
     gf_defrag_pattern_list_t *next;
 };
 
+/* A directory handed out by the parallel rebalance crawler. It is kept
+ * until its subtree is crawled and the files queued from it are migrated,
+ * which is when it can be checkpointed. */
+typedef struct gf_defrag_crawl_item {
+    struct list_head list;
+    struct gf_defrag_crawl_item *parent;
+    loc_t loc;
+    int depth;
+    gf_atomic_t pending; /* itself, child dirs and queued files */
+    gf_boolean_t failed;
+    gf_boolean_t checkpointed;
+} gf_defrag_crawl_item_t;
+
 struct dht_container {
     union {
         struct list_head list;
@@ -443,6 +514,7 @@ struct dht_container {
     loc_t *parent_loc;
     dict_t *migrate_data;
     int local_subvol_index;
+    gf_defrag_crawl_item_t *crawl_item;
 };
 
 typedef struct nodeuuid_info {
@@ -596,6 +668,15 @@ struct dht_conf {
 
     gf_boolean_t force_migration;
 
+    /* number of chunks of a file in flight while migrating it */
+    uint32_t rebal_io_window;
+
+    /* number of threads crawling the directory tree during rebalance */
+    uint32_t rebal_crawl_threads;
+
+    /* seconds lookup misses and linkto targets are cached, 0 is off */
+    uint32_t lookup_cache_timeout;
+
     gf_boolean_t lookup_optimize;
 
     gf_boolean_t unhashed_sticky_bit;
@@ -607,13 +688,26 @@ struct dht_conf {
     /* Request to filter directory entries in readdir request */
     gf_boolean_t readdir_optimize;
 
+    /* Read directories from all the subvolumes at once */
+    gf_boolean_t readdir_merge;
+
     gf_boolean_t rsync_regex_valid;
 
     gf_boolean_t extra_regex_valid;
 
+    /* Identifies the hash regexes in the per-thread name hash cache,
+     * changes whenever they are reconfigured */
+    uint64_t hash_epoch;
+
     /* Support size-weighted rebalancing (heterogeneous bricks). */
     gf_boolean_t do_weighting;
 
+    /* Placement policy of new directory layouts */
+    gf_boolean_t placement_weighting;
+    char *subvol_device_classes;
+    char *device_class_weights;
+    char *device_class_pins;
+
     gf_boolean_t randomize_by_gfid;
 
     gf_boolean_t ensure_durability;
@@ -657,6 +751,7 @@ struct dir_dfmeta {
     int *fetch_entries;
     /* fds corresponding to local subvols only */
     fd_t **lfd;
+    gf_defrag_crawl_item_t *crawl_item;
 };
 
 typedef struct dht_migrate_info {
@@ -665,8 +760,47 @@ typedef struct dht_migrate_info {
     GF_REF_DECL;
 } dht_migrate_info_t;
 
+/* Merged readdirp: a directory listing reading all the subvolumes at once
+ * (cluster.readdir-merge). The d_off of a returned entry is its position in
+ * the merged listing, mapped back to an offset on every subvolume through
+ * the history of the last returned entries. */
+#define DHT_RDM_HISTORY 1024
+
+typedef struct dht_rdm_subvol {
+    gf_dirent_t entries; /* read and filtered, not returned yet */
+    int entry_cnt;
+    off_t read_off; /* where the next readdirp on it starts */
+    off_t emit_off; /* just past its last returned entry */
+    off_t base_off; /* emit_off before the oldest entry of the history */
+    int op_errno;   /* the readdirp could not be sent */
+    gf_boolean_t inflight;
+    gf_boolean_t discard; /* the reply of the inflight readdirp is stale */
+    gf_boolean_t eod;
+} dht_rdm_subvol_t;
+
+typedef struct dht_rdm_cursor {
+    gf_lock_t lock;
+    dict_t *xattr;           /* sent to the subvolumes */
+    dict_t *xattr_skip_dirs; /* for readdir-optimize */
+    xlator_t *first_up_subvol;
+    call_frame_t *waiter; /* readdirp waiting for entries */
+    size_t size;
+    uint64_t seq; /* d_off of the last returned entry */
+    uint64_t hist_seq; /* d_off of the oldest entry in the history */
+    int hist_start;
+    int hist_cnt;
+    int hist_subvol[DHT_RDM_HISTORY];
+    off_t hist_off[DHT_RDM_HISTORY];
+    int next; /* subvolume to return entries from first */
+    gf_boolean_t running;
+    gf_boolean_t prefetch;
+    int cnt;
+    dht_rdm_subvol_t subvols[];
+} dht_rdm_cursor_t;
+
 typedef struct dht_fd_ctx {
     uint64_t opened_on_dst;
+    dht_rdm_cursor_t *rdm; /* only for directories */
     GF_REF_DECL;
 } dht_fd_ctx_t;
 
@@ -715,6 +849,8 @@ typedef struct dht_fd_ctx {
             __local = frame->local;                                            \
             frame->local = NULL;                                               \
         }                                                                      \
+        if (__local)                                                           \
+            dht_ncache_fop_unwind(frame->this, __local);                       \
         STACK_UNWIND_STRICT(fop, frame, params);                               \
         dht_local_wipe(__local);                                               \
     } while (0)
@@ -770,6 +906,10 @@ dht_layout_t *
 dht_layout_for_subvol(xlator_t *this, xlator_t *subvol);
 xlator_t *
 dht_layout_search(xlator_t *this, dht_layout_t *layout, const char *name);
+xlator_t *
+dht_layout_search_hash(dht_layout_t *layout, uint32_t hash);
+void
+dht_layout_compile(dht_layout_t *layout);
 int32_t
 dht_migration_get_dst_subvol(xlator_t *this, dht_local_t *local);
 int32_t
@@ -828,6 +968,11 @@ dht_subvol_cnt(xlator_t *this, xlator_t *subvol);
 int
 dht_hash_compute(xlator_t *this, int type, const char *name, uint32_t *hash_p);
 
+int
+dht_hash_epoch_init(void);
+void
+dht_hash_epoch_update(dht_conf_t *conf);
+
 int
 dht_linkfile_create(call_frame_t *frame, fop_mknod_cbk_t linkfile_cbk,
                     xlator_t *this, xlator_t *tovol, xlator_t *fromvol,
@@ -857,6 +1002,17 @@ dht_free_disk_available_subvol(xlator_t *this, xlator_t *subvol,
 int
 dht_get_du_info_for_subvol(xlator_t *this, int subvol_idx);
 
+gf_boolean_t
+dht_placement_factors(xlator_t *this, loc_t *loc, dht_layout_t *layout,
+                      uint32_t *factors);
+
+double
+dht_placement_usec_per_mb(dht_conf_t *conf, int idx);
+
+void
+dht_placement_sample(xlator_t *this, xlator_t *subvol, dht_local_t *local,
+                     size_t size);
+
 int
 dht_layout_preset(xlator_t *this, xlator_t *subvol, inode_t *inode);
 int
@@ -1161,6 +1317,17 @@ int
 dht_inode_ctx_get(inode_t *inode, xlator_t *this, dht_inode_ctx_t **ctx);
 int
 dht_inode_ctx_set(inode_t *inode, xlator_t *this, dht_inode_ctx_t *ctx);
+
+int
+dht_ncache_lookup(xlator_t *this, dht_local_t *local, xlator_t **subvol);
+void
+dht_ncache_add(xlator_t *this, dht_local_t *local, xlator_t *cached_subvol);
+void
+dht_ncache_invalidate(xlator_t *this, inode_t *dir, const char *name);
+void
+dht_ncache_fop_unwind(xlator_t *this, dht_local_t *local);
+void
+dht_ncache_destroy(dht_ncache_t *nc);
 int
 dht_dir_attr_heal(void *data);
 int
@@ -1172,6 +1339,8 @@ dht_subvol_with_free_space_inodes(xlator_t *this, xlator_t *subvol,
 xlator_t *
 dht_subvol_maxspace_nonzeroinode(xlator_t *this, xlator_t *subvol,
                                  dht_layout_t *layout);
+xlator_t *
+dht_subvol_fastest_with_free_space(xlator_t *this, dht_layout_t *layout);
 int
 dht_dir_has_layout(dict_t *xattr, char *name);
 int
@@ -1231,9 +1400,16 @@ dht_fd_open_on_dst(xlator_t *this, fd_t *fd, xlator_t *dst);
 int32_t
 dht_fd_ctx_destroy(xlator_t *this, fd_t *fd);
 
+dht_rdm_cursor_t *
+dht_rdm_cursor_get(xlator_t *this, fd_t *fd, gf_boolean_t create,
+                   dict_t *xdata);
+
 int32_t
 dht_release(xlator_t *this, fd_t *fd);
 
+int32_t
+dht_releasedir(xlator_t *this, fd_t *fd);
+
 int32_t
 dht_set_fixed_dir_stat(struct iatt *stat);
 
@@ -14,6 +14,23 @@
 
 #include <sys/time.h>
 #include <glusterfs/events.h>
+#include <glusterfs/timespec.h>
+
+/* Weight of a new sample in the averages of the measured latencies */
+#define DHT_PLACEMENT_EWMA(avg, sample)                                        \
+    ((avg) ? (((avg)*7 + (sample)) / 8) : (sample))
+
+static double
+dht_usec_since(struct timespec *start)
+{
+    struct timespec now;
+    struct timespec delta;
+
+    timespec_now(&now);
+    timespec_sub(start, &now, &delta);
+
+    return (delta.tv_sec * 1000000.0) + (delta.tv_nsec / 1000.0);
+}
 
 int
 dht_du_info_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
@@ -71,6 +88,11 @@ dht_du_info_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
     {
         for (i = 0; i < conf->subvolume_cnt; i++)
             if (prev == conf->subvolumes[i]) {
+                if (conf->du_stats[i].probe_start.tv_sec) {
+                    conf->du_stats[i].probe_usec = DHT_PLACEMENT_EWMA(
+                        conf->du_stats[i].probe_usec,
+                        dht_usec_since(&conf->du_stats[i].probe_start));
+                }
                 conf->du_stats[i].avail_percent = percent;
                 conf->du_stats[i].avail_space = bytes;
                 conf->du_stats[i].avail_inodes = percent_inodes;
@@ -130,6 +152,7 @@ dht_get_du_info_for_subvol(xlator_t *this, int subvol_idx)
     tmp_loc.gfid[15] = 1;
 
     statfs_local->call_cnt = 1;
+    timespec_now(&conf->du_stats[subvol_idx].probe_start);
     STACK_WIND_COOKIE(
         statfs_frame, dht_du_info_cbk, conf->subvolumes[subvol_idx],
         conf->subvolumes[subvol_idx],
@@ -188,6 +211,7 @@ dht_get_du_info(call_frame_t *frame, xlator_t *this, loc_t *loc)
 
         statfs_local->call_cnt = conf->subvolume_cnt;
         for (i = 0; i < conf->subvolume_cnt; i++) {
+            timespec_now(&conf->du_stats[i].probe_start);
             STACK_WIND_COOKIE(statfs_frame, dht_du_info_cbk,
                               conf->subvolumes[i], conf->subvolumes[i],
                               conf->subvolumes[i]->fops->statfs, &tmp_loc,
@@ -312,8 +336,11 @@ dht_free_disk_available_subvol(xlator_t *this, xlator_t *subvol,
 
     LOCK(&conf->subvolume_lock);
     {
-        avail_subvol = dht_subvol_with_free_space_inodes(this, subvol, NULL,
-                                                         layout, 0);
+        if (conf->placement_weighting)
+            avail_subvol = dht_subvol_fastest_with_free_space(this, layout);
+        if (!avail_subvol)
+            avail_subvol = dht_subvol_with_free_space_inodes(this, subvol,
+                                                             NULL, layout, 0);
         if (!avail_subvol) {
             avail_subvol = dht_subvol_maxspace_nonzeroinode(this, subvol,
                                                             layout);
@@ -445,6 +472,54 @@ dht_subvol_with_free_space_inodes(xlator_t *this, xlator_t *subvol,
     return avail_subvol;
 }
 
+/* With placement-weighting on, the files their hashed subvolume has no
+ * room for go to the fastest of the subvolumes with enough free space and
+ * inodes. Returns NULL when none of them has been measured yet. */
+xlator_t *
+dht_subvol_fastest_with_free_space(xlator_t *this, dht_layout_t *layout)
+{
+    dht_conf_t *conf = this->private;
+    xlator_t *avail_subvol = NULL;
+    gf_boolean_t by_writes = _gf_false;
+    gf_boolean_t written = _gf_false;
+    double best = 0;
+    double usec = 0;
+    int i = 0;
+
+    /* Write and statfs latencies do not compare, the statfs one is only
+     * used when no subvolume with room has been written to */
+    for (i = 0; i < conf->subvolume_cnt; i++) {
+        if (GF_ATOMIC_GET(conf->du_stats[i].write_bytes) >= (1 << 20))
+            by_writes = _gf_true;
+    }
+
+    for (i = 0; i < conf->subvolume_cnt; i++) {
+        if (dht_subvol_has_err(conf, conf->subvolumes[i], NULL, layout))
+            continue;
+
+        if (conf->du_stats[i].avail_inodes <= conf->min_free_inodes)
+            continue;
+        if ((conf->disk_unit == 'p') &&
+            (conf->du_stats[i].avail_percent <= conf->min_free_disk))
+            continue;
+        if ((conf->disk_unit != 'p') &&
+            (conf->du_stats[i].avail_space <= conf->min_free_disk))
+            continue;
+
+        written = (GF_ATOMIC_GET(conf->du_stats[i].write_bytes) >= (1 << 20));
+        if (by_writes && !written)
+            continue;
+
+        usec = dht_placement_usec_per_mb(conf, i);
+        if (usec && (!best || (usec < best))) {
+            best = usec;
+            avail_subvol = conf->subvolumes[i];
+        }
+    }
+
+    return avail_subvol;
+}
+
 /* Get subvol which has at least one inode and maximum space */
 xlator_t *
 dht_subvol_maxspace_nonzeroinode(xlator_t *this, xlator_t *subvol,
@@ -485,3 +560,217 @@ dht_subvol_maxspace_nonzeroinode(xlator_t *this, xlator_t *subvol,
 
     return avail_subvol;
 }
+
+void
+dht_placement_sample(xlator_t *this, xlator_t *subvol, dht_local_t *local,
+                     size_t size)
+{
+    dht_conf_t *conf = this->private;
+    dht_du_t *du = NULL;
+    int i = 0;
+
+    if (!local->wind_time.tv_sec || !conf->du_stats)
+        return;
+
+    i = dht_subvol_cnt(this, subvol);
+    if (i < 0)
+        return;
+
+    du = &conf->du_stats[i];
+
+    /* Time and bytes are summed rather than averaging the time per MB of
+     * every write, which small writes would inflate */
+    GF_ATOMIC_ADD(du->write_usec, (uint64_t)dht_usec_since(&local->wind_time));
+    if (GF_ATOMIC_ADD(du->write_bytes, size) <= DHT_PLACEMENT_WRITE_WINDOW)
+        return;
+
+    LOCK(&conf->subvolume_lock);
+    {
+        if (GF_ATOMIC_GET(du->write_bytes) > DHT_PLACEMENT_WRITE_WINDOW) {
+            GF_ATOMIC_SUB(du->write_usec, GF_ATOMIC_GET(du->write_usec) / 2);
+            GF_ATOMIC_SUB(du->write_bytes, GF_ATOMIC_GET(du->write_bytes) / 2);
+        }
+    }
+    UNLOCK(&conf->subvolume_lock);
+}
+
+/* How long the subvolume took lately to write a MB, or to answer a statfs
+ * until enough was written to it. 0 when not measured yet. */
+double
+dht_placement_usec_per_mb(dht_conf_t *conf, int idx)
+{
+    dht_du_t *du = &conf->du_stats[idx];
+    uint64_t bytes = GF_ATOMIC_GET(du->write_bytes);
+
+    if (bytes >= (1 << 20))
+        return (double)GF_ATOMIC_GET(du->write_usec) * (1 << 20) / bytes;
+
+    return du->probe_usec;
+}
+
+/* Finds key in a "key:value,key:value" list and copies its value */
+static gf_boolean_t
+dht_placement_list_get(const char *list, const char *key, char *value,
+                       size_t len)
+{
+    const char *item = list;
+    const char *sep = NULL;
+    const char *end = NULL;
+    size_t key_len = strlen(key);
+
+    while (item && *item) {
+        end = strchr(item, ',');
+        if (!end)
+            end = item + strlen(item);
+
+        sep = memchr(item, ':', end - item);
+        if (sep && ((sep - item) == key_len) &&
+            !strncmp(item, key, key_len) && ((end - sep - 1) < len)) {
+            memcpy(value, sep + 1, end - sep - 1);
+            value[end - sep - 1] = '\0';
+            return _gf_true;
+        }
+
+        item = *end ? end + 1 : end;
+    }
+
+    return _gf_false;
+}
+
+/* The device class the longest path prefix of device-class-pins matching
+ * path pins it to */
+static gf_boolean_t
+dht_placement_pin_match(const char *pins, const char *path, char *class,
+                        size_t len)
+{
+    const char *item = pins;
+    const char *sep = NULL;
+    const char *end = NULL;
+    size_t best = 0;
+    size_t prefix = 0;
+
+    while (*item) {
+        end = strchr(item, ',');
+        if (!end)
+            end = item + strlen(item);
+
+        sep = memchr(item, ':', end - item);
+        if (sep) {
+            prefix = sep - item;
+            /* "/a" pins "/a" and "/a/b", not "/ab" */
+            while ((prefix > 1) && (item[prefix - 1] == '/'))
+                prefix--;
+            if ((prefix > best) && ((end - sep - 1) < len) &&
+                !strncmp(path, item, prefix) &&
+                ((path[prefix] == '/') || (path[prefix] == '\0') ||
+                 (prefix == 1))) {
+                best = prefix;
+                memcpy(class, sep + 1, end - sep - 1);
+                class[end - sep - 1] = '\0';
+            }
+        }
+
+        item = *end ? end + 1 : end;
+    }
+
+    return (best > 0);
+}
+
+/* The device class a directory is pinned to. Its path is rebuilt from the
+ * parent inode and the name: loc->path is a "<gfid:...>" path for gfid
+ * based accesses, and a directory whose ancestors are not linked in the
+ * inode table can not be matched either. */
+static gf_boolean_t
+dht_placement_pin_get(const char *pins, loc_t *loc, char *class, size_t len)
+{
+    gf_boolean_t pinned = _gf_false;
+    char *path = NULL;
+    int ret = -1;
+
+    if (!pins)
+        return _gf_false;
+
+    if (loc->parent && loc->name)
+        ret = inode_path(loc->parent, loc->name, &path);
+    else if (loc->inode)
+        ret = inode_path(loc->inode, NULL, &path);
+
+    if ((ret > 0) && (path[0] == '/'))
+        pinned = dht_placement_pin_match(pins, path, class, len);
+
+    GF_FREE(path);
+
+    return pinned;
+}
+
+/* Computes the multiplier of the range of each subvolume of a new layout:
+ * 0 for the subvolumes a pinned directory must avoid, and with
+ * placement-weighting on, the weight of the device class of the subvolume.
+ * The measured speed is left out, layouts are written to disk and must not
+ * change with the load. Returns _gf_false, with all the multipliers at 1,
+ * when no policy applies. */
+gf_boolean_t
+dht_placement_factors(xlator_t *this, loc_t *loc, dht_layout_t *layout,
+                      uint32_t *factors)
+{
+    dht_conf_t *conf = this->private;
+    char pin[NAME_MAX] = {0};
+    char class[NAME_MAX] = {0};
+    char weight[32] = {0};
+    gf_boolean_t *excluded = NULL;
+    gf_boolean_t pinned = _gf_false;
+    uint32_t factor = 0;
+    int usable = 0;
+    int err = 0;
+    int i = 0;
+
+    for (i = 0; i < layout->cnt; i++)
+        factors[i] = 1;
+
+    pinned = dht_placement_pin_get(conf->device_class_pins, loc, pin,
+                                   sizeof(pin));
+    if (!pinned && !conf->placement_weighting)
+        return _gf_false;
+
+    excluded = alloca(layout->cnt * sizeof(*excluded));
+    for (i = 0; i < layout->cnt; i++) {
+        factor = 1;
+        class[0] = '\0';
+        if (conf->subvol_device_classes && layout->list[i].xlator)
+            dht_placement_list_get(conf->subvol_device_classes,
+                                   layout->list[i].xlator->name, class,
+                                   sizeof(class));
+
+        if (conf->placement_weighting && class[0] &&
+            conf->device_class_weights &&
+            dht_placement_list_get(conf->device_class_weights, class, weight,
+                                   sizeof(weight))) {
+            factor = strtoul(weight, NULL, 10);
+            /* Keep every class in the layout and the ranges from
+             * overflowing */
+            factor = min(max(factor, 1), DHT_PLACEMENT_MAX_WEIGHT);
+        }
+
+        factors[i] = factor;
+
+        excluded[i] = (pinned && strcmp(class, pin));
+        err = layout->list[i].err;
+        if (!excluded[i] && ((err == -1) || (err == ENOENT)))
+            usable++;
+    }
+
+    if (pinned && !usable) {
+        gf_msg(this->name, GF_LOG_WARNING, 0, DHT_MSG_SUBVOL_INFO,
+               "no available subvolume of device class %s for %s, using all "
+               "of them",
+               pin, loc->path);
+        return _gf_true;
+    }
+
+    for (i = 0; i < layout->cnt; i++) {
+        if (excluded[i])
+            factors[i] = 0;
+    }
+
+    return _gf_true;
+}
@@ -11,6 +11,59 @@
 #include "dht-common.h"
 #include <glusterfs/hashfn.h>
 
+#define DHT_HASH_CACHE_SIZE 64 /* must be a power of 2 */
+#define DHT_HASH_CACHE_NAME_MAX 48
+
+/* Names are usually hashed several times by the same thread within a short
+ * time: lookup, then create, then setattr of the same entry. Remember the
+ * last results so that the munging regexes, and the lock protecting them,
+ * are only used once per name. */
+typedef struct dht_hash_cache_entry {
+    uint64_t epoch; /* dht_conf_t->hash_epoch, 0 for an unused slot */
+    uint32_t hash;
+    int type;
+    char name[DHT_HASH_CACHE_NAME_MAX];
+} dht_hash_cache_entry_t;
+
+static __thread dht_hash_cache_entry_t dht_hash_cache[DHT_HASH_CACHE_SIZE];
+
+static gf_atomic_t dht_hash_epoch_counter;
+static pthread_once_t dht_hash_epoch_once = PTHREAD_ONCE_INIT;
+
+static void
+dht_hash_epoch_init_once(void)
+{
+    GF_ATOMIC_INIT(dht_hash_epoch_counter, 0);
+}
+
+/* Called from init of every dht instance, the counter is shared by all of
+ * them and must only be initialized by the first one */
+int
+dht_hash_epoch_init(void)
+{
+    return pthread_once(&dht_hash_epoch_once, dht_hash_epoch_init_once);
+}
+
+void
+dht_hash_epoch_update(dht_conf_t *conf)
+{
+    /* Unique across all the dht instances of the process, so that a conf
+     * allocated where a freed one was never hits its entries */
+    conf->hash_epoch = GF_ATOMIC_INC(dht_hash_epoch_counter);
+}
+
+static dht_hash_cache_entry_t *
+dht_hash_cache_slot(const char *name, size_t len)
+{
+    uint32_t slot = len;
+    size_t i = 0;
+
+    for (i = 0; i < len; i++)
+        slot = (slot << 5) - slot + (unsigned char)name[i];
+
+    return &dht_hash_cache[slot & (DHT_HASH_CACHE_SIZE - 1)];
+}
+
 static int
 dht_hash_compute_internal(int type, const char *name, const int len,
                           uint32_t *hash_p)
@@ -72,9 +125,12 @@ int
 dht_hash_compute(xlator_t *this, int type, const char *name, uint32_t *hash_p)
 {
     char *rsync_friendly_name = NULL;
+    dht_hash_cache_entry_t *entry = NULL;
     dht_conf_t *priv = NULL;
+    uint64_t epoch = 0;
     size_t len = 0;
     int munged = 0;
+    int ret = 0;
 
     priv = this->private;
 
@@ -82,6 +138,19 @@ dht_hash_compute(xlator_t *this, int type, const char *name, uint32_t *hash_p)
         return -1;
 
     len = strlen(name) + 1;
+
+    /* Read before the regexes are used: if they change meanwhile the result
+     * is stored under an epoch nobody looks for anymore */
+    epoch = priv->hash_epoch;
+    if (epoch && len <= DHT_HASH_CACHE_NAME_MAX) {
+        entry = dht_hash_cache_slot(name, len - 1);
+        if (entry->epoch == epoch && entry->type == type &&
+            !memcmp(entry->name, name, len)) {
+            *hash_p = entry->hash;
+            return 0;
+        }
+    }
+
     rsync_friendly_name = alloca(len);
 
     LOCK(&priv->lock);
@@ -105,6 +174,14 @@ dht_hash_compute(xlator_t *this, int type, const char *name, uint32_t *hash_p)
         rsync_friendly_name = (char *)name;
     }
 
-    return dht_hash_compute_internal(type, rsync_friendly_name, len - 1,
-                                     hash_p);
+    ret = dht_hash_compute_internal(type, rsync_friendly_name, len - 1,
+                                    hash_p);
+    if (!ret && entry) {
+        memcpy(entry->name, name, strlen(name) + 1);
+        entry->type = type;
+        entry->hash = *hash_p;
+        entry->epoch = epoch;
+    }
+
+    return ret;
 }
@@ -10,11 +10,31 @@
 
 #include "dht-common.h"
 #include "dht-lock.h"
+#include <glusterfs/hashfn.h>
 #include "glusterfs/compat-errno.h"  // for ENODATA on BSD
 
+static void
+dht_rdm_cursor_destroy(dht_rdm_cursor_t *cursor)
+{
+    int i = 0;
+
+    for (i = 0; i < cursor->cnt; i++)
+        gf_dirent_free(&cursor->subvols[i].entries);
+
+    if (cursor->xattr)
+        dict_unref(cursor->xattr);
+    if (cursor->xattr_skip_dirs)
+        dict_unref(cursor->xattr_skip_dirs);
+
+    LOCK_DESTROY(&cursor->lock);
+    GF_FREE(cursor);
+}
+
 static void
 dht_free_fd_ctx(dht_fd_ctx_t *fd_ctx)
 {
+    if (fd_ctx->rdm)
+        dht_rdm_cursor_destroy(fd_ctx->rdm);
     GF_FREE(fd_ctx);
 }
 
@@ -137,6 +157,100 @@ out:
     return fd_ctx;
 }
 
+static dht_rdm_cursor_t *
+dht_rdm_cursor_new(xlator_t *this, dict_t *xdata)
+{
+    dht_conf_t *conf = this->private;
+    dht_rdm_cursor_t *cursor = NULL;
+    int ret = 0;
+    int i = 0;
+
+    cursor = GF_CALLOC(1,
+                       sizeof(*cursor) +
+                           conf->subvolume_cnt * sizeof(dht_rdm_subvol_t),
+                       gf_dht_mt_rdm_cursor_t);
+    if (!cursor)
+        return NULL;
+
+    LOCK_INIT(&cursor->lock);
+    cursor->cnt = conf->subvolume_cnt;
+    cursor->hist_seq = 1;
+    for (i = 0; i < cursor->cnt; i++)
+        INIT_LIST_HEAD(&cursor->subvols[i].entries.list);
+
+    cursor->xattr = xdata ? dict_copy_with_ref(xdata, NULL) : dict_new();
+    if (!cursor->xattr)
+        goto err;
+
+    ret = dict_set_uint32(cursor->xattr, conf->link_xattr_name, 256);
+    if (ret)
+        gf_msg(this->name, GF_LOG_WARNING, 0, DHT_MSG_DICT_SET_FAILED,
+               "Failed to set dictionary value : key = %s",
+               conf->link_xattr_name);
+
+    if (conf->readdir_optimize == _gf_true) {
+        cursor->xattr_skip_dirs = dict_copy_with_ref(cursor->xattr, NULL);
+        if (!cursor->xattr_skip_dirs)
+            goto err;
+
+        ret = dict_set_int32(cursor->xattr_skip_dirs, GF_READDIR_SKIP_DIRS, 1);
+        if (ret)
+            gf_msg(this->name, GF_LOG_ERROR, 0, DHT_MSG_DICT_SET_FAILED,
+                   "Failed to set dictionary value :key = %s",
+                   GF_READDIR_SKIP_DIRS);
+    }
+
+    return cursor;
+
+err:
+    dht_rdm_cursor_destroy(cursor);
+    return NULL;
+}
+
+/* The cursor lives as long as the fd, callers must hold a ref on it */
+dht_rdm_cursor_t *
+dht_rdm_cursor_get(xlator_t *this, fd_t *fd, gf_boolean_t create,
+                   dict_t *xdata)
+{
+    dht_rdm_cursor_t *cursor = NULL;
+    dht_fd_ctx_t *fd_ctx = NULL;
+    uint64_t value = 0;
+    int ret = -1;
+
+    LOCK(&fd->lock);
+    {
+        ret = __fd_ctx_get(fd, this, &value);
+        if (!ret && value) {
+            fd_ctx = (dht_fd_ctx_t *)(uintptr_t)value;
+            cursor = fd_ctx->rdm;
+        }
+        if (cursor || !create)
+            goto unlock;
+
+        if (!fd_ctx) {
+            fd_ctx = GF_CALLOC(1, sizeof(*fd_ctx), gf_dht_mt_fd_ctx_t);
+            if (!fd_ctx)
+                goto unlock;
+            GF_REF_INIT(fd_ctx, dht_free_fd_ctx);
+
+            ret = __fd_ctx_set(fd, this, (uint64_t)(uintptr_t)fd_ctx);
+            if (ret < 0) {
+                gf_smsg(this->name, GF_LOG_WARNING, 0,
+                        DHT_MSG_FD_CTX_SET_FAILED, "fd=0x%p", fd, NULL);
+                GF_REF_PUT(fd_ctx);
+                goto unlock;
+            }
+        }
+
+        fd_ctx->rdm = dht_rdm_cursor_new(this, xdata);
+        cursor = fd_ctx->rdm;
+    }
+unlock:
+    UNLOCK(&fd->lock);
+
+    return cursor;
+}
+
 gf_boolean_t
 dht_fd_open_on_dst(xlator_t *this, fd_t *fd, xlator_t *dst)
 {
@@ -1174,6 +1288,7 @@ dht_init_subvolumes(xlator_t *this, dht_conf_t *conf)
 {
     xlator_list_t *subvols = NULL;
     int cnt = 0;
+    int i = 0;
 
     if (!conf)
         return -1;
@@ -1221,6 +1336,11 @@ dht_init_subvolumes(xlator_t *this, dht_conf_t *conf)
         return -1;
     }
 
+    for (i = 0; i < conf->subvolume_cnt; i++) {
+        GF_ATOMIC_INIT(conf->du_stats[i].write_usec, 0);
+        GF_ATOMIC_INIT(conf->du_stats[i].write_bytes, 0);
+    }
+
     conf->decommissioned_bricks = GF_CALLOC(cnt, sizeof(xlator_t *),
                                             gf_dht_mt_xlator_t);
     if (!conf->decommissioned_bricks) {
@@ -1871,6 +1991,270 @@ out:
     return 0;
 }
 
+static void
+__dht_ncache_entry_del(dht_ncache_t *nc, dht_ncache_entry_t *entry)
+{
+    list_del(&entry->hash);
+    list_del(&entry->lru);
+    nc->count--;
+    GF_FREE(entry);
+}
+
+static void
+__dht_ncache_purge(dht_ncache_t *nc)
+{
+    dht_ncache_entry_t *entry = NULL;
+    dht_ncache_entry_t *tmp = NULL;
+
+    list_for_each_entry_safe(entry, tmp, &nc->lru, lru)
+    {
+        __dht_ncache_entry_del(nc, entry);
+    }
+    nc->version++;
+}
+
+static dht_ncache_entry_t *
+__dht_ncache_find(dht_ncache_t *nc, const char *name, uint32_t hash)
+{
+    dht_ncache_entry_t *entry = NULL;
+
+    list_for_each_entry(entry, &nc->buckets[hash % DHT_NCACHE_BUCKETS], hash)
+    {
+        if (strcmp(entry->name, name) == 0)
+            return entry;
+    }
+
+    return NULL;
+}
+
+static dht_ncache_t *
+dht_ncache_get(xlator_t *this, inode_t *dir, gf_boolean_t create)
+{
+    dht_conf_t *conf = NULL;
+    dht_inode_ctx_t *ctx = NULL;
+    dht_ncache_t *nc = NULL;
+    int i = 0;
+
+    conf = this->private;
+
+    if (!dir || dht_inode_ctx_get(dir, this, &ctx) || !ctx)
+        return NULL;
+
+    if (ctx->ncache || !create)
+        return ctx->ncache;
+
+    nc = GF_CALLOC(1, sizeof(*nc), gf_dht_mt_ncache_t);
+    if (!nc)
+        return NULL;
+
+    LOCK_INIT(&nc->lock);
+    for (i = 0; i < DHT_NCACHE_BUCKETS; i++)
+        INIT_LIST_HEAD(&nc->buckets[i]);
+    INIT_LIST_HEAD(&nc->lru);
+
+    LOCK(&conf->layout_lock);
+    {
+        if (!ctx->ncache) {
+            ctx->ncache = nc;
+            nc = NULL;
+        }
+    }
+    UNLOCK(&conf->layout_lock);
+
+    if (nc)
+        dht_ncache_destroy(nc);
+
+    return ctx->ncache;
+}
+
+void
+dht_ncache_destroy(dht_ncache_t *nc)
+{
+    if (!nc)
+        return;
+
+    __dht_ncache_purge(nc);
+    LOCK_DESTROY(&nc->lock);
+    GF_FREE(nc);
+}
+
+/* Answers a fresh lookup from the cache of its parent. On a miss, local is
+ * armed so that dht_ncache_add() can cache the outcome of the lookup,
+ * unless the parent changes meanwhile. The cache is dropped when the
+ * layout of the parent is no longer the one it was filled with.
+ */
+int
+dht_ncache_lookup(xlator_t *this, dht_local_t *local, xlator_t **subvol)
+{
+    dht_conf_t *conf = NULL;
+    dht_layout_t *layout = NULL;
+    dht_ncache_t *nc = NULL;
+    dht_ncache_entry_t *entry = NULL;
+    loc_t *loc = &local->loc;
+    uint32_t hash = 0;
+    time_t now = 0;
+    int ret = 0;
+
+    conf = this->private;
+
+    if (!conf->lookup_cache_timeout || conf->defrag || !loc->parent ||
+        !loc->name)
+        return 0;
+
+    if (dht_inode_ctx_layout_get(loc->parent, this, &layout) || !layout)
+        return 0;
+
+    nc = dht_ncache_get(this, loc->parent, _gf_true);
+    if (!nc)
+        return 0;
+
+    hash = gf_dm_hashfn(loc->name, strlen(loc->name));
+    now = gf_time();
+
+    LOCK(&nc->lock);
+    {
+        if ((nc->commit_hash != layout->commit_hash) ||
+            (nc->layout_gen != layout->gen)) {
+            __dht_ncache_purge(nc);
+            nc->commit_hash = layout->commit_hash;
+            nc->layout_gen = layout->gen;
+        }
+
+        entry = __dht_ncache_find(nc, loc->name, hash);
+        if (entry && (entry->expire <= now)) {
+            __dht_ncache_entry_del(nc, entry);
+            entry = NULL;
+        }
+
+        if (entry) {
+            *subvol = entry->cached_subvol;
+            gf_uuid_copy(local->gfid, entry->gfid);
+            local->ncache_hit = _gf_true;
+            ret = entry->cached_subvol ? DHT_NCACHE_LINKTO
+                                       : DHT_NCACHE_NEGATIVE;
+        } else {
+            local->ncache_version = nc->version;
+            local->ncache_armed = _gf_true;
+        }
+    }
+    UNLOCK(&nc->lock);
+
+    return ret;
+}
+
+/* Caches the outcome of an armed lookup: a miss if cached_subvol is NULL,
+ * else the subvolume a linkto file led to. */
+void
+dht_ncache_add(xlator_t *this, dht_local_t *local, xlator_t *cached_subvol)
+{
+    dht_conf_t *conf = NULL;
+    dht_ncache_t *nc = NULL;
+    dht_ncache_entry_t *entry = NULL;
+    dht_ncache_entry_t *old = NULL;
+    loc_t *loc = &local->loc;
+    uint32_t hash = 0;
+    size_t len = 0;
+
+    if (!local->ncache_armed)
+        return;
+    local->ncache_armed = _gf_false;
+
+    conf = this->private;
+
+    nc = dht_ncache_get(this, loc->parent, _gf_false);
+    if (!nc)
+        return;
+
+    len = strlen(loc->name);
+    hash = gf_dm_hashfn(loc->name, len);
+
+    entry = GF_MALLOC(sizeof(*entry) + len + 1, gf_dht_mt_ncache_t);
+    if (!entry)
+        return;
+
+    memcpy(entry->name, loc->name, len + 1);
+    entry->cached_subvol = cached_subvol;
+    gf_uuid_copy(entry->gfid, local->gfid);
+    entry->expire = gf_time() + conf->lookup_cache_timeout;
+
+    LOCK(&nc->lock);
+    {
+        /* Skip it if the directory changed while the lookup was in flight */
+        if (nc->version == local->ncache_version) {
+            old = __dht_ncache_find(nc, entry->name, hash);
+            if (old)
+                __dht_ncache_entry_del(nc, old);
+
+            if (nc->count >= DHT_NCACHE_MAX_ENTRIES)
+                __dht_ncache_entry_del(
+                    nc, list_first_entry(&nc->lru, dht_ncache_entry_t, lru));
+
+            list_add_tail(&entry->hash,
+                          &nc->buckets[hash % DHT_NCACHE_BUCKETS]);
+            list_add_tail(&entry->lru, &nc->lru);
+            nc->count++;
+            entry = NULL;
+        }
+    }
+    UNLOCK(&nc->lock);
+
+    GF_FREE(entry);
+}
+
+/* Drops the cached outcome for name in dir, or all of them if name is NULL.
+ * Lookups in flight in dir will not cache their outcome either.
+ */
+void
+dht_ncache_invalidate(xlator_t *this, inode_t *dir, const char *name)
+{
+    dht_ncache_t *nc = NULL;
+    dht_ncache_entry_t *entry = NULL;
+
+    nc = dht_ncache_get(this, dir, _gf_false);
+    if (!nc)
+        return;
+
+    LOCK(&nc->lock);
+    {
+        if (name) {
+            entry = __dht_ncache_find(nc, name,
+                                      gf_dm_hashfn(name, strlen(name)));
+            if (entry)
+                __dht_ncache_entry_del(nc, entry);
+            nc->version++;
+        } else {
+            __dht_ncache_purge(nc);
+        }
+    }
+    UNLOCK(&nc->lock);
+}
+
+/* Called before a fop is unwound: a namespace change done through this
+ * client is visible to the next lookup */
+void
+dht_ncache_fop_unwind(xlator_t *this, dht_local_t *local)
+{
+    switch (local->fop) {
+        case GF_FOP_CREATE:
+        case GF_FOP_MKNOD:
+        case GF_FOP_MKDIR:
+        case GF_FOP_SYMLINK:
+        case GF_FOP_LINK:
+        case GF_FOP_RENAME:
+        case GF_FOP_UNLINK:
+        case GF_FOP_RMDIR:
+            break;
+        default:
+            return;
+    }
+
+    if (local->loc.parent && local->loc.name)
+        dht_ncache_invalidate(this, local->loc.parent, local->loc.name);
+
+    if (local->loc2.parent && local->loc2.name)
+        dht_ncache_invalidate(this, local->loc2.parent, local->loc2.name);
+}
+
 int
 dht_inode_ctx_get(inode_t *inode, xlator_t *this, dht_inode_ctx_t **ctx)
 {
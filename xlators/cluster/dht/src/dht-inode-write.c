@@ -43,6 +43,9 @@ dht_writev_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
         goto out;
     }
 
+    if (op_ret > 0)
+        dht_placement_sample(this, prev, local, op_ret);
+
     /* writev fails with EBADF if dht has not yet opened the fd
      * on the cached subvol. This could happen if the file was migrated
      * and a lookup updated the cached subvol in the inode ctx.
@@ -168,6 +171,9 @@ dht_writev2(xlator_t *this, xlator_t *subvol, call_frame_t *frame, int ret)
 
     local->call_cnt = 2; /* This is the second attempt */
 
+    if (local->wind_time.tv_sec)
+        timespec_now(&local->wind_time);
+
     STACK_WIND_COOKIE(frame, dht_writev_cbk, subvol, subvol,
                       subvol->fops->writev, local->fd, local->rebalance.vector,
                       local->rebalance.count, local->rebalance.offset,
@@ -190,11 +196,14 @@ dht_writev(call_frame_t *frame, xlator_t *this, fd_t *fd, struct iovec *vector,
     xlator_t *subvol = NULL;
     int op_errno = -1;
     dht_local_t *local = NULL;
+    dht_conf_t *conf = NULL;
 
     VALIDATE_OR_GOTO(frame, err);
     VALIDATE_OR_GOTO(this, err);
     VALIDATE_OR_GOTO(fd, err);
 
+    conf = this->private;
+
     local = dht_local_init(frame, NULL, fd, GF_FOP_WRITE);
     if (!local) {
         op_errno = ENOMEM;
@@ -218,6 +227,9 @@ dht_writev(call_frame_t *frame, xlator_t *this, fd_t *fd, struct iovec *vector,
     local->rebalance.iobref = iobref_ref(iobref);
     local->call_cnt = 1;
 
+    if (conf->placement_weighting)
+        timespec_now(&local->wind_time);
+
     STACK_WIND_COOKIE(frame, dht_writev_cbk, subvol, subvol,
                       subvol->fops->writev, fd, local->rebalance.vector,
                       local->rebalance.count, local->rebalance.offset,
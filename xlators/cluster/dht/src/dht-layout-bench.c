@@ -0,0 +1,135 @@
+/*
+ *   Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+ *   This file is part of GlusterFS.
+ *
+ *   This file is licensed to you under your choice of the GNU Lesser
+ *   General Public License, version 3 or any later version (LGPLv3 or
+ *   later), or the GNU General Public License, version 2 (GPLv2), in all
+ *   cases as published by the Free Software Foundation.
+ */
+
+/* Prints the cost of a layout search with and without the compiled table
+ * for growing numbers of subvolumes. Not run by "make check", the numbers
+ * depend on the machine.
+ *
+ * Build with "make dht-layout-bench" in this directory. */
+
+#include "dht-common.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_ITERATIONS 1000000
+
+/* The rest of dht-layout.c needs these, the search never calls them */
+int
+dht_hash_compute(xlator_t *this, int type, const char *name, uint32_t *hash_p)
+{
+    return -1;
+}
+
+int
+dht_inode_ctx_layout_get(inode_t *inode, xlator_t *this, dht_layout_t **layout)
+{
+    return -1;
+}
+
+int
+dht_inode_ctx_layout_set(inode_t *inode, xlator_t *this,
+                         dht_layout_t *layout_int)
+{
+    return -1;
+}
+
+void
+dht_ncache_invalidate(xlator_t *this, inode_t *dir, const char *name)
+{
+}
+
+static dht_layout_t *
+bench_layout_init(xlator_t *xl, int cnt)
+{
+    dht_layout_t *layout;
+    uint32_t chunk;
+    uint32_t start = 0;
+    int i;
+
+    layout = dht_layout_new(xl, cnt);
+    if (!layout)
+        return NULL;
+
+    chunk = 0xffffffff / cnt;
+    for (i = 0; i < cnt; i++) {
+        layout->list[i].xlator = (xlator_t *)(uintptr_t)(0x1000 + i);
+        layout->list[i].start = start;
+        layout->list[i].stop = (i == cnt - 1) ? 0xffffffff : start + chunk - 1;
+        start += chunk;
+    }
+
+    return layout;
+}
+
+static double
+bench_elapsed_ns(struct timespec *begin, struct timespec *end)
+{
+    return (end->tv_sec - begin->tv_sec) * 1e9 +
+           (end->tv_nsec - begin->tv_nsec);
+}
+
+/* Looks up the same fixed sequence of hashes on every run */
+static double
+bench_search(dht_layout_t *layout, uintptr_t *sum)
+{
+    struct timespec begin, end;
+    uint32_t hash = 1;
+    int i;
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (i = 0; i < BENCH_ITERATIONS; i++) {
+        hash = hash * 1664525 + 1013904223;
+        *sum += (uintptr_t)dht_layout_search_hash(layout, hash);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return bench_elapsed_ns(&begin, &end) / BENCH_ITERATIONS;
+}
+
+int
+main(void)
+{
+    const int counts[] = {8, 32, 128, 512};
+    xlator_t xl = {
+        0,
+    };
+    dht_layout_t *layout;
+    uintptr_t scan_sum, table_sum;
+    double scan, table;
+    int c;
+
+    for (c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        layout = bench_layout_init(&xl, counts[c]);
+        if (!layout)
+            return 1;
+
+        scan_sum = 0;
+        scan = bench_search(layout, &scan_sum);
+
+        dht_layout_compile(layout);
+        table_sum = 0;
+        table = bench_search(layout, &table_sum);
+
+        GF_FREE(layout);
+
+        if (scan_sum != table_sum) {
+            fprintf(stderr, "%d subvols: the table found other subvols\n",
+                    counts[c]);
+            return 1;
+        }
+
+        printf("dht_layout_search_hash: %4d subvols: scan %6.1f ns, "
+               "table %6.1f ns\n",
+               counts[c], scan, table);
+    }
+
+    return 0;
+}
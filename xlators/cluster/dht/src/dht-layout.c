@@ -16,7 +16,13 @@
 
 #define layout_entry_size (sizeof((dht_layout_t *)NULL)->list[0])
 
-#define layout_size(cnt) (layout_base_size + (cnt * layout_entry_size))
+#define layout_search_size (sizeof(uint32_t) + sizeof(int))
+
+#define layout_size(cnt)                                                       \
+    (layout_base_size + (cnt * (layout_entry_size + layout_search_size)))
+
+/* Below this many subvolumes scanning list[] is as fast as a table search */
+#define DHT_LAYOUT_SEARCH_TABLE_MIN 8
 
 dht_layout_t *
 dht_layout_new(xlator_t *this, int cnt)
@@ -36,6 +42,8 @@ dht_layout_new(xlator_t *this, int cnt)
 
     layout->type = DHT_HASH_TYPE_DM;
     layout->cnt = cnt;
+    layout->search_start = (uint32_t *)&layout->list[cnt];
+    layout->search_idx = (int *)&layout->search_start[cnt];
 
     if (conf) {
         layout->spread_cnt = conf->dir_spread_cnt;
@@ -43,6 +51,7 @@ dht_layout_new(xlator_t *this, int cnt)
     }
 
     GF_ATOMIC_INIT(layout->ref, 1);
+    GF_ATOMIC_INIT(layout->search_cnt, 0);
 
     ENSURE(NULL != layout);
     ENSURE(layout->type == DHT_HASH_TYPE_DM);
@@ -77,6 +86,8 @@ dht_layout_set(xlator_t *this, inode_t *inode, dht_layout_t *layout)
     if (!conf || !layout)
         goto out;
 
+    dht_layout_compile(layout);
+
     LOCK(&conf->layout_lock);
     {
         oldret = dht_inode_ctx_layout_get(inode, this, &old_layout);
@@ -87,6 +98,9 @@ dht_layout_set(xlator_t *this, inode_t *inode, dht_layout_t *layout)
     UNLOCK(&conf->layout_lock);
 
     if (!oldret) {
+        /* Lookup outcomes cached under the old layout may be wrong */
+        if (!ret && (old_layout != layout))
+            dht_ncache_invalidate(this, inode, NULL);
         dht_layout_unref(old_layout);
     }
     if (ret)
@@ -121,12 +135,86 @@ dht_layout_ref(xlator_t *this, dht_layout_t *layout)
     return layout;
 }
 
+void
+dht_layout_compile(dht_layout_t *layout)
+{
+    uint32_t start = 0;
+    int cnt = 0;
+    int i = 0;
+    int j = 0;
+
+    /* Readers seeing a partially built table are caught by the check of
+     * the candidate range in dht_layout_search_hash() */
+    GF_ATOMIC_SWAP(layout->search_cnt, 0);
+
+    if (layout->cnt < DHT_LAYOUT_SEARCH_TABLE_MIN)
+        return;
+
+    for (i = 0; i < layout->cnt; i++) {
+        start = layout->list[i].start;
+        /* Zeroed out ranges can only match a hash of 0, which is always
+         * looked up in list[] */
+        if ((!start && !layout->list[i].stop) ||
+            (start > layout->list[i].stop))
+            continue;
+
+        /* Layouts are normally sorted already, so this is linear */
+        for (j = cnt; j > 0 && layout->search_start[j - 1] > start; j--) {
+            layout->search_start[j] = layout->search_start[j - 1];
+            layout->search_idx[j] = layout->search_idx[j - 1];
+        }
+        layout->search_start[j] = start;
+        layout->search_idx[j] = i;
+        cnt++;
+    }
+
+    /* With overlapping ranges the first match in list[] wins, keep the
+     * scan for those */
+    for (i = 1; i < cnt; i++) {
+        if (layout->search_start[i] <=
+            layout->list[layout->search_idx[i - 1]].stop)
+            return;
+    }
+
+    GF_ATOMIC_SWAP(layout->search_cnt, cnt);
+}
+
+xlator_t *
+dht_layout_search_hash(dht_layout_t *layout, uint32_t hash)
+{
+    const uint32_t *base = NULL;
+    int half = 0;
+    int cnt = 0;
+    int i = 0;
+
+    cnt = GF_ATOMIC_GET(layout->search_cnt);
+    if (cnt && hash) {
+        base = layout->search_start;
+        while (cnt > 1) {
+            half = cnt / 2;
+            base = (base[half] <= hash) ? base + half : base;
+            cnt -= half;
+        }
+
+        i = layout->search_idx[base - layout->search_start];
+        if (layout->list[i].start <= hash && layout->list[i].stop >= hash)
+            return layout->list[i].xlator;
+        /* Not in the table or the layout changed under it, scan list[] */
+    }
+
+    for (i = 0; i < layout->cnt; i++) {
+        if (layout->list[i].start <= hash && layout->list[i].stop >= hash)
+            return layout->list[i].xlator;
+    }
+
+    return NULL;
+}
+
 xlator_t *
 dht_layout_search(xlator_t *this, dht_layout_t *layout, const char *name)
 {
     uint32_t hash = 0;
     xlator_t *subvol = NULL;
-    int i = 0;
     int ret = 0;
 
     ret = dht_hash_compute(this, layout->type, name, &hash);
@@ -136,13 +224,7 @@ dht_layout_search(xlator_t *this, dht_layout_t *layout, const char *name)
         goto out;
     }
 
-    for (i = 0; i < layout->cnt; i++) {
-        if (layout->list[i].start <= hash && layout->list[i].stop >= hash) {
-            subvol = layout->list[i].xlator;
-            break;
-        }
-    }
-
+    subvol = dht_layout_search_hash(layout, hash);
     if (!subvol) {
         gf_smsg(this->name, GF_LOG_WARNING, 0, DHT_MSG_HASHED_SUBVOL_GET_FAILED,
                 "hash-value=0x%x", hash, NULL);
@@ -292,6 +374,7 @@ dht_disk_layout_merge(xlator_t *this, dht_layout_t *layout, int pos,
     start_off = ntoh32(disk_layout[2]);
     stop_off = ntoh32(disk_layout[3]);
 
+    GF_ATOMIC_SWAP(layout->search_cnt, 0);
     layout->list[pos].commit_hash = commit_hash;
     layout->list[pos].start = start_off;
     layout->list[pos].stop = stop_off;
@@ -378,6 +461,8 @@ dht_layout_entry_swap(dht_layout_t *layout, int i, int j)
     xlator_t *xlator_swap = 0;
     int err_swap = 0;
 
+    GF_ATOMIC_SWAP(layout->search_cnt, 0);
+
     start_swap = layout->list[i].start;
     stop_swap = layout->list[i].stop;
     xlator_swap = layout->list[i].xlator;
@@ -403,6 +488,8 @@ dht_layout_range_swap(dht_layout_t *layout, int i, int j)
     uint32_t start_swap = 0;
     uint32_t stop_swap = 0;
 
+    GF_ATOMIC_SWAP(layout->search_cnt, 0);
+
     start_swap = layout->list[i].start;
     stop_swap = layout->list[i].stop;
 
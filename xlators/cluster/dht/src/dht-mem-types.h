@@ -33,6 +33,12 @@ enum gf_dht_mem_types_ {
     gf_dht_mt_fd_ctx_t,
     gf_dht_ret_cache_t,
     gf_dht_nodeuuids_t,
+    gf_dht_mt_migrate_seg_t,
+    gf_dht_mt_migrate_chunk_t,
+    gf_dht_mt_crawl_item_t,
+    gf_dht_mt_crawler_t,
+    gf_dht_mt_ncache_t,
+    gf_dht_mt_rdm_cursor_t,
     gf_dht_mt_end
 };
 #endif
@@ -128,7 +128,8 @@ GLFS_MSGID(
     DHT_MSG_BLOCK_INODELK_FAILED,
     DHT_MSG_LOCAL_LOCKS_STORE_FAILED_UNLOCKING_FOLLOWING_ENTRYLK,
     DHT_MSG_ALLOC_FRAME_FAILED_NOT_UNLOCKING_FOLLOWING_ENTRYLKS,
-    DHT_MSG_DST_NULL_SET_FAILED);
+    DHT_MSG_DST_NULL_SET_FAILED, DHT_MSG_CHECKPOINT_FAILED,
+    DHT_MSG_CHECKPOINT_SKIPPED, DHT_MSG_CRAWLER_THREAD_CREATE_FAILED);
 
 #define DHT_MSG_FD_CTX_SET_FAILED_STR "Failed to set fd ctx"
 #define DHT_MSG_INVALID_VALUE_STR "Different dst found in the fd ctx"
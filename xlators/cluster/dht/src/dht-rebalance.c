@@ -25,6 +25,8 @@
 #define ESTIMATE_START_INTERVAL 600 /* 10 mins */
 #define HARDLINK_MIG_INPROGRESS -2
 #define SKIP_MIGRATION_FD_POSITIVE -3
+/* Directories up to this depth get a checkpoint once their subtree is done */
+#define DHT_CRAWL_CHECKPOINT_DEPTH 2
 #ifndef MAX
 #define MAX(a, b) (((a) > (b)) ? (a) : (b))
 #endif
@@ -39,6 +41,9 @@ static int
 dht_migrate_file(xlator_t *this, loc_t *loc, xlator_t *cached_subvol,
                  xlator_t *hashed_subvol, int flag, int *fop_errno);
 
+static void
+gf_defrag_crawl_item_unref(xlator_t *this, gf_defrag_crawl_item_t *item);
+
 uint64_t g_totalfiles = 0;
 uint64_t g_totalsize = 0;
 
@@ -77,6 +82,9 @@ gf_defrag_free_container(struct dht_container *container)
 
         GF_FREE(container->parent_loc);
 
+        if (container->crawl_item)
+            gf_defrag_crawl_item_unref(container->this, container->crawl_item);
+
         GF_FREE(container);
     }
 }
@@ -1034,6 +1042,297 @@ dht_rebalance_sparse_segment(xlator_t *subvol, fd_t *fd, off_t *offset,
     return 1;
 }
 
+typedef struct dht_migrate_seg {
+    off_t offset;
+    size_t size;
+} dht_migrate_seg_t;
+
+/* State shared by the chunks of a file copied in parallel. Chunks are carved
+ * in order out of the data segments of the source file, and every chunk in
+ * flight picks the next one as soon as it has been written. */
+typedef struct dht_migrate_pipe {
+    xlator_t *from;
+    xlator_t *to;
+    fd_t *src;
+    fd_t *dst;
+    dict_t *xdata;
+    dht_migrate_seg_t *segs;
+    int seg_count;
+    int seg_idx;
+    off_t next;
+    gf_lock_t lock;
+    int inflight;
+    int op_errno;
+    syncbarrier_t barrier;
+} dht_migrate_pipe_t;
+
+typedef struct dht_migrate_chunk {
+    dht_migrate_pipe_t *pipe;
+    off_t offset;
+    size_t size;
+} dht_migrate_chunk_t;
+
+static gf_boolean_t
+dht_migrate_pipe_next(dht_migrate_pipe_t *pipe, dht_migrate_chunk_t *chunk)
+{
+    dht_migrate_seg_t *seg = NULL;
+    gf_boolean_t found = _gf_false;
+
+    LOCK(&pipe->lock);
+    {
+        while (!pipe->op_errno && (pipe->seg_idx < pipe->seg_count)) {
+            seg = &pipe->segs[pipe->seg_idx];
+            if (pipe->next < seg->offset)
+                pipe->next = seg->offset;
+            if (pipe->next < seg->offset + seg->size) {
+                chunk->offset = pipe->next;
+                chunk->size = min(DHT_REBALANCE_BLKSIZE,
+                                  seg->offset + seg->size - pipe->next);
+                pipe->next += chunk->size;
+                found = _gf_true;
+                break;
+            }
+            pipe->seg_idx++;
+        }
+    }
+    UNLOCK(&pipe->lock);
+
+    return found;
+}
+
+static void
+dht_migrate_pipe_unref(dht_migrate_pipe_t *pipe)
+{
+    int inflight = 0;
+
+    LOCK(&pipe->lock);
+    {
+        inflight = --pipe->inflight;
+    }
+    UNLOCK(&pipe->lock);
+
+    if (!inflight)
+        syncbarrier_wake(&pipe->barrier);
+}
+
+static void
+dht_migrate_chunk_read(call_frame_t *frame, dht_migrate_chunk_t *chunk);
+
+static void
+dht_migrate_chunk_done(call_frame_t *frame, dht_migrate_chunk_t *chunk,
+                       int op_errno)
+{
+    dht_migrate_pipe_t *pipe = chunk->pipe;
+
+    if (op_errno) {
+        LOCK(&pipe->lock);
+        {
+            if (!pipe->op_errno)
+                pipe->op_errno = op_errno;
+        }
+        UNLOCK(&pipe->lock);
+    } else if (dht_migrate_pipe_next(pipe, chunk)) {
+        dht_migrate_chunk_read(frame, chunk);
+        return;
+    }
+
+    STACK_DESTROY(frame->root);
+    dht_migrate_pipe_unref(pipe);
+}
+
+static int
+dht_migrate_chunk_writev_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                             int32_t op_ret, int32_t op_errno,
+                             struct iatt *prebuf, struct iatt *postbuf,
+                             dict_t *xdata)
+{
+    dht_migrate_chunk_t *chunk = cookie;
+
+    if (op_ret <= 0) {
+        dht_migrate_chunk_done(frame, chunk, op_ret ? op_errno : ENOSPC);
+        return 0;
+    }
+
+    if (op_ret < chunk->size) {
+        /* Short write, copy the rest of the chunk again */
+        chunk->offset += op_ret;
+        chunk->size -= op_ret;
+        dht_migrate_chunk_read(frame, chunk);
+        return 0;
+    }
+
+    dht_migrate_chunk_done(frame, chunk, 0);
+    return 0;
+}
+
+static int
+dht_migrate_chunk_readv_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                            int32_t op_ret, int32_t op_errno,
+                            struct iovec *vector, int32_t count,
+                            struct iatt *stbuf, struct iobref *iobref,
+                            dict_t *xdata)
+{
+    dht_migrate_chunk_t *chunk = cookie;
+    dht_migrate_pipe_t *pipe = chunk->pipe;
+
+    if (op_ret <= 0) {
+        /* A read of 0 bytes means the file was probably truncated */
+        dht_migrate_chunk_done(frame, chunk, op_ret ? op_errno : ENOSPC);
+        return 0;
+    }
+
+    STACK_WIND_COOKIE(frame, dht_migrate_chunk_writev_cbk, chunk, pipe->to,
+                      pipe->to->fops->writev, pipe->dst, vector, count,
+                      chunk->offset, 0, iobref, pipe->xdata);
+    return 0;
+}
+
+static void
+dht_migrate_chunk_read(call_frame_t *frame, dht_migrate_chunk_t *chunk)
+{
+    dht_migrate_pipe_t *pipe = chunk->pipe;
+
+    STACK_WIND_COOKIE(frame, dht_migrate_chunk_readv_cbk, chunk, pipe->from,
+                      pipe->from->fops->readv, pipe->src, chunk->size,
+                      chunk->offset, 0, NULL);
+}
+
+/* Copies the file with up to @window chunks in flight instead of one
+ * readv/writev pair at a time. Holes are found up front so that only data
+ * segments are split into chunks. Returns 1 without copying anything if the
+ * parallel copy can't be set up, for the caller to copy serially. */
+static int
+__dht_rebalance_migrate_data_parallel(xlator_t *this, xlator_t *from,
+                                      xlator_t *to, fd_t *src, fd_t *dst,
+                                      uint64_t ia_size, int hole_exists,
+                                      uint32_t window, int *fop_errno)
+{
+    dht_conf_t *conf = this->private;
+    dht_migrate_pipe_t pipe = {0};
+    dht_migrate_chunk_t *chunks = NULL;
+    dht_migrate_seg_t *segs = NULL;
+    call_frame_t *frame = NULL;
+    int seg_alloc = 0;
+    off_t offset = 0;
+    size_t size = 0;
+    uint32_t i = 0;
+    int ret = 0;
+
+    if (!ia_size)
+        return 0;
+
+    ret = syncbarrier_init(&pipe.barrier);
+    if (ret) {
+        gf_msg(this->name, GF_LOG_WARNING, errno, DHT_MSG_MIGRATE_FILE_FAILED,
+               "failed to set up the parallel copy, copying serially");
+        return 1;
+    }
+
+    if (!hole_exists) {
+        pipe.segs = GF_CALLOC(1, sizeof(*pipe.segs), gf_dht_mt_migrate_seg_t);
+        if (!pipe.segs) {
+            *fop_errno = ENOMEM;
+            ret = -1;
+            goto out;
+        }
+        pipe.segs[0].size = ia_size;
+        pipe.seg_count = 1;
+    } else {
+        while ((ret = dht_rebalance_sparse_segment(from, src, &offset,
+                                                   &size)) > 0) {
+            if (pipe.seg_count == seg_alloc) {
+                seg_alloc = seg_alloc ? seg_alloc * 2 : 16;
+                if (pipe.segs)
+                    segs = GF_REALLOC(pipe.segs, seg_alloc * sizeof(*segs));
+                else
+                    segs = GF_CALLOC(seg_alloc, sizeof(*segs),
+                                     gf_dht_mt_migrate_seg_t);
+                if (!segs) {
+                    ret = -ENOMEM;
+                    break;
+                }
+                pipe.segs = segs;
+            }
+            pipe.segs[pipe.seg_count].offset = offset;
+            pipe.segs[pipe.seg_count].size = size;
+            pipe.seg_count++;
+            offset += size;
+        }
+        if (ret < 0) {
+            *fop_errno = -ret;
+            ret = -1;
+            goto out;
+        }
+    }
+
+    if (!conf->force_migration) {
+        /* See __dht_rebalance_migrate_data() */
+        pipe.xdata = dict_new();
+        if (!pipe.xdata ||
+            dict_set_int32_sizen(pipe.xdata, GF_AVOID_OVERWRITE, 1)) {
+            *fop_errno = ENOMEM;
+            ret = -1;
+            goto out;
+        }
+    }
+
+    chunks = GF_CALLOC(window, sizeof(*chunks), gf_dht_mt_migrate_chunk_t);
+    if (!chunks) {
+        *fop_errno = ENOMEM;
+        ret = -1;
+        goto out;
+    }
+
+    pipe.from = from;
+    pipe.to = to;
+    pipe.src = src;
+    pipe.dst = dst;
+    LOCK_INIT(&pipe.lock);
+    /* Held by this thread until all the chunks are started */
+    pipe.inflight = 1;
+
+    for (i = 0; i < window; i++) {
+        chunks[i].pipe = &pipe;
+        if (!dht_migrate_pipe_next(&pipe, &chunks[i]))
+            break;
+
+        frame = syncop_create_frame(this);
+        if (!frame) {
+            LOCK(&pipe.lock);
+            {
+                if (!pipe.op_errno)
+                    pipe.op_errno = ENOMEM;
+            }
+            UNLOCK(&pipe.lock);
+            break;
+        }
+
+        LOCK(&pipe.lock);
+        {
+            pipe.inflight++;
+        }
+        UNLOCK(&pipe.lock);
+        dht_migrate_chunk_read(frame, &chunks[i]);
+    }
+
+    dht_migrate_pipe_unref(&pipe);
+    syncbarrier_wait(&pipe.barrier, 1);
+    LOCK_DESTROY(&pipe.lock);
+
+    ret = 0;
+    if (pipe.op_errno) {
+        *fop_errno = pipe.op_errno;
+        ret = -1;
+    }
+out:
+    syncbarrier_destroy(&pipe.barrier);
+    GF_FREE(chunks);
+    GF_FREE(pipe.segs);
+    if (pipe.xdata)
+        dict_unref(pipe.xdata);
+    return ret;
+}
+
 static int
 __dht_rebalance_migrate_data(xlator_t *this, xlator_t *from, xlator_t *to,
                              fd_t *src, fd_t *dst, uint64_t ia_size,
@@ -1049,8 +1348,19 @@ __dht_rebalance_migrate_data(xlator_t *this, xlator_t *from, xlator_t *to,
     size_t data_block_size = 0;
     dict_t *xdata = NULL;
     dht_conf_t *conf = NULL;
+    uint32_t window = 0;
 
     conf = this->private;
+    /* Read once, the option can be reconfigured during the copy */
+    window = conf->rebal_io_window;
+
+    if (window > 1) {
+        ret = __dht_rebalance_migrate_data_parallel(
+            this, from, to, src, dst, ia_size, hole_exists, window, fop_errno);
+        if (ret <= 0)
+            return ret;
+        ret = 0;
+    }
 
     /* if file size is '0', no need to enter this loop */
     while (total < ia_size) {
@@ -2626,6 +2936,32 @@ out:
     return ret;
 }
 
+/* Counts a failure of the rebalance and keeps @item, if any, from being
+ * checkpointed. The crawler and migration threads call it concurrently. */
+static void
+gf_defrag_count_failure(gf_defrag_info_t *defrag, gf_defrag_crawl_item_t *item)
+{
+    LOCK(&defrag->lock);
+    {
+        defrag->total_failures++;
+        if (item)
+            item->failed = _gf_true;
+    }
+    UNLOCK(&defrag->lock);
+}
+
+/* Keeps @item from being checkpointed without counting a failure */
+static void
+gf_defrag_crawl_item_fail(gf_defrag_info_t *defrag,
+                          gf_defrag_crawl_item_t *item)
+{
+    LOCK(&defrag->lock);
+    {
+        item->failed = _gf_true;
+    }
+    UNLOCK(&defrag->lock);
+}
+
 int
 gf_defrag_migrate_single_file(void *opaque)
 {
@@ -2876,11 +3212,8 @@ gf_defrag_migrate_single_file(void *opaque)
                    DHT_MSG_MIGRATE_FILE_FAILED, "migrate-data failed for %s",
                    entry_loc.path);
 
-            LOCK(&defrag->lock);
-            {
-                defrag->total_failures += 1;
-            }
-            UNLOCK(&defrag->lock);
+            /* Also keeps the directory from being checkpointed */
+            gf_defrag_count_failure(defrag, rebal_entry->crawl_item);
         }
 
         ret = gf_defrag_handle_migrate_error(fop_errno, defrag);
@@ -3255,6 +3588,10 @@ int static gf_defrag_get_entry(xlator_t *this, int i,
 out:
     if (defrag->defrag_status == GF_DEFRAG_STATUS_STARTED) {
         if (ret == 0) {
+            if (tmp_container && dir_dfmeta->crawl_item) {
+                tmp_container->crawl_item = dir_dfmeta->crawl_item;
+                GF_ATOMIC_INC(tmp_container->crawl_item->pending);
+            }
             *container = tmp_container;
         } else {
             gf_defrag_free_container(tmp_container);
@@ -3268,7 +3605,8 @@ out:
 
 int
 gf_defrag_process_dir(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
-                      dict_t *migrate_data, int *perrno)
+                      dict_t *migrate_data, gf_defrag_crawl_item_t *item,
+                      int *perrno)
 {
     int ret = -1;
     dht_conf_t *conf = NULL;
@@ -3314,6 +3652,8 @@ gf_defrag_process_dir(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
         goto out;
     }
 
+    dir_dfmeta->crawl_item = item;
+
     dir_dfmeta->lfd = GF_CALLOC(local_subvols_cnt, sizeof(fd_t *),
                                 gf_common_mt_pointer);
     if (!dir_dfmeta->lfd) {
@@ -3530,9 +3870,13 @@ out:
 
     /* It does not matter if it errored out - this number is
      * used to calculate rebalance estimated time to complete.
-     * No locking required as dirs are processed by a single thread.
+     * Several crawler threads may process dirs at the same time.
      */
-    defrag->num_dirs_processed++;
+    LOCK(&defrag->lock);
+    {
+        defrag->num_dirs_processed++;
+    }
+    UNLOCK(&defrag->lock);
     return ret;
 }
 
@@ -3595,35 +3939,21 @@ gf_defrag_settle_hash(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
     return 0;
 }
 
-int
-gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
-                     dict_t *fix_layout, dict_t *migrate_data)
+/* Looks up a directory before it is crawled, which also creates it on any
+ * newly added subvolume, and links its inode. Returns 1 if the directory is
+ * gone, 0 on success and -1 on failure.
+ */
+static int
+gf_defrag_lookup_dir(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc)
 {
     int ret = -1;
-    loc_t entry_loc = {
-        0,
-    };
-    fd_t *fd = NULL;
-    gf_dirent_t entries;
-    gf_dirent_t *tmp = NULL;
-    gf_dirent_t *entry = NULL;
-    gf_boolean_t free_entries = _gf_false;
-    off_t offset = 0;
     struct iatt iatt = {
         0,
     };
-    struct iatt entry_iatt = {
-        0,
-    };
     inode_t *linked_inode = NULL, *inode = NULL;
     dht_conf_t *conf = NULL;
-    int perrno = 0;
 
     conf = this->private;
-    if (!conf) {
-        ret = -1;
-        goto out;
-    }
 
     ret = syncop_lookup(this, loc, &iatt, NULL, NULL, NULL);
     if (ret) {
@@ -3633,21 +3963,20 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
                    "Skipping",
                    loc->path);
             if (conf->decommission_subvols_cnt) {
-                defrag->total_failures++;
+                gf_defrag_count_failure(defrag, NULL);
             }
-            ret = 0;
-        } else {
-            gf_msg(this->name, GF_LOG_ERROR, -ret, DHT_MSG_DIR_LOOKUP_FAILED,
-                   "lookup failed for:%s", loc->path);
+            return 1;
+        }
 
-            defrag->total_failures++;
+        gf_msg(this->name, GF_LOG_ERROR, -ret, DHT_MSG_DIR_LOOKUP_FAILED,
+               "lookup failed for:%s", loc->path);
 
-            if (conf->decommission_in_progress) {
-                defrag->defrag_status = GF_DEFRAG_STATUS_FAILED;
-                ret = -1;
-            }
+        gf_defrag_count_failure(defrag, NULL);
+
+        if (conf->decommission_in_progress) {
+            defrag->defrag_status = GF_DEFRAG_STATUS_FAILED;
         }
-        goto out;
+        return -1;
     }
 
     linked_inode = inode_link(loc->inode, loc->parent, loc->name, &iatt);
@@ -3656,55 +3985,197 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
     loc->inode = linked_inode;
     inode_unref(inode);
 
-    fd = fd_create(loc->inode, defrag->pid);
-    if (!fd) {
-        gf_log(this->name, GF_LOG_ERROR, "Failed to create fd");
+    return 0;
+}
 
-        defrag->total_failures++;
-        ret = -1;
-        goto out;
+/* Fixes the layout of a directory whose subdirs have all been looked up,
+ * queues its files for migration and settles its commit hash.
+ */
+static int
+gf_defrag_fix_dir(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
+                  dict_t *fix_layout, dict_t *migrate_data,
+                  gf_defrag_crawl_item_t *item)
+{
+    int ret = -1;
+    dht_conf_t *conf = NULL;
+    int perrno = 0;
+
+    conf = this->private;
+
+    /* A directory layout is fixed only after its subdirs are healed to
+     * any newly added bricks. If the layout is fixed before subdirs are
+     * healed, the newly added brick will get a non-null layout.
+     * Any subdirs which hash to that layout will no longer show up
+     * in a directory listing until they are healed.
+     */
+
+    ret = syncop_setxattr(this, loc, fix_layout, 0, NULL, NULL);
+
+    /* In case of a race where the directory is deleted just before
+     * layout setxattr, the errors are updated in the layout structure.
+     * We can use this information to make a decision whether the directory
+     * is deleted entirely.
+     */
+    if (ret == 0) {
+        ret = dht_dir_layout_error_check(this, loc->inode);
+        ret = -ret;
     }
 
-    ret = syncop_opendir(this, loc, fd, NULL, NULL);
     if (ret) {
         if (-ret == ENOENT || -ret == ESTALE) {
+            gf_msg(this->name, GF_LOG_INFO, -ret, DHT_MSG_LAYOUT_FIX_FAILED,
+                   "Setxattr failed. Dir %s "
+                   "renamed or removed",
+                   loc->path);
             if (conf->decommission_subvols_cnt) {
-                defrag->total_failures++;
+                gf_defrag_count_failure(defrag, NULL);
             }
             ret = 0;
             goto out;
-        }
-
-        gf_log(this->name, GF_LOG_ERROR,
-               "Failed to open dir %s, "
-               "err:%d",
-               loc->path, -ret);
-
-        defrag->total_failures++;
-        ret = -1;
-        goto out;
-    }
+        } else {
+            gf_msg(this->name, GF_LOG_ERROR, -ret, DHT_MSG_LAYOUT_FIX_FAILED,
+                   "Setxattr failed for %s", loc->path);
 
-    fd_bind(fd);
-    INIT_LIST_HEAD(&entries.list);
+            gf_defrag_count_failure(defrag, item);
 
-    while ((ret = syncop_readdir(this, fd, 131072, offset, &entries, NULL,
-                                 NULL)) != 0) {
-        if (ret < 0) {
-            if (-ret == ENOENT || -ret == ESTALE) {
-                if (conf->decommission_subvols_cnt) {
-                    defrag->total_failures++;
-                }
-                ret = 0;
+            if (conf->decommission_in_progress) {
+                defrag->defrag_status = GF_DEFRAG_STATUS_FAILED;
+                ret = -1;
                 goto out;
             }
+        }
+    }
 
-            gf_msg(this->name, GF_LOG_ERROR, -ret, DHT_MSG_READDIR_ERROR,
-                   "readdirp failed for "
+    if (defrag->cmd != GF_DEFRAG_CMD_START_LAYOUT_FIX) {
+        ret = gf_defrag_process_dir(this, defrag, loc, migrate_data, item,
+                                    &perrno);
+
+        if (defrag->defrag_status != GF_DEFRAG_STATUS_STARTED) {
+            goto out;
+        }
+
+        if (ret) {
+            if (perrno == ENOENT || perrno == ESTALE) {
+                ret = 0;
+                goto out;
+            } else {
+                gf_defrag_count_failure(defrag, item);
+
+                gf_msg(this->name, GF_LOG_ERROR, 0,
+                       DHT_MSG_DEFRAG_PROCESS_DIR_FAILED,
+                       "gf_defrag_process_dir failed for "
+                       "directory: %s",
+                       loc->path);
+
+                if (conf->decommission_in_progress) {
+                    goto out;
+                }
+            }
+        }
+    }
+
+    gf_msg_trace(this->name, 0, "fix layout called on %s", loc->path);
+
+    if (gf_defrag_settle_hash(this, defrag, loc, fix_layout) != 0) {
+        gf_defrag_count_failure(defrag, item);
+
+        gf_msg(this->name, GF_LOG_ERROR, 0, DHT_MSG_SETTLE_HASH_FAILED,
+               "Settle hash failed for %s", loc->path);
+
+        ret = -1;
+
+        if (conf->decommission_in_progress) {
+            defrag->defrag_status = GF_DEFRAG_STATUS_FAILED;
+            goto out;
+        }
+    }
+
+    ret = 0;
+out:
+    return ret;
+}
+
+int
+gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
+                     dict_t *fix_layout, dict_t *migrate_data)
+{
+    int ret = -1;
+    loc_t entry_loc = {
+        0,
+    };
+    fd_t *fd = NULL;
+    gf_dirent_t entries;
+    gf_dirent_t *tmp = NULL;
+    gf_dirent_t *entry = NULL;
+    gf_boolean_t free_entries = _gf_false;
+    off_t offset = 0;
+    struct iatt entry_iatt = {
+        0,
+    };
+    dht_conf_t *conf = NULL;
+
+    conf = this->private;
+    if (!conf) {
+        ret = -1;
+        goto out;
+    }
+
+    ret = gf_defrag_lookup_dir(this, defrag, loc);
+    if (ret) {
+        if (ret > 0)
+            ret = 0;
+        goto out;
+    }
+
+    fd = fd_create(loc->inode, defrag->pid);
+    if (!fd) {
+        gf_log(this->name, GF_LOG_ERROR, "Failed to create fd");
+
+        gf_defrag_count_failure(defrag, NULL);
+        ret = -1;
+        goto out;
+    }
+
+    ret = syncop_opendir(this, loc, fd, NULL, NULL);
+    if (ret) {
+        if (-ret == ENOENT || -ret == ESTALE) {
+            if (conf->decommission_subvols_cnt) {
+                gf_defrag_count_failure(defrag, NULL);
+            }
+            ret = 0;
+            goto out;
+        }
+
+        gf_log(this->name, GF_LOG_ERROR,
+               "Failed to open dir %s, "
+               "err:%d",
+               loc->path, -ret);
+
+        gf_defrag_count_failure(defrag, NULL);
+        ret = -1;
+        goto out;
+    }
+
+    fd_bind(fd);
+    INIT_LIST_HEAD(&entries.list);
+
+    while ((ret = syncop_readdir(this, fd, 131072, offset, &entries, NULL,
+                                 NULL)) != 0) {
+        if (ret < 0) {
+            if (-ret == ENOENT || -ret == ESTALE) {
+                if (conf->decommission_subvols_cnt) {
+                    gf_defrag_count_failure(defrag, NULL);
+                }
+                ret = 0;
+                goto out;
+            }
+
+            gf_msg(this->name, GF_LOG_ERROR, -ret, DHT_MSG_READDIR_ERROR,
+                   "readdirp failed for "
                    "path %s. Aborting fix-layout",
                    loc->path);
 
-            defrag->total_failures++;
+            gf_defrag_count_failure(defrag, NULL);
             ret = -1;
             goto out;
         }
@@ -3738,7 +4209,7 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
                        " build failed for entry: %s",
                        entry->d_name);
 
-                defrag->total_failures++;
+                gf_defrag_count_failure(defrag, NULL);
 
                 if (conf->decommission_in_progress) {
                     defrag->defrag_status = GF_DEFRAG_STATUS_FAILED;
@@ -3793,94 +4264,500 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
         INIT_LIST_HEAD(&entries.list);
     }
 
-    /* A directory layout is fixed only after its subdirs are healed to
-     * any newly added bricks. If the layout is fixed before subdirs are
-     * healed, the newly added brick will get a non-null layout.
-     * Any subdirs which hash to that layout will no longer show up
-     * in a directory listing until they are healed.
-     */
+    ret = gf_defrag_fix_dir(this, defrag, loc, fix_layout, migrate_data, NULL);
+out:
+    if (free_entries)
+        gf_dirent_free(&entries);
 
-    ret = syncop_setxattr(this, loc, fix_layout, 0, NULL, NULL);
+    loc_wipe(&entry_loc);
 
-    /* In case of a race where the directory is deleted just before
-     * layout setxattr, the errors are updated in the layout structure.
-     * We can use this information to make a decision whether the directory
-     * is deleted entirely.
-     */
+    if (fd)
+        fd_unref(fd);
+
+    return ret;
+}
+
+typedef struct gf_defrag_crawl gf_defrag_crawl_t;
+
+typedef struct gf_defrag_crawler {
+    struct list_head queue; /* dirs found by this thread, not yet crawled */
+    pthread_mutex_t lock;
+    pthread_t tid;
+    int index;
+    dict_t *fix_layout; /* own copy, settling the hash modifies it */
+    gf_defrag_crawl_t *crawl;
+} gf_defrag_crawler_t;
+
+struct gf_defrag_crawl {
+    gf_defrag_crawler_t *crawlers;
+    int count;
+    xlator_t *this;
+    gf_defrag_info_t *defrag;
+    dict_t *migrate_data;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int outstanding; /* dirs queued or being crawled */
+    uint64_t gen;    /* bumped on every queued dir to wake up idle threads */
+    int root_ret;
+    gf_atomic_t skipped;
+};
+
+static gf_boolean_t
+gf_defrag_crawl_checkpointed(xlator_t *this, loc_t *loc)
+{
+    dht_conf_t *conf = NULL;
+    dict_t *dict = NULL;
+    uint32_t hash = 0;
+    gf_boolean_t done = _gf_false;
+
+    conf = this->private;
+
+    /* Only a rebalance restarted with the same commit hash may skip */
+    if (!conf->vch_forced)
+        return _gf_false;
+
+    if ((syncop_getxattr(this, loc, &dict, DHT_REBAL_CHECKPOINT_KEY, NULL,
+                         NULL) == 0) &&
+        (dict_get_uint32(dict, DHT_REBAL_CHECKPOINT_KEY, &hash) == 0) &&
+        (hash == conf->vol_commit_hash)) {
+        done = _gf_true;
+    }
+
+    if (dict)
+        dict_unref(dict);
+
+    return done;
+}
+
+static void
+gf_defrag_crawl_checkpoint(xlator_t *this, gf_defrag_crawl_item_t *item)
+{
+    dht_conf_t *conf = NULL;
+    dict_t *dict = NULL;
+    xlator_t *old_THIS = NULL;
+    int ret = -1;
+
+    conf = this->private;
+
+    if (!conf->vch_forced || !conf->defrag ||
+        (conf->defrag->defrag_status != GF_DEFRAG_STATUS_STARTED))
+        return;
+
+    dict = dict_new();
+    if (!dict)
+        return;
+
+    ret = dict_set_uint32(dict, DHT_REBAL_CHECKPOINT_KEY,
+                          conf->vol_commit_hash);
     if (ret == 0) {
-        ret = dht_dir_layout_error_check(this, loc->inode);
-        ret = -ret;
+        old_THIS = THIS;
+        THIS = this;
+        ret = syncop_setxattr(this, &item->loc, dict, 0, NULL, NULL);
+        THIS = old_THIS;
+    }
+
+    if (ret) {
+        gf_msg(this->name, GF_LOG_WARNING, -ret, DHT_MSG_CHECKPOINT_FAILED,
+               "Failed to checkpoint %s", item->loc.path);
+    } else {
+        gf_msg_debug(this->name, 0, "Checkpointed %s", item->loc.path);
+    }
+
+    dict_unref(dict);
+}
+
+/* A completed rebalance removes its checkpoints so that they do not outlive
+ * it. Only the dirs up to DHT_CRAWL_CHECKPOINT_DEPTH can have one. */
+static void
+gf_defrag_crawl_clear_checkpoints(xlator_t *this, gf_defrag_info_t *defrag,
+                                  loc_t *loc, int depth)
+{
+    loc_t entry_loc = {
+        0,
+    };
+    struct iatt iatt = {
+        0,
+    };
+    gf_dirent_t entries;
+    gf_dirent_t *entry = NULL;
+    inode_t *linked_inode = NULL;
+    fd_t *fd = NULL;
+    off_t offset = 0;
+    int ret = 0;
+
+    if (depth > 0) {
+        ret = syncop_removexattr(this, loc, DHT_REBAL_CHECKPOINT_KEY, NULL,
+                                 NULL);
+        if (ret && (-ret != ENODATA))
+            gf_msg_debug(this->name, -ret,
+                         "Failed to remove the checkpoint of %s", loc->path);
+    }
+
+    if (depth == DHT_CRAWL_CHECKPOINT_DEPTH)
+        return;
+
+    fd = fd_create(loc->inode, defrag->pid);
+    if (!fd)
+        return;
+
+    if (syncop_opendir(this, loc, fd, NULL, NULL))
+        goto out;
+    fd_bind(fd);
+
+    INIT_LIST_HEAD(&entries.list);
+    while ((ret = syncop_readdir(this, fd, 131072, offset, &entries, NULL,
+                                 NULL)) > 0) {
+        list_for_each_entry(entry, &entries.list, list)
+        {
+            offset = entry->d_off;
+
+            if ((entry->d_type != DT_DIR) || !strcmp(entry->d_name, ".") ||
+                !strcmp(entry->d_name, ".."))
+                continue;
+
+            loc_wipe(&entry_loc);
+            if (dht_build_child_loc(this, &entry_loc, loc, entry->d_name) ||
+                syncop_lookup(this, &entry_loc, &iatt, NULL, NULL, NULL))
+                continue;
+
+            linked_inode = inode_link(entry_loc.inode, loc->inode,
+                                      entry_loc.name, &iatt);
+            if (linked_inode) {
+                inode_unref(entry_loc.inode);
+                entry_loc.inode = linked_inode;
+            }
+
+            gf_defrag_crawl_clear_checkpoints(this, defrag, &entry_loc,
+                                              depth + 1);
+        }
+        gf_dirent_free(&entries);
+    }
+out:
+    loc_wipe(&entry_loc);
+    fd_unref(fd);
+}
+
+static gf_defrag_crawl_item_t *
+gf_defrag_crawl_item_new(gf_defrag_crawl_item_t *parent, loc_t *loc)
+{
+    gf_defrag_crawl_item_t *item = NULL;
+
+    item = GF_CALLOC(1, sizeof(*item), gf_dht_mt_crawl_item_t);
+    if (!item)
+        return NULL;
+
+    if (loc_copy(&item->loc, loc)) {
+        GF_FREE(item);
+        return NULL;
+    }
+
+    INIT_LIST_HEAD(&item->list);
+    GF_ATOMIC_INIT(item->pending, 1);
+
+    if (parent) {
+        item->parent = parent;
+        item->depth = parent->depth + 1;
+        GF_ATOMIC_INC(parent->pending);
+    }
+
+    return item;
+}
+
+/* Drops a reference on a crawled directory. The last one means its whole
+ * subtree is done: it is checkpointed if nothing failed below it, and the
+ * reference it holds on its parent is dropped in turn.
+ */
+static void
+gf_defrag_crawl_item_unref(xlator_t *this, gf_defrag_crawl_item_t *item)
+{
+    dht_conf_t *conf = this->private;
+    gf_defrag_crawl_item_t *parent = NULL;
+    gf_boolean_t failed = _gf_false;
+
+    while (item && (GF_ATOMIC_DEC(item->pending) == 0)) {
+        parent = item->parent;
+
+        LOCK(&conf->defrag->lock);
+        {
+            failed = item->failed;
+            if (failed && parent)
+                parent->failed = _gf_true;
+        }
+        UNLOCK(&conf->defrag->lock);
+
+        if (!failed && !item->checkpointed && (item->depth > 0) &&
+            (item->depth <= DHT_CRAWL_CHECKPOINT_DEPTH)) {
+            gf_defrag_crawl_checkpoint(this, item);
+        }
+
+        loc_wipe(&item->loc);
+        GF_FREE(item);
+
+        item = parent;
+    }
+}
+
+static void
+gf_defrag_crawl_push(gf_defrag_crawler_t *crawler, gf_defrag_crawl_item_t *item)
+{
+    gf_defrag_crawl_t *crawl = crawler->crawl;
+
+    /* Count the dir before it can be taken, so that the crawl never looks
+     * finished while it is queued */
+    pthread_mutex_lock(&crawl->mutex);
+    {
+        crawl->outstanding++;
     }
+    pthread_mutex_unlock(&crawl->mutex);
 
+    pthread_mutex_lock(&crawler->lock);
+    {
+        list_add_tail(&item->list, &crawler->queue);
+    }
+    pthread_mutex_unlock(&crawler->lock);
+
+    pthread_mutex_lock(&crawl->mutex);
+    {
+        crawl->gen++;
+        pthread_cond_signal(&crawl->cond);
+    }
+    pthread_mutex_unlock(&crawl->mutex);
+}
+
+/* Returns the next dir to crawl, or NULL once the whole tree is crawled.
+ * A thread takes its own dirs newest first, which keeps it within the
+ * subtree it is working on. When it has none left it steals the oldest dir
+ * of another thread, the nearest to the root and so the one most likely to
+ * have a lot of work below it.
+ */
+static gf_defrag_crawl_item_t *
+gf_defrag_crawl_next(gf_defrag_crawler_t *crawler)
+{
+    gf_defrag_crawl_t *crawl = crawler->crawl;
+    gf_defrag_crawler_t *victim = NULL;
+    gf_defrag_crawl_item_t *item = NULL;
+    gf_boolean_t done = _gf_false;
+    uint64_t gen = 0;
+    int i = 0;
+
+    while (_gf_true) {
+        pthread_mutex_lock(&crawl->mutex);
+        {
+            gen = crawl->gen;
+        }
+        pthread_mutex_unlock(&crawl->mutex);
+
+        pthread_mutex_lock(&crawler->lock);
+        {
+            if (!list_empty(&crawler->queue)) {
+                item = list_last_entry(&crawler->queue, gf_defrag_crawl_item_t,
+                                       list);
+                list_del_init(&item->list);
+            }
+        }
+        pthread_mutex_unlock(&crawler->lock);
+
+        for (i = 1; !item && (i < crawl->count); i++) {
+            victim = &crawl->crawlers[(crawler->index + i) % crawl->count];
+
+            pthread_mutex_lock(&victim->lock);
+            {
+                if (!list_empty(&victim->queue)) {
+                    item = list_first_entry(&victim->queue,
+                                            gf_defrag_crawl_item_t, list);
+                    list_del_init(&item->list);
+                }
+            }
+            pthread_mutex_unlock(&victim->lock);
+        }
+
+        if (item)
+            return item;
+
+        pthread_mutex_lock(&crawl->mutex);
+        {
+            while ((crawl->outstanding > 0) && (gen == crawl->gen))
+                pthread_cond_wait(&crawl->cond, &crawl->mutex);
+
+            done = (crawl->outstanding == 0);
+        }
+        pthread_mutex_unlock(&crawl->mutex);
+
+        if (done)
+            return NULL;
+    }
+}
+
+/* Crawls one directory: looks up its subdirs and queues them, then fixes
+ * its own layout and queues its files for migration.
+ */
+static int
+gf_defrag_crawl_dir(gf_defrag_crawler_t *crawler, gf_defrag_crawl_item_t *item)
+{
+    gf_defrag_crawl_t *crawl = crawler->crawl;
+    xlator_t *this = crawl->this;
+    gf_defrag_info_t *defrag = crawl->defrag;
+    dht_conf_t *conf = NULL;
+    loc_t *loc = &item->loc;
+    loc_t entry_loc = {
+        0,
+    };
+    fd_t *fd = NULL;
+    gf_dirent_t entries;
+    gf_dirent_t *tmp = NULL;
+    gf_dirent_t *entry = NULL;
+    gf_boolean_t free_entries = _gf_false;
+    off_t offset = 0;
+    struct iatt entry_iatt = {
+        0,
+    };
+    gf_defrag_crawl_item_t *child = NULL;
+    int ret = -1;
+
+    conf = this->private;
+
+    if ((item->depth > 0) && (item->depth <= DHT_CRAWL_CHECKPOINT_DEPTH) &&
+        gf_defrag_crawl_checkpointed(this, loc)) {
+        gf_msg(this->name, GF_LOG_INFO, 0, DHT_MSG_CHECKPOINT_SKIPPED,
+               "%s was rebalanced before the restart. Skipping", loc->path);
+        item->checkpointed = _gf_true;
+        GF_ATOMIC_INC(crawl->skipped);
+        return 0;
+    }
+
+    fd = fd_create(loc->inode, defrag->pid);
+    if (!fd) {
+        gf_log(this->name, GF_LOG_ERROR, "Failed to create fd");
+
+        gf_defrag_count_failure(defrag, NULL);
+        ret = -1;
+        goto out;
+    }
+
+    ret = syncop_opendir(this, loc, fd, NULL, NULL);
     if (ret) {
         if (-ret == ENOENT || -ret == ESTALE) {
-            gf_msg(this->name, GF_LOG_INFO, -ret, DHT_MSG_LAYOUT_FIX_FAILED,
-                   "Setxattr failed. Dir %s "
-                   "renamed or removed",
-                   loc->path);
             if (conf->decommission_subvols_cnt) {
-                defrag->total_failures++;
+                gf_defrag_count_failure(defrag, NULL);
             }
             ret = 0;
             goto out;
-        } else {
-            gf_msg(this->name, GF_LOG_ERROR, -ret, DHT_MSG_LAYOUT_FIX_FAILED,
-                   "Setxattr failed for %s", loc->path);
+        }
 
-            defrag->total_failures++;
+        gf_log(this->name, GF_LOG_ERROR,
+               "Failed to open dir %s, "
+               "err:%d",
+               loc->path, -ret);
 
-            if (conf->decommission_in_progress) {
-                defrag->defrag_status = GF_DEFRAG_STATUS_FAILED;
-                ret = -1;
+        gf_defrag_count_failure(defrag, NULL);
+        ret = -1;
+        goto out;
+    }
+
+    fd_bind(fd);
+    INIT_LIST_HEAD(&entries.list);
+
+    while ((ret = syncop_readdir(this, fd, 131072, offset, &entries, NULL,
+                                 NULL)) != 0) {
+        if (ret < 0) {
+            if (-ret == ENOENT || -ret == ESTALE) {
+                if (conf->decommission_subvols_cnt) {
+                    gf_defrag_count_failure(defrag, NULL);
+                }
+                ret = 0;
                 goto out;
             }
-        }
-    }
 
-    if (defrag->cmd != GF_DEFRAG_CMD_START_LAYOUT_FIX) {
-        ret = gf_defrag_process_dir(this, defrag, loc, migrate_data, &perrno);
+            gf_msg(this->name, GF_LOG_ERROR, -ret, DHT_MSG_READDIR_ERROR,
+                   "readdirp failed for "
+                   "path %s. Aborting fix-layout",
+                   loc->path);
 
-        if (defrag->defrag_status != GF_DEFRAG_STATUS_STARTED) {
+            gf_defrag_count_failure(defrag, NULL);
+            ret = -1;
             goto out;
         }
 
-        if (ret) {
-            if (perrno == ENOENT || perrno == ESTALE) {
-                ret = 0;
+        if (list_empty(&entries.list))
+            break;
+
+        free_entries = _gf_true;
+
+        list_for_each_entry_safe(entry, tmp, &entries.list, list)
+        {
+            if (defrag->defrag_status != GF_DEFRAG_STATUS_STARTED) {
+                ret = -1;
                 goto out;
-            } else {
-                defrag->total_failures++;
+            }
 
-                gf_msg(this->name, GF_LOG_ERROR, 0,
-                       DHT_MSG_DEFRAG_PROCESS_DIR_FAILED,
-                       "gf_defrag_process_dir failed for "
-                       "directory: %s",
-                       loc->path);
+            offset = entry->d_off;
+
+            if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
+                continue;
+
+            if ((DT_DIR != entry->d_type) && (DT_UNKNOWN != entry->d_type)) {
+                continue;
+            }
+
+            loc_wipe(&entry_loc);
+
+            ret = dht_build_child_loc(this, &entry_loc, loc, entry->d_name);
+            if (ret) {
+                gf_log(this->name, GF_LOG_ERROR,
+                       "Child loc"
+                       " build failed for entry: %s",
+                       entry->d_name);
+
+                gf_defrag_count_failure(defrag, item);
 
                 if (conf->decommission_in_progress) {
+                    defrag->defrag_status = GF_DEFRAG_STATUS_FAILED;
+                    ret = -1;
                     goto out;
                 }
+                continue;
             }
-        }
-    }
 
-    gf_msg_trace(this->name, 0, "fix layout called on %s", loc->path);
+            if (DT_UNKNOWN == entry->d_type) {
+                ret = syncop_lookup(this, &entry_loc, &entry_iatt, NULL, NULL,
+                                    NULL);
+                if ((ret == 0) && (entry_iatt.ia_type != IA_IFDIR)) {
+                    continue;
+                }
+            }
 
-    if (gf_defrag_settle_hash(this, defrag, loc, fix_layout) != 0) {
-        defrag->total_failures++;
+            /* The subdir must exist on every subvol before the layout of
+             * this dir is fixed, see gf_defrag_fix_dir() */
+            ret = gf_defrag_lookup_dir(this, defrag, &entry_loc);
+            if (ret > 0)
+                continue;
 
-        gf_msg(this->name, GF_LOG_ERROR, 0, DHT_MSG_SETTLE_HASH_FAILED,
-               "Settle hash failed for %s", loc->path);
+            if (ret == 0) {
+                child = gf_defrag_crawl_item_new(item, &entry_loc);
+                if (child) {
+                    gf_defrag_crawl_push(crawler, child);
+                    continue;
+                }
+                gf_defrag_count_failure(defrag, NULL);
+            }
 
-        ret = -1;
+            gf_msg(this->name, GF_LOG_ERROR, 0, DHT_MSG_LAYOUT_FIX_FAILED,
+                   "Fix layout failed for %s", entry_loc.path);
+            gf_defrag_crawl_item_fail(defrag, item);
 
-        if (conf->decommission_in_progress) {
-            defrag->defrag_status = GF_DEFRAG_STATUS_FAILED;
-            goto out;
+            if (defrag->defrag_status != GF_DEFRAG_STATUS_STARTED) {
+                ret = -1;
+                goto out;
+            }
         }
+
+        gf_dirent_free(&entries);
+        free_entries = _gf_false;
+        INIT_LIST_HEAD(&entries.list);
     }
 
-    ret = 0;
+    ret = gf_defrag_fix_dir(this, defrag, loc, crawler->fix_layout,
+                            crawl->migrate_data, item);
 out:
     if (free_entries)
         gf_dirent_free(&entries);
@@ -3893,6 +4770,157 @@ out:
     return ret;
 }
 
+static void *
+gf_defrag_crawl_worker(void *opaque)
+{
+    gf_defrag_crawler_t *crawler = opaque;
+    gf_defrag_crawl_t *crawl = crawler->crawl;
+    gf_defrag_info_t *defrag = crawl->defrag;
+    gf_defrag_crawl_item_t *item = NULL;
+    xlator_t *old_THIS = NULL;
+    pid_t pid = GF_CLIENT_PID_DEFRAG;
+    int ret = 0;
+
+    old_THIS = THIS;
+    THIS = crawl->this;
+    syncopctx_setfspid(&pid);
+
+    while ((item = gf_defrag_crawl_next(crawler)) != NULL) {
+        ret = -1;
+        if (defrag->defrag_status == GF_DEFRAG_STATUS_STARTED)
+            ret = gf_defrag_crawl_dir(crawler, item);
+
+        if (ret) {
+            gf_defrag_crawl_item_fail(defrag, item);
+            if ((item->depth == 0) &&
+                (defrag->defrag_status == GF_DEFRAG_STATUS_STARTED))
+                crawl->root_ret = -1;
+        }
+
+        gf_defrag_crawl_item_unref(crawl->this, item);
+
+        pthread_mutex_lock(&crawl->mutex);
+        {
+            if (--crawl->outstanding == 0)
+                pthread_cond_broadcast(&crawl->cond);
+        }
+        pthread_mutex_unlock(&crawl->mutex);
+    }
+
+    THIS = old_THIS;
+
+    return NULL;
+}
+
+/* Same as gf_defrag_fix_layout(), but the tree is walked by
+ * rebal-crawl-threads threads at once. Each thread queues the subdirs it
+ * finds and any idle thread may take them, so one deep or wide subtree
+ * does not keep the others waiting. The calling thread is one of them.
+ */
+static int
+gf_defrag_parallel_crawl(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
+                         dict_t *fix_layout, dict_t *migrate_data)
+{
+    dht_conf_t *conf = NULL;
+    gf_defrag_crawl_t crawl = {
+        0,
+    };
+    gf_defrag_crawler_t *crawler = NULL;
+    gf_defrag_crawl_item_t *root = NULL;
+    int count = 0;
+    int started = 1;
+    int i = 0;
+    int ret = -1;
+
+    conf = this->private;
+    count = conf->rebal_crawl_threads;
+
+    ret = gf_defrag_lookup_dir(this, defrag, loc);
+    if (ret)
+        return (ret > 0) ? 0 : -1;
+
+    crawl.crawlers = GF_CALLOC(count, sizeof(*crawl.crawlers),
+                               gf_dht_mt_crawler_t);
+    if (!crawl.crawlers) {
+        ret = -1;
+        goto out;
+    }
+
+    crawl.count = count;
+    crawl.this = this;
+    crawl.defrag = defrag;
+    crawl.migrate_data = migrate_data;
+    pthread_mutex_init(&crawl.mutex, NULL);
+    pthread_cond_init(&crawl.cond, NULL);
+    GF_ATOMIC_INIT(crawl.skipped, 0);
+
+    for (i = 0; i < count; i++) {
+        crawler = &crawl.crawlers[i];
+        INIT_LIST_HEAD(&crawler->queue);
+        pthread_mutex_init(&crawler->lock, NULL);
+        crawler->index = i;
+        crawler->crawl = &crawl;
+        crawler->fix_layout = dict_copy_with_ref(fix_layout, NULL);
+        if (!crawler->fix_layout) {
+            ret = -1;
+            goto out;
+        }
+    }
+
+    root = gf_defrag_crawl_item_new(NULL, loc);
+    if (!root) {
+        ret = -1;
+        goto out;
+    }
+
+    gf_defrag_crawl_push(&crawl.crawlers[0], root);
+
+    for (started = 1; started < count; started++) {
+        ret = gf_thread_create(&crawl.crawlers[started].tid, NULL,
+                               gf_defrag_crawl_worker, &crawl.crawlers[started],
+                               "dhtcrawl%d", started & 0x3ff);
+        if (ret != 0) {
+            /* The threads already running take over its share */
+            gf_msg(this->name, GF_LOG_WARNING, ret,
+                   DHT_MSG_CRAWLER_THREAD_CREATE_FAILED,
+                   "Crawler thread[%d] creation failed", started);
+            break;
+        }
+    }
+
+    gf_defrag_crawl_worker(&crawl.crawlers[0]);
+
+    for (i = 1; i < started; i++) {
+        pthread_join(crawl.crawlers[i].tid, NULL);
+    }
+
+    gf_log(this->name, GF_LOG_INFO,
+           "crawled with %d threads, %" PRId64
+           " dirs skipped by checkpoint",
+           started, GF_ATOMIC_GET(crawl.skipped));
+
+    ret = crawl.root_ret;
+out:
+    if (crawl.crawlers) {
+        for (i = 0; i < count; i++) {
+            crawler = &crawl.crawlers[i];
+            if (crawler->fix_layout)
+                dict_unref(crawler->fix_layout);
+            if (crawler->crawl)
+                pthread_mutex_destroy(&crawler->lock);
+        }
+
+        if (crawl.count) {
+            pthread_mutex_destroy(&crawl.mutex);
+            pthread_cond_destroy(&crawl.cond);
+        }
+
+        GF_FREE(crawl.crawlers);
+    }
+
+    return ret;
+}
+
 int
 dht_init_local_subvols_and_nodeuuids(xlator_t *this, dht_conf_t *conf,
                                      loc_t *loc)
@@ -4309,7 +5337,7 @@ gf_defrag_start_crawl(void *data)
     if (ret) {
         gf_log(this->name, GF_LOG_ERROR, "Failed to set %s",
                conf->commithash_xattr_name);
-        defrag->total_failures++;
+        gf_defrag_count_failure(defrag, NULL);
         ret = -1;
         goto out;
     }
@@ -4320,7 +5348,7 @@ gf_defrag_start_crawl(void *data)
                "Failed to set commit hash on %s. "
                "Rebalance cannot proceed.",
                loc.path);
-        defrag->total_failures++;
+        gf_defrag_count_failure(defrag, NULL);
         ret = -1;
         goto out;
     }
@@ -4333,7 +5361,7 @@ gf_defrag_start_crawl(void *data)
                "Failed to start rebalance:"
                "Failed to set dictionary value: key = %s",
                GF_XATTR_FIX_LAYOUT_KEY);
-        defrag->total_failures++;
+        gf_defrag_count_failure(defrag, NULL);
         ret = -1;
         goto out;
     }
@@ -4344,7 +5372,7 @@ gf_defrag_start_crawl(void *data)
     if (ret) {
         gf_msg(this->name, GF_LOG_ERROR, -ret, DHT_MSG_REBALANCE_FAILED,
                "fix layout on %s failed", loc.path);
-        defrag->total_failures++;
+        gf_defrag_count_failure(defrag, NULL);
         ret = -1;
         goto out;
     }
@@ -4354,7 +5382,7 @@ gf_defrag_start_crawl(void *data)
 
         migrate_data = dict_new();
         if (!migrate_data) {
-            defrag->total_failures++;
+            gf_defrag_count_failure(defrag, NULL);
             ret = -1;
             goto out;
         }
@@ -4362,7 +5390,7 @@ gf_defrag_start_crawl(void *data)
             migrate_data, GF_XATTR_FILE_MIGRATE_KEY,
             (defrag->cmd == GF_DEFRAG_CMD_START_FORCE) ? "force" : "non-force");
         if (ret) {
-            defrag->total_failures++;
+            gf_defrag_count_failure(defrag, NULL);
             ret = -1;
             goto out;
         }
@@ -4390,14 +5418,20 @@ gf_defrag_start_crawl(void *data)
         }
     }
 
-    ret = gf_defrag_fix_layout(this, defrag, &loc, fix_layout, migrate_data);
+    if (conf->rebal_crawl_threads > 1) {
+        ret = gf_defrag_parallel_crawl(this, defrag, &loc, fix_layout,
+                                       migrate_data);
+    } else {
+        ret = gf_defrag_fix_layout(this, defrag, &loc, fix_layout,
+                                   migrate_data);
+    }
     if (ret) {
         ret = -1;
         goto out;
     }
 
     if (gf_defrag_settle_hash(this, defrag, &loc, fix_layout) != 0) {
-        defrag->total_failures++;
+        gf_defrag_count_failure(defrag, NULL);
         ret = -1;
         goto out;
     }
@@ -4420,6 +5454,10 @@ out:
         defrag->defrag_status = GF_DEFRAG_STATUS_COMPLETE;
     }
 
+    if ((defrag->defrag_status == GF_DEFRAG_STATUS_COMPLETE) &&
+        conf->vch_forced && (conf->rebal_crawl_threads > 1))
+        gf_defrag_crawl_clear_checkpoints(this, defrag, &loc, 0);
+
     if (fc_thread_started) {
         gf_defrag_estimates_cleanup(this, defrag, filecnt_thread);
     }
@@ -1628,6 +1628,7 @@ dht_fix_layout_of_directory(call_frame_t *frame, loc_t *loc,
     dht_local_t *local = NULL;
     uint32_t subvol_down = 0;
     gf_boolean_t maximize_overlap = _gf_true;
+    uint32_t *factors = NULL;
     char gfid[GF_UUID_BUF_SIZE] = {0};
 
     this = frame->this;
@@ -1701,6 +1702,12 @@ dht_fix_layout_of_directory(call_frame_t *frame, loc_t *loc,
     if (!priv->do_weighting)
         maximize_overlap = _gf_true;
 
+    /* Swapping ranges would hand a placement weighted or pinned range to
+     * another subvolume */
+    factors = alloca(new_layout->cnt * sizeof(*factors));
+    if (dht_placement_factors(this, loc, new_layout, factors))
+        maximize_overlap = _gf_false;
+
     /* Now selectively re-assign ranges only when it helps */
     if (maximize_overlap) {
         dht_selfheal_layout_maximize_overlap(frame, loc, new_layout, layout);
@@ -1752,12 +1759,15 @@ dht_selfheal_layout_new_directory(call_frame_t *frame, loc_t *loc,
     int bricks_to_use = 0;
     int err = 0;
     int start_subvol = 0;
-    uint32_t curr_size;
+    uint64_t curr_size;
     uint32_t range_size;
     uint64_t total_size = 0;
     int real_i;
     dht_conf_t *priv;
     gf_boolean_t weight_by_size;
+    gf_boolean_t weight_by_policy;
+    uint32_t *factors = NULL;
+    int usable = 0;
     int bricks_used = 0;
 
     this = frame->this;
@@ -1767,10 +1777,24 @@ dht_selfheal_layout_new_directory(call_frame_t *frame, loc_t *loc,
     bricks_to_use = dht_get_layout_count(this, layout, 1);
     GF_ASSERT(bricks_to_use > 0);
 
+    /* Multipliers of the placement policy, 0 for the subvolumes a pinned
+     * directory must not use */
+    factors = alloca(layout->cnt * sizeof(*factors));
+    weight_by_policy = dht_placement_factors(this, loc, layout, factors);
+    if (weight_by_policy) {
+        for (i = 0; i < layout->cnt; ++i) {
+            err = layout->list[i].err;
+            if (((err == -1) || (err == ENOENT)) && factors[i])
+                usable++;
+        }
+        if (usable < bricks_to_use)
+            bricks_to_use = usable;
+    }
+
     bricks_used = 0;
     for (i = 0; i < layout->cnt; ++i) {
         err = layout->list[i].err;
-        if ((err != -1) && (err != ENOENT)) {
+        if (((err != -1) && (err != ENOENT)) || !factors[i]) {
             continue;
         }
         curr_size = dht_get_chunks_from_xl(this, layout->list[i].xlator);
@@ -1778,13 +1802,28 @@ dht_selfheal_layout_new_directory(call_frame_t *frame, loc_t *loc,
             weight_by_size = _gf_false;
             break;
         }
-        total_size += curr_size;
+        total_size += curr_size * factors[i];
         if (++bricks_used >= bricks_to_use) {
             break;
         }
     }
 
-    if (weight_by_size && total_size) {
+    if (weight_by_policy && !weight_by_size) {
+        total_size = 0;
+        bricks_used = 0;
+        for (i = 0; i < layout->cnt; ++i) {
+            err = layout->list[i].err;
+            if (((err != -1) && (err != ENOENT)) || !factors[i]) {
+                continue;
+            }
+            total_size += factors[i];
+            if (++bricks_used >= bricks_to_use) {
+                break;
+            }
+        }
+    }
+
+    if ((weight_by_size || weight_by_policy) && total_size) {
         /* We know total_size is not zero. */
         chunk = ((double)0xffffffff) / ((double)total_size);
         gf_msg_debug(this->name, 0,
@@ -1792,6 +1831,7 @@ dht_selfheal_layout_new_directory(call_frame_t *frame, loc_t *loc,
                      chunk);
     } else {
         weight_by_size = _gf_false;
+        weight_by_policy = _gf_false;
         chunk = ((unsigned long)0xffffffff) / bricks_to_use;
     }
 
@@ -1812,7 +1852,7 @@ dht_selfheal_layout_new_directory(call_frame_t *frame, loc_t *loc,
     for (real_i = 0; real_i < layout->cnt; real_i++) {
         i = (real_i + start_subvol) % layout->cnt;
         err = layout->list[i].err;
-        if ((err != -1) && (err != ENOENT)) {
+        if (((err != -1) && (err != ENOENT)) || !factors[i]) {
             continue;
         }
         if (weight_by_size) {
@@ -1823,6 +1863,8 @@ dht_selfheal_layout_new_directory(call_frame_t *frame, loc_t *loc,
         } else {
             curr_size = 1;
         }
+        if (weight_by_policy)
+            curr_size *= factors[i];
         range_size = chunk * curr_size;
         gf_msg_debug(this->name, 0, "assigning range size 0x%x to %s",
                      range_size, layout->list[i].xlator->name);
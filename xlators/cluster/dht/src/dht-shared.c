@@ -137,6 +137,9 @@ dht_priv_dump(xlator_t *this)
 
             snprintf(key, sizeof(key), "du_stats[%d].log", i);
             gf_proc_dump_write(key, "%" PRIu32, conf->du_stats[i].log);
+
+            snprintf(key, sizeof(key), "du_stats[%d].usec_per_mb", i);
+            gf_proc_dump_write(key, "%lf", dht_placement_usec_per_mb(conf, i));
         }
     }
 
@@ -335,6 +338,7 @@ dht_init_regex(xlator_t *this, dict_t *odict, char *name, regex_t *re,
         }
     }
 unlock:
+    dht_hash_epoch_update(conf);
     UNLOCK(&conf->lock);
 }
 
@@ -452,6 +456,9 @@ dht_reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("lookup-optimize", conf->lookup_optimize, options, bool,
                      out);
 
+    GF_OPTION_RECONF("lookup-cache-timeout", conf->lookup_cache_timeout,
+                     options, uint32, out);
+
     GF_OPTION_RECONF("min-free-disk", conf->min_free_disk, options,
                      percent_or_size, out);
     /* option can be any one of percent or bytes */
@@ -467,6 +474,8 @@ dht_reconfigure(xlator_t *this, dict_t *options)
 
     GF_OPTION_RECONF("readdir-optimize", conf->readdir_optimize, options, bool,
                      out);
+    GF_OPTION_RECONF("readdir-merge", conf->readdir_merge, options, bool,
+                     out);
     GF_OPTION_RECONF("randomize-hash-range-by-gfid", conf->randomize_by_gfid,
                      options, bool, out);
 
@@ -476,6 +485,12 @@ dht_reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("force-migration", conf->force_migration, options, bool,
                      out);
 
+    GF_OPTION_RECONF("rebal-io-window", conf->rebal_io_window, options, uint32,
+                     out);
+
+    GF_OPTION_RECONF("rebal-crawl-threads", conf->rebal_crawl_threads, options,
+                     uint32, out);
+
     GF_OPTION_RECONF("ensure-durability", conf->ensure_durability, options,
                      bool, out);
 
@@ -513,6 +528,14 @@ dht_reconfigure(xlator_t *this, dict_t *options)
 
     GF_OPTION_RECONF("weighted-rebalance", conf->do_weighting, options, bool,
                      out);
+    GF_OPTION_RECONF("placement-weighting", conf->placement_weighting, options,
+                     bool, out);
+    GF_OPTION_RECONF("subvol-device-classes", conf->subvol_device_classes,
+                     options, str, out);
+    GF_OPTION_RECONF("device-class-weights", conf->device_class_weights,
+                     options, str, out);
+    GF_OPTION_RECONF("device-class-pins", conf->device_class_pins, options,
+                     str, out);
 
     GF_OPTION_RECONF("use-readdirp", conf->use_readdirp, options, bool, out);
     ret = 0;
@@ -647,6 +670,12 @@ dht_init(xlator_t *this)
     LOCK_INIT(&conf->lock);
     synclock_init(&conf->link_lock, SYNC_LOCK_DEFAULT);
 
+    if (dht_hash_epoch_init()) {
+        gf_msg(this->name, GF_LOG_ERROR, 0, DHT_MSG_INIT_FAILED,
+               "failed to initialize the name hash cache");
+        goto err;
+    }
+
     /* We get the commit-hash to set only for rebalance process */
     if (dict_get_uint32(this->options, "commit-hash", &commit_hash) == 0) {
         gf_msg(this->name, GF_LOG_INFO, 0, DHT_MSG_COMMIT_HASH_INFO,
@@ -730,6 +759,9 @@ dht_init(xlator_t *this)
 
     GF_OPTION_INIT("lookup-optimize", conf->lookup_optimize, bool, err);
 
+    GF_OPTION_INIT("lookup-cache-timeout", conf->lookup_cache_timeout, uint32,
+                   err);
+
     GF_OPTION_INIT("unhashed-sticky-bit", conf->unhashed_sticky_bit, bool, err);
 
     GF_OPTION_INIT("use-readdirp", conf->use_readdirp, bool, err);
@@ -747,10 +779,17 @@ dht_init(xlator_t *this)
 
     GF_OPTION_INIT("readdir-optimize", conf->readdir_optimize, bool, err);
 
+    GF_OPTION_INIT("readdir-merge", conf->readdir_merge, bool, err);
+
     GF_OPTION_INIT("lock-migration", conf->lock_migration_enabled, bool, err);
 
     GF_OPTION_INIT("force-migration", conf->force_migration, bool, err);
 
+    GF_OPTION_INIT("rebal-io-window", conf->rebal_io_window, uint32, err);
+
+    GF_OPTION_INIT("rebal-crawl-threads", conf->rebal_crawl_threads, uint32,
+                   err);
+
     GF_OPTION_INIT("ensure-durability", conf->ensure_durability, bool, err);
 
     if (defrag) {
@@ -839,6 +878,12 @@ dht_init(xlator_t *this)
     }
 
     GF_OPTION_INIT("weighted-rebalance", conf->do_weighting, bool, err);
+    GF_OPTION_INIT("placement-weighting", conf->placement_weighting, bool, err);
+    GF_OPTION_INIT("subvol-device-classes", conf->subvol_device_classes, str,
+                   err);
+    GF_OPTION_INIT("device-class-weights", conf->device_class_weights, str,
+                   err);
+    GF_OPTION_INIT("device-class-pins", conf->device_class_pins, str, err);
 
     conf->lock_pool = mem_pool_new(dht_lock_t, 512);
     if (!conf->lock_pool) {
@@ -916,6 +961,22 @@ struct volume_options dht_options[] = {
      .op_version = {GD_OP_VERSION_3_7_2},
      .level = OPT_STATUS_ADVANCED,
      .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"lookup-cache-timeout"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = 3600,
+     .default_value = "0",
+     .description =
+         "Time in seconds for which a lookup of a missing name, or the "
+         "subvolume a linkto file led to, is remembered per directory, so "
+         "that repeating the lookup needs no lookup on all subvolumes or "
+         "on the linkto file. Entries are dropped when the layout of the "
+         "directory changes, on namespace changes done by this client, and "
+         "on cache invalidations from the bricks (features.cache-"
+         "invalidation). 0 disables the cache.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
     {.key = {"min-free-disk"},
      .type = GF_OPTION_TYPE_PERCENT_OR_SIZET,
      .default_value = "10%",
@@ -1004,6 +1065,19 @@ struct volume_options dht_options[] = {
      .op_version = {1},
      .level = OPT_STATUS_ADVANCED,
      .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"readdir-merge"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .description =
+         "If enabled, directories are read from all the subvolumes at once "
+         "and entries are returned as soon as any subvolume answers, instead "
+         "of reading the subvolumes one after the other. The offsets of the "
+         "entries are only valid on the fd that returned them and for the "
+         "last " TOSTRING(DHT_RDM_HISTORY) " entries returned, seeking "
+         "further back fails with EINVAL.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
     {.key = {"rsync-hash-regex"},
      .type = GF_OPTION_TYPE_STR,
      /* Setting a default here doesn't work.  See dht_init_regex. */
@@ -1051,6 +1125,48 @@ struct volume_options dht_options[] = {
      .level = OPT_STATUS_BASIC,
      .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
 
+    {.key = {"placement-weighting"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .description =
+         "When enabled, the hash ranges of new layouts are also weighted by "
+         "the weight of the device class of each subvolume, and the files "
+         "whose hashed subvolume is full go to the subvolume with free space "
+         "that wrote the fastest lately instead of the emptiest one.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+
+    {.key = {"subvol-device-classes"},
+     .type = GF_OPTION_TYPE_STR,
+     .description =
+         "Device class of the subvolumes, as a comma separated list of "
+         "<subvolume>:<class>, e.g. \"vol-client-0:nvme,vol-client-1:hdd\".",
+     .op_version = {GD_OP_VERSION_10_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+
+    {.key = {"device-class-weights"},
+     .type = GF_OPTION_TYPE_STR,
+     .description =
+         "Weight of the device classes when placement-weighting is on, as a "
+         "comma separated list of <class>:<weight>, e.g. \"nvme:4,hdd:1\". "
+         "Classes not listed weigh 1.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+
+    {.key = {"device-class-pins"},
+     .type = GF_OPTION_TYPE_STR,
+     .description =
+         "Directories whose new layouts only use subvolumes of a device "
+         "class, as a comma separated list of <path>:<class>, e.g. "
+         "\"/db:nvme,/archive:hdd\". A pin applies to the whole tree below "
+         "the path, the longest matching path wins.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+
     /* NUFA option */
     {.key = {"local-volume-name"}, .type = GF_OPTION_TYPE_XLATOR},
 
@@ -1103,6 +1219,34 @@ struct volume_options dht_options[] = {
      .level = OPT_STATUS_ADVANCED,
      .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
 
+    {.key = {"rebal-io-window"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = 64,
+     .default_value = "1",
+     .description = "Number of 1MB chunks of a file that rebalance copies "
+                    "in parallel while migrating it. Larger values speed up "
+                    "the migration of big files, at the cost of 1MB of "
+                    "memory per chunk and per file being migrated.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+
+    {.key = {"rebal-crawl-threads"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = 32,
+     .default_value = "1",
+     .description = "Number of threads that walk the directory tree during "
+                    "rebalance, fixing layouts and finding files to migrate. "
+                    "With more than one thread, idle threads take "
+                    "directories from busy ones, and each finished subtree "
+                    "near the root is checkpointed so that a restarted "
+                    "rebalance skips it.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+
     {.key = {"ensure-durability"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "on",
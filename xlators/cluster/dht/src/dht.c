@@ -97,7 +97,7 @@ struct xlator_dumpops dumpops = {
 
 struct xlator_cbks cbks = {
     .release = dht_release,
-    //      .releasedir = dht_releasedir,
+    .releasedir = dht_releasedir,
     .forget = dht_forget,
 };
 
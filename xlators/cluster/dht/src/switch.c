@@ -872,7 +872,8 @@ struct xlator_fops fops = {
     .setattr = dht_setattr,
 };
 
-struct xlator_cbks cbks = {.forget = dht_forget};
+struct xlator_cbks cbks = {.forget = dht_forget,
+                           .releasedir = dht_releasedir};
 extern int32_t
 mem_acct_init(xlator_t *this);
 
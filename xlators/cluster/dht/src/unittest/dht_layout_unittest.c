@@ -68,6 +68,54 @@ helper_xlator_destroy(xlator_t *xl)
     return 0;
 }
 
+/* Splits the hash space evenly among cnt fake subvolumes, leaving the
+ * entries listed in zeroed with an empty range, like a layout whose spread
+ * count is smaller than the number of subvolumes */
+static dht_layout_t *
+helper_layout_init(xlator_t *xl, int cnt, int zeroed)
+{
+    dht_layout_t *layout;
+    uint32_t chunk;
+    uint32_t start = 0;
+    int ranges = cnt - zeroed;
+    int i;
+
+    layout = dht_layout_new(xl, cnt);
+    assert_non_null(layout);
+
+    chunk = 0xffffffff / ranges;
+    for (i = 0; i < cnt; i++) {
+        layout->list[i].xlator = (xlator_t *)(uintptr_t)(0x1000 + i);
+        if (i < zeroed)
+            continue;
+        layout->list[i].start = start;
+        layout->list[i].stop = (i == cnt - 1) ? 0xffffffff : start + chunk - 1;
+        start += chunk;
+    }
+
+    return layout;
+}
+
+static xlator_t *
+helper_layout_scan(dht_layout_t *layout, uint32_t hash)
+{
+    int i;
+
+    for (i = 0; i < layout->cnt; i++) {
+        if (layout->list[i].start <= hash && layout->list[i].stop >= hash)
+            return layout->list[i].xlator;
+    }
+
+    return NULL;
+}
+
+static uint32_t
+helper_next_hash(uint32_t hash)
+{
+    /* Fixed sequence: the results must not depend on the run */
+    return hash * 1664525 + 1013904223;
+}
+
 /*
  * Unit tests
  */
@@ -116,11 +164,86 @@ test_dht_layout_new(void **state)
     helper_xlator_destroy(xl);
 }
 
+static void
+test_dht_layout_search_hash(void **state)
+{
+    xlator_t *xl;
+    dht_layout_t *layout;
+    uint32_t hash = 1;
+    uint32_t tmp;
+    int i;
+
+    xl = helper_xlator_init(10);
+
+    // Too small for a table
+    layout = helper_layout_init(xl, 4, 0);
+    dht_layout_compile(layout);
+    assert_int_equal(GF_ATOMIC_GET(layout->search_cnt), 0);
+    assert_ptr_equal(dht_layout_search_hash(layout, 0x12345678),
+                     helper_layout_scan(layout, 0x12345678));
+    free(layout);
+
+    // Zeroed out ranges are not part of the table
+    layout = helper_layout_init(xl, 128, 28);
+    dht_layout_compile(layout);
+    assert_int_equal(GF_ATOMIC_GET(layout->search_cnt), 100);
+    assert_ptr_equal(dht_layout_search_hash(layout, 0), layout->list[0].xlator);
+    assert_ptr_equal(dht_layout_search_hash(layout, 0xffffffff),
+                     layout->list[127].xlator);
+    for (i = 0; i < 100000; i++) {
+        hash = helper_next_hash(hash);
+        assert_ptr_equal(dht_layout_search_hash(layout, hash),
+                         helper_layout_scan(layout, hash));
+    }
+
+    // Unsorted layouts are found as well
+    tmp = layout->list[30].start;
+    layout->list[30].start = layout->list[90].start;
+    layout->list[90].start = tmp;
+    tmp = layout->list[30].stop;
+    layout->list[30].stop = layout->list[90].stop;
+    layout->list[90].stop = tmp;
+    dht_layout_compile(layout);
+    assert_int_equal(GF_ATOMIC_GET(layout->search_cnt), 100);
+    for (i = 0; i < 100000; i++) {
+        hash = helper_next_hash(hash);
+        assert_ptr_equal(dht_layout_search_hash(layout, hash),
+                         helper_layout_scan(layout, hash));
+    }
+
+    // A range changed behind the table is not trusted
+    tmp = layout->list[50].start;
+    layout->list[50].start = layout->list[50].stop;
+    assert_ptr_equal(dht_layout_search_hash(layout, tmp),
+                     helper_layout_scan(layout, tmp));
+    layout->list[50].start = tmp;
+
+    // Overlapping ranges keep the first match of the scan
+    layout->list[60].stop = layout->list[61].stop;
+    dht_layout_compile(layout);
+    assert_int_equal(GF_ATOMIC_GET(layout->search_cnt), 0);
+    assert_ptr_equal(dht_layout_search_hash(layout, layout->list[61].start),
+                     layout->list[60].xlator);
+    free(layout);
+
+    // Holes are not found
+    layout = helper_layout_init(xl, 16, 0);
+    tmp = layout->list[8].start;
+    layout->list[8].start = layout->list[8].stop = 0;
+    dht_layout_compile(layout);
+    assert_int_equal(GF_ATOMIC_GET(layout->search_cnt), 15);
+    assert_null(dht_layout_search_hash(layout, tmp));
+    free(layout);
+
+    helper_xlator_destroy(xl);
+}
+
 int
 main(void)
 {
     const struct CMUnitTest xlator_dht_layout_tests[] = {
         unit_test(test_dht_layout_new),
+        unit_test(test_dht_layout_search_hash),
     };
 
     return cmocka_run_group_tests(xlator_dht_layout_tests, NULL, NULL);
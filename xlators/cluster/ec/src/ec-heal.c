@@ -17,6 +17,7 @@
 
 #include "ec.h"
 #include "ec-types.h"
+#include "ec-mem-types.h"
 #include "ec-messages.h"
 #include "ec-helpers.h"
 #include "ec-common.h"
@@ -1944,31 +1945,95 @@ out:
     return ret;
 }
 
+/* The range of the file covered by the blocks of a window. Only that range
+ * is locked, so that the next window can be locked and read while the
+ * blocks of this one are still being written. */
+static void
+ec_heal_data_range(ec_heal_t *heal, off_t *offset, size_t *size)
+{
+    if (heal->block_count == 0) {
+        *offset = 0;
+        *size = 0;
+        return;
+    }
+
+    *offset = heal->blocks[0].offset;
+    *size = heal->blocks[heal->block_count - 1].offset + heal->size - *offset;
+}
+
+/* Starts the copy of all blocks of the current window. Each block has its
+ * own read and write fops, all of them children of the heal fop, so the
+ * state machine won't release the lock until all of them have finished. */
+static void
+ec_heal_data_blocks(ec_heal_t *heal)
+{
+    uint32_t i;
+
+    if (heal->block_count == 0) {
+        ec_heal_data_block(heal);
+        return;
+    }
+
+    for (i = 0; i < heal->block_count; i++) {
+        heal->blocks[i].fop = heal->fop;
+        ec_heal_data_block(&heal->blocks[i]);
+    }
+}
+
+static void
+ec_heal_data_blocks_merge(ec_heal_t *heal)
+{
+    ec_heal_t *block;
+    uint32_t i;
+
+    for (i = 0; i < heal->block_count; i++) {
+        block = &heal->blocks[i];
+
+        LOCK(&heal->lock);
+
+        heal->good &= block->good;
+        heal->bad &= block->bad;
+        if (block->done) {
+            heal->done = 1;
+        }
+
+        UNLOCK(&heal->lock);
+
+        block->fop = NULL;
+    }
+}
+
 int32_t
 ec_manager_heal_block(ec_fop_data_t *fop, int32_t state)
 {
     ec_heal_t *heal = fop->data;
+    off_t offset = 0;
+    size_t size = 0;
+
     heal->fop = fop;
 
     switch (state) {
         case EC_STATE_INIT:
             ec_owner_set(fop->frame, fop->frame->root);
 
-            ec_heal_inodelk(heal, F_WRLCK, 1, 0, 0);
+            ec_heal_data_range(heal, &offset, &size);
+            ec_heal_inodelk(heal, F_WRLCK, 1, offset, size);
 
             return EC_STATE_HEAL_DATA_COPY;
 
         case EC_STATE_HEAL_DATA_COPY:
             gf_msg_debug(fop->xl->name, 0, "%s: read/write starting",
                          uuid_utoa(heal->fd->inode->gfid));
-            ec_heal_data_block(heal);
+            ec_heal_data_blocks(heal);
 
             return EC_STATE_HEAL_DATA_UNLOCK;
 
         case -EC_STATE_HEAL_DATA_COPY:
         case -EC_STATE_HEAL_DATA_UNLOCK:
         case EC_STATE_HEAL_DATA_UNLOCK:
-            ec_heal_inodelk(heal, F_UNLCK, 1, 0, 0);
+            ec_heal_data_blocks_merge(heal);
+            ec_heal_data_range(heal, &offset, &size);
+            ec_heal_inodelk(heal, F_UNLCK, 1, offset, size);
 
             return EC_STATE_REPORT;
 
@@ -2055,21 +2120,268 @@ ec_sync_heal_block(call_frame_t *frame, xlator_t *this, ec_heal_t *heal)
     return 0;
 }
 
+/* Finds where the data at or after '*data' starts and where it ends on one
+ * of the sources. The range from there to the end of the file is locked
+ * while looking, so that no write or discard can change it meanwhile. The
+ * offsets on the bricks are the ones of the file divided by the number of
+ * fragments. */
+static int
+ec_heal_seek(call_frame_t *frame, ec_t *ec, ec_heal_t *heal, off_t *data,
+             off_t *hole)
+{
+    default_args_cbk_t *replies = NULL;
+    unsigned char *locked_on = NULL;
+    unsigned char *output = NULL;
+    unsigned char *on = NULL;
+    off_t start = *data / ec->fragments;
+    off_t offset = 0;
+    int ret = 0;
+    int i = 0;
+
+    EC_REPLIES_ALLOC(replies, ec->nodes);
+    locked_on = alloca0(ec->nodes);
+    output = alloca0(ec->nodes);
+    on = alloca0(ec->nodes);
+    ec_mask_to_char_array(heal->good, on, ec->nodes);
+
+    ret = cluster_inodelk(ec->xl_list, on, ec->nodes, replies, locked_on,
+                          frame, ec->xl, ec->xl->name, heal->fd->inode, start,
+                          0);
+    {
+        for (i = 0; i < ec->nodes; i++) {
+            if (locked_on[i])
+                break;
+        }
+        if (i == ec->nodes) {
+            ret = -ENOTCONN;
+            goto unlock;
+        }
+
+        ret = syncop_seek(ec->xl_list[i], heal->fd, start, GF_SEEK_DATA, NULL,
+                          &offset);
+        if (ret < 0)
+            goto unlock;
+        *data = offset * ec->fragments;
+
+        ret = syncop_seek(ec->xl_list[i], heal->fd, offset, GF_SEEK_HOLE, NULL,
+                          &offset);
+        if (ret < 0)
+            goto unlock;
+        *hole = offset * ec->fragments;
+    }
+unlock:
+    cluster_uninodelk(ec->xl_list, locked_on, ec->nodes, replies, output, frame,
+                      ec->xl, ec->xl->name, heal->fd->inode, start, 0);
+    cluster_replies_wipe(replies, ec->nodes);
+
+    return ret;
+}
+
+/* Finds the first stripe at or after '*offset' that contains data on the
+ * sources. '*data_end' caches the end of the last data extent found, so that
+ * only two seeks are needed per extent instead of two per block.
+ *
+ * Returns 1 if there's no more data, 0 if '*offset' has been updated, or a
+ * negative error if the sources don't support seek. */
+static int
+ec_heal_next_data(call_frame_t *frame, ec_t *ec, ec_heal_t *heal,
+                  uint64_t *offset, uint64_t *data_end)
+{
+    off_t data = *offset;
+    off_t hole = 0;
+    int ret;
+
+    if (*offset < *data_end)
+        return 0;
+
+    ret = ec_heal_seek(frame, ec, heal, &data, &hole);
+    if (ret == -ENXIO)
+        return 1;
+    if (ret < 0)
+        return ret;
+
+    /* Writes must be aligned to the stripe size. */
+    data -= data % ec->stripe_size;
+    if (data > *offset) {
+        GF_ATOMIC_ADD(ec->stats.data_heal.skipped, data - *offset);
+        *offset = data;
+    }
+    *data_end = hole;
+
+    return 0;
+}
+
+/* Waits until 'size' more bytes can be rebuilt without exceeding the
+ * bandwidth limit. Each block reserves its slot after the previous one, and
+ * the heal task yields its thread while it waits. */
+static void
+ec_heal_throttle_data(ec_t *ec, uint64_t size)
+{
+    struct timespec now;
+    uint64_t limit = ec->heal_bandwidth_limit;
+    uint64_t usecs = 0;
+    uint64_t start = 0;
+    uint64_t wait = 0;
+
+    if (limit == 0)
+        return;
+
+    timespec_now(&now);
+    usecs = TS(now) / 1000;
+
+    LOCK(&ec->lock);
+    {
+        start = max(usecs, ec->heal_throttle_next);
+        ec->heal_throttle_next = start + size * 1000000 / limit;
+    }
+    UNLOCK(&ec->lock);
+
+    for (wait = start - usecs; (wait > 0) && !ec->shutdown;
+         wait -= min(wait, 1000000)) {
+        synctask_usleep(min(wait, 1000000));
+    }
+}
+
+static void
+ec_heal_data_stats_update(ec_t *ec, fd_t *fd, uint64_t healed,
+                          struct timespec *start)
+{
+    struct timespec end;
+    uint64_t usecs;
+
+    timespec_now(&end);
+    usecs = gf_tsdiff(start, &end) / 1000;
+
+    GF_ATOMIC_INC(ec->stats.data_heal.files);
+    GF_ATOMIC_ADD(ec->stats.data_heal.healed, healed);
+    GF_ATOMIC_ADD(ec->stats.data_heal.usecs, usecs);
+
+    LOCK(&ec->stats.data_heal.lock);
+    {
+        gf_uuid_copy(ec->stats.data_heal.last_gfid, fd->inode->gfid);
+        ec->stats.data_heal.last_size = healed;
+        ec->stats.data_heal.last_usecs = usecs;
+    }
+    UNLOCK(&ec->stats.data_heal.lock);
+
+    gf_msg_debug(ec->xl->name, 0,
+                 "%s: rebuilt %" PRIu64 " bytes in %" PRIu64
+                 " usecs (%" PRIu64 " KB/s)",
+                 uuid_utoa(fd->inode->gfid), healed, usecs,
+                 (usecs == 0) ? 0 : (healed * 1000000 / usecs) / 1024);
+}
+
+/* Chooses the blocks of the next window, skipping the holes of the sources
+ * if requested, and waits for the bandwidth they need. Returns the number of
+ * blocks, 0 when there's nothing left to rebuild. */
+static uint32_t
+ec_heal_window_prepare(call_frame_t *frame, ec_t *ec, ec_heal_t *heal,
+                       ec_heal_t *window, uint32_t blocks, uint64_t *offset,
+                       uint64_t *data_end, uint64_t size, uint64_t *pending)
+{
+    ec_heal_t *block = NULL;
+    uint32_t count = 0;
+    int ret = 0;
+
+    *pending = 0;
+    for (count = 0; (count < blocks) && (*offset < size); count++) {
+        ret = ec_heal_next_data(frame, ec, heal, offset, data_end);
+        if (ret < 0) {
+            /* Sources can't tell where holes are. Copy everything. */
+            gf_msg_debug(ec->xl->name, 0, "%s: unable to find holes: %s",
+                         uuid_utoa(heal->fd->inode->gfid), strerror(-ret));
+            *data_end = size;
+        } else if (ret > 0) {
+            GF_ATOMIC_ADD(ec->stats.data_heal.skipped, size - *offset);
+            *offset = size;
+            break;
+        }
+
+        block = &window->blocks[count];
+        block->offset = *offset;
+        block->good = heal->good;
+        block->bad = heal->bad;
+        block->done = 0;
+
+        ec_heal_throttle_data(ec, heal->size);
+        *pending += min(heal->size, size - *offset);
+        *offset += heal->size;
+    }
+
+    window->block_count = count;
+    window->good = heal->good;
+    window->bad = heal->bad;
+    window->done = 0;
+    window->error = 0;
+
+    return count;
+}
+
+/* Waits for a window started by ec_rebuild_data() and merges its result. */
+static int
+ec_heal_window_wait(ec_heal_t *heal, ec_heal_t *window)
+{
+    syncbarrier_wait(window->data, 1);
+
+    heal->good &= window->good;
+    heal->bad &= window->bad;
+    if (window->done)
+        heal->done = 1;
+
+    if (window->error != 0)
+        return -window->error;
+    if (heal->bad == 0)
+        return -ENOTCONN;
+
+    return 0;
+}
+
 int
 ec_rebuild_data(call_frame_t *frame, ec_t *ec, fd_t *fd, uint64_t size,
-                unsigned char *sources, unsigned char *healed_sinks)
+                unsigned char *sources, unsigned char *healed_sinks,
+                gf_boolean_t skip_holes)
 {
     ec_heal_t *heal = NULL;
+    ec_heal_t *windows = NULL;
+    ec_heal_t *window = NULL;
+    ec_heal_t *prev = NULL;
+    ec_heal_t *blocks = NULL;
+    ec_heal_t *block = NULL;
+    syncbarrier_t barriers[2];
+    uint64_t pending[2] = {0, 0};
+    struct timespec start;
+    uint64_t offset = 0;
+    uint64_t data_end = 0;
+    uint64_t healed = 0;
+    uint32_t count = 0;
+    uint32_t n = 0;
+    uint32_t i = 0;
+    uint32_t j = 0;
     int ret = 0;
-    syncbarrier_t barrier;
+    int err = 0;
+
+    /* Blocks rebuilt in parallel by each window. The value is read once,
+     * so that a reconfiguration doesn't change it in the middle. */
+    count = max(ec->heal_pipeline_window, 1);
 
-    if (syncbarrier_init(&barrier))
+    if (syncbarrier_init(&barriers[0]))
+        return -ENOMEM;
+    if (syncbarrier_init(&barriers[1])) {
+        syncbarrier_destroy(&barriers[0]);
         return -ENOMEM;
+    }
+    blocks = GF_CALLOC(2 * count, sizeof(*blocks), ec_mt_ec_heal_t);
+    if (blocks == NULL) {
+        syncbarrier_destroy(&barriers[0]);
+        syncbarrier_destroy(&barriers[1]);
+        return -ENOMEM;
+    }
+
+    timespec_now(&start);
 
     heal = alloca0(sizeof(*heal));
     heal->fd = fd_ref(fd);
     heal->xl = ec->xl;
-    heal->data = &barrier;
     ec_adjust_size_up(ec, &size, _gf_false);
     heal->total_size = size;
     heal->size = (128 * GF_UNIT_KB * (ec->self_heal_window_size));
@@ -2083,35 +2395,104 @@ ec_rebuild_data(call_frame_t *frame, ec_t *ec, fd_t *fd, uint64_t size,
     heal->iatt.ia_type = IA_IFREG;
     LOCK_INIT(&heal->lock);
 
-    for (heal->offset = 0; (heal->offset < size) && !heal->done;
-         heal->offset += heal->size) {
-        /* We immediately abort any heal if a shutdown request has been
-         * received to avoid delays. The healing of this file will be
-         * restarted by another SHD or other client that accesses the
-         * file. */
-        if (ec->shutdown) {
+    /* Two windows are in flight: the blocks of the next one are locked and
+     * read while the blocks of the previous one are still being written.
+     * Each window locks only its own range, with the lock owner of its own
+     * fop, so they don't conflict. */
+    windows = alloca0(2 * sizeof(*windows));
+    for (i = 0; i < 2; i++) {
+        window = &windows[i];
+        window->fd = heal->fd;
+        window->xl = heal->xl;
+        window->data = &barriers[i];
+        window->size = heal->size;
+        window->total_size = heal->total_size;
+        window->iatt.ia_type = IA_IFREG;
+        window->blocks = &blocks[i * count];
+        LOCK_INIT(&window->lock);
+        for (j = 0; j < count; j++) {
+            block = &window->blocks[j];
+            block->fd = heal->fd;
+            block->xl = heal->xl;
+            block->size = heal->size;
+            block->total_size = heal->total_size;
+            block->iatt.ia_type = IA_IFREG;
+            LOCK_INIT(&block->lock);
+        }
+    }
+
+    if (!skip_holes) {
+        data_end = size;
+    }
+
+    for (;;) {
+        window = NULL;
+        if ((ret >= 0) && (offset < size) && !heal->done) {
+            /* We immediately abort any heal if a shutdown request has been
+             * received to avoid delays. The healing of this file will be
+             * restarted by another SHD or other client that accesses the
+             * file. */
+            if (ec->shutdown) {
+                gf_msg_debug(ec->xl->name, 0,
+                             "Cancelling heal because "
+                             "EC is stopping.");
+                ret = -ENOTCONN;
+            } else {
+                window = &windows[n % 2];
+                if (ec_heal_window_prepare(frame, ec, heal, window, count,
+                                           &offset, &data_end, size,
+                                           &pending[n % 2]) == 0) {
+                    window = NULL;
+                }
+            }
+        }
+
+        if (window != NULL) {
             gf_msg_debug(ec->xl->name, 0,
-                         "Cancelling heal because "
-                         "EC is stopping.");
-            ret = -ENOTCONN;
-            break;
+                         "%s: sources: %d, sinks: "
+                         "%d, offset: %" PRIu64 " bsize: %" PRIu64
+                         " blocks: %u",
+                         uuid_utoa(fd->inode->gfid),
+                         EC_COUNT(sources, ec->nodes),
+                         EC_COUNT(healed_sinks, ec->nodes),
+                         window->blocks[0].offset, heal->size,
+                         window->block_count);
+            ec_heal_block(frame, ec->xl, window->bad | window->good,
+                          EC_MINIMUM_ONE, ec_heal_block_done, window);
+            n++;
+        }
+
+        if (prev != NULL) {
+            err = ec_heal_window_wait(heal, prev);
+            if (err < 0) {
+                if (ret >= 0)
+                    ret = err;
+            } else {
+                healed += pending[prev - windows];
+            }
         }
 
-        gf_msg_debug(ec->xl->name, 0,
-                     "%s: sources: %d, sinks: "
-                     "%d, offset: %" PRIu64 " bsize: %" PRIu64,
-                     uuid_utoa(fd->inode->gfid), EC_COUNT(sources, ec->nodes),
-                     EC_COUNT(healed_sinks, ec->nodes), heal->offset,
-                     heal->size);
-        ret = ec_sync_heal_block(frame, ec->xl, heal);
-        if (ret < 0)
+        if (window == NULL)
             break;
+        prev = window;
     }
+
     memset(healed_sinks, 0, ec->nodes);
     ec_mask_to_char_array(heal->bad, healed_sinks, ec->nodes);
+    if (ret >= 0) {
+        ec_heal_data_stats_update(ec, fd, healed, &start);
+    }
+    for (i = 0; i < 2; i++) {
+        for (j = 0; j < count; j++) {
+            LOCK_DESTROY(&windows[i].blocks[j].lock);
+        }
+        LOCK_DESTROY(&windows[i].lock);
+    }
+    GF_FREE(blocks);
     fd_unref(heal->fd);
     LOCK_DESTROY(&heal->lock);
-    syncbarrier_destroy(heal->data);
+    syncbarrier_destroy(&barriers[0]);
+    syncbarrier_destroy(&barriers[1]);
     if (ret < 0)
         gf_msg_debug(ec->xl->name, 0, "%s: heal failed %s",
                      uuid_utoa(fd->inode->gfid), strerror(-ret));
@@ -2158,6 +2539,57 @@ out:
     return ret;
 }
 
+/* Empties the sinks and extends them back to the size of the file, so that
+ * any range not rebuilt afterwards reads as zeroes. This is needed before
+ * skipping holes, otherwise stale data present in the sinks would survive. */
+int
+__ec_heal_reset_sinks(call_frame_t *frame, ec_t *ec, fd_t *fd,
+                      unsigned char *healed_sinks, uint64_t size)
+{
+    default_args_cbk_t *replies = NULL;
+    unsigned char *output = NULL;
+    off_t offset = 0;
+    int ret = 0;
+    int i = 0;
+
+    EC_REPLIES_ALLOC(replies, ec->nodes);
+    output = alloca0(ec->nodes);
+
+    ret = cluster_ftruncate(ec->xl_list, healed_sinks, ec->nodes, replies,
+                            output, frame, ec->xl, fd, 0, NULL);
+    for (i = 0; i < ec->nodes; i++) {
+        if (!output[i] && healed_sinks[i])
+            healed_sinks[i] = 0;
+    }
+    cluster_replies_wipe(replies, ec->nodes);
+
+    if (EC_COUNT(healed_sinks, ec->nodes) == 0) {
+        ret = -ENOTCONN;
+        goto out;
+    }
+
+    offset = size;
+    ec_adjust_offset_up(ec, &offset, _gf_true);
+    ret = cluster_ftruncate(ec->xl_list, healed_sinks, ec->nodes, replies,
+                            output, frame, ec->xl, fd, offset, NULL);
+    for (i = 0; i < ec->nodes; i++) {
+        if (!output[i] && healed_sinks[i])
+            healed_sinks[i] = 0;
+    }
+
+    if (EC_COUNT(healed_sinks, ec->nodes) == 0) {
+        ret = -ENOTCONN;
+        goto out;
+    }
+
+out:
+    cluster_replies_wipe(replies, ec->nodes);
+    if (ret < 0)
+        gf_msg_debug(ec->xl->name, 0, "%s: heal failed %s",
+                     uuid_utoa(fd->inode->gfid), strerror(-ret));
+    return ret;
+}
+
 int
 ec_data_undo_pending(call_frame_t *frame, ec_t *ec, fd_t *fd, dict_t *xattr,
                      uint64_t *versions, uint64_t *dirty, uint64_t *size,
@@ -2357,6 +2789,7 @@ __ec_heal_data(call_frame_t *frame, ec_t *ec, fd_t *fd, unsigned char *heal_on,
     uint64_t *size = NULL;
     unsigned char *trim = NULL;
     default_args_cbk_t *replies = NULL;
+    gf_boolean_t skip_holes = ec->heal_skip_holes;
     int ret = 0;
     int source = 0;
 
@@ -2399,6 +2832,10 @@ __ec_heal_data(call_frame_t *frame, ec_t *ec, fd_t *fd, unsigned char *heal_on,
 
         ret = __ec_heal_trim_sinks(frame, ec, fd, healed_sinks, trim,
                                    size[source]);
+        if ((ret >= 0) && skip_holes) {
+            ret = __ec_heal_reset_sinks(frame, ec, fd, healed_sinks,
+                                        size[source]);
+        }
     }
 unlock:
     cluster_uninodelk(ec->xl_list, locked_on, ec->nodes, replies, output, frame,
@@ -2415,7 +2852,8 @@ unlock:
                  uuid_utoa(fd->inode->gfid), EC_COUNT(sources, ec->nodes),
                  EC_COUNT(healed_sinks, ec->nodes));
 
-    ret = ec_rebuild_data(frame, ec, fd, size[source], sources, healed_sinks);
+    ret = ec_rebuild_data(frame, ec, fd, size[source], sources, healed_sinks,
+                          skip_holes);
     if (ret < 0)
         goto out;
 
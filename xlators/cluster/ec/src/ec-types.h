@@ -586,6 +586,8 @@ struct _ec_heal {
     uint64_t total_size;
     uint64_t version[2];
     uint64_t raw_size;
+    ec_heal_t *blocks;    /* Blocks healed in parallel under one lock */
+    uint32_t block_count; /* Number of valid entries in 'blocks' */
 };
 
 struct subvol_healer {
@@ -631,6 +633,16 @@ struct _ec_statistics {
                                 files/directories*/
         gf_atomic_t completed; /*Number of heals complted on files/directories*/
     } shd;
+    struct {
+        gf_atomic_t files;   /* Number of files whose data was rebuilt. */
+        gf_atomic_t healed;  /* Bytes of file data rebuilt on sinks. */
+        gf_atomic_t skipped; /* Bytes not rebuilt because they were holes. */
+        gf_atomic_t usecs;   /* Time spent rebuilding data, in usecs. */
+        gf_lock_t lock;      /* Protects the 'last' fields below. */
+        uuid_t last_gfid;    /* Last file whose data was rebuilt. */
+        uint64_t last_size;  /* Bytes rebuilt for the last file. */
+        uint64_t last_usecs; /* Time taken by the last file. */
+    } data_heal;
 };
 
 struct _ec {
@@ -671,6 +683,10 @@ struct _ec {
     uint32_t background_heals;
     uint32_t heal_wait_qlen;
     uint32_t self_heal_window_size; /* max size of read/writes */
+    uint32_t heal_pipeline_window;  /* blocks healed in parallel per file */
+    uint64_t heal_bandwidth_limit;  /* bytes/sec, 0 means unlimited */
+    uint64_t heal_throttle_next;    /* usecs, when the next block may go */
+    gf_boolean_t heal_skip_holes;
     uint32_t eager_lock_timeout;
     uint32_t other_eager_lock_timeout;
     struct list_head pending_fops;
@@ -192,6 +192,7 @@ __ec_destroy_private(xlator_t *this)
         }
 
         LOCK_DESTROY(&ec->lock);
+        LOCK_DESTROY(&ec->stats.data_heal.lock);
 
         if (ec->leaf_to_subvolid)
             dict_unref(ec->leaf_to_subvolid);
@@ -271,6 +272,12 @@ reconfigure(xlator_t *this, dict_t *options)
                      failed);
     GF_OPTION_RECONF("self-heal-window-size", ec->self_heal_window_size,
                      options, uint32, failed);
+    GF_OPTION_RECONF("heal-pipeline-window", ec->heal_pipeline_window,
+                     options, uint32, failed);
+    GF_OPTION_RECONF("heal-skip-holes", ec->heal_skip_holes, options, bool,
+                     failed);
+    GF_OPTION_RECONF("heal-bandwidth-limit", ec->heal_bandwidth_limit,
+                     options, size_uint64, failed);
     GF_OPTION_RECONF("heal-timeout", ec->shd.timeout, options, int32, failed);
     ec_configure_background_heal_opts(ec, background_heals, heal_wait_qlen);
     GF_OPTION_RECONF("shd-max-threads", ec->shd.max_threads, options, uint32,
@@ -712,6 +719,11 @@ ec_statistics_init(ec_t *ec)
     GF_ATOMIC_INIT(ec->stats.stripe_cache.errors, 0);
     GF_ATOMIC_INIT(ec->stats.shd.attempted, 0);
     GF_ATOMIC_INIT(ec->stats.shd.completed, 0);
+    GF_ATOMIC_INIT(ec->stats.data_heal.files, 0);
+    GF_ATOMIC_INIT(ec->stats.data_heal.healed, 0);
+    GF_ATOMIC_INIT(ec->stats.data_heal.skipped, 0);
+    GF_ATOMIC_INIT(ec->stats.data_heal.usecs, 0);
+    LOCK_INIT(&ec->stats.data_heal.lock);
 }
 
 static int
@@ -856,6 +868,11 @@ init(xlator_t *this)
     GF_OPTION_INIT("heal-wait-qlength", ec->heal_wait_qlen, uint32, failed);
     GF_OPTION_INIT("self-heal-window-size", ec->self_heal_window_size, uint32,
                    failed);
+    GF_OPTION_INIT("heal-pipeline-window", ec->heal_pipeline_window, uint32,
+                   failed);
+    GF_OPTION_INIT("heal-skip-holes", ec->heal_skip_holes, bool, failed);
+    GF_OPTION_INIT("heal-bandwidth-limit", ec->heal_bandwidth_limit,
+                   size_uint64, failed);
     ec_configure_background_heal_opts(ec, ec->background_heals,
                                       ec->heal_wait_qlen);
     GF_OPTION_INIT("read-policy", read_policy, str, failed);
@@ -1328,11 +1345,17 @@ ec_gf_setxattr(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *dict,
                int32_t flags, dict_t *xdata)
 {
     int error = 0;
+    uint32_t minimum = EC_MINIMUM_MIN;
 
     EC_INTERNAL_XATTR_OR_GOTO("", dict, error, out);
 
-    ec_setxattr(frame, this, -1, EC_MINIMUM_MIN, default_setxattr_cbk, NULL,
-                loc, dict, flags, xdata);
+    /* Shards deleted in bulk must be gone from all the bricks, or shard
+     * falls back to unlinking them one by one */
+    if (dict_get_sizen(dict, GF_XATTR_SHARD_BULK_DELETE))
+        minimum = EC_MINIMUM_ALL;
+
+    ec_setxattr(frame, this, -1, minimum, default_setxattr_cbk, NULL, loc,
+                dict, flags, xdata);
 
     return 0;
 out:
@@ -1533,6 +1556,9 @@ ec_dump_private(xlator_t *this)
     ec_t *ec = NULL;
     char key_prefix[GF_DUMP_MAX_BUF_LEN];
     char tmp[65];
+    uint64_t files;
+    uint64_t healed;
+    uint64_t usecs;
 
     GF_ASSERT(this);
 
@@ -1557,6 +1583,11 @@ ec_dump_private(xlator_t *this)
     gf_proc_dump_write("heal-wait-qlength", "%d", ec->heal_wait_qlen);
     gf_proc_dump_write("self-heal-window-size", "%" PRIu32,
                        ec->self_heal_window_size);
+    gf_proc_dump_write("heal-pipeline-window", "%" PRIu32,
+                       ec->heal_pipeline_window);
+    gf_proc_dump_write("heal-skip-holes", "%d", ec->heal_skip_holes);
+    gf_proc_dump_write("heal-bandwidth-limit", "%" PRIu64,
+                       ec->heal_bandwidth_limit);
     gf_proc_dump_write("healers", "%d", ec->healers);
     gf_proc_dump_write("heal-waiters", "%d", ec->heal_waiters);
     gf_proc_dump_write("read-policy", "%s", ec_read_policies[ec->read_policy]);
@@ -1586,6 +1617,41 @@ ec_dump_private(xlator_t *this)
     gf_proc_dump_write("heals-completed", "%" GF_PRI_ATOMIC,
                        GF_ATOMIC_GET(ec->stats.shd.completed));
 
+    snprintf(key_prefix, GF_DUMP_MAX_BUF_LEN, "%s.%s.stats.data_heal",
+             this->type, this->name);
+    gf_proc_dump_add_section("%s", key_prefix);
+
+    files = GF_ATOMIC_GET(ec->stats.data_heal.files);
+    healed = GF_ATOMIC_GET(ec->stats.data_heal.healed);
+    usecs = GF_ATOMIC_GET(ec->stats.data_heal.usecs);
+    gf_proc_dump_write("files", "%" PRIu64, files);
+    gf_proc_dump_write("bytes-healed", "%" PRIu64, healed);
+    gf_proc_dump_write("bytes-skipped", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(ec->stats.data_heal.skipped));
+    gf_proc_dump_write("heal-time-usecs", "%" PRIu64, usecs);
+    gf_proc_dump_write("throughput-KBps", "%" PRIu64,
+                       (usecs == 0) ? 0 : (healed * 1000000 / usecs) / 1024);
+
+    LOCK(&ec->stats.data_heal.lock);
+    {
+        if (files > 0) {
+            gf_proc_dump_write("last-gfid", "%s",
+                               uuid_utoa(ec->stats.data_heal.last_gfid));
+            gf_proc_dump_write("last-bytes-healed", "%" PRIu64,
+                               ec->stats.data_heal.last_size);
+            gf_proc_dump_write("last-heal-time-usecs", "%" PRIu64,
+                               ec->stats.data_heal.last_usecs);
+            gf_proc_dump_write(
+                "last-throughput-KBps", "%" PRIu64,
+                (ec->stats.data_heal.last_usecs == 0)
+                    ? 0
+                    : (ec->stats.data_heal.last_size * 1000000 /
+                       ec->stats.data_heal.last_usecs) /
+                          1024);
+        }
+    }
+    UNLOCK(&ec->stats.data_heal.lock);
+
     return 0;
 }
 
@@ -1800,6 +1866,37 @@ struct volume_options options[] = {
      .tags = {"disperse"},
      .description = "Maximum number blocks(128KB) per file for which "
                     "self-heal process would be applied simultaneously."},
+    {.key = {"heal-pipeline-window"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = 64,
+     .default_value = "1",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+     .tags = {"disperse"},
+     .description = "Number of blocks (of self-heal-window-size) of a file "
+                    "that self-heal reads from the sources and writes to the "
+                    "sinks in parallel. The next blocks are read while the "
+                    "previous ones are being written."},
+    {.key = {"heal-skip-holes"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+     .tags = {"disperse"},
+     .description = "If enabled, self-heal uses SEEK_DATA/SEEK_HOLE on the "
+                    "sources to skip holes of sparse files. Sinks are "
+                    "emptied before the heal so that skipped ranges are "
+                    "holes on them too."},
+    {.key = {"heal-bandwidth-limit"},
+     .type = GF_OPTION_TYPE_SIZET,
+     .min = 0,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+     .tags = {"disperse"},
+     .description = "Maximum amount of file data per second that self-heal "
+                    "rebuilds on this disperse subvolume. 0 means no limit."},
     {.key = {"optimistic-change-log"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "on",
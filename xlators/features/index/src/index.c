@@ -22,6 +22,13 @@
 #define XATTROP_SUBDIR "xattrop"
 #define DIRTY_SUBDIR "dirty"
 #define ENTRY_CHANGES_SUBDIR "entry-changes"
+#define DIRTY_REGIONS_SUBDIR "dirty-regions"
+
+/* Granularity of the dirty-regions bitmaps and the largest bitmap kept,
+ * which covers files of up to 8TB. */
+#define INDEX_DIRTY_REGION_SIZE (1024 * 1024)
+#define INDEX_DIRTY_REGIONS_MAX (1024 * 1024)
+#define INDEX_DIRTY_REGIONS_HDR sizeof(uint32_t)
 
 struct index_syncop_args {
     inode_t *parent;
@@ -765,6 +772,178 @@ is_xattr_in_watchlist(dict_t *this, char *key, data_t *value, void *matchdata)
     return _gf_false;
 }
 
+static int
+_index_pending_incremented(dict_t *d, char *k, data_t *v, void *tmp)
+{
+    gf_boolean_t *incremented = tmp;
+    int32_t *array = (int32_t *)v->data;
+    int i = 0;
+
+    for (i = 0; i < v->len / sizeof(int32_t); i++) {
+        if ((int32_t)ntoh32(array[i]) > 0) {
+            *incremented = _gf_true;
+            break;
+        }
+    }
+    return 0;
+}
+
+static void
+index_dirty_regions_del(xlator_t *this, inode_t *inode, index_inode_ctx_t *ctx)
+{
+    index_priv_t *priv = this->private;
+    char path[PATH_MAX] = {0};
+
+    if (ctx->dirty_regions == NOTIN)
+        return;
+
+    make_gfid_path(priv->index_basepath, DIRTY_REGIONS_SUBDIR, inode->gfid,
+                   path, sizeof(path));
+    if (sys_unlink(path) && (errno != ENOENT))
+        gf_msg(this->name, GF_LOG_ERROR, errno, INDEX_MSG_INDEX_DEL_FAILED,
+               "%s: failed to delete dirty regions", path);
+    else
+        ctx->dirty_regions = NOTIN;
+}
+
+static int
+index_dirty_regions_open(xlator_t *this, inode_t *inode, gf_boolean_t create)
+{
+    index_priv_t *priv = this->private;
+    char path[PATH_MAX] = {0};
+    uint32_t hdr = hton32(INDEX_DIRTY_REGION_SIZE);
+    int fd = -1;
+
+    make_gfid_path(priv->index_basepath, DIRTY_REGIONS_SUBDIR, inode->gfid,
+                   path, sizeof(path));
+    if (!create)
+        return sys_open(path, O_RDWR, 0);
+
+    fd = sys_open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if ((fd < 0) && (errno == ENOENT)) {
+        if (index_dir_create(this, DIRTY_REGIONS_SUBDIR) == 0)
+            fd = sys_open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    }
+    if (fd < 0)
+        return fd;
+
+    if (sys_pwrite(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr)) {
+        sys_close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int
+index_dirty_regions_mark(int fd, uint64_t offset, uint64_t len)
+{
+    char *buf = NULL;
+    uint64_t first = offset / INDEX_DIRTY_REGION_SIZE;
+    uint64_t last = (offset + len - 1) / INDEX_DIRTY_REGION_SIZE;
+    uint64_t bit = 0;
+    size_t size = 0;
+    off_t start = 0;
+    int ret = -1;
+
+    if ((offset + len < offset) || (last / 8 >= INDEX_DIRTY_REGIONS_MAX))
+        return -1;
+
+    start = first / 8;
+    size = last / 8 - start + 1;
+    buf = GF_CALLOC(1, size, gf_index_mt_dirty_regions_t);
+    if (!buf)
+        return -1;
+
+    if (sys_pread(fd, buf, size, INDEX_DIRTY_REGIONS_HDR + start) < 0)
+        goto out;
+    for (bit = first; bit <= last; bit++)
+        buf[bit / 8 - start] |= 1 << (bit % 8);
+    if (sys_pwrite(fd, buf, size, INDEX_DIRTY_REGIONS_HDR + start) != size)
+        goto out;
+    ret = 0;
+out:
+    GF_FREE(buf);
+    return ret;
+}
+
+/* Keeps the dirty-regions bitmap of a file up to date with an AFR xattrop
+ * that marks some replica as bad. The bitmap is only started when the file
+ * had no pending changes, so that it covers everything the bad replicas
+ * missed. Changes whose region is not known drop it and heal falls back to
+ * the whole file. */
+static void
+index_dirty_regions_action(xlator_t *this, inode_t *inode,
+                           gf_xattrop_flags_t optype, dict_t *xattr,
+                           dict_t *xdata)
+{
+    index_priv_t *priv = this->private;
+    index_inode_ctx_t *ctx = NULL;
+    gf_boolean_t incremented = _gf_false;
+    gf_boolean_t pending = _gf_false;
+    char path[PATH_MAX] = {0};
+    struct stat st = {0};
+    uint64_t *region = NULL;
+    uint64_t offset = 0;
+    uint64_t len = GF_XATTROP_DIRTY_REGION_ALL;
+    data_t *data = NULL;
+    int fd = -1;
+
+    if (optype != GF_XATTROP_ADD_ARRAY || !priv->pending_watchlist)
+        return;
+
+    dict_foreach_match(xattr, is_xattr_in_watchlist, priv->pending_watchlist,
+                       _index_pending_incremented, &incremented);
+    if (!incremented)
+        return;
+
+    if (index_inode_ctx_get(inode, this, &ctx))
+        return;
+
+    if (xdata)
+        data = dict_get_sizen(xdata, GF_XATTROP_DIRTY_REGION);
+    if (data && data->len == 2 * sizeof(uint64_t)) {
+        region = (uint64_t *)data->data;
+        offset = ntoh64(region[0]);
+        len = ntoh64(region[1]);
+    }
+
+    if (len == GF_XATTROP_DIRTY_REGION_ALL)
+        goto del;
+
+    if (ctx->state[XATTROP] == UNKNOWN) {
+        make_gfid_path(priv->index_basepath, XATTROP_SUBDIR, inode->gfid, path,
+                       sizeof(path));
+        pending = (sys_stat(path, &st) == 0);
+    } else {
+        pending = (ctx->state[XATTROP] == IN);
+    }
+
+    if (!pending) {
+        fd = index_dirty_regions_open(this, inode, _gf_true);
+    } else if (ctx->dirty_regions != NOTIN) {
+        fd = index_dirty_regions_open(this, inode, _gf_false);
+        if ((fd < 0) && (errno == ENOENT)) {
+            ctx->dirty_regions = NOTIN;
+            return;
+        }
+    } else {
+        return;
+    }
+    if (fd < 0)
+        goto del;
+    ctx->dirty_regions = IN;
+
+    if (len && index_dirty_regions_mark(fd, offset, len))
+        goto del;
+
+    sys_close(fd);
+    return;
+del:
+    if (fd >= 0)
+        sys_close(fd);
+    index_dirty_regions_del(this, inode, ctx);
+}
+
 static int
 index_find_xattr_type(dict_t *d, char *k, data_t *v)
 {
@@ -984,14 +1163,20 @@ _index_action(xlator_t *this, inode_t *inode, int *zfilled)
             if (ctx->state[i] == NOTIN)
                 continue;
             ret = index_del(this, inode->gfid, subdir, i);
-            if (!ret)
+            if (!ret) {
                 ctx->state[i] = NOTIN;
+                if (i == XATTROP)
+                    ctx->pending_since = ctx->last_activity = 0;
+            }
         } else if (zfilled[i] == 0) {
             if (ctx->state[i] == IN)
                 continue;
             ret = index_add(this, inode->gfid, subdir, i);
-            if (!ret)
+            if (!ret) {
                 ctx->state[i] = IN;
+                if (i == XATTROP)
+                    ctx->pending_since = gf_time();
+            }
         }
     }
 out:
@@ -1043,6 +1228,12 @@ xattrop_index_action(xlator_t *this, index_local_t *local, dict_t *xattr,
                              _check_key_is_zero_filled, zfilled);
     _index_action(this, inode, zfilled);
 
+    if (zfilled[XATTROP] == 1) {
+        ret = index_inode_ctx_get(inode, this, &ctx);
+        if (!ret)
+            index_dirty_regions_del(this, inode, ctx);
+    }
+
     if (req_xdata) {
         ret = index_entry_action(this, inode, req_xdata,
                                  GF_XATTROP_ENTRY_OUT_KEY);
@@ -1287,6 +1478,19 @@ index_xattrop64_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
                        is_xattr_in_watchlist, priv->pending_watchlist);
 }
 
+/* Remember that a client is still modifying a file which needs heal, so that
+ * the self-heal daemon can bring it back in sync before colder files. */
+static void
+index_heal_hint_touch(xlator_t *this, inode_t *inode)
+{
+    index_inode_ctx_t *ctx = NULL;
+
+    if (index_inode_ctx_get(inode, this, &ctx))
+        return;
+    if (ctx->state[XATTROP] == IN)
+        ctx->last_activity = gf_time();
+}
+
 void
 index_xattrop_do(call_frame_t *frame, xlator_t *this, loc_t *loc, fd_t *fd,
                  gf_xattrop_flags_t optype, dict_t *xattr, dict_t *xdata)
@@ -1324,7 +1528,11 @@ index_xattrop_do(call_frame_t *frame, xlator_t *this, loc_t *loc, fd_t *fd,
      */
     ret = dict_foreach(xattr, index_fill_zero_array, zfilled);
 
+    if (zfilled[XATTROP] == 0)
+        index_dirty_regions_action(this, local->inode, optype, xattr, xdata);
     _index_action(this, local->inode, zfilled);
+    if (frame->root->pid >= 0)
+        index_heal_hint_touch(this, local->inode);
     if (xdata)
         ret = index_entry_action(this, local->inode, xdata,
                                  GF_XATTROP_ENTRY_IN_KEY);
@@ -1472,6 +1680,55 @@ index_entry_count(xlator_t *this, char *subdir)
     return count;
 }
 
+static int
+index_dirty_regions_get(xlator_t *this, loc_t *loc, dict_t *xattr)
+{
+    index_priv_t *priv = this->private;
+    char path[PATH_MAX] = {0};
+    struct stat st = {0};
+    char *buf = NULL;
+    int fd = -1;
+    int ret = 0;
+
+    if (!loc->inode || gf_uuid_is_null(loc->inode->gfid))
+        return -EINVAL;
+
+    make_gfid_path(priv->index_basepath, DIRTY_REGIONS_SUBDIR,
+                   loc->inode->gfid, path, sizeof(path));
+    fd = sys_open(path, O_RDONLY, 0);
+    if (fd < 0)
+        return (errno == ENOENT) ? -ENODATA : -errno;
+
+    if (sys_fstat(fd, &st)) {
+        ret = -errno;
+        goto out;
+    }
+    if ((st.st_size < INDEX_DIRTY_REGIONS_HDR) ||
+        (st.st_size > INDEX_DIRTY_REGIONS_HDR + INDEX_DIRTY_REGIONS_MAX)) {
+        ret = -ENODATA;
+        goto out;
+    }
+
+    buf = GF_MALLOC(st.st_size, gf_index_mt_dirty_regions_t);
+    if (!buf) {
+        ret = -ENOMEM;
+        goto out;
+    }
+    if (sys_pread(fd, buf, st.st_size, 0) != st.st_size) {
+        ret = -EIO;
+        goto out;
+    }
+
+    ret = dict_set_bin(xattr, GF_XATTROP_DIRTY_REGIONS, buf, st.st_size);
+    if (ret)
+        goto out;
+    buf = NULL;
+out:
+    GF_FREE(buf);
+    sys_close(fd);
+    return ret;
+}
+
 int32_t
 index_getxattr_wrapper(call_frame_t *frame, xlator_t *this, loc_t *loc,
                        const char *name, dict_t *xdata)
@@ -1528,6 +1785,8 @@ index_getxattr_wrapper(call_frame_t *frame, xlator_t *this, loc_t *loc,
                    "count set failed");
             goto done;
         }
+    } else if (strcmp(name, GF_XATTROP_DIRTY_REGIONS) == 0) {
+        ret = index_dirty_regions_get(this, loc, xattr);
     }
 done:
     if (ret)
@@ -1942,6 +2201,12 @@ index_unlink_wrapper(call_frame_t *frame, xlator_t *this, loc_t *loc, int flag,
         subdir = index_get_subdir_from_type(type);
         gf_uuid_parse(loc->name, gfid);
         ret = index_del(this, gfid, subdir, type);
+        if ((ret == 0) && (type == XATTROP)) {
+            /* Stale entry: the file is gone, so is its bitmap */
+            make_gfid_path(priv->index_basepath, DIRTY_REGIONS_SUBDIR, gfid,
+                           filepath, sizeof(filepath));
+            (void)sys_unlink(filepath);
+        }
     }
     if (ret < 0) {
         op_ret = -1;
@@ -1966,7 +2231,8 @@ index_getxattr(call_frame_t *frame, xlator_t *this, loc_t *loc,
 
     if (!name ||
         (!index_is_vgfid_xattr(name) && strcmp(GF_XATTROP_INDEX_COUNT, name) &&
-         strcmp(GF_XATTROP_DIRTY_COUNT, name)))
+         strcmp(GF_XATTROP_DIRTY_COUNT, name) &&
+         strcmp(GF_XATTROP_DIRTY_REGIONS, name)))
         goto out;
 
     stub = fop_getxattr_stub(frame, index_getxattr_wrapper, loc, name, xdata);
@@ -2088,6 +2354,12 @@ index_lookup_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
                  struct iatt *buf, dict_t *xdata, struct iatt *postparent)
 {
     xdata = index_fill_link_count(this, xdata);
+    /* @cookie is set if the client asked whether we apply piggybacked
+     * changelogs */
+    if (cookie && xdata &&
+        dict_set_int8(xdata, GF_XATTROP_PIGGYBACK_SUPPORTED, 1))
+        gf_msg(this->name, GF_LOG_DEBUG, ENOMEM, INDEX_MSG_DICT_SET_FAILED,
+               "Unable to set %s", GF_XATTROP_PIGGYBACK_SUPPORTED);
     STACK_UNWIND_STRICT(lookup, frame, op_ret, op_errno, inode, buf, xdata,
                         postparent);
     if (xdata)
@@ -2095,12 +2367,46 @@ index_lookup_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
     return 0;
 }
 
+int32_t
+index_heal_hint_lookup_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                           int32_t op_ret, int32_t op_errno, inode_t *inode,
+                           struct iatt *buf, dict_t *xdata,
+                           struct iatt *postparent)
+{
+    index_inode_ctx_t *ctx = NULL;
+    uint64_t tmp_ctx = 0;
+
+    if (op_ret < 0 || !inode)
+        goto out;
+
+    if (inode_ctx_get(inode, this, &tmp_ctx) || !tmp_ctx)
+        goto out;
+    ctx = (index_inode_ctx_t *)(uintptr_t)tmp_ctx;
+
+    xdata = (xdata) ? dict_ref(xdata) : dict_new();
+    if (!xdata)
+        goto out;
+    if (dict_set_uint64(xdata, GF_XATTROP_PENDING_SINCE, ctx->pending_since) ||
+        dict_set_uint64(xdata, GF_XATTROP_LAST_ACTIVITY, ctx->last_activity))
+        gf_msg(this->name, GF_LOG_DEBUG, ENOMEM, INDEX_MSG_DICT_SET_FAILED,
+               "Unable to set heal hints for %s", uuid_utoa(inode->gfid));
+    STACK_UNWIND_STRICT(lookup, frame, op_ret, op_errno, inode, buf, xdata,
+                        postparent);
+    dict_unref(xdata);
+    return 0;
+out:
+    STACK_UNWIND_STRICT(lookup, frame, op_ret, op_errno, inode, buf, xdata,
+                        postparent);
+    return 0;
+}
+
 int32_t
 index_lookup(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xattr_req)
 {
     inode_t *inode = NULL;
     call_stub_t *stub = NULL;
     char *flag = NULL;
+    int piggyback = 0;
     int ret = -1;
 
     if (!index_is_fop_on_internal_inode(this, loc->parent, loc->pargfid) &&
@@ -2128,7 +2434,13 @@ index_lookup(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xattr_req)
 normal:
     ret = dict_get_str_sizen(xattr_req, "link-count", &flag);
     if ((ret == 0) && (strcmp(flag, GF_XATTROP_INDEX_COUNT) == 0)) {
-        STACK_WIND(frame, index_lookup_cbk, FIRST_CHILD(this),
+        piggyback = (dict_get_sizen(xattr_req,
+                                    GF_XATTROP_PIGGYBACK_SUPPORTED) != NULL);
+        STACK_WIND_COOKIE(frame, index_lookup_cbk, (void *)(long)piggyback,
+                          FIRST_CHILD(this), FIRST_CHILD(this)->fops->lookup,
+                          loc, xattr_req);
+    } else if (xattr_req && dict_get_sizen(xattr_req, GF_XATTROP_HEAL_HINT)) {
+        STACK_WIND(frame, index_heal_hint_lookup_cbk, FIRST_CHILD(this),
                    FIRST_CHILD(this)->fops->lookup, loc, xattr_req);
     } else {
         STACK_WIND(frame, default_lookup_cbk, FIRST_CHILD(this),
@@ -2168,6 +2480,271 @@ index_fstat(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
     return 0;
 }
 
+static gf_boolean_t
+index_piggyback_key_match(dict_t *d, char *k, data_t *v, void *prefix)
+{
+    return (strncmp(k, prefix, strlen(prefix)) == 0);
+}
+
+static int
+index_piggyback_key_copy(dict_t *d, char *k, data_t *v, void *xattr)
+{
+    return dict_set(xattr, k, v);
+}
+
+static gf_boolean_t
+index_piggyback_is_unlock(call_stub_t *stub)
+{
+    return (stub->fop == GF_FOP_INODELK || stub->fop == GF_FOP_FINODELK);
+}
+
+/* A data fop whose changelog could not be applied fails without being
+ * performed. An unlock is sent anyway, or the lock would be held until the
+ * client goes away, and the changelog is left to be found by self-heal. */
+static void
+index_piggyback_failed(xlator_t *this, call_stub_t *stub, int op_errno)
+{
+    if (!index_piggyback_is_unlock(stub)) {
+        call_unwind_error(stub, -1, op_errno);
+        return;
+    }
+
+    gf_msg(this->name, GF_LOG_WARNING, op_errno, INDEX_MSG_PIGGYBACK_FAILED,
+           "failed to apply the changelog sent with an unlock, unlocking "
+           "anyway");
+    call_resume(stub);
+}
+
+static int32_t
+index_piggyback_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                    int32_t op_ret, int32_t op_errno, dict_t *xattr,
+                    dict_t *xdata)
+{
+    call_stub_t *stub = cookie;
+
+    STACK_DESTROY(frame->root);
+    if (op_ret < 0)
+        index_piggyback_failed(this, stub, op_errno);
+    else
+        call_resume(stub);
+    return 0;
+}
+
+/* Apply the changelog carried in the xdata of @stub's fop through our own
+ * xattrop path, so that the index is updated exactly as for a separate
+ * xattrop, and only then let the fop go down. */
+static void
+index_piggyback(xlator_t *this, call_stub_t *stub, loc_t *loc, fd_t *fd,
+                dict_t *xdata)
+{
+    call_frame_t *frame = NULL;
+    dict_t *xattr = NULL;
+    char *prefix = NULL;
+    int op_errno = ENOMEM;
+
+    if (dict_get_str_sizen(xdata, GF_XATTROP_PIGGYBACK, &prefix) ||
+        !prefix[0]) {
+        op_errno = EINVAL;
+        goto err;
+    }
+
+    xattr = dict_new();
+    if (!xattr)
+        goto err;
+    if (dict_foreach_match(xdata, index_piggyback_key_match, prefix,
+                           index_piggyback_key_copy, xattr) < 0)
+        goto err;
+    if (!xattr->count) {
+        dict_unref(xattr);
+        call_resume(stub);
+        return;
+    }
+
+    /* A frame of our own, as the fop's frame is owned by the stub */
+    frame = copy_frame(stub->frame);
+    if (!frame)
+        goto err;
+
+    if (fd)
+        STACK_WIND_COOKIE(frame, index_piggyback_cbk, stub, this,
+                          this->fops->fxattrop, fd, GF_XATTROP_ADD_ARRAY,
+                          xattr, NULL);
+    else
+        STACK_WIND_COOKIE(frame, index_piggyback_cbk, stub, this,
+                          this->fops->xattrop, loc, GF_XATTROP_ADD_ARRAY,
+                          xattr, NULL);
+    dict_unref(xattr);
+    return;
+err:
+    if (xattr)
+        dict_unref(xattr);
+    index_piggyback_failed(this, stub, op_errno);
+}
+
+#define INDEX_PIGGYBACK(fop, frame, this, loc, fd, xdata, args...)             \
+    do {                                                                       \
+        call_stub_t *__stub = NULL;                                            \
+                                                                               \
+        if (!xdata || !dict_get_sizen(xdata, GF_XATTROP_PIGGYBACK))            \
+            break;                                                             \
+        __stub = fop_##fop##_stub(frame, default_##fop##_resume, args);        \
+        if (!__stub) {                                                         \
+            default_##fop##_failure_cbk(frame, ENOMEM);                        \
+            return 0;                                                          \
+        }                                                                      \
+        index_piggyback(this, __stub, loc, fd, xdata);                         \
+        return 0;                                                              \
+    } while (0)
+
+int32_t
+index_writev(call_frame_t *frame, xlator_t *this, fd_t *fd,
+             struct iovec *vector, int32_t count, off_t off, uint32_t flags,
+             struct iobref *iobref, dict_t *xdata)
+{
+    INDEX_PIGGYBACK(writev, frame, this, NULL, fd, xdata, fd, vector, count,
+                    off, flags, iobref, xdata);
+
+    STACK_WIND_TAIL(frame, FIRST_CHILD(this), FIRST_CHILD(this)->fops->writev,
+                    fd, vector, count, off, flags, iobref, xdata);
+    return 0;
+}
+
+int32_t
+index_truncate(call_frame_t *frame, xlator_t *this, loc_t *loc, off_t offset,
+               dict_t *xdata)
+{
+    INDEX_PIGGYBACK(truncate, frame, this, loc, NULL, xdata, loc, offset,
+                    xdata);
+
+    STACK_WIND_TAIL(frame, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->truncate, loc, offset, xdata);
+    return 0;
+}
+
+int32_t
+index_ftruncate(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+                dict_t *xdata)
+{
+    INDEX_PIGGYBACK(ftruncate, frame, this, NULL, fd, xdata, fd, offset,
+                    xdata);
+
+    STACK_WIND_TAIL(frame, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->ftruncate, fd, offset, xdata);
+    return 0;
+}
+
+int32_t
+index_fallocate(call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t mode,
+                off_t offset, size_t len, dict_t *xdata)
+{
+    INDEX_PIGGYBACK(fallocate, frame, this, NULL, fd, xdata, fd, mode, offset,
+                    len, xdata);
+
+    STACK_WIND_TAIL(frame, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->fallocate, fd, mode, offset, len,
+                    xdata);
+    return 0;
+}
+
+int32_t
+index_discard(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+              size_t len, dict_t *xdata)
+{
+    INDEX_PIGGYBACK(discard, frame, this, NULL, fd, xdata, fd, offset, len,
+                    xdata);
+
+    STACK_WIND_TAIL(frame, FIRST_CHILD(this), FIRST_CHILD(this)->fops->discard,
+                    fd, offset, len, xdata);
+    return 0;
+}
+
+int32_t
+index_zerofill(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+               off_t len, dict_t *xdata)
+{
+    INDEX_PIGGYBACK(zerofill, frame, this, NULL, fd, xdata, fd, offset, len,
+                    xdata);
+
+    STACK_WIND_TAIL(frame, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->zerofill, fd, offset, len, xdata);
+    return 0;
+}
+
+int32_t
+index_setattr(call_frame_t *frame, xlator_t *this, loc_t *loc,
+              struct iatt *stbuf, int32_t valid, dict_t *xdata)
+{
+    INDEX_PIGGYBACK(setattr, frame, this, loc, NULL, xdata, loc, stbuf, valid,
+                    xdata);
+
+    STACK_WIND_TAIL(frame, FIRST_CHILD(this), FIRST_CHILD(this)->fops->setattr,
+                    loc, stbuf, valid, xdata);
+    return 0;
+}
+
+int32_t
+index_fsetattr(call_frame_t *frame, xlator_t *this, fd_t *fd,
+               struct iatt *stbuf, int32_t valid, dict_t *xdata)
+{
+    INDEX_PIGGYBACK(fsetattr, frame, this, NULL, fd, xdata, fd, stbuf, valid,
+                    xdata);
+
+    STACK_WIND_TAIL(frame, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->fsetattr, fd, stbuf, valid, xdata);
+    return 0;
+}
+
+/* The post-op of a transaction may come with its unlock, which must be sent
+ * down even when the post-op can't be applied */
+int32_t
+index_inodelk(call_frame_t *frame, xlator_t *this, const char *volume,
+              loc_t *loc, int32_t cmd, struct gf_flock *flock, dict_t *xdata)
+{
+    call_stub_t *stub = NULL;
+
+    if (flock->l_type == F_UNLCK && xdata &&
+        dict_get_sizen(xdata, GF_XATTROP_PIGGYBACK)) {
+        stub = fop_inodelk_stub(frame, default_inodelk_resume, volume, loc,
+                                cmd, flock, xdata);
+        if (stub) {
+            index_piggyback(this, stub, loc, NULL, xdata);
+            return 0;
+        }
+        gf_msg(this->name, GF_LOG_WARNING, ENOMEM, INDEX_MSG_PIGGYBACK_FAILED,
+               "failed to apply the changelog sent with an unlock, unlocking "
+               "anyway");
+    }
+
+    STACK_WIND_TAIL(frame, FIRST_CHILD(this), FIRST_CHILD(this)->fops->inodelk,
+                    volume, loc, cmd, flock, xdata);
+    return 0;
+}
+
+int32_t
+index_finodelk(call_frame_t *frame, xlator_t *this, const char *volume,
+               fd_t *fd, int32_t cmd, struct gf_flock *flock, dict_t *xdata)
+{
+    call_stub_t *stub = NULL;
+
+    if (flock->l_type == F_UNLCK && xdata &&
+        dict_get_sizen(xdata, GF_XATTROP_PIGGYBACK)) {
+        stub = fop_finodelk_stub(frame, default_finodelk_resume, volume, fd,
+                                 cmd, flock, xdata);
+        if (stub) {
+            index_piggyback(this, stub, NULL, fd, xdata);
+            return 0;
+        }
+        gf_msg(this->name, GF_LOG_WARNING, ENOMEM, INDEX_MSG_PIGGYBACK_FAILED,
+               "failed to apply the changelog sent with an unlock, unlocking "
+               "anyway");
+    }
+
+    STACK_WIND_TAIL(frame, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->finodelk, volume, fd, cmd, flock,
+                    xdata);
+    return 0;
+}
+
 int32_t
 index_opendir(call_frame_t *frame, xlator_t *this, loc_t *loc, fd_t *fd,
               dict_t *xdata)
@@ -2667,6 +3244,16 @@ notify(xlator_t *this, int event, void *data, ...)
 struct xlator_fops fops = {
     .xattrop = index_xattrop,
     .fxattrop = index_fxattrop,
+    .writev = index_writev,
+    .truncate = index_truncate,
+    .ftruncate = index_ftruncate,
+    .fallocate = index_fallocate,
+    .discard = index_discard,
+    .zerofill = index_zerofill,
+    .setattr = index_setattr,
+    .fsetattr = index_fsetattr,
+    .inodelk = index_inodelk,
+    .finodelk = index_finodelk,
 
     // interface functions follow
     .getxattr = index_getxattr,
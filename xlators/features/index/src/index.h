@@ -36,6 +36,9 @@ typedef struct index_inode_ctx {
     int state[XATTROP_TYPE_END];
     uuid_t virtual_pargfid; /* virtual gfid of dir under
                               .glusterfs/indices/entry-changes. */
+    int dirty_regions; /* whether the file has a dirty-regions bitmap */
+    time_t pending_since; /* when the gfid entered the xattrop index */
+    time_t last_activity; /* last client xattrop while in the index */
 } index_inode_ctx_t;
 
 typedef struct index_fd_ctx {
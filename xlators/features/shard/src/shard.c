@@ -531,6 +531,8 @@ shard_local_wipe(shard_local_t *local)
         dict_unref(local->xattr_req);
     if (local->xattr_rsp)
         dict_unref(local->xattr_rsp);
+    if (local->fanout.xdata)
+        dict_unref(local->fanout.xdata);
 
     for (i = 0; i < count; i++) {
         if (!local->inode_list)
@@ -579,6 +581,52 @@ shard_modify_size_and_block_count(struct iatt *stbuf, dict_t *dict,
     return 0;
 }
 
+/* Raises the pre-created high-water mark in the ctx of @inode to the one
+ * stored with the size of the file, as returned by a lookup in @dict. The
+ * mark in the ctx may be ahead of the stored one while its update is in
+ * flight, so it is never lowered here. */
+static void
+shard_inode_ctx_update_precreated(inode_t *inode, xlator_t *this,
+                                  dict_t *dict)
+{
+    int64_t precreated = 0;
+    void *size_attr = NULL;
+    uint64_t size_array[4];
+    shard_inode_ctx_t *ctx = NULL;
+
+    if (!dict || dict_get_ptr(dict, GF_XATTR_SHARD_FILE_SIZE, &size_attr))
+        return;
+
+    memcpy(size_array, size_attr, sizeof(size_array));
+    precreated = (int64_t)ntoh64(size_array[1]);
+    if (precreated <= 0)
+        return;
+
+    LOCK(&inode->lock);
+    {
+        if ((__shard_inode_ctx_get(inode, this, &ctx) == 0) &&
+            (ctx->precreated < precreated))
+            ctx->precreated = precreated;
+    }
+    UNLOCK(&inode->lock);
+}
+
+static uint64_t
+shard_inode_ctx_get_precreated(inode_t *inode, xlator_t *this)
+{
+    uint64_t ctx_uint = 0;
+    uint64_t precreated = 0;
+
+    LOCK(&inode->lock);
+    {
+        if (__inode_ctx_get(inode, this, &ctx_uint) == 0)
+            precreated = ((shard_inode_ctx_t *)(uintptr_t)ctx_uint)->precreated;
+    }
+    UNLOCK(&inode->lock);
+
+    return precreated;
+}
+
 int
 shard_call_count_return(call_frame_t *frame)
 {
@@ -1150,7 +1198,8 @@ err:
 }
 
 int
-shard_set_size_attrs(int64_t size, int64_t block_count, int64_t **size_attr_p)
+shard_set_size_attrs(int64_t size, int64_t block_count, int64_t precreated,
+                     int64_t **size_attr_p)
 {
     int ret = -1;
     int64_t *size_attr = NULL;
@@ -1165,9 +1214,11 @@ shard_set_size_attrs(int64_t size, int64_t block_count, int64_t **size_attr_p)
     size_attr[0] = hton64(size);
     /* As sharding evolves, it _may_ be necessary to embed more pieces of
      * information within the same xattr. So allocating slots for them in
-     * advance. For now, only bytes 0-63 and 128-191 which would make up the
-     * current size and block count respectively of the file are valid.
+     * advance. For now, only bytes 0-63, 64-127 and 128-191 which would make
+     * up the current size, the last shard pre-created past it and the block
+     * count respectively of the file are valid.
      */
+    size_attr[1] = hton64(precreated);
     size_attr[2] = hton64(block_count);
 
     *size_attr_p = size_attr;
@@ -1206,12 +1257,14 @@ shard_update_file_size(call_frame_t *frame, xlator_t *this, fd_t *fd,
     /* If both size and block count have not changed, then skip the xattrop.
      */
     delta_blocks = GF_ATOMIC_GET(local->delta_blocks);
-    if ((local->delta_size + local->hole_size == 0) && (delta_blocks == 0)) {
+    if ((local->delta_size + local->hole_size == 0) && (delta_blocks == 0) &&
+        (local->delta_precreated == 0)) {
         goto out;
     }
 
     ret = shard_set_size_attrs(local->delta_size + local->hole_size,
-                               delta_blocks, &size_attr);
+                               delta_blocks, local->delta_precreated,
+                               &size_attr);
     if (ret) {
         gf_msg(this->name, GF_LOG_ERROR, 0, SHARD_MSG_SIZE_SET_FAILED,
                "Failed to set size attrs for %s", uuid_utoa(inode->gfid));
@@ -1503,6 +1556,7 @@ shard_inode_ctx_update(inode_t *inode, xlator_t *this, dict_t *xdata,
     if (size) {
         shard_inode_ctx_set(inode, this, buf, 0, SHARD_LOOKUP_MASK);
         (void)shard_inode_ctx_invalidate(inode, this, buf);
+        shard_inode_ctx_update_precreated(inode, this, xdata);
     }
 }
 
@@ -1742,6 +1796,7 @@ shard_set_iattr_invoke_post_handler(call_frame_t *frame, xlator_t *this,
         local->op_errno = ENOMEM;
         goto unwind;
     }
+    shard_inode_ctx_update_precreated(inode, this, xdata);
 
 unwind:
     local->handler(frame, this);
@@ -2019,9 +2074,24 @@ int
 shard_post_update_size_truncate_handler(call_frame_t *frame, xlator_t *this)
 {
     shard_local_t *local = NULL;
+    shard_inode_ctx_t *ctx = NULL;
+    inode_t *inode = NULL;
 
     local = frame->local;
 
+    /* The shards created ahead of the writes are gone with the ones past the
+     * new size */
+    if ((local->op_ret >= 0) && (local->delta_precreated < 0)) {
+        inode = local->loc.inode;
+        LOCK(&inode->lock);
+        {
+            if ((__shard_inode_ctx_get(inode, this, &ctx) == 0) &&
+                (ctx->precreated == -local->delta_precreated))
+                ctx->precreated = 0;
+        }
+        UNLOCK(&inode->lock);
+    }
+
     if (local->fop == GF_FOP_TRUNCATE)
         SHARD_STACK_UNWIND(truncate, frame, local->op_ret, local->op_errno,
                            &local->prebuf, &local->postbuf, NULL);
@@ -2621,6 +2691,7 @@ int
 shard_truncate_begin(call_frame_t *frame, xlator_t *this)
 {
     int ret = 0;
+    uint64_t precreated = 0;
     shard_local_t *local = NULL;
     shard_priv_t *priv = NULL;
 
@@ -2650,6 +2721,16 @@ shard_truncate_begin(call_frame_t *frame, xlator_t *this)
     local->last_block = get_highest_block(0, local->prebuf.ia_size,
                                           local->block_size);
 
+    /* Shards created ahead of the writes lie past the current size, up to
+     * the high-water mark stored along with it, which is cleared with the
+     * size update. */
+    precreated = shard_inode_ctx_get_precreated(local->loc.inode, this);
+    if (precreated) {
+        if (precreated > local->last_block)
+            local->last_block = precreated;
+        local->delta_precreated = -(int64_t)precreated;
+    }
+
     local->num_blocks = local->last_block - local->first_block + 1;
     GF_ASSERT(local->num_blocks > 0);
     local->resolver_base_inode = (local->fop == GF_FOP_TRUNCATE)
@@ -2909,7 +2990,8 @@ shard_mknod(call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
     frame->local = local;
     local->block_size = priv->block_size;
     if (!__is_gsyncd_on_shard_dir(frame, loc)) {
-        SHARD_INODE_CREATE_INIT(this, local->block_size, xdata, loc, 0, 0, err);
+        SHARD_INODE_CREATE_INIT(this, local->block_size, xdata, loc, 0, 0, 0,
+                                err);
     }
 
     STACK_WIND(frame, shard_mknod_cbk, FIRST_CHILD(this),
@@ -3319,6 +3401,102 @@ shard_regulated_shards_deletion(call_frame_t *cleanup_frame, xlator_t *this,
     return ret;
 }
 
+/* Drops the inodes of shards deleted in bulk on the bricks from the inode
+ * table and the lru list, the way a regular unlink would */
+static void
+shard_forget_deleted_shards(xlator_t *this, shard_local_t *local,
+                            uuid_t base_gfid, int first_block, int last_block)
+{
+    shard_priv_t *priv = this->private;
+    char block_bname[256] = {
+        0,
+    };
+    inode_t *inode = NULL;
+    int block = 0;
+
+    for (block = first_block; block <= last_block; block++) {
+        shard_make_block_bname(block, base_gfid, block_bname,
+                               sizeof(block_bname));
+        inode = inode_grep(this->itable, priv->dot_shard_inode, block_bname);
+        if (!inode)
+            continue;
+
+        local->inode_list = &inode;
+        local->first_block = block;
+        shard_unlink_block_inode(local, block);
+        local->inode_list = NULL;
+        inode_unref(inode);
+    }
+}
+
+/* Asks every brick to delete its shards of the file in one go instead of
+ * looking up and unlinking them one by one. Returns the first block that is
+ * still to be deleted, which is past last_block when all of them are gone. */
+static int
+shard_bulk_delete_shards(call_frame_t *cleanup_frame, xlator_t *this,
+                         gf_dirent_t *entry, int first_block, int last_block)
+{
+    shard_local_t *local = cleanup_frame->local;
+    dict_t *xattr = NULL;
+    dict_t *xdata_rsp = NULL;
+    char value[GF_UUID_BUF_SIZE + 32] = {
+        0,
+    };
+    uuid_t gfid = {
+        0,
+    };
+    int now = 0;
+    int ret = 0;
+
+    if (gf_uuid_parse(entry->d_name, gfid))
+        return first_block;
+
+    xattr = dict_new();
+    if (!xattr)
+        return first_block;
+
+    if (gf_uuid_is_null(local->dot_shard_loc.gfid))
+        gf_uuid_copy(local->dot_shard_loc.gfid,
+                     local->dot_shard_loc.inode->gfid);
+
+    while (first_block <= last_block) {
+        now = min(last_block - first_block + 1, SHARD_BULK_DELETE_CHUNK);
+        snprintf(value, sizeof(value), "%s:%d:%d", entry->d_name, first_block,
+                 first_block + now - 1);
+        ret = dict_set_dynstr_with_alloc(xattr, GF_XATTR_SHARD_BULK_DELETE,
+                                         value);
+        if (ret)
+            break;
+
+        ret = syncop_setxattr(FIRST_CHILD(this), &local->dot_shard_loc, xattr,
+                              0, NULL, &xdata_rsp);
+        STACK_RESET(cleanup_frame->root);
+        /* Bricks not knowing the request store it as an xattr instead */
+        if (!ret && (!xdata_rsp ||
+                     !dict_get_sizen(xdata_rsp, GF_XATTR_SHARD_BULK_DELETE)))
+            ret = -EOPNOTSUPP;
+        if (xdata_rsp) {
+            dict_unref(xdata_rsp);
+            xdata_rsp = NULL;
+        }
+        if (ret) {
+            /* Not supported by the bricks, some of them down or some
+             * shards still open: unlink what is left one by one */
+            gf_msg_debug(this->name, -ret,
+                         "bulk deletion of blocks %d-%d of gfid %s failed",
+                         first_block, first_block + now - 1, entry->d_name);
+            break;
+        }
+
+        shard_forget_deleted_shards(this, local, gfid, first_block,
+                                    first_block + now - 1);
+        first_block += now;
+    }
+
+    dict_unref(xattr);
+    return first_block;
+}
+
 int
 __shard_delete_shards_of_entry(call_frame_t *cleanup_frame, xlator_t *this,
                                gf_dirent_t *entry, inode_t *inode)
@@ -3327,6 +3505,7 @@ __shard_delete_shards_of_entry(call_frame_t *cleanup_frame, xlator_t *this,
     int shard_count = 0;
     int first_block = 0;
     int now = 0;
+    int64_t precreated = 0;
     uint64_t size = 0;
     uint64_t block_size = 0;
     uint64_t size_array[4] = {
@@ -3402,27 +3581,23 @@ __shard_delete_shards_of_entry(call_frame_t *cleanup_frame, xlator_t *this,
 
     memcpy(size_array, size_attr, sizeof(size_array));
     size = ntoh64(size_array[0]);
+    precreated = (int64_t)ntoh64(size_array[1]);
 
     shard_count = (size / block_size) - 1;
-    if (shard_count < 0) {
-        gf_msg_debug(this->name, 0,
-                     "Size of %s hasn't grown beyond "
-                     "its shard-block-size. Nothing to delete. "
-                     "Returning",
-                     entry->d_name);
-        /* File size < shard-block-size, so nothing to delete */
-        ret = 0;
-        goto delete_marker;
-    }
     if ((size % block_size) > 0)
         shard_count++;
 
-    if (shard_count == 0) {
+    /* Empty shards may have been created past EOF for sequential writers */
+    if (precreated > shard_count)
+        shard_count = precreated;
+
+    if (shard_count <= 0) {
         gf_msg_debug(this->name, 0,
-                     "Size of %s is exactly equal to "
+                     "Size of %s hasn't grown beyond "
                      "its shard-block-size. Nothing to delete. "
                      "Returning",
                      entry->d_name);
+        /* File size <= shard-block-size, so nothing to delete */
         ret = 0;
         goto delete_marker;
     }
@@ -3456,6 +3631,12 @@ __shard_delete_shards_of_entry(call_frame_t *cleanup_frame, xlator_t *this,
 
     first_block = 1;
 
+    if (priv->bulk_delete) {
+        first_block = shard_bulk_delete_shards(cleanup_frame, this, entry,
+                                               first_block, shard_count);
+        shard_count -= first_block - 1;
+    }
+
     while (shard_count) {
         if (shard_count < local->deletion_rate) {
             now = shard_count;
@@ -3971,8 +4152,10 @@ shard_set_size_attrs_on_marker_file(call_frame_t *frame, xlator_t *this)
         bs = local->block_size;
     else if (local->fop == GF_FOP_RENAME)
         bs = local->dst_block_size;
-    SHARD_INODE_CREATE_INIT(this, bs, xdata, &local->newloc,
-                            local->prebuf.ia_size, 0, err);
+    SHARD_INODE_CREATE_INIT(
+        this, bs, xdata, &local->newloc, local->prebuf.ia_size, 0,
+        shard_inode_ctx_get_precreated(local->int_inodelk.loc.inode, this),
+        err);
     STACK_WIND(frame, shard_set_size_attrs_on_marker_file_cbk,
                FIRST_CHILD(this), FIRST_CHILD(this)->fops->xattrop,
                &local->newloc, GF_XATTROP_GET_AND_SET, xdata, NULL);
@@ -4131,7 +4314,9 @@ shard_create_marker_file_under_remove_me(call_frame_t *frame, xlator_t *this,
         bs = local->dst_block_size;
 
     SHARD_INODE_CREATE_INIT(this, bs, xattr_req, &local->newloc,
-                            local->prebuf.ia_size, 0, err);
+                            local->prebuf.ia_size, 0,
+                            shard_inode_ctx_get_precreated(loc->inode, this),
+                            err);
 
     /* Mark this as an internal operation, so that in case of disk full,
      * the marker file will be created as part of reserve space */
@@ -4801,7 +4986,8 @@ shard_create(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
     local->block_size = priv->block_size;
 
     if (!__is_gsyncd_on_shard_dir(frame, loc)) {
-        SHARD_INODE_CREATE_INIT(this, local->block_size, xdata, loc, 0, 0, err);
+        SHARD_INODE_CREATE_INIT(this, local->block_size, xdata, loc, 0, 0, 0,
+                                err);
     }
 
     STACK_WIND(frame, shard_create_cbk, FIRST_CHILD(this),
@@ -5199,12 +5385,17 @@ shard_post_mknod_readv_handler(call_frame_t *frame, xlator_t *this)
     return 0;
 }
 
+int
+shard_fanout_start(call_frame_t *frame, xlator_t *this);
+
 int
 shard_post_resolve_readv_handler(call_frame_t *frame, xlator_t *this)
 {
     shard_local_t *local = NULL;
+    shard_priv_t *priv = NULL;
 
     local = frame->local;
+    priv = this->private;
 
     if (local->op_ret < 0) {
         if (local->op_errno != ENOENT) {
@@ -5225,7 +5416,9 @@ shard_post_resolve_readv_handler(call_frame_t *frame, xlator_t *this)
         }
     }
 
-    if (local->call_count) {
+    if (priv->fanout_window) {
+        shard_fanout_start(frame, this);
+    } else if (local->call_count) {
         shard_common_lookup_shards(frame, this, local->resolver_base_inode,
                                    shard_post_lookup_shards_readv_handler);
     } else {
@@ -5673,6 +5866,549 @@ shard_common_inode_write_do(call_frame_t *frame, xlator_t *this)
     return 0;
 }
 
+/* Reads and writes fanned out block by block: instead of looking up all the
+ * shards of the request, then creating the missing ones, then winding the
+ * I/O, each block goes through its lookup, mknod and I/O on its own. Data
+ * moves on the blocks already resolved while the others are still being
+ * looked up, and at most shard-fanout-window blocks are in flight at once.
+ * Once a block failed no more are started.
+ *
+ * local->call_count counts the blocks whose I/O has not answered yet, and
+ * the answers of the I/O go through the same callbacks as the non fanned
+ * out fops, which unwind once the last one is in.
+ */
+static void
+shard_fanout_block(call_frame_t *frame, xlator_t *this, uint64_t index);
+
+static void
+shard_fanout_next(call_frame_t *frame, xlator_t *this, int32_t op_ret)
+{
+    shard_local_t *local = frame->local;
+    uint64_t index = 0;
+
+    LOCK(&frame->lock);
+    {
+        if ((op_ret < 0) && (local->fanout.next < local->num_blocks)) {
+            /* The fop fails anyway, the blocks not started yet are
+             * dropped along with their call counts. The block completing
+             * still holds its own, so this does not reach 0. */
+            local->call_count -= local->num_blocks - local->fanout.next;
+            local->fanout.next = local->num_blocks;
+        }
+        index = local->fanout.next;
+        if (index < local->num_blocks)
+            local->fanout.next++;
+    }
+    UNLOCK(&frame->lock);
+
+    /* The block being completed still holds its call count, so local
+     * cannot go away while the next one is started */
+    if (index < local->num_blocks)
+        shard_fanout_block(frame, this, index);
+}
+
+static int
+shard_fanout_readv_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                       int32_t op_ret, int32_t op_errno, struct iovec *vector,
+                       int32_t count, struct iatt *stbuf, struct iobref *iobref,
+                       dict_t *xdata)
+{
+    shard_fanout_next(frame, this, op_ret);
+    return shard_readv_do_cbk(frame, cookie, this, op_ret, op_errno, vector,
+                              count, stbuf, iobref, xdata);
+}
+
+static int
+shard_fanout_writev_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                        int32_t op_ret, int32_t op_errno, struct iatt *pre,
+                        struct iatt *post, dict_t *xdata)
+{
+    shard_fanout_next(frame, this, op_ret);
+    return shard_common_inode_write_do_cbk(frame, cookie, this, op_ret,
+                                           op_errno, pre, post, xdata);
+}
+
+static void
+shard_fanout_fail(call_frame_t *frame, xlator_t *this, int32_t op_errno)
+{
+    shard_local_t *local = frame->local;
+
+    if (local->fop == GF_FOP_READ)
+        shard_fanout_readv_cbk(frame, NULL, this, -1, op_errno, NULL, 0, NULL,
+                               NULL, NULL);
+    else
+        shard_fanout_writev_cbk(frame, NULL, this, -1, op_errno, NULL, NULL,
+                                NULL);
+}
+
+static void
+shard_fanout_io(call_frame_t *frame, xlator_t *this, uint64_t index)
+{
+    shard_local_t *local = frame->local;
+    uint64_t block = local->first_block + index;
+    fd_t *anon_fd = NULL;
+    struct iovec *vec = NULL;
+    int count = 0;
+    int32_t flags = local->flags;
+    off_t offset = local->offset;
+    off_t shard_offset = 0;
+    size_t size = 0;
+
+    if (index)
+        offset = block * local->block_size;
+    shard_offset = offset % local->block_size;
+    size = min(local->block_size - shard_offset,
+               local->total_size - (offset - local->offset));
+
+    if (block == 0) {
+        anon_fd = fd_ref(local->fd);
+    } else {
+        anon_fd = fd_anonymous(local->inode_list[index]);
+        if (!anon_fd) {
+            shard_fanout_fail(frame, this, ENOMEM);
+            return;
+        }
+    }
+
+    if (local->fop == GF_FOP_READ) {
+        STACK_WIND_COOKIE(frame, shard_fanout_readv_cbk, anon_fd,
+                          FIRST_CHILD(this), FIRST_CHILD(this)->fops->readv,
+                          anon_fd, size, shard_offset, flags, local->xattr_req);
+        return;
+    }
+
+    count = iov_subset(local->vector, local->count, offset - local->offset,
+                       size, &vec, 0);
+    if (count < 0) {
+        fd_unref(anon_fd);
+        shard_fanout_fail(frame, this, ENOMEM);
+        return;
+    }
+
+    if (block) {
+        if (local->fd->flags & O_DIRECT)
+            flags = O_DIRECT;
+        else
+            flags = GF_ANON_FD_FLAGS;
+    }
+
+    STACK_WIND_COOKIE(frame, shard_fanout_writev_cbk, anon_fd,
+                      FIRST_CHILD(this), FIRST_CHILD(this)->fops->writev,
+                      anon_fd, vec, count, shard_offset, flags, local->iobref,
+                      local->fanout.xdata);
+    GF_FREE(vec);
+}
+
+static int
+shard_fanout_loc_fill(xlator_t *this, shard_local_t *local, uint64_t index,
+                      loc_t *loc)
+{
+    shard_priv_t *priv = this->private;
+    char path[SHARD_PATH_MAX];
+    int prefix_len = 0;
+    int ret = -1;
+
+    prefix_len = shard_make_base_path(path, local->resolver_base_inode->gfid);
+    shard_append_index(path, SHARD_PATH_MAX, prefix_len,
+                       local->first_block + index);
+
+    loc->inode = inode_new(this->itable);
+    loc->parent = inode_ref(priv->dot_shard_inode);
+    gf_uuid_copy(loc->pargfid, priv->dot_shard_gfid);
+    ret = inode_path(loc->parent, path + sizeof(GF_SHARD_DIR) + 1,
+                     (char **)&(loc->path));
+    if (ret < 0 || !(loc->inode)) {
+        gf_msg(this->name, GF_LOG_ERROR, 0, SHARD_MSG_INODE_PATH_FAILED,
+               "Inode path failed on %s", path);
+        loc_wipe(loc);
+        return -1;
+    }
+
+    loc->name = strrchr(loc->path, '/');
+    if (loc->name)
+        loc->name++;
+
+    return 0;
+}
+
+static int
+shard_fanout_lookup_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                        int32_t op_ret, int32_t op_errno, inode_t *inode,
+                        struct iatt *buf, dict_t *xdata,
+                        struct iatt *postparent);
+
+static int
+shard_fanout_mknod_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                       int32_t op_ret, int32_t op_errno, inode_t *inode,
+                       struct iatt *buf, struct iatt *preparent,
+                       struct iatt *postparent, dict_t *xdata);
+
+/* The cookie of the lookups is the index of the block, shifted left by one,
+ * with the low bit set for the lookup after a mknod that found the shard
+ * created by someone else */
+static void
+shard_fanout_lookup(call_frame_t *frame, xlator_t *this, uint64_t index,
+                    gf_boolean_t retry)
+{
+    shard_local_t *local = frame->local;
+    loc_t loc = {
+        0,
+    };
+    dict_t *xattr_req = NULL;
+
+    if (shard_fanout_loc_fill(this, local, index, &loc)) {
+        shard_fanout_fail(frame, this, ENOMEM);
+        return;
+    }
+
+    xattr_req = shard_create_gfid_dict(local->xattr_req);
+    if (!xattr_req) {
+        loc_wipe(&loc);
+        shard_fanout_fail(frame, this, ENOMEM);
+        return;
+    }
+
+    STACK_WIND_COOKIE(frame, shard_fanout_lookup_cbk,
+                      (void *)(long)((index << 1) | retry), FIRST_CHILD(this),
+                      FIRST_CHILD(this)->fops->lookup, &loc, xattr_req);
+    loc_wipe(&loc);
+    dict_unref(xattr_req);
+}
+
+static void
+shard_fanout_mknod(call_frame_t *frame, xlator_t *this, uint64_t index)
+{
+    shard_local_t *local = frame->local;
+    loc_t loc = {
+        0,
+    };
+    dict_t *xattr_req = NULL;
+
+    if (shard_fanout_loc_fill(this, local, index, &loc)) {
+        shard_fanout_fail(frame, this, ENOMEM);
+        return;
+    }
+
+    xattr_req = shard_create_gfid_dict(local->xattr_req);
+    if (!xattr_req) {
+        loc_wipe(&loc);
+        shard_fanout_fail(frame, this, ENOMEM);
+        return;
+    }
+
+    STACK_WIND_COOKIE(frame, shard_fanout_mknod_cbk, (void *)(long)index,
+                      FIRST_CHILD(this), FIRST_CHILD(this)->fops->mknod, &loc,
+                      local->fanout.mode, local->fanout.rdev, 0, xattr_req);
+    loc_wipe(&loc);
+    dict_unref(xattr_req);
+}
+
+static int
+shard_fanout_lookup_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                        int32_t op_ret, int32_t op_errno, inode_t *inode,
+                        struct iatt *buf, dict_t *xdata,
+                        struct iatt *postparent)
+{
+    shard_local_t *local = frame->local;
+    uint64_t index = (long)cookie >> 1;
+    gf_boolean_t retry = (long)cookie & 1;
+
+    if (op_ret < 0) {
+        if ((op_errno == ENOENT) && !retry) {
+            shard_fanout_mknod(frame, this, index);
+            return 0;
+        }
+        gf_msg(this->name, GF_LOG_ERROR, op_errno,
+               SHARD_MSG_LOOKUP_SHARD_FAILED,
+               "Lookup on shard %" PRIu64 " failed. Base file gfid = %s",
+               local->first_block + index,
+               uuid_utoa(local->resolver_base_inode->gfid));
+        shard_fanout_fail(frame, this, op_errno);
+        return 0;
+    }
+
+    shard_link_block_inode(local, local->first_block + index, inode, buf);
+    shard_fanout_io(frame, this, index);
+    return 0;
+}
+
+static int
+shard_fanout_mknod_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                       int32_t op_ret, int32_t op_errno, inode_t *inode,
+                       struct iatt *buf, struct iatt *preparent,
+                       struct iatt *postparent, dict_t *xdata)
+{
+    shard_local_t *local = frame->local;
+    uint64_t index = (long)cookie;
+
+    if (op_ret < 0) {
+        gf_msg_debug(this->name, 0, "mknod of shard %" PRIu64 " failed: %s",
+                     local->first_block + index, strerror(op_errno));
+        if (op_errno == EEXIST)
+            shard_fanout_lookup(frame, this, index, _gf_true);
+        else
+            shard_fanout_fail(frame, this, op_errno);
+        return 0;
+    }
+
+    shard_link_block_inode(local, local->first_block + index, inode, buf);
+    shard_fanout_io(frame, this, index);
+    return 0;
+}
+
+static void
+shard_fanout_block(call_frame_t *frame, xlator_t *this, uint64_t index)
+{
+    shard_local_t *local = frame->local;
+
+    if (local->inode_list[index])
+        shard_fanout_io(frame, this, index);
+    else if ((local->fop == GF_FOP_WRITE) &&
+             (local->first_block + index > local->fanout.eof_block))
+        /* Past EOF the shard can only exist if it was created ahead of the
+         * writes, which mknod finds out with EEXIST */
+        shard_fanout_mknod(frame, this, index);
+    else
+        shard_fanout_lookup(frame, this, index, _gf_false);
+}
+
+static int
+shard_precreate_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                    int32_t op_ret, int32_t op_errno, inode_t *inode,
+                    struct iatt *buf, struct iatt *preparent,
+                    struct iatt *postparent, dict_t *xdata)
+{
+    shard_local_t *local = frame->local;
+    uint64_t index = (long)cookie;
+
+    /* A shard already there is as good as a created one */
+    if (op_ret == 0)
+        shard_link_block_inode(local, local->first_block + index, inode, buf);
+    else if (op_errno != EEXIST)
+        gf_msg_debug(this->name, op_errno,
+                     "pre-creation of shard %" PRIu64 " of %s failed",
+                     local->first_block + index,
+                     uuid_utoa(local->loc.inode->gfid));
+
+    if (shard_call_count_return(frame) == 0)
+        SHARD_STACK_DESTROY(frame);
+
+    return 0;
+}
+
+static void
+shard_precreate_mknods(call_frame_t *frame, xlator_t *this)
+{
+    shard_local_t *local = frame->local;
+    uint64_t count = local->num_blocks;
+    uint64_t i = 0;
+    loc_t loc = {
+        0,
+    };
+    dict_t *xattr_req = NULL;
+
+    /* frame may be gone once the last mknod is wound */
+    for (i = 0; i < count; i++) {
+        xattr_req = NULL;
+        if (shard_fanout_loc_fill(this, local, i, &loc) ||
+            !(xattr_req = shard_create_gfid_dict(local->xattr_req))) {
+            loc_wipe(&loc);
+            shard_precreate_cbk(frame, (void *)(long)i, this, -1, ENOMEM, NULL,
+                                NULL, NULL, NULL, NULL);
+            continue;
+        }
+
+        STACK_WIND_COOKIE(frame, shard_precreate_cbk, (void *)(long)i,
+                          FIRST_CHILD(this), FIRST_CHILD(this)->fops->mknod,
+                          &loc, local->fanout.mode, local->fanout.rdev, 0,
+                          xattr_req);
+        loc_wipe(&loc);
+        dict_unref(xattr_req);
+    }
+}
+
+static int
+shard_precreate_mark_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                         int32_t op_ret, int32_t op_errno, dict_t *dict,
+                         dict_t *xdata)
+{
+    shard_local_t *local = frame->local;
+    shard_inode_ctx_t *ctx = NULL;
+    inode_t *inode = local->loc.inode;
+    uint64_t last = local->first_block + local->num_blocks - 1;
+
+    if (op_ret == 0) {
+        shard_precreate_mknods(frame, this);
+        return 0;
+    }
+
+    /* Without the mark the shards could outlive the file */
+    gf_msg(this->name, GF_LOG_WARNING, op_errno,
+           SHARD_MSG_UPDATE_FILE_SIZE_FAILED,
+           "Failed to record the shards to pre-create for %s",
+           uuid_utoa(inode->gfid));
+    LOCK(&inode->lock);
+    {
+        if ((__shard_inode_ctx_get(inode, this, &ctx) == 0) &&
+            (ctx->precreated == last))
+            ctx->precreated = last - local->delta_precreated;
+    }
+    UNLOCK(&inode->lock);
+
+    SHARD_STACK_DESTROY(frame);
+    return 0;
+}
+
+/* Creates in the background the shards following the last one written by a
+ * write at the end of the file, so that a sequential writer finds them
+ * resolved instead of waiting for a mknod at every shard boundary. The last
+ * shard created this way is first added to the size xattr of the file, for
+ * truncate and unlink to find out how far past the size shards may exist. */
+static void
+shard_precreate(call_frame_t *frame, xlator_t *this)
+{
+    shard_priv_t *priv = this->private;
+    shard_local_t *local = frame->local;
+    shard_local_t *pc_local = NULL;
+    shard_inode_ctx_t *ctx = NULL;
+    call_frame_t *pc_frame = NULL;
+    inode_t *base_inode = local->resolver_base_inode;
+    uint64_t first = local->last_block + 1;
+    uint64_t last = local->last_block + priv->precreate_count;
+    uint64_t prev = 0;
+    uint64_t count = 0;
+    int64_t *size_attr = NULL;
+    dict_t *xattr_req = NULL;
+
+    LOCK(&base_inode->lock);
+    {
+        if (__shard_inode_ctx_get(base_inode, this, &ctx) == 0) {
+            prev = ctx->precreated;
+            if (ctx->precreated >= first)
+                first = ctx->precreated + 1;
+            if (first <= last)
+                ctx->precreated = last;
+        } else {
+            first = last + 1;
+        }
+    }
+    UNLOCK(&base_inode->lock);
+
+    if (first > last)
+        return;
+    count = last - first + 1;
+
+    pc_frame = create_frame(this, this->ctx->pool);
+    if (!pc_frame)
+        goto err;
+
+    pc_local = mem_get0(this->local_pool);
+    if (!pc_local)
+        goto err;
+    pc_frame->local = pc_local;
+
+    pc_local->loc.inode = inode_ref(base_inode);
+    gf_uuid_copy(pc_local->loc.gfid, base_inode->gfid);
+    pc_local->resolver_base_inode = pc_local->loc.inode;
+    pc_local->first_block = first;
+    pc_local->num_blocks = count;
+    pc_local->call_count = count;
+    pc_local->fanout.mode = local->fanout.mode;
+    pc_local->fanout.rdev = local->fanout.rdev;
+    pc_local->delta_precreated = last - prev;
+    pc_local->inode_list = GF_CALLOC(count, sizeof(inode_t *),
+                                     gf_shard_mt_inode_list);
+    pc_local->xattr_req = dict_new();
+    xattr_req = dict_new();
+    if (!pc_local->inode_list || !pc_local->xattr_req || !xattr_req)
+        goto err;
+
+    /* Added rather than set, so that updates reaching the brick out of
+     * order still leave it at the highest mark */
+    if (shard_set_size_attrs(0, 0, pc_local->delta_precreated, &size_attr))
+        goto err;
+    if (dict_set_bin(xattr_req, GF_XATTR_SHARD_FILE_SIZE, size_attr, 8 * 4)) {
+        GF_FREE(size_attr);
+        goto err;
+    }
+
+    STACK_WIND(pc_frame, shard_precreate_mark_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->xattrop, &pc_local->loc,
+               GF_XATTROP_ADD_ARRAY64, xattr_req, NULL);
+    dict_unref(xattr_req);
+    return;
+
+err:
+    gf_msg(this->name, GF_LOG_WARNING, ENOMEM, SHARD_MSG_MEMALLOC_FAILED,
+           "Failed to pre-create shards of %s", uuid_utoa(base_inode->gfid));
+    LOCK(&base_inode->lock);
+    {
+        if (ctx->precreated == last)
+            ctx->precreated = prev;
+    }
+    UNLOCK(&base_inode->lock);
+    if (xattr_req)
+        dict_unref(xattr_req);
+    if (pc_frame)
+        SHARD_STACK_DESTROY(pc_frame);
+}
+
+int
+shard_fanout_start(call_frame_t *frame, xlator_t *this)
+{
+    shard_priv_t *priv = this->private;
+    shard_local_t *local = frame->local;
+    shard_inode_ctx_t ctx_tmp = {
+        0,
+    };
+    uint64_t window = 0;
+    uint64_t i = 0;
+
+    if (shard_inode_ctx_get_all(local->fd->inode, this, &ctx_tmp)) {
+        gf_msg(this->name, GF_LOG_ERROR, 0, SHARD_MSG_INODE_CTX_GET_FAILED,
+               "Failed to get inode ctx for %s",
+               uuid_utoa(local->fd->inode->gfid));
+        goto err;
+    }
+    local->fanout.mode = st_mode_from_ia(ctx_tmp.stat.ia_prot,
+                                         ctx_tmp.stat.ia_type);
+    local->fanout.rdev = ctx_tmp.stat.ia_rdev;
+
+    if (local->fop == GF_FOP_READ) {
+        if (local->fd->flags & O_DIRECT)
+            local->flags = O_DIRECT;
+    } else {
+        /* The lookups and mknods of the shards go with xattr_req, the
+         * writes need atomic updates of the size on top of it */
+        local->fanout.xdata = dict_copy_with_ref(local->xattr_req, NULL);
+        if (!local->fanout.xdata ||
+            dict_set_uint32(local->fanout.xdata, GLUSTERFS_WRITE_UPDATE_ATOMIC,
+                            4))
+            goto err;
+    }
+
+    window = min(priv->fanout_window, local->num_blocks);
+    local->call_count = local->num_blocks;
+    local->fanout.next = window;
+    local->fanout.eof_block = get_highest_block(0, local->prebuf.ia_size,
+                                                local->block_size);
+
+    SHARD_SET_ROOT_FS_ID(frame, local);
+
+    if ((local->fop == GF_FOP_WRITE) && priv->precreate_count &&
+        (local->last_block >= local->fanout.eof_block))
+        shard_precreate(frame, this);
+
+    /* local may be gone once the last block of the window is started */
+    for (i = 0; i < window; i++)
+        shard_fanout_block(frame, this, i);
+
+    return 0;
+err:
+    shard_common_failure_unwind(local->fop, frame, -1, ENOMEM);
+    return 0;
+}
+
 int
 shard_common_inode_write_post_mknod_handler(call_frame_t *frame,
                                             xlator_t *this);
@@ -5731,8 +6467,10 @@ shard_common_inode_write_post_resolve_handler(call_frame_t *frame,
                                               xlator_t *this)
 {
     shard_local_t *local = NULL;
+    shard_priv_t *priv = NULL;
 
     local = frame->local;
+    priv = this->private;
 
     if (local->op_ret < 0) {
         shard_common_failure_unwind(local->fop, frame, local->op_ret,
@@ -5740,7 +6478,9 @@ shard_common_inode_write_post_resolve_handler(call_frame_t *frame,
         return 0;
     }
 
-    if (local->call_count) {
+    if ((local->fop == GF_FOP_WRITE) && priv->fanout_window) {
+        shard_fanout_start(frame, this);
+    } else if (local->call_count) {
         shard_common_lookup_shards(
             frame, this, local->resolver_base_inode,
             shard_common_inode_write_post_lookup_shards_handler);
@@ -7334,6 +8074,12 @@ init(xlator_t *this)
 
     GF_OPTION_INIT("shard-lru-limit", priv->lru_limit, uint64, out);
 
+    GF_OPTION_INIT("shard-fanout-window", priv->fanout_window, uint32, out);
+
+    GF_OPTION_INIT("shard-precreate-count", priv->precreate_count, uint32, out);
+
+    GF_OPTION_INIT("shard-bulk-delete", priv->bulk_delete, bool, out);
+
     this->local_pool = mem_pool_new(shard_local_t, 128);
     if (!this->local_pool) {
         ret = -1;
@@ -7402,6 +8148,15 @@ reconfigure(xlator_t *this, dict_t *options)
 
     GF_OPTION_RECONF("shard-deletion-rate", priv->deletion_rate, options,
                      uint32, out);
+
+    GF_OPTION_RECONF("shard-fanout-window", priv->fanout_window, options,
+                     uint32, out);
+
+    GF_OPTION_RECONF("shard-precreate-count", priv->precreate_count, options,
+                     uint32, out);
+
+    GF_OPTION_RECONF("shard-bulk-delete", priv->bulk_delete, options, bool,
+                     out);
     ret = 0;
 
 out:
@@ -7569,6 +8324,55 @@ struct volume_options options[] = {
                        "amount of memory consumed by these inodes and their "
                        "internal metadata",
     },
+    {
+        .key = {"shard-fanout-window"},
+        .type = GF_OPTION_TYPE_INT,
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+        .tags = {"shard"},
+        .default_value = "0",
+        .min = 0,
+        .max = 1024,
+        .description = "The number of shards a read or a write works on at "
+                       "once. Each shard is looked up, created if missing, "
+                       "and read or written on its own, so data moves on the "
+                       "shards already resolved while the others are still "
+                       "being looked up, and no more shards are started once "
+                       "one failed. 0, the default, looks up all the shards "
+                       "of the request before doing any I/O, without a limit "
+                       "on the number of calls in flight.",
+    },
+    {
+        .key = {"shard-precreate-count"},
+        .type = GF_OPTION_TYPE_INT,
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+        .tags = {"shard"},
+        .default_value = "0",
+        .min = 0,
+        .max = 64,
+        .description = "The number of shards created in the background "
+                       "past the end of a file being written to at its end, "
+                       "so that sequential writers do not wait for the "
+                       "creation of a shard at every shard boundary. Only "
+                       "used with shard-fanout-window enabled. Lowering it "
+                       "may leave empty shards behind when files written "
+                       "with the higher value are deleted.",
+    },
+    {
+        .key = {"shard-bulk-delete"},
+        .type = GF_OPTION_TYPE_BOOL,
+        .op_version = {GD_OP_VERSION_11_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+        .tags = {"shard"},
+        .default_value = "off",
+        .description = "Have the bricks delete the shards of removed files "
+                       "themselves, a range of shards at a time, instead of "
+                       "unlinking them one by one through the client. Shards "
+                       "are only deleted this way when all the bricks are "
+                       "up. Deletions done this way are not accounted by "
+                       "quota.",
+    },
     {.key = {NULL}},
 };
 
@@ -20,6 +20,7 @@
 #define GF_SHARD_REMOVE_ME_DIR ".remove_me"
 #define SHARD_MIN_BLOCK_SIZE (4 * GF_UNIT_MB)
 #define SHARD_MAX_BLOCK_SIZE (4 * GF_UNIT_TB)
+#define SHARD_BULK_DELETE_CHUNK 65536
 #define SHARD_XATTR_PREFIX "trusted.glusterfs.shard."
 #define GF_XATTR_SHARD_BLOCK_SIZE "trusted.glusterfs.shard.block-size"
 /**
@@ -113,7 +114,7 @@ shard_unlock_entrylk(call_frame_t *frame, xlator_t *this);
     } while (0);
 
 #define SHARD_INODE_CREATE_INIT(this, block_size, xattr_req, loc, size,        \
-                                block_count, label)                            \
+                                block_count, precreated, label)                \
     do {                                                                       \
         int __ret = -1;                                                        \
         int64_t *__size_attr = NULL;                                           \
@@ -134,7 +135,8 @@ shard_unlock_entrylk(call_frame_t *frame, xlator_t *this);
             goto label;                                                        \
         }                                                                      \
                                                                                \
-        __ret = shard_set_size_attrs(size, block_count, &__size_attr);         \
+        __ret = shard_set_size_attrs(size, block_count, precreated,            \
+                                     &__size_attr);                            \
         if (__ret)                                                             \
             goto label;                                                        \
                                                                                \
@@ -230,6 +232,9 @@ typedef struct shard_priv {
     shard_bg_deletion_state_t bg_del_state;
     gf_boolean_t first_lookup_done;
     uint64_t lru_limit;
+    uint32_t fanout_window;
+    uint32_t precreate_count;
+    gf_boolean_t bulk_delete;
     shard_unlink_thread_t thread_info;
 } shard_priv_t;
 
@@ -249,6 +254,16 @@ typedef struct {
     gf_boolean_t acquired_lock;
 } shard_entrylk_t;
 
+/* State of a read or write fanned out block by block, see
+ * shard_fanout_start() */
+typedef struct {
+    uint64_t next;      /* index of the next block to start */
+    uint64_t eof_block; /* last block of the file before the fop */
+    mode_t mode;        /* of the shards to create */
+    dev_t rdev;
+    dict_t *xdata;      /* of the writes to the shards */
+} shard_fanout_t;
+
 typedef int32_t (*shard_post_fop_handler_t)(call_frame_t *frame,
                                             xlator_t *this);
 typedef int32_t (*shard_post_resolve_fop_handler_t)(call_frame_t *frame,
@@ -287,6 +302,7 @@ typedef struct shard_local {
     size_t readdir_size;
     int64_t delta_size;
     gf_atomic_t delta_blocks;
+    int64_t delta_precreated;
     loc_t loc;
     loc_t dot_shard_loc;
     loc_t dot_shard_rm_loc;
@@ -330,6 +346,7 @@ typedef struct shard_local {
     gf_boolean_t cleanup_required;
     uuid_t base_gfid;
     char *name;
+    shard_fanout_t fanout;
 } shard_local_t;
 
 typedef struct shard_inode_ctx {
@@ -349,6 +366,8 @@ typedef struct shard_inode_ctx {
     inode_t *inode;
     int fsync_count;
     inode_t *base_inode;
+    uint64_t precreated; /* last block created ahead of the writes of the
+                            base file */
 } shard_inode_ctx_t;
 
 typedef enum {
@@ -458,6 +458,42 @@ up_invalidate_needed(dict_t *xattrs)
     return _gf_true;
 }
 
+/*
+ * Whether clients other than @client have registered for the invalidations
+ * of @inode. Only peeks at the inode_ctx, which is not created if missing.
+ */
+gf_boolean_t
+upcall_inode_has_other_clients(xlator_t *this, inode_t *inode,
+                               client_t *client)
+{
+    upcall_inode_ctx_t *up_inode_ctx = NULL;
+    upcall_client_t *up_client_entry = NULL;
+    gf_boolean_t found = _gf_false;
+    uint64_t ctx = 0;
+
+    if (!is_upcall_enabled(this) || !client || !inode)
+        return _gf_false;
+
+    if (inode_ctx_get(inode, this, &ctx) || !ctx)
+        return _gf_false;
+    up_inode_ctx = (upcall_inode_ctx_t *)(long)ctx;
+
+    pthread_mutex_lock(&up_inode_ctx->client_list_lock);
+    {
+        list_for_each_entry(up_client_entry, &up_inode_ctx->client_list,
+                            client_list)
+        {
+            if (strcmp(client->client_uid, up_client_entry->client_uid)) {
+                found = _gf_true;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&up_inode_ctx->client_list_lock);
+
+    return found;
+}
+
 /*
  * Given a client, first fetch upcall_entry_t from the inode_ctx client list.
  * Later traverse through the client list of that upcall entry. If this client
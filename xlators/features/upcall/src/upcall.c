@@ -605,6 +605,33 @@ err:
     return 0;
 }
 
+/* Invalidates the parent of a new entry, with the name of the entry so that
+ * the clients caching the names in the parent can add it rather than drop
+ * all they have */
+static void
+up_parent_entry_created(call_frame_t *frame, xlator_t *this, client_t *client,
+                        upcall_local_t *local, struct iatt *postparent)
+{
+    dict_t *xattr = NULL;
+
+    /* The name is only worth a dict when somebody else will get it */
+    if (local->loc.name &&
+        upcall_inode_has_other_clients(this, local->inode, client)) {
+        xattr = dict_new();
+        if (xattr &&
+            dict_set_str(xattr, UP_ENTRY_CREATED, (char *)local->loc.name)) {
+            dict_unref(xattr);
+            xattr = NULL;
+        }
+    }
+
+    upcall_cache_invalidate(frame, this, client, local->inode, UP_TIMES,
+                            postparent, NULL, NULL, xattr);
+
+    if (xattr)
+        dict_unref(xattr);
+}
+
 static int32_t
 up_mkdir_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
              int op_errno, inode_t *inode, struct iatt *stbuf,
@@ -624,9 +651,7 @@ up_mkdir_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
     }
 
     /* invalidate parent's entry too */
-    flags = UP_TIMES;
-    upcall_cache_invalidate(frame, this, client, local->inode, flags,
-                            postparent, NULL, NULL, NULL);
+    up_parent_entry_created(frame, this, client, local, postparent);
 
     flags = UP_UPDATE_CLIENT;
     upcall_cache_invalidate(frame, this, client, local->loc.inode, flags, stbuf,
@@ -687,9 +712,7 @@ up_create_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
     /* As its a new file create, no need of sending notification
      * However invalidate parent's entry and update that fact that the
      * client has accessed the newly created entry */
-    flags = UP_TIMES;
-    upcall_cache_invalidate(frame, this, client, local->inode, flags,
-                            postparent, NULL, NULL, NULL);
+    up_parent_entry_created(frame, this, client, local, postparent);
 
     flags = UP_UPDATE_CLIENT;
     upcall_cache_invalidate(frame, this, client, local->loc.inode, flags, stbuf,
@@ -1009,9 +1032,7 @@ up_mknod_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
     }
 
     /* invalidate parent's entry too */
-    flags = UP_TIMES;
-    upcall_cache_invalidate(frame, this, client, local->inode, flags,
-                            postparent, NULL, NULL, NULL);
+    up_parent_entry_created(frame, this, client, local, postparent);
 
     flags = UP_UPDATE_CLIENT;
     upcall_cache_invalidate(frame, this, client, local->loc.inode, flags, buf,
@@ -1071,9 +1092,7 @@ up_symlink_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
     }
 
     /* invalidate parent's entry too */
-    flags = UP_TIMES;
-    upcall_cache_invalidate(frame, this, client, local->inode, flags,
-                            postparent, NULL, NULL, NULL);
+    up_parent_entry_created(frame, this, client, local, postparent);
 
     flags = UP_UPDATE_CLIENT;
     upcall_cache_invalidate(frame, this, client, local->loc.inode, flags, buf,
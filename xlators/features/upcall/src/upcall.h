@@ -120,6 +120,9 @@ upcall_cache_invalidate(call_frame_t *frame, xlator_t *this, client_t *client,
                         inode_t *inode, uint32_t flags, struct iatt *stbuf,
                         struct iatt *p_stbuf, struct iatt *oldp_stbuf,
                         dict_t *xattr);
+gf_boolean_t
+upcall_inode_has_other_clients(xlator_t *this, inode_t *inode,
+                               client_t *client);
 int
 up_filter_xattr(dict_t *xattr, dict_t *regd_xattrs);
 
@@ -1279,12 +1279,16 @@ glusterd_store_node_state_write(int fd, glusterd_volinfo_t *volinfo)
     }
 
     gf_uuid_unparse(volinfo->rebal.rebalance_id, uuid);
+    /* The commit hash lets a rebalance restarted by glusterd skip the
+     * directories checkpointed before it was interrupted */
     ret = snprintf(buf + total_len, sizeof(buf) - total_len,
-                   "%s=%d\n%s=%d\n%s=%d\n%s=%s\n",
+                   "%s=%d\n%s=%d\n%s=%d\n%s=%s\n%s=%" PRIu32 "\n",
                    GLUSTERD_STORE_KEY_VOL_DEFRAG, volinfo->rebal.defrag_cmd,
                    GLUSTERD_STORE_KEY_VOL_DEFRAG_STATUS,
                    volinfo->rebal.defrag_status, GLUSTERD_STORE_KEY_DEFRAG_OP,
-                   volinfo->rebal.op, GF_REBALANCE_TID_KEY, uuid);
+                   volinfo->rebal.op, GF_REBALANCE_TID_KEY, uuid,
+                   GLUSTERD_STORE_KEY_VOL_DEFRAG_COMMIT_HASH,
+                   volinfo->rebal.commit_hash);
     if (ret < 0 || ret >= sizeof(buf) - total_len) {
         ret = -1;
         goto out;
@@ -2905,6 +2909,9 @@ glusterd_store_retrieve_node_state(glusterd_volinfo_t *volinfo)
         } else if (!strncmp(key, GLUSTERD_STORE_KEY_VOL_DEFRAG_RUN_TIME,
                             SLEN(GLUSTERD_STORE_KEY_VOL_DEFRAG_RUN_TIME))) {
             volinfo->rebal.rebalance_time = atoi(value);
+        } else if (!strncmp(key, GLUSTERD_STORE_KEY_VOL_DEFRAG_COMMIT_HASH,
+                            SLEN(GLUSTERD_STORE_KEY_VOL_DEFRAG_COMMIT_HASH))) {
+            sscanf(value, "%" SCNu32, &volinfo->rebal.commit_hash);
         } else {
             if (!tmp_dict) {
                 tmp_dict = dict_new();
@@ -101,6 +101,7 @@ typedef enum glusterd_store_ver_ac_ {
 #define GLUSTERD_STORE_KEY_VOL_DEFRAG_FAILURES "failures"
 #define GLUSTERD_STORE_KEY_VOL_DEFRAG_SKIPPED "skipped"
 #define GLUSTERD_STORE_KEY_VOL_DEFRAG_RUN_TIME "run-time"
+#define GLUSTERD_STORE_KEY_VOL_DEFRAG_COMMIT_HASH "commit-hash"
 
 #define GLUSTERD_STORE_KEY_VOL_MIGRATED_FILES "migrated-files"
 #define GLUSTERD_STORE_KEY_VOL_MIGRATED_SIZE "migration-size"
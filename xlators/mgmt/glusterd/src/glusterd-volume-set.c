@@ -830,6 +830,10 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .voltype = "cluster/distribute",
      .op_version = GD_OP_VERSION_3_7_2,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.lookup-cache-timeout",
+     .voltype = "cluster/distribute",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "cluster.min-free-disk",
      .voltype = "cluster/distribute",
      .op_version = 1,
@@ -852,6 +856,10 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .voltype = "cluster/distribute",
      .op_version = 1,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.readdir-merge",
+     .voltype = "cluster/distribute",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "cluster.rsync-hash-regex",
      .voltype = "cluster/distribute",
      .type = NO_DOC,
@@ -904,6 +912,22 @@ struct volopt_map_entry glusterd_volopt_map[] = {
         .flags = VOLOPT_FLAG_CLIENT_OPT,
     },
 
+    {
+        .key = "cluster.rebal-io-window",
+        .voltype = "cluster/distribute",
+        .option = "rebal-io-window",
+        .op_version = GD_OP_VERSION_10_0,
+        .flags = VOLOPT_FLAG_CLIENT_OPT,
+    },
+
+    {
+        .key = "cluster.rebal-crawl-threads",
+        .voltype = "cluster/distribute",
+        .option = "rebal-crawl-threads",
+        .op_version = GD_OP_VERSION_10_0,
+        .flags = VOLOPT_FLAG_CLIENT_OPT,
+    },
+
     /* NUFA xlator options (Distribute special case) */
     {.key = "cluster.nufa",
      .voltype = "cluster/distribute",
@@ -922,6 +946,22 @@ struct volopt_map_entry glusterd_volopt_map[] = {
         .voltype = "cluster/distribute",
         .op_version = GD_OP_VERSION_3_6_0,
     },
+    {.key = "cluster.placement-weighting",
+     .voltype = "cluster/distribute",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.subvol-device-classes",
+     .voltype = "cluster/distribute",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.device-class-weights",
+     .voltype = "cluster/distribute",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.device-class-pins",
+     .voltype = "cluster/distribute",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
 
     /* Switch xlator options (Distribute special case) */
     {.key = "cluster.switch",
@@ -954,6 +994,10 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .voltype = "cluster/replicate",
      .op_version = 2,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.read-probe-interval",
+     .voltype = "cluster/replicate",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "cluster.background-self-heal-count",
      .voltype = "cluster/replicate",
      .op_version = 1,
@@ -993,6 +1037,10 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .option = "data-self-heal-window-size",
      .op_version = 1,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.data-self-heal-checksum",
+     .voltype = "cluster/replicate",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "cluster.data-change-log",
      .voltype = "cluster/replicate",
      .op_version = 1,
@@ -1215,6 +1263,11 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .option = "cache-size",
      .op_version = GD_OP_VERSION_8_0,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "performance.io-cache-policy",
+     .voltype = "performance/io-cache",
+     .option = "cache-policy",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {
         .key = "performance.cache-size",
         .voltype = "performance/io-cache",
@@ -1258,6 +1311,26 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .voltype = "performance/io-threads",
      .option = "pass-through",
      .op_version = GD_OP_VERSION_4_1_0},
+    {.key = "performance.iot-scheduler",
+     .voltype = "performance/io-threads",
+     .option = "scheduler",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "performance.iot-high-prio-deadline",
+     .voltype = "performance/io-threads",
+     .option = "high-prio-deadline",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "performance.iot-normal-prio-deadline",
+     .voltype = "performance/io-threads",
+     .option = "normal-prio-deadline",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "performance.iot-low-prio-deadline",
+     .voltype = "performance/io-threads",
+     .option = "low-prio-deadline",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "performance.iot-least-prio-deadline",
+     .voltype = "performance/io-threads",
+     .option = "least-prio-deadline",
+     .op_version = GD_OP_VERSION_10_0},
 
     /* Other perf xlators' options */
     {.key = "performance.io-cache-pass-through",
@@ -1297,6 +1370,11 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .option = "ctime-invalidation",
      .op_version = GD_OP_VERSION_5_0,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "performance.quick-read-cache-compression",
+     .voltype = "performance/quick-read",
+     .option = "cache-compression",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "performance.flush-behind",
      .voltype = "performance/write-behind",
      .option = "flush-behind",
@@ -1362,6 +1440,11 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .option = "aggregate-size",
      .op_version = GD_OP_VERSION_4_1_0,
      .flags = OPT_FLAG_CLIENT_OPT},
+    {.key = "performance.aggregate-size-max",
+     .voltype = "performance/write-behind",
+     .option = "aggregate-size-max",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "performance.nfs.write-behind-trickling-writes",
      .voltype = "performance/write-behind",
      .option = "trickling-writes",
@@ -1388,6 +1471,11 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .option = "page-count",
      .op_version = 1,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "performance.read-ahead-stream-count",
+     .voltype = "performance/read-ahead",
+     .option = "stream-count",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {
         .key = "performance.read-ahead-pass-through",
         .voltype = "performance/read-ahead",
@@ -1451,10 +1539,24 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .flags = VOLOPT_FLAG_CLIENT_OPT,
      .description = "A comma separated list of xattrs that shall be "
                     "cached by md-cache. The only wildcard allowed is '*'"},
+    {.key = "performance.cache-absent-xattrs",
+     .voltype = "performance/md-cache",
+     .option = "cache-absent-xattrs",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "performance.md-cache-size",
+     .voltype = "performance/md-cache",
+     .option = "md-cache-size",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "performance.nl-cache-pass-through",
      .voltype = "performance/nl-cache",
      .option = "pass-through",
      .op_version = GD_OP_VERSION_4_1_0},
+    {.key = "performance.flash-cache-pass-through",
+     .voltype = "performance/flash-cache",
+     .option = "pass-through",
+     .op_version = GD_OP_VERSION_10_0},
 
     /* Client xlator options */
     {.key = "network.frame-timeout",
@@ -1743,6 +1845,16 @@ struct volopt_map_entry glusterd_volopt_map[] = {
     },
 
     /* Performance xlators enable/disbable options */
+    /* flash-cache goes below write-behind, which answers writes with no
+     * pre/post attributes to check the cached data against */
+    {.key = "performance.flash-cache",
+     .voltype = "performance/flash-cache",
+     .option = "!perf",
+     .value = "off",
+     .op_version = GD_OP_VERSION_10_0,
+     .description = "enable/disable caching of file data on a local disk "
+                    "of the clients, kept across mounts.",
+     .flags = VOLOPT_FLAG_CLIENT_OPT | VOLOPT_FLAG_XLATOR_OPT},
     {.key = "performance.write-behind",
      .voltype = "performance/write-behind",
      .option = "!perf",
@@ -2621,6 +2733,18 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .voltype = "features/shard",
      .op_version = GD_OP_VERSION_5_0,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "features.shard-fanout-window",
+     .voltype = "features/shard",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "features.shard-precreate-count",
+     .voltype = "features/shard",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "features.shard-bulk-delete",
+     .voltype = "features/shard",
+     .op_version = GD_OP_VERSION_11_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {
         .key = "features.scrub-throttle",
         .voltype = "features/bit-rot",
@@ -2726,6 +2850,14 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .voltype = "cluster/replicate",
      .op_version = GD_OP_VERSION_3_7_12,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.shd-heal-order",
+     .voltype = "cluster/replicate",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.pre-op-compat",
+     .voltype = "cluster/replicate",
+     .op_version = GD_OP_VERSION_11_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "cluster.locking-scheme",
      .voltype = "cluster/replicate",
      .type = DOC,
@@ -2736,6 +2868,10 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .type = DOC,
      .op_version = GD_OP_VERSION_3_8_0,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.granular-data-heal",
+     .voltype = "cluster/replicate",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {
         .option = "revocation-secs",
         .key = "features.locks-revocation-secs",
@@ -2839,6 +2975,14 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .flags = VOLOPT_FLAG_CLIENT_OPT,
      .op_version = GD_OP_VERSION_3_9_1,
      .validate_fn = validate_rda_cache_limit},
+    {
+        .key = "performance.rda-listing-timeout",
+        .voltype = "performance/readdir-ahead",
+        .value = "0",
+        .type = DOC,
+        .flags = VOLOPT_FLAG_CLIENT_OPT,
+        .op_version = GD_OP_VERSION_10_0,
+    },
     {
         .key = "performance.nl-cache-positive-entry",
         .voltype = "performance/nl-cache",
@@ -2862,6 +3006,42 @@ struct volopt_map_entry glusterd_volopt_map[] = {
         .flags = VOLOPT_FLAG_CLIENT_OPT,
         .op_version = GD_OP_VERSION_3_11_0,
     },
+    {
+        .key = "performance.nl-cache-readdir-filter",
+        .voltype = "performance/nl-cache",
+        .flags = VOLOPT_FLAG_CLIENT_OPT,
+        .op_version = GD_OP_VERSION_10_0,
+    },
+    {
+        .key = "performance.flash-cache-dir",
+        .voltype = "performance/flash-cache",
+        .flags = VOLOPT_FLAG_CLIENT_OPT,
+        .op_version = GD_OP_VERSION_10_0,
+    },
+    {
+        .key = "performance.flash-cache-size",
+        .voltype = "performance/flash-cache",
+        .flags = VOLOPT_FLAG_CLIENT_OPT,
+        .op_version = GD_OP_VERSION_10_0,
+    },
+    {
+        .key = "performance.flash-cache-block-size",
+        .voltype = "performance/flash-cache",
+        .flags = VOLOPT_FLAG_CLIENT_OPT,
+        .op_version = GD_OP_VERSION_10_0,
+    },
+    {
+        .key = "performance.flash-cache-write-policy",
+        .voltype = "performance/flash-cache",
+        .flags = VOLOPT_FLAG_CLIENT_OPT,
+        .op_version = GD_OP_VERSION_10_0,
+    },
+    {
+        .key = "performance.flash-cache-timeout",
+        .voltype = "performance/flash-cache",
+        .flags = VOLOPT_FLAG_CLIENT_OPT,
+        .op_version = GD_OP_VERSION_10_0,
+    },
 
     /* Brick multiplexing options */
     {.key = GLUSTERD_BRICK_MULTIPLEX_KEY,
@@ -3002,6 +3182,18 @@ struct volopt_map_entry glusterd_volopt_map[] = {
                     " count should be in the range"
                     "[disperse-data-count,  disperse-count] (inclusive)",
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "disperse.heal-pipeline-window",
+     .voltype = "cluster/disperse",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "disperse.heal-skip-holes",
+     .voltype = "cluster/disperse",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "disperse.heal-bandwidth-limit",
+     .voltype = "cluster/disperse",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {
         .key = "features.sdfs",
         .voltype = "features/sdfs",
@@ -0,0 +1,26 @@
+/*
+ *   Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+ *   This file is part of GlusterFS.
+ *
+ *   This file is licensed to you under your choice of the GNU Lesser
+ *   General Public License, version 3 or any later version (LGPLv3 or
+ *   later), or the GNU General Public License, version 2 (GPLv2), in all
+ *   cases as published by the Free Software Foundation.
+ */
+
+#ifndef __FLASH_CACHE_MEM_TYPES_H__
+#define __FLASH_CACHE_MEM_TYPES_H__
+
+#include <glusterfs/mem-types.h>
+
+enum gf_fc_mem_types_ {
+    gf_fc_mt_fc_conf_t = gf_common_mt_end + 1,
+    gf_fc_mt_fc_inode_t,
+    gf_fc_mt_fc_local_t,
+    gf_fc_mt_bitmap,
+    gf_fc_mt_fc_victim_t,
+    gf_fc_mt_fc_fill_t,
+    gf_fc_mt_end
+};
+
+#endif /* __FLASH_CACHE_MEM_TYPES_H__ */
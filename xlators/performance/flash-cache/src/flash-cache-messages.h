@@ -0,0 +1,30 @@
+/*
+ *   Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+ *   This file is part of GlusterFS.
+ *
+ *   This file is licensed to you under your choice of the GNU Lesser
+ *   General Public License, version 3 or any later version (LGPLv3 or
+ *   later), or the GNU General Public License, version 2 (GPLv2), in all
+ *   cases as published by the Free Software Foundation.
+ */
+
+#ifndef __FLASH_CACHE_MESSAGES_H__
+#define __FLASH_CACHE_MESSAGES_H__
+
+#include <glusterfs/glfs-message-id.h>
+
+/* To add new message IDs, append new identifiers at the end of the list.
+ *
+ * Never remove a message ID. If it's not used anymore, you can rename it or
+ * leave it as it is, but not delete it. This is to prevent reutilization of
+ * IDs by other messages.
+ *
+ * The component name must match one of the entries defined in
+ * glfs-message-id.h.
+ */
+
+GLFS_MSGID(FLASH_CACHE, FC_MSG_NO_MEMORY, FC_MSG_INVALID_CONFIG,
+           FC_MSG_STORE_INIT_FAILED, FC_MSG_STORE_IO_FAILED,
+           FC_MSG_THREAD_FAILED);
+
+#endif /* __FLASH_CACHE_MESSAGES_H__ */
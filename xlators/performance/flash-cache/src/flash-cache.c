@@ -0,0 +1,2221 @@
+/*
+ *   Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+ *   This file is part of GlusterFS.
+ *
+ *   This file is licensed to you under your choice of the GNU Lesser
+ *   General Public License, version 3 or any later version (LGPLv3 or
+ *   later), or the GNU General Public License, version 2 (GPLv2), in all
+ *   cases as published by the Free Software Foundation.
+ */
+
+#include <dirent.h>
+#include <glusterfs/defaults.h>
+#include <glusterfs/statedump.h>
+#include <glusterfs/syscall.h>
+#include <glusterfs/upcall-utils.h>
+#include "flash-cache.h"
+
+#define FC_STACK_UNWIND(fop, frame, params...)                                 \
+    do {                                                                       \
+        fc_local_t *__local = NULL;                                            \
+        if (frame) {                                                           \
+            __local = frame->local;                                            \
+            frame->local = NULL;                                               \
+        }                                                                      \
+        STACK_UNWIND_STRICT(fop, frame, params);                               \
+        fc_local_wipe(__local);                                                \
+    } while (0)
+
+typedef struct {
+    uuid_t gfid;
+    time_t mtime;
+    uint64_t bytes;
+} fc_victim_t;
+
+struct fc_victims {
+    fc_victim_t *list;
+    size_t count;
+    size_t size;
+};
+
+typedef void (*fc_store_walk_fn)(xlator_t *this, uuid_t gfid,
+                                 struct fc_index_header *hdr, struct stat *st,
+                                 void *data);
+
+static void
+fc_local_wipe(fc_local_t *local)
+{
+    if (!local)
+        return;
+
+    if (local->fd)
+        fd_unref(local->fd);
+    GF_FREE(local->vector);
+    if (local->iobref)
+        iobref_unref(local->iobref);
+    if (local->xdata)
+        dict_unref(local->xdata);
+    GF_FREE(local);
+}
+
+static fc_local_t *
+fc_local_init(call_frame_t *frame, fc_inode_t *ctx, fd_t *fd)
+{
+    fc_local_t *local = NULL;
+
+    local = GF_CALLOC(1, sizeof(*local), gf_fc_mt_fc_local_t);
+    if (!local)
+        return NULL;
+
+    local->ctx = ctx;
+    if (fd)
+        local->fd = fd_ref(fd);
+    frame->local = local;
+
+    return local;
+}
+
+static void
+fc_store_path(fc_conf_t *conf, uuid_t gfid, const char *suffix, char *path,
+              size_t len)
+{
+    char gfid_str[GF_UUID_BUF_SIZE];
+
+    uuid_utoa_r(gfid, gfid_str);
+    snprintf(path, len, "%s/%.2s/%s%s", conf->cache_dir, gfid_str, gfid_str,
+             suffix);
+}
+
+static void
+fc_validator_set(fc_validator_t *valid, struct iatt *buf)
+{
+    valid->size = buf->ia_size;
+    valid->mtime = buf->ia_mtime;
+    valid->mtime_nsec = buf->ia_mtime_nsec;
+    valid->ctime = buf->ia_ctime;
+    valid->ctime_nsec = buf->ia_ctime_nsec;
+}
+
+static gf_boolean_t
+fc_validator_match(fc_validator_t *valid, struct iatt *buf)
+{
+    return (valid->size == buf->ia_size) && (valid->mtime == buf->ia_mtime) &&
+           (valid->mtime_nsec == buf->ia_mtime_nsec) &&
+           (valid->ctime == buf->ia_ctime) &&
+           (valid->ctime_nsec == buf->ia_ctime_nsec);
+}
+
+static gf_boolean_t
+__fc_block_test(fc_inode_t *ctx, uint64_t block)
+{
+    if (block >= ctx->nblocks)
+        return _gf_false;
+
+    return (ctx->bitmap[block / 8] >> (block % 8)) & 1;
+}
+
+static int
+__fc_block_set(xlator_t *this, fc_inode_t *ctx, uint64_t block)
+{
+    fc_conf_t *conf = this->private;
+    uint8_t *bitmap = NULL;
+    uint64_t bytes = 0;
+    uint64_t old = ctx->nblocks / 8;
+
+    if (block >= ctx->nblocks) {
+        bytes = max(block / 8 + 1, old * 2);
+        if (ctx->bitmap)
+            bitmap = GF_REALLOC(ctx->bitmap, bytes);
+        else
+            bitmap = GF_CALLOC(bytes, 1, gf_fc_mt_bitmap);
+        if (!bitmap)
+            return -1;
+        memset(bitmap + old, 0, bytes - old);
+        ctx->bitmap = bitmap;
+        ctx->nblocks = bytes * 8;
+    }
+
+    if (__fc_block_test(ctx, block))
+        return 0;
+
+    ctx->bitmap[block / 8] |= 1 << (block % 8);
+    ctx->cached++;
+    ctx->dirty = _gf_true;
+    GF_ATOMIC_ADD(conf->used, conf->block_size);
+
+    return 0;
+}
+
+static void
+__fc_blocks_clear(xlator_t *this, fc_inode_t *ctx, uint64_t first,
+                  uint64_t last)
+{
+    fc_conf_t *conf = this->private;
+    uint64_t block = 0;
+
+    for (block = first; (block <= last) && (block < ctx->nblocks); block++) {
+        if (!__fc_block_test(ctx, block))
+            continue;
+        ctx->bitmap[block / 8] &= ~(1 << (block % 8));
+        ctx->cached--;
+        ctx->dirty = _gf_true;
+        GF_ATOMIC_SUB(conf->used, conf->block_size);
+    }
+}
+
+/* Opens the files of the store for this inode, creating them if needed. A
+ * data file opened here has no valid block yet, whatever it contains is
+ * left over and thrown away. Only done by the prune thread, the fops look
+ * at data_fd once a block is set, which happens after. */
+static int
+fc_store_open(xlator_t *this, fc_inode_t *ctx)
+{
+    fc_conf_t *conf = this->private;
+    char path[PATH_MAX];
+    char gfid_str[GF_UUID_BUF_SIZE];
+
+    if ((ctx->data_fd >= 0) && (ctx->idx_fd >= 0))
+        return 0;
+
+    uuid_utoa_r(ctx->gfid, gfid_str);
+    snprintf(path, sizeof(path), "%s/%.2s", conf->cache_dir, gfid_str);
+    if (sys_mkdir(path, 0700) && (errno != EEXIST))
+        goto err;
+
+    if (ctx->data_fd < 0) {
+        fc_store_path(conf, ctx->gfid, "", path, sizeof(path));
+        ctx->data_fd = sys_open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (ctx->data_fd < 0)
+            goto err;
+    }
+
+    if (ctx->idx_fd < 0) {
+        fc_store_path(conf, ctx->gfid, ".idx", path, sizeof(path));
+        ctx->idx_fd = sys_open(path, O_RDWR | O_CREAT, 0600);
+        if (ctx->idx_fd < 0)
+            goto err;
+    }
+
+    return 0;
+err:
+    gf_msg(this->name, GF_LOG_WARNING, errno, FC_MSG_STORE_IO_FAILED,
+           "failed to open %s", path);
+    return -1;
+}
+
+static void
+fc_index_header_fill(xlator_t *this, fc_inode_t *ctx,
+                     struct fc_index_header *hdr, uint32_t flags)
+{
+    fc_conf_t *conf = this->private;
+
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->magic = FC_INDEX_MAGIC;
+    hdr->version = FC_INDEX_VERSION;
+    hdr->flags = flags;
+    hdr->block_size = conf->block_size;
+    hdr->nblocks = ctx->nblocks;
+    hdr->cached = ctx->cached;
+    hdr->size = ctx->valid.size;
+    hdr->mtime = ctx->valid.mtime;
+    hdr->mtime_nsec = ctx->valid.mtime_nsec;
+    hdr->ctime = ctx->valid.ctime;
+    hdr->ctime_nsec = ctx->valid.ctime_nsec;
+}
+
+/* Flags the index open, it has to be synced before the data file is
+ * written to */
+static int
+fc_index_mark(xlator_t *this, fc_inode_t *ctx)
+{
+    struct fc_index_header hdr;
+
+    if (fc_store_open(this, ctx))
+        return -1;
+
+    LOCK(&ctx->lock);
+    {
+        fc_index_header_fill(this, ctx, &hdr, FC_INDEX_OPEN);
+    }
+    UNLOCK(&ctx->lock);
+
+    if (sys_pwrite(ctx->idx_fd, &hdr, sizeof(hdr), 0) != sizeof(hdr)) {
+        gf_msg(this->name, GF_LOG_WARNING, errno, FC_MSG_STORE_IO_FAILED,
+               "failed to update the index of %s", uuid_utoa(ctx->gfid));
+        return -1;
+    }
+
+    return 0;
+}
+
+static void
+fc_index_load(xlator_t *this, fc_inode_t *ctx)
+{
+    fc_conf_t *conf = this->private;
+    struct fc_index_header hdr;
+    char path[PATH_MAX];
+    uint64_t counted = 0;
+    ssize_t bytes = 0;
+
+    fc_store_path(conf, ctx->gfid, ".idx", path, sizeof(path));
+    ctx->idx_fd = sys_open(path, O_RDWR, 0);
+    if (ctx->idx_fd < 0)
+        return;
+
+    if ((sys_pread(ctx->idx_fd, &hdr, sizeof(hdr), 0) != sizeof(hdr)) ||
+        (hdr.magic != FC_INDEX_MAGIC) || (hdr.version != FC_INDEX_VERSION))
+        goto discard;
+
+    /* Accounted for when the store was scanned */
+    counted = hdr.cached * hdr.block_size;
+    if ((hdr.flags & FC_INDEX_OPEN) || (hdr.block_size != conf->block_size) ||
+        (hdr.nblocks % 8))
+        goto discard;
+
+    fc_store_path(conf, ctx->gfid, "", path, sizeof(path));
+    ctx->data_fd = sys_open(path, O_RDWR, 0);
+    if (ctx->data_fd < 0)
+        goto discard;
+
+    bytes = hdr.nblocks / 8;
+    if (bytes) {
+        ctx->bitmap = GF_CALLOC(bytes, 1, gf_fc_mt_bitmap);
+        if (!ctx->bitmap ||
+            (sys_pread(ctx->idx_fd, ctx->bitmap, bytes, sizeof(hdr)) != bytes))
+            goto discard;
+    }
+
+    ctx->nblocks = hdr.nblocks;
+    ctx->cached = hdr.cached;
+    ctx->valid.size = hdr.size;
+    ctx->valid.mtime = hdr.mtime;
+    ctx->valid.mtime_nsec = hdr.mtime_nsec;
+    ctx->valid.ctime = hdr.ctime;
+    ctx->valid.ctime_nsec = hdr.ctime_nsec;
+    ctx->has_valid = _gf_true;
+    return;
+
+discard:
+    GF_ATOMIC_SUB(conf->used, counted);
+    GF_FREE(ctx->bitmap);
+    ctx->bitmap = NULL;
+    if (ctx->data_fd >= 0) {
+        sys_close(ctx->data_fd);
+        ctx->data_fd = -1;
+    }
+    ctx->dirty = _gf_true;
+}
+
+static void
+fc_fill_free(xlator_t *this, fc_fill_t *fill)
+{
+    fc_conf_t *conf = this->private;
+
+    GF_ATOMIC_SUB(conf->pending, fill->size);
+    GF_FREE(fill->vector);
+    if (fill->iobref)
+        iobref_unref(fill->iobref);
+    GF_FREE(fill);
+}
+
+static void
+fc_fills_free(xlator_t *this, struct list_head *fills)
+{
+    fc_fill_t *fill = NULL;
+    fc_fill_t *tmp = NULL;
+
+    list_for_each_entry_safe(fill, tmp, fills, list)
+    {
+        list_del(&fill->list);
+        fc_fill_free(this, fill);
+    }
+}
+
+/* Hands the inode to the prune thread, unless it has it already */
+static void
+__fc_store_queue(xlator_t *this, fc_inode_t *ctx)
+{
+    fc_conf_t *conf = this->private;
+
+    pthread_mutex_lock(&conf->prune_lock);
+    {
+        if (list_empty(&ctx->work)) {
+            list_add_tail(&ctx->work, &conf->work);
+            pthread_cond_signal(&conf->prune_cond);
+        }
+    }
+    pthread_mutex_unlock(&conf->prune_lock);
+}
+
+/* The prune thread writes the data to the store and sets blocks @first to
+ * @last, unless the file changed since */
+static void
+__fc_fill_queue(xlator_t *this, fc_inode_t *ctx, off_t offset,
+                struct iovec *vector, int count, size_t size,
+                struct iobref *iobref, uint64_t first, uint64_t last)
+{
+    fc_conf_t *conf = this->private;
+    fc_fill_t *fill = NULL;
+
+    if (GF_ATOMIC_GET(conf->pending) + size > FC_PENDING_MAX)
+        return;
+
+    fill = GF_CALLOC(1, sizeof(*fill), gf_fc_mt_fc_fill_t);
+    if (!fill)
+        return;
+
+    fill->vector = iov_dup(vector, count);
+    if (!fill->vector) {
+        GF_FREE(fill);
+        return;
+    }
+    fill->count = count;
+    if (iobref)
+        fill->iobref = iobref_ref(iobref);
+    fill->gen = ctx->gen;
+    fill->first = first;
+    fill->last = last;
+    fill->offset = offset;
+    fill->size = size;
+    GF_ATOMIC_ADD(conf->pending, size);
+
+    list_add_tail(&fill->list, &ctx->fills);
+    __fc_store_queue(this, ctx);
+}
+
+static void
+fc_inode_ctx_free(fc_inode_t *ctx)
+{
+    if (ctx->data_fd >= 0)
+        sys_close(ctx->data_fd);
+    if (ctx->idx_fd >= 0)
+        sys_close(ctx->idx_fd);
+    GF_FREE(ctx->bitmap);
+    LOCK_DESTROY(&ctx->lock);
+    GF_FREE(ctx);
+}
+
+static fc_inode_t *
+__fc_forgotten_find(fc_conf_t *conf, uuid_t gfid)
+{
+    fc_inode_t *ctx = NULL;
+
+    list_for_each_entry(ctx, &conf->forgotten, store)
+    {
+        if (!gf_uuid_compare(ctx->gfid, gfid))
+            return ctx;
+    }
+
+    return NULL;
+}
+
+static fc_inode_t *
+fc_inode_ctx_get(xlator_t *this, inode_t *inode, gf_boolean_t create)
+{
+    fc_conf_t *conf = this->private;
+    fc_inode_t *ctx = NULL;
+    uint64_t value = 0;
+
+    if (!inode_ctx_get(inode, this, &value))
+        return (fc_inode_t *)(uintptr_t)value;
+
+    if (!create || !conf->enabled || (inode->ia_type != IA_IFREG) ||
+        gf_uuid_is_null(inode->gfid))
+        return NULL;
+
+    pthread_mutex_lock(&conf->store_lock);
+    {
+        if (!inode_ctx_get(inode, this, &value)) {
+            ctx = (fc_inode_t *)(uintptr_t)value;
+            goto unlock;
+        }
+
+        /* Taken back as is while its index waits to be written, the
+         * store can't be loaded before that */
+        ctx = __fc_forgotten_find(conf, inode->gfid);
+        if (ctx) {
+            value = (uint64_t)(uintptr_t)ctx;
+            if (inode_ctx_set(inode, this, &value)) {
+                ctx = NULL;
+                goto unlock;
+            }
+            list_del_init(&ctx->store);
+            LOCK(&ctx->lock);
+            {
+                ctx->forgotten = _gf_false;
+            }
+            UNLOCK(&ctx->lock);
+            goto unlock;
+        }
+
+        ctx = GF_CALLOC(1, sizeof(*ctx), gf_fc_mt_fc_inode_t);
+        if (!ctx)
+            goto unlock;
+
+        LOCK_INIT(&ctx->lock);
+        gf_uuid_copy(ctx->gfid, inode->gfid);
+        ctx->data_fd = -1;
+        ctx->idx_fd = -1;
+        INIT_LIST_HEAD(&ctx->fills);
+        INIT_LIST_HEAD(&ctx->work);
+        INIT_LIST_HEAD(&ctx->store);
+        INIT_LIST_HEAD(&ctx->batch);
+        INIT_LIST_HEAD(&ctx->filling);
+        fc_index_load(this, ctx);
+
+        value = (uint64_t)(uintptr_t)ctx;
+        if (inode_ctx_set(inode, this, &value)) {
+            fc_inode_ctx_free(ctx);
+            ctx = NULL;
+        }
+    }
+unlock:
+    pthread_mutex_unlock(&conf->store_lock);
+
+    return ctx;
+}
+
+static void
+__fc_inode_drop(xlator_t *this, fc_inode_t *ctx)
+{
+    fc_conf_t *conf = this->private;
+
+    ctx->gen++;
+    fc_fills_free(this, &ctx->fills);
+    if (!ctx->cached)
+        return;
+
+    /* The blocks go right away, the data file when the prune thread gets
+     * to it */
+    ctx->truncate = _gf_true;
+    __fc_store_queue(this, ctx);
+
+    GF_ATOMIC_SUB(conf->used, ctx->cached * conf->block_size);
+    GF_ATOMIC_INC(conf->invalidations);
+    memset(ctx->bitmap, 0, ctx->nblocks / 8);
+    ctx->cached = 0;
+    ctx->dirty = _gf_true;
+}
+
+static void
+__fc_inode_adopt(fc_inode_t *ctx, struct iatt *buf)
+{
+    if (!ctx->has_valid || !fc_validator_match(&ctx->valid, buf)) {
+        fc_validator_set(&ctx->valid, buf);
+        ctx->has_valid = _gf_true;
+        ctx->dirty = _gf_true;
+    }
+    ctx->stat = *buf;
+    ctx->validated = gf_time();
+}
+
+/* The file was seen as @buf, anything cached for another version of it
+ * goes */
+static void
+__fc_inode_validate(xlator_t *this, fc_inode_t *ctx, struct iatt *buf)
+{
+    if (ctx->has_valid && !fc_validator_match(&ctx->valid, buf))
+        __fc_inode_drop(this, ctx);
+
+    __fc_inode_adopt(ctx, buf);
+}
+
+static void
+fc_inode_validate(xlator_t *this, fc_inode_t *ctx, struct iatt *buf)
+{
+    LOCK(&ctx->lock);
+    {
+        __fc_inode_validate(this, ctx, buf);
+    }
+    UNLOCK(&ctx->lock);
+}
+
+/* Blocks overlapping [offset, offset + len) are stale, as is the block of the
+ * old end of file when the size changed: the tail of the block past it is
+ * now either a hole or data written by somebody else. */
+static void
+__fc_range_clear(xlator_t *this, fc_inode_t *ctx, off_t offset, size_t len,
+                 uint64_t old_size, uint64_t new_size)
+{
+    fc_conf_t *conf = this->private;
+    uint64_t bs = conf->block_size;
+
+    if (len)
+        __fc_blocks_clear(this, ctx, offset / bs, (offset + len - 1) / bs);
+
+    if ((new_size != old_size) && (old_size % bs))
+        __fc_blocks_clear(this, ctx, old_size / bs, old_size / bs);
+
+    if (new_size < old_size)
+        __fc_blocks_clear(this, ctx, new_size / bs, (old_size - 1) / bs);
+}
+
+static gf_boolean_t
+__fc_write_keeps(xlator_t *this, fc_inode_t *ctx, uint64_t block, off_t offset,
+                 size_t len, uint64_t old_size, uint64_t new_size)
+{
+    fc_conf_t *conf = this->private;
+    uint64_t start = block * conf->block_size;
+    uint64_t end = min(start + conf->block_size, new_size);
+
+    /* Written entirely */
+    if ((offset <= start) && (offset + len >= end))
+        return _gf_true;
+
+    /* Or partly, over data that was cached and with no hole left between
+     * the old end of file and the write */
+    if (!__fc_block_test(ctx, block))
+        return _gf_false;
+
+    return (old_size >= end) || (old_size <= start) || (offset <= old_size);
+}
+
+static void
+__fc_write_through(xlator_t *this, fc_inode_t *ctx, fc_local_t *local,
+                   off_t offset, size_t len, uint64_t old_size,
+                   uint64_t new_size)
+{
+    fc_conf_t *conf = this->private;
+    uint64_t first = offset / conf->block_size;
+    uint64_t last = (offset + len - 1) / conf->block_size;
+    gf_boolean_t keep_first = _gf_false;
+    gf_boolean_t keep_last = _gf_false;
+
+    keep_first = __fc_write_keeps(this, ctx, first, offset, len, old_size,
+                                  new_size);
+    keep_last = __fc_write_keeps(this, ctx, last, offset, len, old_size,
+                                 new_size);
+
+    __fc_range_clear(this, ctx, offset, len, old_size, new_size);
+
+    if (!keep_first)
+        first++;
+    if (!keep_last) {
+        if (!last)
+            return;
+        last--;
+    }
+    if (first > last)
+        return;
+
+    __fc_fill_queue(this, ctx, offset, local->vector, local->count, len,
+                    local->iobref, first, last);
+}
+
+static void
+fc_inode_modified(xlator_t *this, fc_local_t *local, struct iatt *prebuf,
+                  struct iatt *postbuf, off_t offset, size_t len)
+{
+    fc_inode_t *ctx = local->ctx;
+
+    LOCK(&ctx->lock);
+    {
+        ctx->gen++;
+        if (!ctx->has_valid || !fc_validator_match(&ctx->valid, prebuf))
+            __fc_inode_drop(this, ctx);
+        else if (local->vector && len &&
+                 (len == iov_length(local->vector, local->count)))
+            __fc_write_through(this, ctx, local, offset, len, prebuf->ia_size,
+                               postbuf->ia_size);
+        else
+            __fc_range_clear(this, ctx, offset, len, prebuf->ia_size,
+                             postbuf->ia_size);
+
+        __fc_inode_adopt(ctx, postbuf);
+    }
+    UNLOCK(&ctx->lock);
+}
+
+static void
+fc_inode_dirty(fc_inode_t *ctx)
+{
+    LOCK(&ctx->lock);
+    {
+        ctx->dirty = _gf_true;
+    }
+    UNLOCK(&ctx->lock);
+}
+
+static void
+fc_inode_drop(xlator_t *this, fc_inode_t *ctx)
+{
+    LOCK(&ctx->lock);
+    {
+        __fc_inode_drop(this, ctx);
+    }
+    UNLOCK(&ctx->lock);
+}
+
+/* Reads of the file started from now on can't be cached before the reply of
+ * this fop is seen */
+static fc_local_t *
+fc_modify_begin(call_frame_t *frame, xlator_t *this, inode_t *inode, fd_t *fd,
+                off_t offset, size_t len)
+{
+    fc_inode_t *ctx = NULL;
+    fc_local_t *local = NULL;
+
+    ctx = fc_inode_ctx_get(this, inode, _gf_true);
+    if (!ctx)
+        return NULL;
+
+    local = fc_local_init(frame, ctx, fd);
+
+    LOCK(&ctx->lock);
+    {
+        ctx->gen++;
+        if (!local)
+            __fc_inode_drop(this, ctx);
+    }
+    UNLOCK(&ctx->lock);
+
+    if (local) {
+        local->offset = offset;
+        local->size = len;
+    }
+
+    return local;
+}
+
+static int32_t
+fc_modify_cbk(call_frame_t *frame, xlator_t *this, int32_t op_ret,
+              struct iatt *prebuf, struct iatt *postbuf, off_t offset,
+              size_t len)
+{
+    fc_local_t *local = frame->local;
+
+    if (!local)
+        return 0;
+
+    /* A failed fop may still have changed part of the file */
+    if (op_ret < 0)
+        fc_inode_drop(this, local->ctx);
+    else
+        fc_inode_modified(this, local, prebuf, postbuf, offset, len);
+
+    return 0;
+}
+
+static void
+fc_prune_wake(xlator_t *this)
+{
+    fc_conf_t *conf = this->private;
+
+    pthread_mutex_lock(&conf->prune_lock);
+    {
+        conf->prune_wanted = _gf_true;
+        pthread_cond_signal(&conf->prune_cond);
+    }
+    pthread_mutex_unlock(&conf->prune_lock);
+}
+
+static gf_boolean_t
+fc_fd_cached(xlator_t *this, fd_t *fd)
+{
+    uint64_t value = 0;
+
+    fd_ctx_get(fd, this, &value);
+
+    return value != FC_FD_DIRECT;
+}
+
+int32_t
+fc_readv_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
+             int32_t op_errno, struct iovec *vector, int32_t count,
+             struct iatt *stbuf, struct iobref *iobref, dict_t *xdata)
+{
+    fc_local_t *local = frame->local;
+
+    if ((op_ret >= 0) && local && stbuf)
+        fc_inode_validate(this, local->ctx, stbuf);
+
+    FC_STACK_UNWIND(readv, frame, op_ret, op_errno, vector, count, stbuf,
+                    iobref, xdata);
+    return 0;
+}
+
+/* Keeps the blocks read from the child, whole ones only, but for the last
+ * block of the file */
+static void
+fc_readv_fill(xlator_t *this, fc_local_t *local, struct iovec *vector,
+              int32_t count, size_t len, struct iatt *stbuf,
+              struct iobref *iobref)
+{
+    fc_conf_t *conf = this->private;
+    fc_inode_t *ctx = local->ctx;
+    uint64_t start = local->first * conf->block_size;
+    uint64_t full = 0;
+
+    if (start + len >= stbuf->ia_size)
+        full = (len + conf->block_size - 1) / conf->block_size;
+    else
+        full = len / conf->block_size;
+
+    LOCK(&ctx->lock);
+    {
+        if (ctx->has_valid && !fc_validator_match(&ctx->valid, stbuf)) {
+            __fc_inode_drop(this, ctx);
+        } else if (full && (ctx->gen == local->gen)) {
+            __fc_fill_queue(this, ctx, start, vector, count, len, iobref,
+                            local->first, local->first + full - 1);
+        }
+
+        __fc_inode_adopt(ctx, stbuf);
+    }
+    UNLOCK(&ctx->lock);
+}
+
+int32_t
+fc_readv_fill_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, struct iovec *vector,
+                  int32_t count, struct iatt *stbuf, struct iobref *iobref,
+                  dict_t *xdata)
+{
+    fc_conf_t *conf = this->private;
+    fc_local_t *local = frame->local;
+    struct iovec *slice = NULL;
+    int slice_count = 0;
+    off_t skip = 0;
+    int32_t size = 0;
+
+    if (op_ret < 0)
+        goto unwind;
+
+    fc_readv_fill(this, local, vector, count, op_ret, stbuf, iobref);
+
+    /* Hand back only what was asked for out of the blocks */
+    skip = local->offset - local->first * conf->block_size;
+    if (op_ret > skip) {
+        size = min(op_ret - skip, local->size);
+        slice_count = iov_subset(vector, count, skip, size, &slice, 0);
+        if (slice_count < 0) {
+            op_ret = -1;
+            op_errno = ENOMEM;
+            goto unwind;
+        }
+    }
+
+    FC_STACK_UNWIND(readv, frame, size, op_errno, slice, slice_count, stbuf,
+                    iobref, xdata);
+    GF_FREE(slice);
+    return 0;
+
+unwind:
+    FC_STACK_UNWIND(readv, frame, op_ret, op_errno, vector, count, stbuf,
+                    iobref, xdata);
+    return 0;
+}
+
+static int
+fc_readv_cached(call_frame_t *frame, xlator_t *this, off_t end)
+{
+    fc_conf_t *conf = this->private;
+    fc_local_t *local = frame->local;
+    fc_inode_t *ctx = local->ctx;
+    struct iobuf *iobuf = NULL;
+    struct iobref *iobref = NULL;
+    struct iovec vector;
+    struct iatt stbuf;
+    ssize_t size = end - local->offset;
+    gf_boolean_t valid = _gf_false;
+    int ret = -1;
+
+    iobuf = iobuf_get2(this->ctx->iobuf_pool, size);
+    if (!iobuf)
+        goto out;
+
+    iobref = iobref_new();
+    if (!iobref || iobref_add(iobref, iobuf))
+        goto out;
+
+    if (sys_pread(ctx->data_fd, iobuf->ptr, size, local->offset) != size)
+        goto out;
+
+    /* The blocks may have been dropped while they were read */
+    LOCK(&ctx->lock);
+    {
+        valid = (ctx->gen == local->gen);
+        if (valid) {
+            ctx->used = _gf_true;
+            stbuf = ctx->stat;
+        }
+    }
+    UNLOCK(&ctx->lock);
+
+    if (!valid)
+        goto out;
+
+    GF_ATOMIC_INC(conf->hits);
+    vector.iov_base = iobuf->ptr;
+    vector.iov_len = size;
+    FC_STACK_UNWIND(readv, frame, size, 0, &vector, 1, &stbuf, iobref, NULL);
+    ret = 0;
+out:
+    if (iobref)
+        iobref_unref(iobref);
+    if (iobuf)
+        iobuf_unref(iobuf);
+    return ret;
+}
+
+static void
+fc_readv_resume(call_frame_t *frame, xlator_t *this)
+{
+    fc_conf_t *conf = this->private;
+    fc_local_t *local = frame->local;
+    fc_inode_t *ctx = local->ctx;
+    uint64_t block = 0;
+    uint64_t last = 0;
+    off_t end = 0;
+    gf_boolean_t hit = _gf_false;
+
+    if (local->uncached)
+        goto wind;
+
+    LOCK(&ctx->lock);
+    {
+        if (!ctx->has_valid || (local->offset >= ctx->valid.size)) {
+            local->uncached = _gf_true;
+        } else {
+            end = min(local->offset + local->size, ctx->valid.size);
+            local->first = local->offset / conf->block_size;
+            last = (end - 1) / conf->block_size;
+            for (block = local->first; block <= last; block++) {
+                if (!__fc_block_test(ctx, block))
+                    break;
+            }
+            hit = (block > last);
+            local->gen = ctx->gen;
+        }
+    }
+    UNLOCK(&ctx->lock);
+
+    if (local->uncached)
+        goto wind;
+
+    if (hit && !fc_readv_cached(frame, this, end))
+        return;
+
+    GF_ATOMIC_INC(conf->misses);
+    STACK_WIND(frame, fc_readv_fill_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->readv, local->fd,
+               (last - local->first + 1) * conf->block_size,
+               local->first * conf->block_size, local->flags, local->xdata);
+    return;
+
+wind:
+    STACK_WIND(frame, fc_readv_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->readv, local->fd, local->size,
+               local->offset, local->flags, local->xdata);
+}
+
+int32_t
+fc_readv_fstat_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                   int32_t op_ret, int32_t op_errno, struct iatt *buf,
+                   dict_t *xdata)
+{
+    fc_local_t *local = frame->local;
+
+    if (op_ret < 0)
+        local->uncached = _gf_true;
+    else
+        fc_inode_validate(this, local->ctx, buf);
+
+    fc_readv_resume(frame, this);
+    return 0;
+}
+
+int32_t
+fc_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+         off_t offset, uint32_t flags, dict_t *xdata)
+{
+    fc_conf_t *conf = this->private;
+    fc_inode_t *ctx = NULL;
+    fc_local_t *local = NULL;
+    gf_boolean_t stale = _gf_false;
+
+    if (!size || !fc_fd_cached(this, fd))
+        goto wind;
+
+    ctx = fc_inode_ctx_get(this, fd->inode, _gf_true);
+    if (!ctx)
+        goto wind;
+
+    local = fc_local_init(frame, ctx, fd);
+    if (!local)
+        goto wind;
+
+    local->offset = offset;
+    local->size = size;
+    local->flags = flags;
+    if (xdata)
+        local->xdata = dict_ref(xdata);
+
+    LOCK(&ctx->lock);
+    {
+        stale = (gf_time() - ctx->validated >= conf->cache_timeout);
+    }
+    UNLOCK(&ctx->lock);
+
+    if (stale) {
+        STACK_WIND(frame, fc_readv_fstat_cbk, FIRST_CHILD(this),
+                   FIRST_CHILD(this)->fops->fstat, fd, NULL);
+        return 0;
+    }
+
+    fc_readv_resume(frame, this);
+    return 0;
+
+wind:
+    STACK_WIND(frame, default_readv_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->readv, fd, size, offset, flags, xdata);
+    return 0;
+}
+
+int32_t
+fc_writev_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+              struct iatt *postbuf, dict_t *xdata)
+{
+    fc_local_t *local = frame->local;
+
+    if (local)
+        fc_modify_cbk(frame, this, op_ret, prebuf, postbuf, local->offset,
+                      (op_ret > 0) ? op_ret : 0);
+
+    FC_STACK_UNWIND(writev, frame, op_ret, op_errno, prebuf, postbuf, xdata);
+    return 0;
+}
+
+int32_t
+fc_writev(call_frame_t *frame, xlator_t *this, fd_t *fd, struct iovec *vector,
+          int32_t count, off_t offset, uint32_t flags, struct iobref *iobref,
+          dict_t *xdata)
+{
+    fc_conf_t *conf = this->private;
+    fc_local_t *local = NULL;
+
+    local = fc_modify_begin(frame, this, fd->inode, fd, offset,
+                            iov_length(vector, count));
+
+    /* Without a copy of the data the write is only cached around */
+    if (local && (conf->write_policy == FC_WRITE_THROUGH)) {
+        local->vector = iov_dup(vector, count);
+        if (local->vector) {
+            local->count = count;
+            local->iobref = iobref_ref(iobref);
+        }
+    }
+
+    STACK_WIND(frame, fc_writev_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->writev, fd, vector, count, offset,
+               flags, iobref, xdata);
+    return 0;
+}
+
+int32_t
+fc_truncate_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                struct iatt *postbuf, dict_t *xdata)
+{
+    fc_modify_cbk(frame, this, op_ret, prebuf, postbuf, 0, 0);
+
+    FC_STACK_UNWIND(truncate, frame, op_ret, op_errno, prebuf, postbuf, xdata);
+    return 0;
+}
+
+int32_t
+fc_truncate(call_frame_t *frame, xlator_t *this, loc_t *loc, off_t offset,
+            dict_t *xdata)
+{
+    fc_modify_begin(frame, this, loc->inode, NULL, 0, 0);
+
+    STACK_WIND(frame, fc_truncate_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->truncate, loc, offset, xdata);
+    return 0;
+}
+
+int32_t
+fc_ftruncate_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                 struct iatt *postbuf, dict_t *xdata)
+{
+    fc_modify_cbk(frame, this, op_ret, prebuf, postbuf, 0, 0);
+
+    FC_STACK_UNWIND(ftruncate, frame, op_ret, op_errno, prebuf, postbuf,
+                    xdata);
+    return 0;
+}
+
+int32_t
+fc_ftruncate(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+             dict_t *xdata)
+{
+    fc_modify_begin(frame, this, fd->inode, fd, 0, 0);
+
+    STACK_WIND(frame, fc_ftruncate_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->ftruncate, fd, offset, xdata);
+    return 0;
+}
+
+int32_t
+fc_fallocate_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                 struct iatt *postbuf, dict_t *xdata)
+{
+    fc_local_t *local = frame->local;
+
+    if (local)
+        fc_modify_cbk(frame, this, op_ret, prebuf, postbuf, local->offset,
+                      local->size);
+
+    FC_STACK_UNWIND(fallocate, frame, op_ret, op_errno, prebuf, postbuf,
+                    xdata);
+    return 0;
+}
+
+int32_t
+fc_fallocate(call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t keep_size,
+             off_t offset, size_t len, dict_t *xdata)
+{
+    fc_modify_begin(frame, this, fd->inode, fd, offset, len);
+
+    STACK_WIND(frame, fc_fallocate_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->fallocate, fd, keep_size, offset, len,
+               xdata);
+    return 0;
+}
+
+int32_t
+fc_discard_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+               struct iatt *postbuf, dict_t *xdata)
+{
+    fc_local_t *local = frame->local;
+
+    if (local)
+        fc_modify_cbk(frame, this, op_ret, prebuf, postbuf, local->offset,
+                      local->size);
+
+    FC_STACK_UNWIND(discard, frame, op_ret, op_errno, prebuf, postbuf, xdata);
+    return 0;
+}
+
+int32_t
+fc_discard(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+           size_t len, dict_t *xdata)
+{
+    fc_modify_begin(frame, this, fd->inode, fd, offset, len);
+
+    STACK_WIND(frame, fc_discard_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->discard, fd, offset, len, xdata);
+    return 0;
+}
+
+int32_t
+fc_zerofill_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                struct iatt *postbuf, dict_t *xdata)
+{
+    fc_local_t *local = frame->local;
+
+    if (local)
+        fc_modify_cbk(frame, this, op_ret, prebuf, postbuf, local->offset,
+                      local->size);
+
+    FC_STACK_UNWIND(zerofill, frame, op_ret, op_errno, prebuf, postbuf, xdata);
+    return 0;
+}
+
+int32_t
+fc_zerofill(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+            off_t len, dict_t *xdata)
+{
+    fc_modify_begin(frame, this, fd->inode, fd, offset, len);
+
+    STACK_WIND(frame, fc_zerofill_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->zerofill, fd, offset, len, xdata);
+    return 0;
+}
+
+int32_t
+fc_copy_file_range_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                       int32_t op_ret, int32_t op_errno, struct iatt *stbuf,
+                       struct iatt *prebuf_dst, struct iatt *postbuf_dst,
+                       dict_t *xdata)
+{
+    fc_local_t *local = frame->local;
+
+    if (local)
+        fc_modify_cbk(frame, this, op_ret, prebuf_dst, postbuf_dst,
+                      local->offset, (op_ret > 0) ? op_ret : 0);
+
+    FC_STACK_UNWIND(copy_file_range, frame, op_ret, op_errno, stbuf,
+                    prebuf_dst, postbuf_dst, xdata);
+    return 0;
+}
+
+int32_t
+fc_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                   off64_t off_in, fd_t *fd_out, off64_t off_out, size_t len,
+                   uint32_t flags, dict_t *xdata)
+{
+    fc_modify_begin(frame, this, fd_out->inode, fd_out, off_out, len);
+
+    STACK_WIND(frame, fc_copy_file_range_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->copy_file_range, fd_in, off_in, fd_out,
+               off_out, len, flags, xdata);
+    return 0;
+}
+
+int32_t
+fc_setattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+               struct iatt *postbuf, dict_t *xdata)
+{
+    fc_modify_cbk(frame, this, op_ret, prebuf, postbuf, 0, 0);
+
+    FC_STACK_UNWIND(setattr, frame, op_ret, op_errno, prebuf, postbuf, xdata);
+    return 0;
+}
+
+int32_t
+fc_setattr(call_frame_t *frame, xlator_t *this, loc_t *loc,
+           struct iatt *stbuf, int32_t valid, dict_t *xdata)
+{
+    /* Keeps the cache across chmod and the like, which change the ctime */
+    if (inode_ctx_get(loc->inode, this, NULL) == 0)
+        fc_modify_begin(frame, this, loc->inode, NULL, 0, 0);
+
+    STACK_WIND(frame, fc_setattr_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->setattr, loc, stbuf, valid, xdata);
+    return 0;
+}
+
+int32_t
+fc_fsetattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                struct iatt *postbuf, dict_t *xdata)
+{
+    fc_modify_cbk(frame, this, op_ret, prebuf, postbuf, 0, 0);
+
+    FC_STACK_UNWIND(fsetattr, frame, op_ret, op_errno, prebuf, postbuf, xdata);
+    return 0;
+}
+
+int32_t
+fc_fsetattr(call_frame_t *frame, xlator_t *this, fd_t *fd, struct iatt *stbuf,
+            int32_t valid, dict_t *xdata)
+{
+    if (inode_ctx_get(fd->inode, this, NULL) == 0)
+        fc_modify_begin(frame, this, fd->inode, fd, 0, 0);
+
+    STACK_WIND(frame, fc_fsetattr_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->fsetattr, fd, stbuf, valid, xdata);
+    return 0;
+}
+
+int32_t
+fc_lookup_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, inode_t *inode,
+              struct iatt *buf, dict_t *xdata, struct iatt *postparent)
+{
+    fc_inode_t *ctx = NULL;
+
+    if ((op_ret == 0) && inode && IA_ISREG(buf->ia_type)) {
+        ctx = fc_inode_ctx_get(this, inode, _gf_false);
+        if (ctx)
+            fc_inode_validate(this, ctx, buf);
+    }
+
+    STACK_UNWIND_STRICT(lookup, frame, op_ret, op_errno, inode, buf, xdata,
+                        postparent);
+    return 0;
+}
+
+int32_t
+fc_lookup(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
+{
+    STACK_WIND(frame, fc_lookup_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->lookup, loc, xdata);
+    return 0;
+}
+
+int32_t
+fc_open_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
+            int32_t op_errno, fd_t *fd, dict_t *xdata)
+{
+    int32_t flags = (int32_t)(long)cookie;
+
+    /* Also gets the fd released through fc_release */
+    if (op_ret >= 0)
+        fd_ctx_set(fd, this, (flags & O_DIRECT) ? FC_FD_DIRECT : FC_FD_CACHED);
+
+    STACK_UNWIND_STRICT(open, frame, op_ret, op_errno, fd, xdata);
+    return 0;
+}
+
+int32_t
+fc_open(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
+        fd_t *fd, dict_t *xdata)
+{
+    STACK_WIND_COOKIE(frame, fc_open_cbk, (void *)(long)flags,
+                      FIRST_CHILD(this), FIRST_CHILD(this)->fops->open, loc,
+                      flags, fd, xdata);
+    return 0;
+}
+
+int32_t
+fc_create_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, fd_t *fd, inode_t *inode,
+              struct iatt *buf, struct iatt *preparent,
+              struct iatt *postparent, dict_t *xdata)
+{
+    int32_t flags = (int32_t)(long)cookie;
+
+    if (op_ret >= 0)
+        fd_ctx_set(fd, this, (flags & O_DIRECT) ? FC_FD_DIRECT : FC_FD_CACHED);
+
+    STACK_UNWIND_STRICT(create, frame, op_ret, op_errno, fd, inode, buf,
+                        preparent, postparent, xdata);
+    return 0;
+}
+
+int32_t
+fc_create(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
+          mode_t mode, mode_t umask, fd_t *fd, dict_t *xdata)
+{
+    STACK_WIND_COOKIE(frame, fc_create_cbk, (void *)(long)flags,
+                      FIRST_CHILD(this), FIRST_CHILD(this)->fops->create, loc,
+                      flags, mode, umask, fd, xdata);
+    return 0;
+}
+
+static int32_t
+fc_release(xlator_t *this, fd_t *fd)
+{
+    fc_inode_t *ctx = NULL;
+
+    ctx = fc_inode_ctx_get(this, fd->inode, _gf_false);
+    if (!ctx)
+        return 0;
+
+    /* Written back by the prune thread */
+    LOCK(&ctx->lock);
+    {
+        ctx->flush = _gf_true;
+        __fc_store_queue(this, ctx);
+    }
+    UNLOCK(&ctx->lock);
+
+    return 0;
+}
+
+static int32_t
+fc_forget(xlator_t *this, inode_t *inode)
+{
+    fc_conf_t *conf = this->private;
+    fc_inode_t *ctx = NULL;
+    uint64_t value = 0;
+
+    inode_ctx_del(inode, this, &value);
+    ctx = (fc_inode_t *)(uintptr_t)value;
+    if (!ctx)
+        return 0;
+
+    /* Freed by the prune thread once the index is written back */
+    pthread_mutex_lock(&conf->store_lock);
+    {
+        list_add_tail(&ctx->store, &conf->forgotten);
+        LOCK(&ctx->lock);
+        {
+            ctx->forgotten = _gf_true;
+            __fc_store_queue(this, ctx);
+        }
+        UNLOCK(&ctx->lock);
+    }
+    pthread_mutex_unlock(&conf->store_lock);
+
+    return 0;
+}
+
+static void
+fc_invalidate(xlator_t *this, struct gf_upcall *up_data)
+{
+    struct gf_upcall_cache_invalidation *up_ci = NULL;
+    inode_table_t *itable = NULL;
+    inode_t *inode = NULL;
+    fc_inode_t *ctx = NULL;
+
+    if (up_data->event_type != GF_UPCALL_CACHE_INVALIDATION)
+        return;
+
+    up_ci = (struct gf_upcall_cache_invalidation *)up_data->data;
+
+    itable = ((xlator_t *)this->graph->top)->itable;
+    if (!itable)
+        return;
+
+    inode = inode_find(itable, up_data->gfid);
+    if (!inode)
+        return;
+
+    ctx = fc_inode_ctx_get(this, inode, _gf_false);
+    if (ctx) {
+        LOCK(&ctx->lock);
+        {
+            /* Written to by another client, or gone */
+            if (up_ci->flags & (UP_WRITE_FLAGS | UP_FORGET))
+                __fc_inode_drop(this, ctx);
+            else if (up_ci->flags & (UP_INVAL_ATTR | IATT_UPDATE_FLAGS))
+                ctx->validated = 0;
+        }
+        UNLOCK(&ctx->lock);
+    }
+
+    inode_unref(inode);
+}
+
+int32_t
+fc_notify(xlator_t *this, int32_t event, void *data, ...)
+{
+    fc_conf_t *conf = this->private;
+
+    if ((event == GF_EVENT_UPCALL) && conf->enabled)
+        fc_invalidate(this, data);
+
+    return default_notify(this, event, data);
+}
+
+static void
+fc_store_walk(xlator_t *this, fc_store_walk_fn fn, void *data)
+{
+    fc_conf_t *conf = this->private;
+    struct fc_index_header hdr;
+    struct dirent *entry = NULL;
+    struct dirent scratch[2] = {
+        {
+            0,
+        },
+    };
+    struct stat st;
+    char path[PATH_MAX];
+    char gfid_str[GF_UUID_BUF_SIZE];
+    uuid_t gfid;
+    DIR *dir = NULL;
+    int fd = -1;
+    int i = 0;
+
+    for (i = 0; i < 256; i++) {
+        snprintf(path, sizeof(path), "%s/%02x", conf->cache_dir, i);
+        dir = sys_opendir(path);
+        if (!dir)
+            continue;
+
+        while ((entry = sys_readdir(dir, scratch)) != NULL) {
+            if ((strlen(entry->d_name) != GF_UUID_BUF_SIZE - 1 + 4) ||
+                strcmp(entry->d_name + GF_UUID_BUF_SIZE - 1, ".idx"))
+                continue;
+
+            snprintf(gfid_str, sizeof(gfid_str), "%.36s", entry->d_name);
+            if (gf_uuid_parse(gfid_str, gfid))
+                continue;
+
+            fd = sys_openat(dirfd(dir), entry->d_name, O_RDONLY, 0);
+            if (fd < 0)
+                continue;
+
+            if (sys_fstat(fd, &st)) {
+                sys_close(fd);
+                continue;
+            }
+
+            /* A broken index still gets pruned, it just weighs nothing */
+            if ((sys_pread(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr)) ||
+                (hdr.magic != FC_INDEX_MAGIC) ||
+                (hdr.version != FC_INDEX_VERSION))
+                memset(&hdr, 0, sizeof(hdr));
+            sys_close(fd);
+
+            fn(this, gfid, &hdr, &st, data);
+        }
+
+        sys_closedir(dir);
+    }
+}
+
+static void
+fc_store_count(xlator_t *this, uuid_t gfid, struct fc_index_header *hdr,
+               struct stat *st, void *data)
+{
+    *(uint64_t *)data += hdr->cached * hdr->block_size;
+}
+
+static void
+fc_store_collect(xlator_t *this, uuid_t gfid, struct fc_index_header *hdr,
+                 struct stat *st, void *data)
+{
+    struct fc_victims *victims = data;
+    fc_victim_t *list = NULL;
+    size_t size = 0;
+
+    if (victims->count == victims->size) {
+        size = victims->size ? victims->size * 2 : 1024;
+        if (victims->list)
+            list = GF_REALLOC(victims->list, size * sizeof(*list));
+        else
+            list = GF_CALLOC(size, sizeof(*list), gf_fc_mt_fc_victim_t);
+        if (!list)
+            return;
+        victims->list = list;
+        victims->size = size;
+    }
+
+    gf_uuid_copy(victims->list[victims->count].gfid, gfid);
+    victims->list[victims->count].mtime = st->st_mtime;
+    victims->list[victims->count].bytes = hdr->cached * hdr->block_size;
+    victims->count++;
+}
+
+static int
+fc_victim_cmp(const void *a, const void *b)
+{
+    const fc_victim_t *va = a;
+    const fc_victim_t *vb = b;
+
+    return (va->mtime > vb->mtime) - (va->mtime < vb->mtime);
+}
+
+static void
+fc_store_evict(xlator_t *this, inode_table_t *itable, fc_victim_t *victim)
+{
+    fc_conf_t *conf = this->private;
+    inode_t *inode = NULL;
+    fc_inode_t *ctx = NULL;
+    char path[PATH_MAX];
+
+    pthread_mutex_lock(&conf->store_lock);
+    {
+        /* Looked up under the lock, so that the files can't be loaded
+         * while they are removed */
+        if (itable)
+            inode = inode_find(itable, victim->gfid);
+        if (inode)
+            ctx = fc_inode_ctx_get(this, inode, _gf_false);
+        if (!ctx)
+            ctx = __fc_forgotten_find(conf, victim->gfid);
+
+        /* Files in use keep their place in the store, only their blocks go */
+        if (ctx) {
+            fc_inode_drop(this, ctx);
+        } else {
+            fc_store_path(conf, victim->gfid, "", path, sizeof(path));
+            sys_unlink(path);
+            fc_store_path(conf, victim->gfid, ".idx", path, sizeof(path));
+            sys_unlink(path);
+            GF_ATOMIC_SUB(conf->used, victim->bytes);
+        }
+    }
+    pthread_mutex_unlock(&conf->store_lock);
+
+    if (inode)
+        inode_unref(inode);
+
+    GF_ATOMIC_INC(conf->evictions);
+}
+
+/* Files whose index was written the longest ago go first */
+static void
+fc_store_prune(xlator_t *this)
+{
+    fc_conf_t *conf = this->private;
+    struct fc_victims victims = {
+        0,
+    };
+    inode_table_t *itable = NULL;
+    uint64_t target = conf->cache_size / 100 * FC_PRUNE_WATERMARK;
+    size_t i = 0;
+
+    if (GF_ATOMIC_GET(conf->used) <= conf->cache_size)
+        return;
+
+    fc_store_walk(this, fc_store_collect, &victims);
+    if (!victims.count)
+        return;
+
+    qsort(victims.list, victims.count, sizeof(*victims.list), fc_victim_cmp);
+
+    itable = ((xlator_t *)this->graph->top)->itable;
+    for (i = 0; (i < victims.count) && (GF_ATOMIC_GET(conf->used) > target);
+         i++)
+        fc_store_evict(this, itable, &victims.list[i]);
+
+    GF_FREE(victims.list);
+}
+
+/* Syncs the @count files of the store written to, @fd being one of them */
+static int
+fc_store_sync(int fd, int count)
+{
+    if (!count)
+        return 0;
+
+    /* A single syncfs is cheaper than a sync per file */
+    if (count > 1)
+        return gf_syncfs(fd);
+
+    return sys_fdatasync(fd);
+}
+
+static gf_boolean_t
+fc_store_writes(fc_inode_t *ctx)
+{
+    return !list_empty(&ctx->filling) ||
+           (ctx->truncating && (ctx->data_fd >= 0));
+}
+
+/* Flags open the indexes of the inodes whose data file is about to be
+ * written to, with one sync for all of them */
+static void
+fc_store_mark(xlator_t *this, struct list_head *batch)
+{
+    fc_inode_t *ctx = NULL;
+    int fd = -1;
+    int count = 0;
+    int ret = 0;
+
+    list_for_each_entry(ctx, batch, batch)
+    {
+        if (ctx->marked || !fc_store_writes(ctx))
+            continue;
+
+        if (fc_index_mark(this, ctx)) {
+            fc_fills_free(this, &ctx->filling);
+            ctx->truncating = _gf_false;
+            continue;
+        }
+        fd = ctx->idx_fd;
+        count++;
+    }
+
+    ret = fc_store_sync(fd, count);
+    if (ret)
+        gf_msg(this->name, GF_LOG_WARNING, errno, FC_MSG_STORE_IO_FAILED,
+               "failed to sync the indexes of the store");
+
+    list_for_each_entry(ctx, batch, batch)
+    {
+        if (ctx->marked || !fc_store_writes(ctx))
+            continue;
+
+        if (ret) {
+            fc_fills_free(this, &ctx->filling);
+            ctx->truncating = _gf_false;
+        } else {
+            ctx->marked = _gf_true;
+        }
+    }
+}
+
+static void
+fc_store_fill(xlator_t *this, struct list_head *batch)
+{
+    fc_inode_t *ctx = NULL;
+    fc_fill_t *fill = NULL;
+    fc_fill_t *tmp = NULL;
+    uint64_t block = 0;
+    ssize_t ret = 0;
+
+    list_for_each_entry(ctx, batch, batch)
+    {
+        if (ctx->truncating && (ctx->data_fd >= 0))
+            sys_ftruncate(ctx->data_fd, 0);
+
+        list_for_each_entry_safe(fill, tmp, &ctx->filling, list)
+        {
+            list_del(&fill->list);
+
+            ret = sys_pwritev(ctx->data_fd, fill->vector, fill->count,
+                              fill->offset);
+            if (ret == (ssize_t)fill->size) {
+                LOCK(&ctx->lock);
+                {
+                    /* Unless the file changed since the data was seen */
+                    for (block = fill->first;
+                         (fill->gen == ctx->gen) && (block <= fill->last);
+                         block++) {
+                        if (__fc_block_set(this, ctx, block))
+                            break;
+                    }
+                }
+                UNLOCK(&ctx->lock);
+            }
+
+            fc_fill_free(this, fill);
+        }
+    }
+}
+
+/* The data reaches the disk before the bitmap, the bitmap before the header
+ * that makes it valid again, each step with one sync for all the indexes
+ * written back */
+static void
+fc_store_flush(xlator_t *this, struct list_head *batch)
+{
+    fc_inode_t *ctx = NULL;
+    uint8_t *bitmap = NULL;
+    ssize_t bytes = 0;
+    int fd = -1;
+    int count = 0;
+
+    list_for_each_entry(ctx, batch, batch)
+    {
+        if (!ctx->flushing)
+            continue;
+
+        LOCK(&ctx->lock);
+        {
+            ctx->flushing = (ctx->idx_fd >= 0) &&
+                            (ctx->dirty || ctx->marked || ctx->used);
+            ctx->rewriting = ctx->dirty || ctx->marked;
+        }
+        UNLOCK(&ctx->lock);
+
+        if (ctx->flushing && ctx->rewriting && (ctx->data_fd >= 0)) {
+            fd = ctx->data_fd;
+            count++;
+        }
+    }
+
+    if (fc_store_sync(fd, count))
+        goto err;
+
+    fd = -1;
+    count = 0;
+    list_for_each_entry(ctx, batch, batch)
+    {
+        if (!ctx->flushing)
+            continue;
+
+        /* Only the prune thread sets blocks, nblocks can't grow meanwhile */
+        bytes = ctx->rewriting ? ctx->nblocks / 8 : 0;
+        if (bytes) {
+            bitmap = GF_MALLOC(bytes, gf_fc_mt_bitmap);
+            if (!bitmap) {
+                ctx->flushing = _gf_false;
+                continue;
+            }
+        }
+
+        LOCK(&ctx->lock);
+        {
+            fc_index_header_fill(this, ctx, &ctx->hdr, 0);
+            if (bytes)
+                memcpy(bitmap, ctx->bitmap, bytes);
+            if (ctx->rewriting)
+                ctx->dirty = _gf_false;
+            ctx->used = _gf_false;
+        }
+        UNLOCK(&ctx->lock);
+
+        if (ctx->rewriting &&
+            ((bytes && (sys_pwrite(ctx->idx_fd, bitmap, bytes,
+                                   sizeof(ctx->hdr)) != bytes)) ||
+             sys_ftruncate(ctx->idx_fd, sizeof(ctx->hdr) + bytes))) {
+            gf_msg(this->name, GF_LOG_WARNING, errno, FC_MSG_STORE_IO_FAILED,
+                   "failed to write the index of %s", uuid_utoa(ctx->gfid));
+            fc_inode_dirty(ctx);
+            ctx->flushing = _gf_false;
+        } else if (ctx->rewriting) {
+            fd = ctx->idx_fd;
+            count++;
+        }
+
+        GF_FREE(bitmap);
+        bitmap = NULL;
+    }
+
+    if (fc_store_sync(fd, count))
+        goto err;
+
+    /* Rewritten even when unchanged, its mtime tells the pruner when the
+     * file was last used */
+    list_for_each_entry(ctx, batch, batch)
+    {
+        if (!ctx->flushing)
+            continue;
+
+        if (sys_pwrite(ctx->idx_fd, &ctx->hdr, sizeof(ctx->hdr), 0) !=
+            sizeof(ctx->hdr)) {
+            gf_msg(this->name, GF_LOG_WARNING, errno, FC_MSG_STORE_IO_FAILED,
+                   "failed to write the index of %s", uuid_utoa(ctx->gfid));
+            fc_inode_dirty(ctx);
+            continue;
+        }
+        ctx->marked = _gf_false;
+    }
+
+    return;
+err:
+    gf_msg(this->name, GF_LOG_WARNING, errno, FC_MSG_STORE_IO_FAILED,
+           "failed to sync the store");
+    list_for_each_entry(ctx, batch, batch)
+    {
+        if (ctx->flushing && ctx->rewriting)
+            fc_inode_dirty(ctx);
+    }
+}
+
+/* A forgotten inode goes once its index is written back, unless it was
+ * looked up or queued again meanwhile */
+static void
+fc_store_release(xlator_t *this, fc_inode_t *ctx)
+{
+    fc_conf_t *conf = this->private;
+    gf_boolean_t release = _gf_false;
+
+    pthread_mutex_lock(&conf->store_lock);
+    {
+        LOCK(&ctx->lock);
+        {
+            pthread_mutex_lock(&conf->prune_lock);
+            {
+                release = ctx->forgotten && list_empty(&ctx->work);
+            }
+            pthread_mutex_unlock(&conf->prune_lock);
+
+            if (release)
+                list_del_init(&ctx->store);
+        }
+        UNLOCK(&ctx->lock);
+    }
+    pthread_mutex_unlock(&conf->store_lock);
+
+    if (release)
+        fc_inode_ctx_free(ctx);
+}
+
+/* Does what the fops queued on the inodes, see flash-cache.h */
+static void
+fc_store_work(xlator_t *this)
+{
+    fc_conf_t *conf = this->private;
+    struct list_head queue;
+    struct list_head batch;
+    fc_inode_t *ctx = NULL;
+    fc_inode_t *tmp = NULL;
+
+    INIT_LIST_HEAD(&queue);
+    INIT_LIST_HEAD(&batch);
+
+    pthread_mutex_lock(&conf->prune_lock);
+    {
+        list_splice_init(&conf->work, &queue);
+    }
+    pthread_mutex_unlock(&conf->prune_lock);
+
+    list_for_each_entry_safe(ctx, tmp, &queue, work)
+    {
+        LOCK(&ctx->lock);
+        {
+            /* Anything queued from now on is for the next batch */
+            pthread_mutex_lock(&conf->prune_lock);
+            {
+                list_del_init(&ctx->work);
+            }
+            pthread_mutex_unlock(&conf->prune_lock);
+
+            list_splice_init(&ctx->fills, &ctx->filling);
+            ctx->truncating = ctx->truncate;
+            ctx->flushing = ctx->flush || ctx->forgotten;
+            ctx->truncate = _gf_false;
+            ctx->flush = _gf_false;
+        }
+        UNLOCK(&ctx->lock);
+
+        list_add_tail(&ctx->batch, &batch);
+    }
+
+    fc_store_mark(this, &batch);
+    fc_store_fill(this, &batch);
+    fc_store_flush(this, &batch);
+
+    list_for_each_entry_safe(ctx, tmp, &batch, batch)
+    {
+        list_del_init(&ctx->batch);
+        fc_store_release(this, ctx);
+    }
+}
+
+static void *
+fc_prune_thread(void *data)
+{
+    xlator_t *this = data;
+    fc_conf_t *conf = this->private;
+
+    THIS = this;
+
+    pthread_mutex_lock(&conf->prune_lock);
+    while (!conf->fini) {
+        if (list_empty(&conf->work) && !conf->prune_wanted) {
+            pthread_cond_wait(&conf->prune_cond, &conf->prune_lock);
+            continue;
+        }
+        conf->prune_wanted = _gf_false;
+        pthread_mutex_unlock(&conf->prune_lock);
+
+        /* The queue goes first, the blocks it sets count for the pruning */
+        fc_store_work(this);
+        fc_store_prune(this);
+
+        pthread_mutex_lock(&conf->prune_lock);
+    }
+    pthread_mutex_unlock(&conf->prune_lock);
+
+    return NULL;
+}
+
+static int
+fc_store_init(xlator_t *this)
+{
+    fc_conf_t *conf = this->private;
+    uint64_t used = 0;
+
+    if (sys_mkdir(conf->cache_dir, 0700) && (errno != EEXIST)) {
+        gf_msg(this->name, GF_LOG_ERROR, errno, FC_MSG_STORE_INIT_FAILED,
+               "failed to create %s, caching disabled", conf->cache_dir);
+        return -1;
+    }
+
+    if (sys_access(conf->cache_dir, R_OK | W_OK | X_OK)) {
+        gf_msg(this->name, GF_LOG_ERROR, errno, FC_MSG_STORE_INIT_FAILED,
+               "%s is not usable, caching disabled", conf->cache_dir);
+        return -1;
+    }
+
+    fc_store_walk(this, fc_store_count, &used);
+    GF_ATOMIC_ADD(conf->used, used);
+
+    if (gf_thread_create(&conf->prune_thread, NULL, fc_prune_thread, this,
+                         "fcprune")) {
+        gf_msg(this->name, GF_LOG_ERROR, errno, FC_MSG_THREAD_FAILED,
+               "failed to start the prune thread, caching disabled");
+        return -1;
+    }
+    conf->prune_running = _gf_true;
+
+    if (used > conf->cache_size)
+        fc_prune_wake(this);
+
+    return 0;
+}
+
+static int
+fc_write_policy_get(xlator_t *this, const char *name,
+                    fc_write_policy_t *policy)
+{
+    if (!strcmp(name, "write-through"))
+        *policy = FC_WRITE_THROUGH;
+    else if (!strcmp(name, "write-around"))
+        *policy = FC_WRITE_AROUND;
+    else
+        return -1;
+
+    return 0;
+}
+
+static int32_t
+fc_inodectx(xlator_t *this, inode_t *inode)
+{
+    fc_inode_t *ctx = NULL;
+    char key_prefix[GF_DUMP_MAX_BUF_LEN];
+
+    ctx = fc_inode_ctx_get(this, inode, _gf_false);
+    if (!ctx)
+        return 0;
+
+    gf_proc_dump_build_key(key_prefix, "xlator.performance.flash-cache",
+                           "fc_inode");
+    gf_proc_dump_add_section("%s", key_prefix);
+
+    LOCK(&ctx->lock);
+    {
+        gf_proc_dump_write("gfid", "%s", uuid_utoa(inode->gfid));
+        gf_proc_dump_write("cached_blocks", "%" PRIu64, ctx->cached);
+        gf_proc_dump_write("size", "%" PRIu64, ctx->valid.size);
+        gf_proc_dump_write("dirty", "%d", ctx->dirty);
+    }
+    UNLOCK(&ctx->lock);
+
+    return 0;
+}
+
+static int32_t
+fc_priv_dump(xlator_t *this)
+{
+    fc_conf_t *conf = this->private;
+    char key_prefix[GF_DUMP_MAX_BUF_LEN];
+
+    snprintf(key_prefix, GF_DUMP_MAX_BUF_LEN, "%s.%s", this->type, this->name);
+    gf_proc_dump_add_section("%s", key_prefix);
+
+    gf_proc_dump_write("cache_dir", "%s", conf->enabled ? conf->cache_dir : "");
+    gf_proc_dump_write("cache_limit", "%" PRIu64, conf->cache_size);
+    gf_proc_dump_write("consumed_cache_size", "%" PRId64,
+                       GF_ATOMIC_GET(conf->used));
+    gf_proc_dump_write("block_size", "%" PRIu64, conf->block_size);
+    gf_proc_dump_write("pending_size", "%" PRId64,
+                       GF_ATOMIC_GET(conf->pending));
+    gf_proc_dump_write("write_policy", "%s",
+                       (conf->write_policy == FC_WRITE_THROUGH)
+                           ? "write-through"
+                           : "write-around");
+    gf_proc_dump_write("hit_count", "%" PRId64, GF_ATOMIC_GET(conf->hits));
+    gf_proc_dump_write("miss_count", "%" PRId64, GF_ATOMIC_GET(conf->misses));
+    gf_proc_dump_write("invalidations", "%" PRId64,
+                       GF_ATOMIC_GET(conf->invalidations));
+    gf_proc_dump_write("evictions", "%" PRId64,
+                       GF_ATOMIC_GET(conf->evictions));
+
+    return 0;
+}
+
+int32_t
+fc_mem_acct_init(xlator_t *this)
+{
+    return xlator_mem_acct_init(this, gf_fc_mt_end);
+}
+
+int32_t
+fc_reconfigure(xlator_t *this, dict_t *options)
+{
+    fc_conf_t *conf = this->private;
+    char *write_policy = NULL;
+
+    GF_OPTION_RECONF("flash-cache-size", conf->cache_size, options,
+                     size_uint64, out);
+    GF_OPTION_RECONF("flash-cache-timeout", conf->cache_timeout, options, time,
+                     out);
+    GF_OPTION_RECONF("flash-cache-write-policy", write_policy, options, str,
+                     out);
+    fc_write_policy_get(this, write_policy, &conf->write_policy);
+    GF_OPTION_RECONF("pass-through", this->pass_through, options, bool, out);
+
+    /* The store itself only changes on the next mount */
+    if (!conf->enabled)
+        this->pass_through = _gf_true;
+    else if (GF_ATOMIC_GET(conf->used) > conf->cache_size)
+        fc_prune_wake(this);
+
+out:
+    return 0;
+}
+
+int32_t
+fc_init(xlator_t *this)
+{
+    fc_conf_t *conf = NULL;
+    char *write_policy = NULL;
+    int ret = -1;
+
+    if (!this->children || this->children->next) {
+        gf_msg(this->name, GF_LOG_ERROR, 0, FC_MSG_INVALID_CONFIG,
+               "FATAL: flash-cache not configured with exactly one child");
+        goto out;
+    }
+
+    conf = GF_CALLOC(1, sizeof(*conf), gf_fc_mt_fc_conf_t);
+    if (!conf)
+        goto out;
+
+    GF_OPTION_INIT("flash-cache-dir", conf->cache_dir, path, out);
+    GF_OPTION_INIT("flash-cache-size", conf->cache_size, size_uint64, out);
+    GF_OPTION_INIT("flash-cache-block-size", conf->block_size, size_uint64,
+                   out);
+    GF_OPTION_INIT("flash-cache-write-policy", write_policy, str, out);
+    GF_OPTION_INIT("flash-cache-timeout", conf->cache_timeout, time, out);
+    GF_OPTION_INIT("pass-through", this->pass_through, bool, out);
+
+    if (fc_write_policy_get(this, write_policy, &conf->write_policy))
+        goto out;
+
+    if (conf->block_size % (4 * GF_UNIT_KB)) {
+        gf_msg(this->name, GF_LOG_ERROR, 0, FC_MSG_INVALID_CONFIG,
+               "flash-cache-block-size must be a multiple of 4KB");
+        goto out;
+    }
+
+    pthread_mutex_init(&conf->store_lock, NULL);
+    pthread_mutex_init(&conf->prune_lock, NULL);
+    pthread_cond_init(&conf->prune_cond, NULL);
+    INIT_LIST_HEAD(&conf->forgotten);
+    INIT_LIST_HEAD(&conf->work);
+    GF_ATOMIC_INIT(conf->used, 0);
+    GF_ATOMIC_INIT(conf->pending, 0);
+    GF_ATOMIC_INIT(conf->hits, 0);
+    GF_ATOMIC_INIT(conf->misses, 0);
+    GF_ATOMIC_INIT(conf->invalidations, 0);
+    GF_ATOMIC_INIT(conf->evictions, 0);
+
+    this->private = conf;
+
+    /* Without a usable store every fop just goes through */
+    if (conf->cache_dir && !fc_store_init(this))
+        conf->enabled = _gf_true;
+    if (!conf->enabled)
+        this->pass_through = _gf_true;
+
+    ret = 0;
+out:
+    if (ret < 0) {
+        GF_FREE(conf);
+        this->private = NULL;
+    }
+
+    return ret;
+}
+
+void
+fc_fini(xlator_t *this)
+{
+    fc_conf_t *conf = this->private;
+
+    if (!conf)
+        return;
+
+    if (conf->prune_running) {
+        pthread_mutex_lock(&conf->prune_lock);
+        {
+            conf->fini = _gf_true;
+            pthread_cond_signal(&conf->prune_cond);
+        }
+        pthread_mutex_unlock(&conf->prune_lock);
+        pthread_join(conf->prune_thread, NULL);
+
+        /* What was queued after the thread stopped */
+        while (!list_empty(&conf->work))
+            fc_store_work(this);
+    }
+
+    pthread_cond_destroy(&conf->prune_cond);
+    pthread_mutex_destroy(&conf->prune_lock);
+    pthread_mutex_destroy(&conf->store_lock);
+    GF_FREE(conf);
+    this->private = NULL;
+}
+
+struct xlator_fops fc_fops = {
+    .lookup = fc_lookup,
+    .open = fc_open,
+    .create = fc_create,
+    .readv = fc_readv,
+    .writev = fc_writev,
+    .truncate = fc_truncate,
+    .ftruncate = fc_ftruncate,
+    .fallocate = fc_fallocate,
+    .discard = fc_discard,
+    .zerofill = fc_zerofill,
+    .copy_file_range = fc_copy_file_range,
+    .setattr = fc_setattr,
+    .fsetattr = fc_fsetattr,
+};
+
+struct xlator_cbks fc_cbks = {
+    .forget = fc_forget,
+    .release = fc_release,
+};
+
+struct xlator_dumpops fc_dumpops = {
+    .inodectx = fc_inodectx,
+    .priv = fc_priv_dump,
+};
+
+struct volume_options fc_options[] = {
+    {
+        .key = {"flash-cache"},
+        .type = GF_OPTION_TYPE_BOOL,
+        .default_value = "off",
+        .description = "enable/disable flash-cache",
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_SETTABLE,
+    },
+    {
+        .key = {"flash-cache-dir"},
+        .type = GF_OPTION_TYPE_PATH,
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+        .description = "Directory on a local disk of the client holding the "
+                       "cached data. It is kept across mounts, a change "
+                       "takes effect on the next mount. Nothing is cached "
+                       "when not set.",
+    },
+    {
+        .key = {"flash-cache-size"},
+        .type = GF_OPTION_TYPE_SIZET,
+        .min = 1 * GF_UNIT_MB,
+        .default_value = "10GB",
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+        .description = "Size of the data kept in flash-cache-dir, the files "
+                       "used the longest ago are removed past it",
+    },
+    {
+        .key = {"flash-cache-block-size"},
+        .type = GF_OPTION_TYPE_SIZET,
+        .min = 4 * GF_UNIT_KB,
+        .max = 16 * GF_UNIT_MB,
+        .default_value = "128KB",
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+        .description = "Unit in which data is read from the volume and "
+                       "cached, a multiple of 4KB. The data cached with "
+                       "another block size is dropped.",
+    },
+    {
+        .key = {"flash-cache-write-policy"},
+        .type = GF_OPTION_TYPE_STR,
+        .value = {"write-around", "write-through"},
+        .default_value = "write-around",
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+        .description = "write-around drops the blocks a write goes to, "
+                       "write-through updates them with the data written.",
+    },
+    {
+        .key = {"flash-cache-timeout"},
+        .type = GF_OPTION_TYPE_TIME,
+        .min = 0,
+        .max = 600,
+        .default_value = "1",
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+        .description = "Time after which the size, mtime and ctime of a file "
+                       "are checked again before its cached data is used. "
+                       "With features.cache-invalidation on, changes made "
+                       "by other clients are also seen right away.",
+    },
+    {.key = {"pass-through"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "false",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
+     .tags = {"flash-cache"},
+     .description = "Enable/Disable flash cache translator"},
+
+    {.key = {NULL}},
+};
+
+xlator_api_t xlator_api = {
+    .init = fc_init,
+    .fini = fc_fini,
+    .notify = fc_notify,
+    .reconfigure = fc_reconfigure,
+    .mem_acct_init = fc_mem_acct_init,
+    .op_version = {GD_OP_VERSION_10_0},
+    .dumpops = &fc_dumpops,
+    .fops = &fc_fops,
+    .cbks = &fc_cbks,
+    .options = fc_options,
+    .identifier = "flash-cache",
+    .category = GF_TECH_PREVIEW,
+};
@@ -0,0 +1,171 @@
+/*
+ *   Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+ *   This file is part of GlusterFS.
+ *
+ *   This file is licensed to you under your choice of the GNU Lesser
+ *   General Public License, version 3 or any later version (LGPLv3 or
+ *   later), or the GNU General Public License, version 2 (GPLv2), in all
+ *   cases as published by the Free Software Foundation.
+ */
+
+#ifndef __FLASH_CACHE_H__
+#define __FLASH_CACHE_H__
+
+#include <glusterfs/glusterfs.h>
+#include <glusterfs/xlator.h>
+#include <glusterfs/locking.h>
+#include <glusterfs/atomic.h>
+#include "flash-cache-mem-types.h"
+#include "flash-cache-messages.h"
+
+/*
+ * flash-cache keeps the data of the files read through the mount in a
+ * directory on a local disk, so that it survives remounts.
+ *
+ * The data of a file lives in <cache-dir>/<gfid[0:2]>/<gfid>, at the same
+ * offsets as in the file, and <gfid>.idx next to it holds a header and a
+ * bitmap of the blocks of the data file that can be trusted. The header
+ * records the size, mtime and ctime of the file when the blocks were read,
+ * the cache of the file is dropped as soon as the file is seen with any
+ * other.
+ *
+ * The index is flagged FC_INDEX_OPEN, and synced, before the data file is
+ * touched, and only written back clean when the fd is released or the
+ * inode forgotten. An index found open on load, after a crash, is thrown
+ * away.
+ *
+ * The fops never touch the store themselves: the data to cache, the
+ * truncations and the index write backs are queued on the inode and done
+ * by the prune thread, which batches the syncs of all the inodes it finds
+ * in the queue.
+ */
+
+#define FC_INDEX_MAGIC 0x63666667 /* "gffc" */
+#define FC_INDEX_VERSION 1
+#define FC_INDEX_OPEN 0x1
+
+/* Pruning stops once the cache is back to this percentage of cache-size */
+#define FC_PRUNE_WATERMARK 90
+
+/* Nothing more is cached while this much data waits to be written */
+#define FC_PENDING_MAX (64 * GF_UNIT_MB)
+
+#define FC_FD_CACHED 1
+#define FC_FD_DIRECT 2
+
+typedef enum {
+    FC_WRITE_AROUND,
+    FC_WRITE_THROUGH,
+} fc_write_policy_t;
+
+/* In host byte order, the store is never shared between machines */
+struct fc_index_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t flags;
+    uint32_t block_size;
+    uint64_t nblocks; /* bits in the bitmap that follows */
+    uint64_t cached;  /* bits set */
+    uint64_t size;
+    int64_t mtime;
+    int64_t ctime;
+    uint32_t mtime_nsec;
+    uint32_t ctime_nsec;
+};
+
+typedef struct {
+    uint64_t size;
+    int64_t mtime;
+    int64_t ctime;
+    uint32_t mtime_nsec;
+    uint32_t ctime_nsec;
+} fc_validator_t;
+
+typedef struct {
+    struct list_head list;
+    uint64_t gen;   /* of the inode when the data was seen */
+    uint64_t first; /* blocks valid once the data is written */
+    uint64_t last;
+    off_t offset;
+    struct iovec *vector;
+    int count;
+    size_t size;
+    struct iobref *iobref;
+} fc_fill_t;
+
+typedef struct {
+    gf_lock_t lock;
+    uuid_t gfid;
+    int data_fd;
+    int idx_fd;
+    uint8_t *bitmap;
+    uint64_t nblocks;
+    uint64_t cached;
+    uint64_t gen; /* bumped whenever blocks being read may go stale */
+    fc_validator_t valid;
+    struct iatt stat; /* returned by the reads served from the cache */
+    time_t validated;
+    gf_boolean_t has_valid;
+    gf_boolean_t dirty;     /* the index on disk is out of date */
+    gf_boolean_t used;      /* read from since the index was written */
+    gf_boolean_t truncate;  /* the data file is to be emptied */
+    gf_boolean_t flush;     /* the index is to be written back */
+    gf_boolean_t forgotten; /* in conf->forgotten, freed once flushed */
+    struct list_head fills; /* fc_fill_t waiting for the prune thread */
+    struct list_head work;  /* in conf->work, under conf->prune_lock */
+    struct list_head store; /* in conf->forgotten, under conf->store_lock */
+    /* Only touched by the prune thread */
+    struct list_head batch;
+    struct list_head filling;
+    gf_boolean_t truncating;
+    gf_boolean_t flushing;
+    gf_boolean_t rewriting; /* the bitmap is written back too */
+    gf_boolean_t marked;    /* the index on disk is flagged FC_INDEX_OPEN */
+    struct fc_index_header hdr;
+} fc_inode_t;
+
+typedef struct {
+    char *cache_dir;
+    uint64_t cache_size;
+    uint64_t block_size;
+    fc_write_policy_t write_policy;
+    uint32_t cache_timeout;
+    gf_boolean_t enabled;
+    /* serializes loading the index of a file against the pruner removing
+     * it */
+    pthread_mutex_t store_lock;
+    /* inodes forgotten with a write back still queued, they are taken
+     * back if looked up again before it is done */
+    struct list_head forgotten;
+    /* protects the queue of the prune thread, taken under ctx->lock */
+    pthread_mutex_t prune_lock;
+    pthread_cond_t prune_cond;
+    struct list_head work;
+    pthread_t prune_thread;
+    gf_boolean_t prune_running;
+    gf_boolean_t prune_wanted;
+    gf_boolean_t fini;
+    gf_atomic_t used;
+    gf_atomic_t pending; /* bytes queued in fc_fill_t */
+    gf_atomic_t hits;
+    gf_atomic_t misses;
+    gf_atomic_t invalidations;
+    gf_atomic_t evictions;
+} fc_conf_t;
+
+typedef struct {
+    fc_inode_t *ctx;
+    fd_t *fd;
+    off_t offset;
+    size_t size;
+    uint32_t flags;
+    uint64_t first; /* block the read sent to the child starts at */
+    uint64_t gen;
+    gf_boolean_t uncached;
+    struct iovec *vector;
+    int count;
+    struct iobref *iobref;
+    dict_t *xdata;
+} fc_local_t;
+
+#endif /* __FLASH_CACHE_H__ */
@@ -992,10 +992,20 @@ ioc_dispatch_requests(call_frame_t *frame, ioc_inode_t *ioc_inode, fd_t *fd,
             local_offset = max(trav_offset, offset);
             trav_size = min(((offset + size) - local_offset), table->page_size);
 
-            if (!trav) {
+            if (trav) {
+                ioc_inode->hits++;
+                if (trav->policy.queue != IOC_QUEUE_NONE) {
+                    pthread_mutex_lock(&table->policy_lock);
+                    {
+                        ioc_policy_access(&table->policy, &trav->policy);
+                    }
+                    pthread_mutex_unlock(&table->policy_lock);
+                }
+            } else {
                 /* page not in cache, we need to generate page
                  * fault
                  */
+                ioc_inode->misses++;
                 trav = __ioc_page_create(ioc_inode, trav_offset);
                 fault = 1;
                 if (!trav) {
@@ -1663,6 +1673,8 @@ reconfigure(xlator_t *this, dict_t *options)
     ioc_table_t *table = NULL;
     int ret = -1;
     uint64_t cache_size_new = 0;
+    char *policy = NULL;
+    ioc_policy_type_t policy_type = IOC_POLICY_LRU;
     if (!this || !this->private)
         goto out;
 
@@ -1715,7 +1727,18 @@ reconfigure(xlator_t *this, dict_t *options)
         }
         table->cache_size = cache_size_new;
 
-        ret = 0;
+        GF_OPTION_RECONF("cache-policy", policy, options, str, unlock);
+        if (ioc_policy_type_get(policy, &policy_type)) {
+            ret = -1;
+            goto unlock;
+        }
+
+        pthread_mutex_lock(&table->policy_lock);
+        {
+            ret = ioc_policy_reconf(&table->policy, policy_type,
+                                    table->cache_size / table->page_size);
+        }
+        pthread_mutex_unlock(&table->policy_lock);
     }
 unlock:
     ioc_table_unlock(table);
@@ -1738,6 +1761,8 @@ init(xlator_t *this)
     glusterfs_ctx_t *ctx = NULL;
     data_t *data = 0;
     uint32_t num_pages = 0;
+    char *policy = NULL;
+    ioc_policy_type_t policy_type = IOC_POLICY_LRU;
 
     xl_options = this->options;
 
@@ -1771,6 +1796,12 @@ init(xlator_t *this)
 
     GF_OPTION_INIT("max-file-size", table->max_file_size, size_uint64, out);
 
+    GF_OPTION_INIT("cache-policy", policy, str, out);
+    if (ioc_policy_type_get(policy, &policy_type)) {
+        ret = -1;
+        goto out;
+    }
+
     if (!check_cache_size_ok(this, table->cache_size)) {
         ret = -1;
         goto out;
@@ -1832,6 +1863,12 @@ init(xlator_t *this)
         goto out;
     }
 
+    pthread_mutex_init(&table->policy_lock, NULL);
+    if (ioc_policy_init(&table->policy, policy_type, num_pages)) {
+        ret = -1;
+        goto out;
+    }
+
     ret = 0;
 
     ctx = this->ctx;
@@ -2004,6 +2041,8 @@ ioc_inode_dump(xlator_t *this, inode_t *inode)
         __inode_path(ioc_inode->inode, NULL, &path);
 
         gf_proc_dump_write("inode.weight", "%d", ioc_inode->weight);
+        gf_proc_dump_write("inode.hits", "%" PRIu64, ioc_inode->hits);
+        gf_proc_dump_write("inode.misses", "%" PRIu64, ioc_inode->misses);
 
         if (path) {
             gf_proc_dump_write("path", "%s", path);
@@ -2059,6 +2098,20 @@ ioc_priv_dump(xlator_t *this)
         gf_proc_dump_write("cache_timeout", "%u", priv->cache_timeout);
         gf_proc_dump_write("min-file-size", "%" PRIu64, priv->min_file_size);
         gf_proc_dump_write("max-file-size", "%" PRIu64, priv->max_file_size);
+
+        pthread_mutex_lock(&priv->policy_lock);
+        {
+            gf_proc_dump_write("cache-policy", "%s",
+                               ioc_policy_type_name(priv->policy.type));
+            gf_proc_dump_write("a1in_pages", "%" PRIu64,
+                               priv->policy.a1in_count);
+            gf_proc_dump_write("am_pages", "%" PRIu64, priv->policy.am_count);
+            gf_proc_dump_write("ghost_pages", "%" PRIu64,
+                               priv->policy.ghost_count);
+            gf_proc_dump_write("ghost_hits", "%" PRIu64,
+                               priv->policy.ghost_hits);
+        }
+        pthread_mutex_unlock(&priv->policy_lock);
     }
     pthread_mutex_unlock(&priv->table_lock);
 out:
@@ -2121,6 +2174,8 @@ fini(xlator_t *this)
 
     GF_ASSERT (list_empty (&table->inodes));
     */
+    ioc_policy_fini(&table->policy);
+    pthread_mutex_destroy(&table->policy_lock);
     pthread_mutex_destroy(&table->table_lock);
     GF_FREE(table);
 
@@ -2213,6 +2268,18 @@ struct volume_options options[] = {
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
      .tags = {"io-cache"},
      .description = "Enable/Disable io cache translator"},
+    {.key = {"cache-policy"},
+     .type = GF_OPTION_TYPE_STR,
+     .value = {"lru", "2q"},
+     .default_value = "lru",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
+     .tags = {"io-cache"},
+     .description = "Page replacement policy. 'lru' evicts the pages of the "
+                    "least recently read files first. '2q' keeps pages read "
+                    "only once in a separate queue holding a quarter of the "
+                    "cache, so that a large sequential scan does not evict "
+                    "the pages that are read repeatedly."},
     {.key = {NULL}},
 };
 
@@ -21,6 +21,7 @@
 #include <sys/time.h>
 #include <fnmatch.h>
 #include "io-cache-messages.h"
+#include "ioc-policy.h"
 
 #define IOC_PAGE_SIZE (1024 * 128) /* 128KB */
 #define IOC_CACHE_SIZE (32 * 1024 * 1024)
@@ -101,6 +102,7 @@ struct ioc_page {
     struct list_head page_lru;
     struct ioc_inode *inode; /* inode this page belongs to */
     struct ioc_priority *priority;
+    struct ioc_policy_entry policy; /* queued by the replacement policy */
     char dirty;
     char ready;
     struct iovec *vector;
@@ -142,6 +144,8 @@ struct ioc_inode {
                       * on each read
                       */
     inode_t *inode;
+    uint64_t hits;   /* pages read from the cache */
+    uint64_t misses; /* pages read from the children */
 };
 
 struct ioc_table {
@@ -161,6 +165,8 @@ struct ioc_table {
     int32_t cache_timeout;
     int32_t max_pri;
     struct mem_pool *mem_pool;
+    struct ioc_policy policy;
+    pthread_mutex_t policy_lock; /* taken after the inode locks */
 };
 
 typedef struct ioc_table ioc_table_t;
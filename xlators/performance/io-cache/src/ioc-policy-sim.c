@@ -0,0 +1,275 @@
+/*
+ *   Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+ *   This file is part of GlusterFS.
+ *
+ *   This file is licensed to you under your choice of the GNU Lesser
+ *   General Public License, version 3 or any later version (LGPLv3 or
+ *   later), or the GNU General Public License, version 2 (GPLv2), in all
+ *   cases as published by the Free Software Foundation.
+ */
+
+/*
+ * Replays a trace of reads through the page replacement policies of
+ * io-cache and prints the hit ratio of each of them.
+ *
+ * Every line of the trace is a read: "<file> <offset> <size>", where <file>
+ * is any word identifying the file, a gfid or a path for instance. Lines
+ * starting with '#' are ignored.
+ *
+ * 'lru' here is a single lru of pages. io-cache orders inodes rather than
+ * pages in lru mode, which behaves the same for a scan through a large file.
+ *
+ * Build with "make ioc-policy-sim" in this directory.
+ */
+
+#include <stdio.h>
+#include <getopt.h>
+#include <glusterfs/common-utils.h>
+#include <glusterfs/hashfn.h>
+#include "ioc-policy.h"
+
+#define SIM_BUCKETS 65536
+
+struct sim_page {
+    struct ioc_policy_entry policy;
+    struct sim_page *next; /* in the bucket */
+    uuid_t gfid;
+    off_t offset;
+};
+
+struct sim_read {
+    uuid_t gfid;
+    off_t offset;
+    size_t size;
+};
+
+struct sim_result {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t ghost_hits;
+};
+
+static struct sim_page **
+sim_bucket(struct sim_page **buckets, uuid_t gfid, off_t offset)
+{
+    uint32_t key = 0;
+
+    memcpy(&key, gfid, sizeof(key));
+    key ^= (uint32_t)(offset * 2654435761U);
+
+    return &buckets[key % SIM_BUCKETS];
+}
+
+static void
+sim_page_evict(struct ioc_policy *policy, struct sim_page **buckets)
+{
+    struct ioc_policy_entry *entry = NULL;
+    struct sim_page *page = NULL;
+    struct sim_page **trav = NULL;
+
+    entry = ioc_policy_victim(policy);
+    page = list_entry(entry, struct sim_page, policy);
+    ioc_policy_evict(policy, entry, page->gfid, page->offset);
+
+    for (trav = sim_bucket(buckets, page->gfid, page->offset); *trav;
+         trav = &(*trav)->next) {
+        if (*trav == page) {
+            *trav = page->next;
+            break;
+        }
+    }
+    free(page);
+}
+
+static int
+sim_run(ioc_policy_type_t type, struct sim_read *reads, uint64_t count,
+        uint64_t pages, uint64_t page_size, struct sim_result *result)
+{
+    struct ioc_policy policy;
+    struct sim_page **buckets = NULL;
+    struct sim_page **bucket = NULL;
+    struct sim_page *page = NULL;
+    uint64_t cached = 0;
+    uint64_t i = 0;
+    off_t offset = 0;
+    off_t end = 0;
+
+    buckets = calloc(SIM_BUCKETS, sizeof(*buckets));
+    if (!buckets || ioc_policy_init(&policy, type, pages)) {
+        free(buckets);
+        return -1;
+    }
+
+    memset(result, 0, sizeof(*result));
+    for (i = 0; i < count; i++) {
+        offset = gf_floor(reads[i].offset, page_size);
+        end = reads[i].offset + reads[i].size;
+        for (; offset < end; offset += page_size) {
+            bucket = sim_bucket(buckets, reads[i].gfid, offset);
+            for (page = *bucket; page; page = page->next) {
+                if ((page->offset == offset) &&
+                    !gf_uuid_compare(page->gfid, reads[i].gfid))
+                    break;
+            }
+
+            if (page) {
+                result->hits++;
+                ioc_policy_access(&policy, &page->policy);
+                continue;
+            }
+
+            result->misses++;
+            if (cached == pages) {
+                sim_page_evict(&policy, buckets);
+                cached--;
+            }
+
+            page = calloc(1, sizeof(*page));
+            if (!page)
+                goto out;
+            gf_uuid_copy(page->gfid, reads[i].gfid);
+            page->offset = offset;
+            page->next = *bucket;
+            *bucket = page;
+            ioc_policy_insert(&policy, &page->policy, page->gfid, offset);
+            cached++;
+        }
+    }
+    result->ghost_hits = policy.ghost_hits;
+
+out:
+    while (cached--)
+        sim_page_evict(&policy, buckets);
+    ioc_policy_fini(&policy);
+    free(buckets);
+
+    return 0;
+}
+
+static int
+sim_load(FILE *trace, struct sim_read **readsp, uint64_t *countp)
+{
+    struct sim_read *reads = NULL;
+    struct sim_read *tmp = NULL;
+    uint64_t count = 0;
+    uint64_t size = 0;
+    char line[1024];
+    char file[512];
+    unsigned long long offset = 0;
+    unsigned long long len = 0;
+    uint32_t hash[2] = {
+        0,
+    };
+
+    while (fgets(line, sizeof(line), trace)) {
+        if ((line[0] == '#') ||
+            (sscanf(line, "%511s %llu %llu", file, &offset, &len) != 3))
+            continue;
+
+        if (count == size) {
+            size = size ? size * 2 : 65536;
+            tmp = realloc(reads, size * sizeof(*reads));
+            if (!tmp) {
+                free(reads);
+                return -1;
+            }
+            reads = tmp;
+        }
+
+        /* Any identifier will do as long as it maps to a single gfid */
+        memset(reads[count].gfid, 0, sizeof(uuid_t));
+        if (gf_uuid_parse(file, reads[count].gfid)) {
+            hash[0] = gf_dm_hashfn(file, strlen(file));
+            hash[1] = SuperFastHash(file, strlen(file));
+            memcpy(reads[count].gfid, hash, sizeof(hash));
+        }
+        reads[count].offset = offset;
+        reads[count].size = len;
+        count++;
+    }
+
+    *readsp = reads;
+    *countp = count;
+    return 0;
+}
+
+static void
+sim_usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [-c cache-size] [-p page-size] [-P lru|2q] "
+            "[trace]\n",
+            name);
+}
+
+int
+main(int argc, char *argv[])
+{
+    ioc_policy_type_t types[] = {IOC_POLICY_LRU, IOC_POLICY_2Q};
+    int ntypes = sizeof(types) / sizeof(types[0]);
+    struct sim_result result;
+    struct sim_read *reads = NULL;
+    uint64_t count = 0;
+    uint64_t cache_size = 32 * GF_UNIT_MB;
+    uint64_t page_size = 128 * GF_UNIT_KB;
+    FILE *trace = stdin;
+    int opt = 0;
+    int i = 0;
+
+    while ((opt = getopt(argc, argv, "c:p:P:h")) != -1) {
+        switch (opt) {
+            case 'c':
+                if (gf_string2bytesize_uint64(optarg, &cache_size))
+                    goto usage;
+                break;
+            case 'p':
+                if (gf_string2bytesize_uint64(optarg, &page_size) ||
+                    !page_size)
+                    goto usage;
+                break;
+            case 'P':
+                if (ioc_policy_type_get(optarg, &types[0]))
+                    goto usage;
+                ntypes = 1;
+                break;
+            default:
+                goto usage;
+        }
+    }
+
+    if (optind < argc) {
+        trace = fopen(argv[optind], "r");
+        if (!trace) {
+            perror(argv[optind]);
+            return 1;
+        }
+    }
+
+    if (sim_load(trace, &reads, &count)) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    printf("%-6s %12s %12s %12s %8s\n", "policy", "hits", "misses",
+           "ghost-hits", "ratio");
+    for (i = 0; i < ntypes; i++) {
+        if (sim_run(types[i], reads, count, max(cache_size / page_size, 1),
+                    page_size, &result)) {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+        printf("%-6s %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %7.2f%%\n",
+               ioc_policy_type_name(types[i]), result.hits, result.misses,
+               result.ghost_hits,
+               (result.hits + result.misses)
+                   ? 100.0 * result.hits / (result.hits + result.misses)
+                   : 0.0);
+    }
+
+    free(reads);
+    return 0;
+
+usage:
+    sim_usage(argv[0]);
+    return 1;
+}
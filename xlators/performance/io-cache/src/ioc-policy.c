@@ -0,0 +1,260 @@
+/*
+ *   Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+ *   This file is part of GlusterFS.
+ *
+ *   This file is licensed to you under your choice of the GNU Lesser
+ *   General Public License, version 3 or any later version (LGPLv3 or
+ *   later), or the GNU General Public License, version 2 (GPLv2), in all
+ *   cases as published by the Free Software Foundation.
+ */
+
+#include <glusterfs/common-utils.h>
+#include <glusterfs/mem-pool.h>
+#include "ioc-policy.h"
+#include "ioc-mem-types.h"
+
+#define IOC_GHOST_BUCKETS 4096
+
+struct ioc_ghost {
+    struct list_head list; /* in ghosts */
+    struct list_head hash; /* in ghost_hash */
+    uuid_t gfid;
+    off_t offset;
+};
+
+int
+ioc_policy_type_get(const char *name, ioc_policy_type_t *type)
+{
+    if (!strcmp(name, "lru"))
+        *type = IOC_POLICY_LRU;
+    else if (!strcmp(name, "2q"))
+        *type = IOC_POLICY_2Q;
+    else
+        return -1;
+
+    return 0;
+}
+
+const char *
+ioc_policy_type_name(ioc_policy_type_t type)
+{
+    return (type == IOC_POLICY_2Q) ? "2q" : "lru";
+}
+
+static struct list_head *
+ioc_ghost_bucket(struct ioc_policy *policy, uuid_t gfid, off_t offset)
+{
+    uint64_t key = 0;
+
+    memcpy(&key, &gfid[8], sizeof(key));
+    key ^= (uint64_t)offset * 0x9e3779b97f4a7c15ULL;
+    key ^= key >> 29;
+
+    return &policy->ghost_hash[key & (IOC_GHOST_BUCKETS - 1)];
+}
+
+static void
+ioc_ghost_destroy(struct ioc_policy *policy, struct ioc_ghost *ghost)
+{
+    list_del(&ghost->list);
+    list_del(&ghost->hash);
+    policy->ghost_count--;
+    GF_FREE(ghost);
+}
+
+static void
+ioc_ghosts_trim(struct ioc_policy *policy, uint64_t max)
+{
+    struct ioc_ghost *ghost = NULL;
+
+    while (policy->ghost_count > max) {
+        ghost = list_first_entry(&policy->ghosts, struct ioc_ghost, list);
+        ioc_ghost_destroy(policy, ghost);
+    }
+}
+
+/* Forgets the page if it was evicted from a1in recently, returns whether it
+ * was */
+static gf_boolean_t
+ioc_ghost_take(struct ioc_policy *policy, uuid_t gfid, off_t offset)
+{
+    struct list_head *bucket = NULL;
+    struct ioc_ghost *ghost = NULL;
+
+    if (!policy->ghost_count)
+        return _gf_false;
+
+    bucket = ioc_ghost_bucket(policy, gfid, offset);
+    list_for_each_entry(ghost, bucket, hash)
+    {
+        if ((ghost->offset == offset) && !gf_uuid_compare(ghost->gfid, gfid)) {
+            ioc_ghost_destroy(policy, ghost);
+            return _gf_true;
+        }
+    }
+
+    return _gf_false;
+}
+
+static void
+ioc_ghost_add(struct ioc_policy *policy, uuid_t gfid, off_t offset)
+{
+    struct ioc_ghost *ghost = NULL;
+
+    if (!policy->ghost_max)
+        return;
+
+    ioc_ghosts_trim(policy, policy->ghost_max - 1);
+
+    ghost = GF_MALLOC(sizeof(*ghost), gf_ioc_mt_ioc_ghost_t);
+    if (!ghost)
+        return;
+
+    gf_uuid_copy(ghost->gfid, gfid);
+    ghost->offset = offset;
+    list_add_tail(&ghost->list, &policy->ghosts);
+    list_add(&ghost->hash, ioc_ghost_bucket(policy, gfid, offset));
+    policy->ghost_count++;
+}
+
+static void
+ioc_policy_size(struct ioc_policy *policy, uint64_t pages)
+{
+    if (policy->type == IOC_POLICY_2Q) {
+        policy->a1in_max = max(pages / 4, 1);
+        policy->ghost_max = pages / 2;
+    } else {
+        policy->a1in_max = 0;
+        policy->ghost_max = 0;
+    }
+    ioc_ghosts_trim(policy, policy->ghost_max);
+}
+
+int
+ioc_policy_init(struct ioc_policy *policy, ioc_policy_type_t type,
+                uint64_t pages)
+{
+    memset(policy, 0, sizeof(*policy));
+    INIT_LIST_HEAD(&policy->a1in);
+    INIT_LIST_HEAD(&policy->am);
+    INIT_LIST_HEAD(&policy->ghosts);
+
+    return ioc_policy_reconf(policy, type, pages);
+}
+
+int
+ioc_policy_reconf(struct ioc_policy *policy, ioc_policy_type_t type,
+                  uint64_t pages)
+{
+    int i = 0;
+
+    if ((type == IOC_POLICY_2Q) && !policy->ghost_hash) {
+        policy->ghost_hash = GF_MALLOC(
+            IOC_GHOST_BUCKETS * sizeof(struct list_head), gf_ioc_mt_list_head);
+        if (!policy->ghost_hash)
+            return -1;
+        for (i = 0; i < IOC_GHOST_BUCKETS; i++)
+            INIT_LIST_HEAD(&policy->ghost_hash[i]);
+    }
+
+    /* Pages already queued stay where they are, new ones follow the new
+     * policy */
+    policy->type = type;
+    ioc_policy_size(policy, pages);
+
+    return 0;
+}
+
+void
+ioc_policy_fini(struct ioc_policy *policy)
+{
+    ioc_ghosts_trim(policy, 0);
+    GF_FREE(policy->ghost_hash);
+    policy->ghost_hash = NULL;
+}
+
+static void
+ioc_policy_enqueue(struct ioc_policy *policy, struct ioc_policy_entry *entry,
+                   ioc_queue_t queue)
+{
+    entry->queue = queue;
+    if (queue == IOC_QUEUE_A1IN) {
+        list_add_tail(&entry->list, &policy->a1in);
+        policy->a1in_count++;
+    } else {
+        list_add_tail(&entry->list, &policy->am);
+        policy->am_count++;
+    }
+}
+
+/* A page not in the cache is being read */
+void
+ioc_policy_insert(struct ioc_policy *policy, struct ioc_policy_entry *entry,
+                  uuid_t gfid, off_t offset)
+{
+    if ((policy->type == IOC_POLICY_LRU) ||
+        ioc_ghost_take(policy, gfid, offset)) {
+        if (policy->type == IOC_POLICY_2Q)
+            policy->ghost_hits++;
+        ioc_policy_enqueue(policy, entry, IOC_QUEUE_AM);
+    } else {
+        ioc_policy_enqueue(policy, entry, IOC_QUEUE_A1IN);
+    }
+}
+
+/* A page in the cache is read again. Hits in a1in are not counted, a page
+ * read several times in a row during a scan is still read only once. */
+void
+ioc_policy_access(struct ioc_policy *policy, struct ioc_policy_entry *entry)
+{
+    if (entry->queue == IOC_QUEUE_AM)
+        list_move_tail(&entry->list, &policy->am);
+}
+
+struct ioc_policy_entry *
+ioc_policy_victim(struct ioc_policy *policy)
+{
+    if (policy->a1in_count &&
+        ((policy->a1in_count > policy->a1in_max) || !policy->am_count))
+        return list_first_entry(&policy->a1in, struct ioc_policy_entry, list);
+
+    if (policy->am_count)
+        return list_first_entry(&policy->am, struct ioc_policy_entry, list);
+
+    return NULL;
+}
+
+/* The victim can't be evicted right now, try it again last */
+void
+ioc_policy_requeue(struct ioc_policy *policy, struct ioc_policy_entry *entry)
+{
+    if (entry->queue == IOC_QUEUE_A1IN)
+        list_move_tail(&entry->list, &policy->a1in);
+    else if (entry->queue == IOC_QUEUE_AM)
+        list_move_tail(&entry->list, &policy->am);
+}
+
+void
+ioc_policy_remove(struct ioc_policy *policy, struct ioc_policy_entry *entry)
+{
+    if (entry->queue == IOC_QUEUE_A1IN)
+        policy->a1in_count--;
+    else if (entry->queue == IOC_QUEUE_AM)
+        policy->am_count--;
+    else
+        return;
+
+    list_del_init(&entry->list);
+    entry->queue = IOC_QUEUE_NONE;
+}
+
+/* The page is dropped to make room for others */
+void
+ioc_policy_evict(struct ioc_policy *policy, struct ioc_policy_entry *entry,
+                 uuid_t gfid, off_t offset)
+{
+    if (entry->queue == IOC_QUEUE_A1IN)
+        ioc_ghost_add(policy, gfid, offset);
+
+    ioc_policy_remove(policy, entry);
+}
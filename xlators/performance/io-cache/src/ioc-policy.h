@@ -0,0 +1,99 @@
+/*
+ *   Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+ *   This file is part of GlusterFS.
+ *
+ *   This file is licensed to you under your choice of the GNU Lesser
+ *   General Public License, version 3 or any later version (LGPLv3 or
+ *   later), or the GNU General Public License, version 2 (GPLv2), in all
+ *   cases as published by the Free Software Foundation.
+ */
+
+#ifndef __IOC_POLICY_H
+#define __IOC_POLICY_H
+
+#include <glusterfs/glusterfs.h>
+#include <glusterfs/list.h>
+
+/*
+ * Page replacement policies of io-cache, kept free of any locking and of the
+ * rest of the translator so that ioc-policy-sim can replay traces through
+ * the very same code.
+ *
+ * lru: a single list of pages, the least recently read is evicted first.
+ *
+ * 2q:  pages read for the first time go through a fifo (a1in) holding a
+ *      quarter of the cache. Pages evicted from it are remembered, without
+ *      their data, in a ghost list (a1out) as long as half of the cache.
+ *      Only pages read again while in the ghost list get into the main lru
+ *      (am), so a single scan through a large file can't push out pages
+ *      that are read over and over.
+ */
+
+typedef enum {
+    IOC_POLICY_LRU,
+    IOC_POLICY_2Q,
+} ioc_policy_type_t;
+
+typedef enum {
+    IOC_QUEUE_NONE,
+    IOC_QUEUE_A1IN,
+    IOC_QUEUE_AM,
+} ioc_queue_t;
+
+struct ioc_policy_entry {
+    struct list_head list;
+    ioc_queue_t queue;
+};
+
+struct ioc_policy {
+    ioc_policy_type_t type;
+    struct list_head a1in;
+    struct list_head am;
+    struct list_head ghosts; /* a1out, oldest first */
+    struct list_head *ghost_hash;
+    uint64_t a1in_count;
+    uint64_t am_count;
+    uint64_t ghost_count;
+    uint64_t a1in_max;
+    uint64_t ghost_max;
+    uint64_t ghost_hits;
+};
+
+int
+ioc_policy_type_get(const char *name, ioc_policy_type_t *type);
+
+const char *
+ioc_policy_type_name(ioc_policy_type_t type);
+
+int
+ioc_policy_init(struct ioc_policy *policy, ioc_policy_type_t type,
+                uint64_t pages);
+
+int
+ioc_policy_reconf(struct ioc_policy *policy, ioc_policy_type_t type,
+                  uint64_t pages);
+
+void
+ioc_policy_fini(struct ioc_policy *policy);
+
+void
+ioc_policy_insert(struct ioc_policy *policy, struct ioc_policy_entry *entry,
+                  uuid_t gfid, off_t offset);
+
+void
+ioc_policy_access(struct ioc_policy *policy, struct ioc_policy_entry *entry);
+
+struct ioc_policy_entry *
+ioc_policy_victim(struct ioc_policy *policy);
+
+void
+ioc_policy_requeue(struct ioc_policy *policy, struct ioc_policy_entry *entry);
+
+void
+ioc_policy_evict(struct ioc_policy *policy, struct ioc_policy_entry *entry,
+                 uuid_t gfid, off_t offset);
+
+void
+ioc_policy_remove(struct ioc_policy *policy, struct ioc_policy_entry *entry);
+
+#endif /* __IOC_POLICY_H */
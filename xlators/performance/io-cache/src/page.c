@@ -85,6 +85,7 @@ int64_t
 __ioc_page_destroy(ioc_page_t *page)
 {
     int64_t page_size = 0;
+    ioc_table_t *table = NULL;
 
     GF_VALIDATE_OR_GOTO("io-cache", page, out);
 
@@ -100,6 +101,15 @@ __ioc_page_destroy(ioc_page_t *page)
                        sizeof(page->offset));
         list_del(&page->page_lru);
 
+        if (page->policy.queue != IOC_QUEUE_NONE) {
+            table = page->inode->table;
+            pthread_mutex_lock(&table->policy_lock);
+            {
+                ioc_policy_remove(&table->policy, &page->policy);
+            }
+            pthread_mutex_unlock(&table->policy_lock);
+        }
+
         gf_msg_trace(page->inode->table->xl->name, 0,
                      "destroying page = %p, offset = %" PRId64
                      " "
@@ -185,6 +195,71 @@ __ioc_inode_prune(ioc_inode_t *curr, uint64_t *size_pruned,
 out:
     return 0;
 }
+
+/*
+ * __ioc_policy_prune - evict the pages queued by the replacement policy, in
+ *                      the order it chooses.
+ *
+ * assumes the table lock is held
+ */
+static void
+__ioc_policy_prune(ioc_table_t *table, uint64_t *size_pruned,
+                   uint64_t size_to_prune)
+{
+    struct ioc_policy_entry *entry = NULL;
+    ioc_page_t *page = NULL;
+    ioc_inode_t *ioc_inode = NULL;
+    uint64_t tries = 0;
+    int64_t ret = 0;
+
+    pthread_mutex_lock(&table->policy_lock);
+    {
+        tries = table->policy.a1in_count + table->policy.am_count;
+    }
+    pthread_mutex_unlock(&table->policy_lock);
+
+    while ((*size_pruned < size_to_prune) && tries--) {
+        pthread_mutex_lock(&table->policy_lock);
+        entry = ioc_policy_victim(&table->policy);
+        if (!entry) {
+            pthread_mutex_unlock(&table->policy_lock);
+            break;
+        }
+
+        page = list_entry(entry, ioc_page_t, policy);
+        ioc_inode = page->inode;
+
+        /* The inode lock is taken before the policy lock everywhere
+         * else, skip pages of inodes in use rather than wait */
+        if (pthread_mutex_trylock(&ioc_inode->inode_lock)) {
+            ioc_policy_requeue(&table->policy, entry);
+            pthread_mutex_unlock(&table->policy_lock);
+            continue;
+        }
+
+        if (page->waitq) {
+            ioc_policy_requeue(&table->policy, entry);
+            pthread_mutex_unlock(&table->policy_lock);
+            pthread_mutex_unlock(&ioc_inode->inode_lock);
+            continue;
+        }
+
+        ioc_policy_evict(&table->policy, entry, ioc_inode->inode->gfid,
+                         page->offset);
+        pthread_mutex_unlock(&table->policy_lock);
+
+        *size_pruned += page->size;
+        ret = __ioc_page_destroy(page);
+        if (ret != -1)
+            table->cache_used -= ret;
+
+        if (ioc_empty(&ioc_inode->cache))
+            list_del_init(&ioc_inode->inode_lru);
+
+        pthread_mutex_unlock(&ioc_inode->inode_lock);
+    }
+}
+
 /*
  * ioc_prune - prune the cache. we have a limit to the number of pages we
  *             can have in-memory.
@@ -205,8 +280,15 @@ ioc_prune(ioc_table_t *table)
     ioc_table_lock(table);
     {
         size_to_prune = table->cache_used - table->cache_size;
+
+        /* Pages cached before the policy was switched from lru are not
+         * queued, they are pruned per inode below */
+        __ioc_policy_prune(table, &size_pruned, size_to_prune);
+
         /* take out the least recently used inode */
-        for (index = 0; index < table->max_pri; index++) {
+        for (index = 0;
+             (index < table->max_pri) && (size_pruned < size_to_prune);
+             index++) {
             list_for_each_entry_safe(curr, next_ioc_inode,
                                      &table->inode_lru[index], inode_lru)
             {
@@ -275,6 +357,15 @@ __ioc_page_create(ioc_inode_t *ioc_inode, off_t offset)
 
     list_add_tail(&newpage->page_lru, &ioc_inode->cache.page_lru);
 
+    if (table->policy.type != IOC_POLICY_LRU) {
+        pthread_mutex_lock(&table->policy_lock);
+        {
+            ioc_policy_insert(&table->policy, &newpage->policy,
+                              ioc_inode->inode->gfid, rounded_offset);
+        }
+        pthread_mutex_unlock(&table->policy_lock);
+    }
+
     page = newpage;
 
     gf_msg_trace("io-cache", 0, "returning new page %p", page);
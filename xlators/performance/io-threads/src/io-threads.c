@@ -56,14 +56,15 @@ struct volume_options options[];
 iot_client_ctx_t *
 iot_get_ctx(xlator_t *this, client_t *client)
 {
+    iot_conf_t *conf = this->private;
     iot_client_ctx_t *ctx = NULL;
     iot_client_ctx_t *setted_ctx = NULL;
     int i;
 
     if (client_ctx_get(client, this, (void **)&ctx) != 0) {
-        ctx = GF_MALLOC(GF_FOP_PRI_MAX * sizeof(*ctx), gf_iot_mt_client_ctx_t);
+        ctx = GF_MALLOC(conf->ctx_count * sizeof(*ctx), gf_iot_mt_client_ctx_t);
         if (ctx) {
-            for (i = 0; i < GF_FOP_PRI_MAX; ++i) {
+            for (i = 0; i < conf->ctx_count; ++i) {
                 INIT_LIST_HEAD(&ctx[i].clients);
                 INIT_LIST_HEAD(&ctx[i].reqs);
             }
@@ -78,6 +79,66 @@ iot_get_ctx(xlator_t *this, client_t *client)
     return ctx;
 }
 
+static const char *iot_sched_names[] = {
+    [IOT_SCHED_GLOBAL] = "global",
+    [IOT_SCHED_PER_WORKER] = "per-worker",
+    [IOT_SCHED_DEADLINE] = "deadline",
+};
+
+static uint64_t
+iot_now(void)
+{
+    struct timespec now = {
+        0,
+    };
+
+    timespec_now(&now);
+    return TS(now) / 1000;
+}
+
+/* The request with the earliest deadline among the first ones of each
+ * client in the priorities that have a thread left. */
+static call_stub_t *
+__iot_dequeue_earliest(iot_conf_t *conf, int *pri)
+{
+    call_stub_t *stub = NULL;
+    call_stub_t *first = NULL;
+    iot_client_ctx_t *ctx = NULL;
+    iot_client_ctx_t *earliest = NULL;
+    int i = 0;
+
+    for (i = 0; i < GF_FOP_PRI_MAX; i++) {
+        if (conf->ac_iot_count[i] >= conf->ac_iot_limit[i]) {
+            continue;
+        }
+
+        list_for_each_entry(ctx, &conf->clients[i], clients)
+        {
+            first = list_first_entry(&ctx->reqs, call_stub_t, list);
+            if (!stub || first->deadline < stub->deadline) {
+                stub = first;
+                earliest = ctx;
+                *pri = i;
+            }
+        }
+    }
+
+    if (!stub)
+        return NULL;
+
+    list_del_init(&stub->list);
+    if (list_empty(&earliest->reqs)) {
+        list_del_init(&earliest->clients);
+    }
+
+    conf->ac_iot_count[*pri]++;
+    conf->queue_marked[*pri] = _gf_false;
+    conf->queue_size--;
+    conf->queue_sizes[*pri]--;
+
+    return stub;
+}
+
 call_stub_t *
 __iot_dequeue(iot_conf_t *conf, int *pri)
 {
@@ -86,6 +147,9 @@ __iot_dequeue(iot_conf_t *conf, int *pri)
     iot_client_ctx_t *ctx;
 
     *pri = -1;
+    if (conf->scheduler == IOT_SCHED_DEADLINE)
+        return __iot_dequeue_earliest(conf, pri);
+
     for (i = 0; i < GF_FOP_PRI_MAX; i++) {
         if (conf->ac_iot_count[i] >= conf->ac_iot_limit[i]) {
             continue;
@@ -129,6 +193,35 @@ __iot_dequeue(iot_conf_t *conf, int *pri)
     return stub;
 }
 
+/*
+ * A request is due the target latency of its priority after it arrived.
+ * Behind requests of its client in the same priority, it is also due no
+ * earlier than the time one of the threads of the priority takes to meet a
+ * target after the last of them, so that a client with a backlog does not
+ * delay the others.  This is never more than IOT_DEADLINE_MAX_DELAY targets
+ * after its arrival, so that the client is not starved either.
+ */
+static void
+__iot_set_deadline(iot_conf_t *conf, iot_client_ctx_t *ctx, call_stub_t *stub,
+                   int pri)
+{
+    uint64_t target = (uint64_t)conf->deadline[pri] * 1000;
+    uint64_t deadline = stub->queued + target;
+    uint64_t pace = target / max(conf->ac_iot_limit[pri], 1);
+    call_stub_t *last = NULL;
+
+    if (!list_empty(&ctx->reqs)) {
+        last = list_last_entry(&ctx->reqs, call_stub_t, list);
+        deadline = max(deadline, last->deadline + pace);
+        deadline = min(deadline,
+                       stub->queued + IOT_DEADLINE_MAX_DELAY * target);
+        /* the first request of a client must stay its earliest */
+        deadline = max(deadline, last->deadline);
+    }
+
+    stub->deadline = deadline;
+}
+
 void
 __iot_enqueue(iot_conf_t *conf, call_stub_t *stub, int pri)
 {
@@ -150,6 +243,10 @@ __iot_enqueue(iot_conf_t *conf, call_stub_t *stub, int pri)
         ctx = &conf->no_client[pri];
     }
 
+    if (conf->scheduler == IOT_SCHED_DEADLINE) {
+        __iot_set_deadline(conf, ctx, stub, pri);
+    }
+
     if (list_empty(&ctx->reqs)) {
         list_add_tail(&ctx->clients, &conf->clients[pri]);
     }
@@ -160,6 +257,29 @@ __iot_enqueue(iot_conf_t *conf, call_stub_t *stub, int pri)
     conf->queue_sizes[pri]++;
 }
 
+static void
+iot_run_stub(iot_conf_t *conf, call_stub_t *stub, int pri)
+{
+    uint64_t now = iot_now();
+    uint64_t wait = now - stub->queued;
+    int i = 0;
+
+    while (i < IOT_WAIT_BUCKETS - 1 && (wait >> i))
+        i++;
+    GF_ATOMIC_INC(conf->queue_wait[pri][i]);
+    if (conf->scheduler == IOT_SCHED_DEADLINE && now > stub->deadline)
+        GF_ATOMIC_INC(conf->deadline_misses[pri]);
+
+    if (stub->poison) {
+        gf_log(conf->this->name, GF_LOG_INFO, "Dropping poisoned request %p.",
+               stub);
+        call_stub_destroy(stub);
+    } else {
+        call_resume(stub);
+    }
+    GF_ATOMIC_DEC(conf->stub_cnt);
+}
+
 void *
 iot_worker(void *data)
 {
@@ -223,16 +343,8 @@ iot_worker(void *data)
         }
         pthread_mutex_unlock(&conf->mutex);
 
-        if (stub) { /* guard against spurious wakeups */
-            if (stub->poison) {
-                gf_log(this->name, GF_LOG_INFO, "Dropping poisoned request %p.",
-                       stub);
-                call_stub_destroy(stub);
-            } else {
-                call_resume(stub);
-            }
-            GF_ATOMIC_DEC(conf->stub_cnt);
-        }
+        if (stub) /* guard against spurious wakeups */
+            iot_run_stub(conf, stub, pri);
         stub = NULL;
 
         if (bye)
@@ -242,11 +354,369 @@ iot_worker(void *data)
     return NULL;
 }
 
+/*
+ * The per-worker scheduler.  Each worker has its own queues, with the same
+ * per-client round robin within a priority as the global queue, and takes
+ * the lock of another worker only to steal from it when its own queues have
+ * nothing it may run.  The limits on the number of threads running each
+ * priority are shared by all the workers.
+ */
+
+static void
+__iot_worker_queue(iot_conf_t *conf, iot_worker_t *worker, call_stub_t *stub,
+                   int pri)
+{
+    client_t *client = stub->frame->root->client;
+    iot_client_ctx_t *ctx = NULL;
+
+    if (client) {
+        ctx = iot_get_ctx(conf->this, client);
+        if (ctx) {
+            ctx = &ctx[worker->index * GF_FOP_PRI_MAX + pri];
+        }
+    }
+    if (!ctx) {
+        ctx = &worker->no_client[pri];
+    }
+
+    if (list_empty(&ctx->reqs)) {
+        list_add_tail(&ctx->clients, &worker->clients[pri]);
+    }
+    list_add_tail(&stub->list, &ctx->reqs);
+}
+
+/* Moves the requests pushed on the inboxes of @worker to its queues, in the
+ * order they were pushed. */
+static void
+__iot_worker_drain(iot_conf_t *conf, iot_worker_t *worker)
+{
+    struct list_head *head = NULL;
+    struct list_head *prev = NULL;
+    struct list_head *next = NULL;
+    int i;
+
+    for (i = 0; i < GF_FOP_PRI_MAX; i++) {
+        head = (struct list_head *)GF_ATOMIC_SWAP(worker->inbox[i], 0);
+
+        prev = NULL;
+        while (head) {
+            next = head->next;
+            head->next = prev;
+            prev = head;
+            head = next;
+        }
+
+        while (prev) {
+            next = prev->next;
+            __iot_worker_queue(conf, worker,
+                               list_entry(prev, call_stub_t, list), i);
+            prev = next;
+        }
+    }
+}
+
+static call_stub_t *
+__iot_worker_dequeue(iot_conf_t *conf, iot_worker_t *worker, int *pri)
+{
+    call_stub_t *stub = NULL;
+    iot_client_ctx_t *ctx;
+    int i;
+
+    for (i = 0; i < GF_FOP_PRI_MAX; i++) {
+        if (list_empty(&worker->clients[i])) {
+            continue;
+        }
+
+        if (GF_ATOMIC_INC(conf->running[i]) > conf->ac_iot_limit[i]) {
+            GF_ATOMIC_DEC(conf->running[i]);
+            continue;
+        }
+
+        ctx = list_first_entry(&worker->clients[i], iot_client_ctx_t, clients);
+        stub = list_first_entry(&ctx->reqs, call_stub_t, list);
+        list_del_init(&stub->list);
+        if (list_empty(&ctx->reqs)) {
+            list_del_init(&ctx->clients);
+        } else {
+            list_rotate_left(&worker->clients[i]);
+        }
+
+        GF_ATOMIC_DEC(worker->queued[i]);
+        conf->queue_marked[i] = _gf_false;
+        *pri = i;
+        break;
+    }
+
+    return stub;
+}
+
+static int64_t
+iot_worker_queued(iot_worker_t *worker)
+{
+    int64_t queued = 0;
+    int i;
+
+    for (i = 0; i < GF_FOP_PRI_MAX; i++)
+        queued += GF_ATOMIC_GET(worker->queued[i]);
+
+    return queued;
+}
+
+/* The next request for @worker: from its own queues, or else from the
+ * queues of the others, starting with its neighbour. */
+static call_stub_t *
+iot_worker_next(iot_conf_t *conf, iot_worker_t *worker, int *pri)
+{
+    iot_worker_t *victim = NULL;
+    call_stub_t *stub = NULL;
+    int i;
+
+    pthread_mutex_lock(&worker->lock);
+    {
+        __iot_worker_drain(conf, worker);
+        stub = __iot_worker_dequeue(conf, worker, pri);
+    }
+    pthread_mutex_unlock(&worker->lock);
+
+    for (i = 1; !stub && i < conf->worker_count; i++) {
+        victim = &conf->workers[(worker->index + i) % conf->worker_count];
+        if (!iot_worker_queued(victim)) {
+            continue;
+        }
+
+        pthread_mutex_lock(&victim->lock);
+        {
+            __iot_worker_drain(conf, victim);
+            stub = __iot_worker_dequeue(conf, victim, pri);
+        }
+        pthread_mutex_unlock(&victim->lock);
+
+        if (stub) {
+            GF_ATOMIC_INC(worker->stolen);
+        }
+    }
+
+    return stub;
+}
+
+static void *
+iot_worker_loop(void *data)
+{
+    iot_worker_t *worker = data;
+    iot_conf_t *conf = worker->conf;
+    call_stub_t *stub = NULL;
+    struct timespec sleep_till = {
+        0,
+    };
+    int64_t arrivals = 0;
+    int pri = -1;
+
+    THIS = conf->this;
+
+    for (;;) {
+        arrivals = GF_ATOMIC_GET(worker->arrivals);
+
+        stub = iot_worker_next(conf, worker, &pri);
+        if (stub) {
+            iot_run_stub(conf, stub, pri);
+            GF_ATOMIC_DEC(conf->running[pri]);
+            continue;
+        }
+
+        if (conf->down) {
+            break;
+        }
+
+        /*
+         * Both sides of the wakeup use read-modify-write operations, so
+         * either this sees the arrivals of iot_worker_schedule() or it sees
+         * the worker sleeping.  The timeout is for the requests that could
+         * not be run because of the limit of their priority.
+         */
+        pthread_mutex_lock(&worker->lock);
+        {
+            GF_ATOMIC_SWAP(worker->sleeping, 1);
+            if (GF_ATOMIC_ADD(worker->arrivals, 0) == arrivals &&
+                !conf->down) {
+                clock_gettime(CLOCK_REALTIME_COARSE, &sleep_till);
+                sleep_till.tv_sec += 1;
+
+                GF_ATOMIC_INC(conf->idle_workers);
+                pthread_cond_timedwait(&worker->cond, &worker->lock,
+                                       &sleep_till);
+                GF_ATOMIC_DEC(conf->idle_workers);
+            }
+            GF_ATOMIC_SWAP(worker->sleeping, 0);
+        }
+        pthread_mutex_unlock(&worker->lock);
+    }
+
+    pthread_mutex_lock(&conf->mutex);
+    {
+        conf->curr_count--;
+        if (conf->curr_count == 0)
+            pthread_cond_broadcast(&conf->cond);
+        gf_msg_debug(conf->this->name, 0,
+                     "terminated. conf->curr_count=%d", conf->curr_count);
+    }
+    pthread_mutex_unlock(&conf->mutex);
+
+    return NULL;
+}
+
+static void
+iot_worker_wake(iot_worker_t *worker)
+{
+    pthread_mutex_lock(&worker->lock);
+    {
+        pthread_cond_signal(&worker->cond);
+    }
+    pthread_mutex_unlock(&worker->lock);
+}
+
+static int
+iot_worker_schedule(iot_conf_t *conf, call_stub_t *stub, int pri)
+{
+    iot_worker_t *worker = NULL;
+    uintptr_t head = 0;
+    int i;
+
+    if (pri < 0 || pri >= GF_FOP_PRI_MAX)
+        pri = GF_FOP_PRI_MAX - 1;
+
+    i = GF_ATOMIC_INC(conf->next_worker) % conf->worker_count;
+    worker = &conf->workers[i];
+
+    GF_ATOMIC_INC(conf->stub_cnt);
+    GF_ATOMIC_INC(worker->queued[pri]);
+    do {
+        head = GF_ATOMIC_GET(worker->inbox[pri]);
+        stub->list.next = (struct list_head *)head;
+    } while (
+        !GF_ATOMIC_CMP_SWAP(worker->inbox[pri], head, (uintptr_t)&stub->list));
+    GF_ATOMIC_INC(worker->arrivals);
+
+    if (GF_ATOMIC_ADD(worker->sleeping, 0)) {
+        iot_worker_wake(worker);
+    } else if (GF_ATOMIC_GET(conf->idle_workers) > 0) {
+        /* @worker is busy, let an idle one steal the request */
+        for (i = 0; i < conf->worker_count; i++) {
+            if (GF_ATOMIC_GET(conf->workers[i].sleeping)) {
+                iot_worker_wake(&conf->workers[i]);
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int
+iot_workers_start(iot_conf_t *conf)
+{
+    iot_worker_t *worker = NULL;
+    pthread_t thread;
+    int ret = 0;
+    int i, j;
+
+    conf->workers = GF_CALLOC(conf->max_count, sizeof(*conf->workers),
+                              gf_iot_mt_worker_t);
+    if (!conf->workers)
+        return -1;
+
+    for (i = 0; i < conf->max_count; i++) {
+        worker = &conf->workers[i];
+        pthread_mutex_init(&worker->lock, NULL);
+        pthread_cond_init(&worker->cond, NULL);
+        for (j = 0; j < GF_FOP_PRI_MAX; j++) {
+            GF_ATOMIC_INIT(worker->inbox[j], 0);
+            GF_ATOMIC_INIT(worker->queued[j], 0);
+            INIT_LIST_HEAD(&worker->clients[j]);
+            INIT_LIST_HEAD(&worker->no_client[j].clients);
+            INIT_LIST_HEAD(&worker->no_client[j].reqs);
+        }
+        GF_ATOMIC_INIT(worker->arrivals, 0);
+        GF_ATOMIC_INIT(worker->sleeping, 0);
+        GF_ATOMIC_INIT(worker->stolen, 0);
+        worker->conf = conf;
+        worker->index = i;
+    }
+    conf->worker_count = conf->max_count;
+    conf->ctx_count = conf->worker_count * GF_FOP_PRI_MAX;
+
+    pthread_mutex_lock(&conf->mutex);
+    {
+        for (i = 0; i < conf->worker_count; i++) {
+            ret = gf_thread_create(&thread, &conf->w_attr, iot_worker_loop,
+                                   &conf->workers[i], "iotwr%03hx", i & 0x3ff);
+            if (ret != 0)
+                break;
+            pthread_detach(thread);
+            conf->curr_count++;
+        }
+
+        /* Nothing is scheduled yet, the workers without a thread can go */
+        for (j = i; j < conf->worker_count; j++) {
+            pthread_cond_destroy(&conf->workers[j].cond);
+            pthread_mutex_destroy(&conf->workers[j].lock);
+        }
+        conf->worker_count = i;
+    }
+    pthread_mutex_unlock(&conf->mutex);
+
+    return (conf->worker_count > 0) ? 0 : -1;
+}
+
+static void
+iot_workers_destroy(iot_conf_t *conf)
+{
+    int i;
+
+    for (i = 0; i < conf->worker_count; i++) {
+        pthread_cond_destroy(&conf->workers[i].cond);
+        pthread_mutex_destroy(&conf->workers[i].lock);
+    }
+
+    GF_FREE(conf->workers);
+    conf->workers = NULL;
+}
+
+/* The number of requests waiting in the queues of @pri */
+static int
+iot_queue_length(iot_conf_t *conf, int pri)
+{
+    int length = 0;
+    int i;
+
+    if (conf->scheduler == IOT_SCHED_GLOBAL)
+        return conf->queue_sizes[pri];
+
+    for (i = 0; i < conf->worker_count; i++)
+        length += GF_ATOMIC_GET(conf->workers[i].queued[pri]);
+
+    return length;
+}
+
+/* The number of threads running requests of @pri */
+static int
+iot_running(iot_conf_t *conf, int pri)
+{
+    if (conf->scheduler == IOT_SCHED_GLOBAL)
+        return conf->ac_iot_count[pri];
+
+    return GF_ATOMIC_GET(conf->running[pri]);
+}
+
 int
 do_iot_schedule(iot_conf_t *conf, call_stub_t *stub, int pri)
 {
     int ret = 0;
 
+    stub->queued = iot_now();
+
+    if (conf->scheduler == IOT_SCHED_PER_WORKER)
+        return iot_worker_schedule(conf, stub, pri);
+
     pthread_mutex_lock(&conf->mutex);
     {
         __iot_enqueue(conf, stub, pri);
@@ -926,7 +1396,11 @@ iot_priv_dump(xlator_t *this)
     iot_conf_t *conf = NULL;
     char key_prefix[GF_DUMP_MAX_BUF_LEN];
     char key[GF_DUMP_MAX_BUF_LEN];
+    int64_t stolen = 0;
+    int64_t count = 0;
+    int length = 0;
     int i = 0;
+    int b = 0;
 
     if (!this)
         return 0;
@@ -939,6 +1413,7 @@ iot_priv_dump(xlator_t *this)
 
     gf_proc_dump_add_section("%s", key_prefix);
 
+    gf_proc_dump_write("scheduler", "%s", iot_sched_names[conf->scheduler]);
     gf_proc_dump_write("maximum_threads_count", "%d", conf->max_count);
     gf_proc_dump_write("current_threads_count", "%d", conf->curr_count);
     gf_proc_dump_write("sleep_count", "%d", conf->sleep_count);
@@ -953,19 +1428,52 @@ iot_priv_dump(xlator_t *this)
     gf_proc_dump_write("max_least_priority_threads", "%d",
                        conf->ac_iot_limit[GF_FOP_PRI_LEAST]);
     gf_proc_dump_write("current_high_priority_threads", "%d",
-                       conf->ac_iot_count[GF_FOP_PRI_HI]);
+                       iot_running(conf, GF_FOP_PRI_HI));
     gf_proc_dump_write("current_normal_priority_threads", "%d",
-                       conf->ac_iot_count[GF_FOP_PRI_NORMAL]);
+                       iot_running(conf, GF_FOP_PRI_NORMAL));
     gf_proc_dump_write("current_low_priority_threads", "%d",
-                       conf->ac_iot_count[GF_FOP_PRI_LO]);
+                       iot_running(conf, GF_FOP_PRI_LO));
     gf_proc_dump_write("current_least_priority_threads", "%d",
-                       conf->ac_iot_count[GF_FOP_PRI_LEAST]);
+                       iot_running(conf, GF_FOP_PRI_LEAST));
     for (i = 0; i < GF_FOP_PRI_MAX; i++) {
-        if (!conf->queue_sizes[i])
+        length = iot_queue_length(conf, i);
+        if (!length)
             continue;
         snprintf(key, sizeof(key), "%s_priority_queue_length",
                  iot_get_pri_meaning(i));
-        gf_proc_dump_write(key, "%d", conf->queue_sizes[i]);
+        gf_proc_dump_write(key, "%d", length);
+    }
+    for (i = 0; i < conf->worker_count; i++)
+        stolen += GF_ATOMIC_GET(conf->workers[i].stolen);
+    if (conf->scheduler == IOT_SCHED_PER_WORKER)
+        gf_proc_dump_write("stolen_requests", "%" PRId64, stolen);
+
+    for (i = 0; i < GF_FOP_PRI_MAX; i++) {
+        if (conf->scheduler == IOT_SCHED_DEADLINE) {
+            snprintf(key, sizeof(key), "%s_priority_deadline_msecs",
+                     iot_get_pri_meaning(i));
+            gf_proc_dump_write(key, "%d", conf->deadline[i]);
+            snprintf(key, sizeof(key), "%s_priority_deadline_misses",
+                     iot_get_pri_meaning(i));
+            gf_proc_dump_write(key, "%" PRId64,
+                               GF_ATOMIC_GET(conf->deadline_misses[i]));
+        }
+
+        /* bucket b has the waits from 2^(b-1) up to 2^b usecs */
+        for (b = 0; b < IOT_WAIT_BUCKETS; b++) {
+            count = GF_ATOMIC_GET(conf->queue_wait[i][b]);
+            if (!count)
+                continue;
+            if (b < IOT_WAIT_BUCKETS - 1)
+                snprintf(key, sizeof(key),
+                         "%s_priority_queue_wait_lt_%" PRIu64 "_usecs",
+                         iot_get_pri_meaning(i), (uint64_t)1 << b);
+            else
+                snprintf(key, sizeof(key),
+                         "%s_priority_queue_wait_ge_%" PRIu64 "_usecs",
+                         iot_get_pri_meaning(i), (uint64_t)1 << (b - 1));
+            gf_proc_dump_write(key, "%" PRId64, count);
+        }
     }
 
     return 0;
@@ -1046,6 +1554,11 @@ iot_apply_event(xlator_t *this, threshold_t *thresh)
     thresh->update_time = now;
 }
 
+/*
+ * With the per-worker scheduler the number of threads is fixed, there is no
+ * emergency thread to start: raising the limit of a stalled priority only
+ * lets more of the workers run its requests.
+ */
 static void *
 iot_watchdog(void *arg)
 {
@@ -1078,7 +1591,7 @@ iot_watchdog(void *arg)
             } else {
                 bad_times[i] = 0;
             }
-            priv->queue_marked[i] = (priv->queue_sizes[i] > 0);
+            priv->queue_marked[i] = (iot_queue_length(priv, i) > 0);
         }
         pthread_mutex_unlock(&priv->mutex);
         pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
@@ -1164,6 +1677,18 @@ reconfigure(xlator_t *this, dict_t *options)
 
     GF_OPTION_RECONF("pass-through", this->pass_through, options, bool, out);
 
+    GF_OPTION_RECONF("high-prio-deadline", conf->deadline[GF_FOP_PRI_HI],
+                     options, int32, out);
+
+    GF_OPTION_RECONF("normal-prio-deadline", conf->deadline[GF_FOP_PRI_NORMAL],
+                     options, int32, out);
+
+    GF_OPTION_RECONF("low-prio-deadline", conf->deadline[GF_FOP_PRI_LO],
+                     options, int32, out);
+
+    GF_OPTION_RECONF("least-prio-deadline", conf->deadline[GF_FOP_PRI_LEAST],
+                     options, int32, out);
+
     if (conf->watchdog_secs > 0) {
         start_iot_watchdog(this);
     } else {
@@ -1179,8 +1704,10 @@ int
 init(xlator_t *this)
 {
     iot_conf_t *conf = NULL;
+    char *scheduler = NULL;
     int ret = -1;
     int i = 0;
+    int j = 0;
 
     if (!this->children || this->children->next) {
         gf_smsg("io-threads", GF_LOG_ERROR, 0,
@@ -1244,16 +1771,51 @@ init(xlator_t *this)
 
     GF_OPTION_INIT("pass-through", this->pass_through, bool, out);
 
+    GF_OPTION_INIT("scheduler", scheduler, str, out);
+    if (strcmp(scheduler, "per-worker") == 0)
+        conf->scheduler = IOT_SCHED_PER_WORKER;
+    else if (strcmp(scheduler, "deadline") == 0)
+        conf->scheduler = IOT_SCHED_DEADLINE;
+    else
+        conf->scheduler = IOT_SCHED_GLOBAL;
+
+    GF_OPTION_INIT("high-prio-deadline", conf->deadline[GF_FOP_PRI_HI], int32,
+                   out);
+
+    GF_OPTION_INIT("normal-prio-deadline", conf->deadline[GF_FOP_PRI_NORMAL],
+                   int32, out);
+
+    GF_OPTION_INIT("low-prio-deadline", conf->deadline[GF_FOP_PRI_LO], int32,
+                   out);
+
+    GF_OPTION_INIT("least-prio-deadline", conf->deadline[GF_FOP_PRI_LEAST],
+                   int32, out);
+
     conf->this = this;
+    conf->ctx_count = GF_FOP_PRI_MAX;
     GF_ATOMIC_INIT(conf->stub_cnt, 0);
 
     for (i = 0; i < GF_FOP_PRI_MAX; i++) {
         INIT_LIST_HEAD(&conf->clients[i]);
         INIT_LIST_HEAD(&conf->no_client[i].clients);
         INIT_LIST_HEAD(&conf->no_client[i].reqs);
+        GF_ATOMIC_INIT(conf->running[i], 0);
+        GF_ATOMIC_INIT(conf->deadline_misses[i], 0);
+        for (j = 0; j < IOT_WAIT_BUCKETS; j++)
+            GF_ATOMIC_INIT(conf->queue_wait[i][j], 0);
     }
+    GF_ATOMIC_INIT(conf->next_worker, 0);
+    GF_ATOMIC_INIT(conf->idle_workers, 0);
 
-    if (!this->pass_through) {
+    if (conf->scheduler == IOT_SCHED_PER_WORKER) {
+        /* All of them, the workers own their queues */
+        ret = iot_workers_start(conf);
+        if (ret == -1) {
+            gf_smsg(this->name, GF_LOG_ERROR, 0,
+                    IO_THREADS_MSG_WORKER_THREAD_INIT_FAILED, NULL);
+            goto out;
+        }
+    } else if (!this->pass_through) {
         ret = iot_workers_scale(conf);
 
         if (ret == -1) {
@@ -1282,11 +1844,15 @@ out:
 static void
 iot_exit_threads(iot_conf_t *conf)
 {
+    int i;
+
     pthread_mutex_lock(&conf->mutex);
     {
         conf->down = _gf_true;
         /*Let all the threads know that xl is going down*/
         pthread_cond_broadcast(&conf->cond);
+        for (i = 0; i < conf->worker_count; i++)
+            iot_worker_wake(&conf->workers[i]);
         while (conf->curr_count) /*Wait for threads to exit*/
             pthread_cond_wait(&conf->cond, &conf->mutex);
     }
@@ -1360,6 +1926,9 @@ fini(xlator_t *this)
 
     stop_iot_watchdog(this);
 
+    if (conf->workers)
+        iot_workers_destroy(conf);
+
     GF_FREE(conf);
 
     this->private = NULL;
@@ -1378,32 +1947,51 @@ iot_client_destroy(xlator_t *this, client_t *client)
     return 0;
 }
 
-static int
-iot_disconnect_cbk(xlator_t *this, client_t *client)
+static void
+iot_poison_reqs(xlator_t *this, iot_client_ctx_t *ctx, client_t *client)
 {
-    int i;
     call_stub_t *curr;
     call_stub_t *next;
+
+    list_for_each_entry_safe(curr, next, &ctx->reqs, list)
+    {
+        if (curr->frame->root->client != client) {
+            continue;
+        }
+        gf_log(this->name, GF_LOG_INFO, "poisoning %s fop at %p for client %s",
+               gf_fop_list[curr->fop], curr, client->client_uid);
+        curr->poison = _gf_true;
+    }
+}
+
+static int
+iot_disconnect_cbk(xlator_t *this, client_t *client)
+{
+    int i, w;
     iot_conf_t *conf = this->private;
-    iot_client_ctx_t *ctx;
+    iot_worker_t *worker;
 
     if (!conf || !conf->cleanup_disconnected_reqs) {
         goto out;
     }
 
-    pthread_mutex_lock(&conf->mutex);
-    for (i = 0; i < GF_FOP_PRI_MAX; i++) {
-        ctx = &conf->no_client[i];
-        list_for_each_entry_safe(curr, next, &ctx->reqs, list)
-        {
-            if (curr->frame->root->client != client) {
-                continue;
+    if (conf->scheduler == IOT_SCHED_PER_WORKER) {
+        for (w = 0; w < conf->worker_count; w++) {
+            worker = &conf->workers[w];
+            pthread_mutex_lock(&worker->lock);
+            {
+                __iot_worker_drain(conf, worker);
+                for (i = 0; i < GF_FOP_PRI_MAX; i++)
+                    iot_poison_reqs(this, &worker->no_client[i], client);
             }
-            gf_log(this->name, GF_LOG_INFO,
-                   "poisoning %s fop at %p for client %s",
-                   gf_fop_list[curr->fop], curr, client->client_uid);
-            curr->poison = _gf_true;
+            pthread_mutex_unlock(&worker->lock);
         }
+        goto out;
+    }
+
+    pthread_mutex_lock(&conf->mutex);
+    for (i = 0; i < GF_FOP_PRI_MAX; i++) {
+        iot_poison_reqs(this, &conf->no_client[i], client);
     }
     pthread_mutex_unlock(&conf->mutex);
 
@@ -1554,7 +2142,9 @@ struct volume_options options[] = {
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
      .tags = {"io-threads"},
      .description = "Number of seconds a queue must be stalled before "
-                    "starting an 'emergency' thread."},
+                    "starting an 'emergency' thread. With the per-worker "
+                    "scheduler no thread is started, the stalled priority "
+                    "may only use more of the workers."},
     {.key = {"cleanup-disconnected-reqs"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "off",
@@ -1569,6 +2159,62 @@ struct volume_options options[] = {
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
      .tags = {"io-threads"},
      .description = "Enable/Disable io threads translator"},
+    {.key = {"scheduler"},
+     .type = GF_OPTION_TYPE_STR,
+     .value = {"global", "per-worker", "deadline"},
+     .default_value = "global",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"io-threads"},
+     .description = "How requests are handed to the threads. 'global' queues "
+                    "them in one queue and starts and stops threads as "
+                    "needed. 'per-worker' starts thread-count threads, each "
+                    "with its own queues that requests are added to without "
+                    "taking a lock, and lets idle threads take requests "
+                    "from the queues of busy ones. 'deadline' runs the "
+                    "queued request due first, each one being due the "
+                    "*-prio-deadline of its priority after it arrived. "
+                    "Applied when the brick is restarted."},
+    {.key = {"high-prio-deadline"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = 60000,
+     .default_value = "20",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"io-threads"},
+     .description = "Target latency in milliseconds of the high priority "
+                    "IO operations with the deadline scheduler"},
+    {.key = {"normal-prio-deadline"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = 60000,
+     .default_value = "100",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"io-threads"},
+     .description = "Target latency in milliseconds of the normal priority "
+                    "IO operations with the deadline scheduler"},
+    {.key = {"low-prio-deadline"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = 60000,
+     .default_value = "500",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"io-threads"},
+     .description = "Target latency in milliseconds of the low priority "
+                    "IO operations with the deadline scheduler"},
+    {.key = {"least-prio-deadline"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = 60000,
+     .default_value = "2000",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"io-threads"},
+     .description = "Target latency in milliseconds of the least priority "
+                    "IO operations with the deadline scheduler"},
     {
         .key = {NULL},
     },
@@ -36,11 +36,42 @@ struct iot_conf;
 
 #define IOT_THREAD_STACK_SIZE ((size_t)(256 * 1024))
 
+/* Buckets of the queue wait histograms, by powers of 2 of usecs */
+#define IOT_WAIT_BUCKETS 24
+
+/* The most a backlog of a client delays its deadlines, in targets */
+#define IOT_DEADLINE_MAX_DELAY 8
+
 typedef struct {
     struct list_head clients;
     struct list_head reqs;
 } iot_client_ctx_t;
 
+typedef enum {
+    IOT_SCHED_GLOBAL,     /* one queue shared by a varying number of threads */
+    IOT_SCHED_PER_WORKER, /* a queue per thread, idle threads steal */
+    IOT_SCHED_DEADLINE,   /* the global queue, earliest deadline first */
+} iot_sched_t;
+
+/*
+ * A thread of the per-worker scheduler and its queues.  Requests are pushed
+ * on the inbox of their priority without taking any lock, and are moved to
+ * the per-client queues by the worker (or by a thief) with the lock held.
+ */
+typedef struct iot_worker {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    gf_atomic_uintptr_t inbox[GF_FOP_PRI_MAX]; /* stack of call_stub_t */
+    struct list_head clients[GF_FOP_PRI_MAX];
+    iot_client_ctx_t no_client[GF_FOP_PRI_MAX];
+    gf_atomic_t queued[GF_FOP_PRI_MAX]; /* in the inbox and the queues */
+    gf_atomic_t arrivals;               /* to not miss a wakeup */
+    gf_atomic_t sleeping;
+    gf_atomic_t stolen; /* requests taken from the other workers */
+    struct iot_conf *conf;
+    int index;
+} iot_worker_t;
+
 struct iot_conf {
     pthread_mutex_t mutex;
     pthread_cond_t cond;
@@ -79,6 +110,19 @@ struct iot_conf {
     pthread_t watchdog_thread;
     gf_boolean_t queue_marked[GF_FOP_PRI_MAX];
     gf_boolean_t cleanup_disconnected_reqs;
+
+    iot_sched_t scheduler;
+    iot_worker_t *workers; /* with IOT_SCHED_PER_WORKER */
+    int32_t worker_count;
+    int32_t ctx_count; /* of iot_client_ctx_t in the ctx of a client */
+    gf_atomic_t next_worker;
+    gf_atomic_t idle_workers;
+    /* ac_iot_count of the per-worker scheduler, which takes no global lock */
+    gf_atomic_t running[GF_FOP_PRI_MAX];
+
+    int32_t deadline[GF_FOP_PRI_MAX]; /* target latency, in msecs */
+    gf_atomic_t deadline_misses[GF_FOP_PRI_MAX];
+    gf_atomic_t queue_wait[GF_FOP_PRI_MAX][IOT_WAIT_BUCKETS];
 };
 
 typedef struct iot_conf iot_conf_t;
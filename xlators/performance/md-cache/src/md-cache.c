@@ -56,6 +56,10 @@ struct mdc_statistics {
     gf_atomic_t xattr_invals; /* No. of invalidates received from upcall */
     gf_atomic_t need_lookup;  /* No. of lookups issued, because other
                                  xlators requested for explicit lookup */
+    gf_atomic_t xattr_absent_hit; /* No. of getxattrs answered ENODATA
+                                     from the absent xattrs cached */
+    gf_atomic_t evictions; /* No. of inodes whose cache was dropped to
+                              stay within md-cache-size */
 };
 
 struct mdc_conf {
@@ -78,6 +82,15 @@ struct mdc_conf {
     struct mdc_statfs_cache statfs_cache;
     char *mdc_xattr_str;
     gf_atomic_int32_t generation;
+
+    gf_boolean_t cache_absent_xattrs;
+    uint64_t cache_size; /* 0 for no limit */
+
+    /* md_caches holding cached metadata, least recently updated first */
+    gf_lock_t lru_lock;
+    struct list_head lru;
+    uint64_t lru_count;
+    uint64_t cache_used;
 };
 
 struct mdc_local;
@@ -96,6 +109,37 @@ typedef struct mdc_local mdc_local_t;
         mdc_local_wipe(__xl, __local);                                         \
     } while (0)
 
+/* The xattrs cached for an inode are packed in a single allocation, as a
+ * sequence of records each made of a struct mdc_xattr_rec, the key with its
+ * terminating NUL and the value, aligned on 8 bytes. Keys found missing are
+ * kept the same way, flagged MDC_XATTR_ABSENT with a struct mdc_absent as
+ * their value.
+ */
+#define MDC_XATTR_ABSENT 0x1
+
+/* absent keys remembered per inode, the oldest one goes first */
+#define MDC_ABSENT_MAX 16
+
+struct mdc_xattr_rec {
+    uint16_t key_len; /* with the terminating NUL */
+    uint8_t flags;
+    uint8_t type; /* gf_dict_data_type_t of the value */
+    uint32_t value_len;
+};
+
+struct mdc_absent {
+    time_t time;    /* when the key was found missing */
+    int64_t ctime;  /* of the inode then, the key is trusted to be */
+    uint32_t nsec;  /* missing as long as the ctime cached is the same */
+};
+
+struct mdc_xattrs {
+    uint32_t size; /* of data */
+    uint16_t count;
+    uint16_t absent;
+    char data[];
+};
+
 struct md_cache {
     ia_prot_t md_prot;
     uint32_t md_nlink;
@@ -111,15 +155,21 @@ struct md_cache {
     uint64_t md_size;
     uint64_t md_blocks;
     uint64_t generation;
-    dict_t *xattr;
-    char *linkname;
+    struct mdc_xattrs *xattr;
     time_t ia_time;
     time_t xa_time;
+    uint32_t xa_gen; /* bumped whenever cached xattrs may go stale */
+    uint32_t seq;    /* odd while the stat is being updated, see
+                        mdc_inode_iatt_get() */
     gf_boolean_t need_lookup;
     gf_boolean_t valid;
     gf_boolean_t gen_rollover;
     gf_boolean_t invalidation_rollover;
-    gf_lock_t lock;
+    gf_boolean_t referenced; /* read since it was last looked at by
+                                mdc_lru_prune() */
+    size_t footprint;        /* accounted in conf->cache_used */
+    struct list_head lru;
+    gf_lock_t lock; /* taken by the writers only for the stat */
 };
 
 struct mdc_local {
@@ -130,9 +180,28 @@ struct mdc_local {
     char *key;
     dict_t *xattr;
     uint64_t incident_time;
+    uint32_t xa_gen;
     bool update_cache;
 };
 
+/* The stat cached (md_* fields, valid, ia_time) is only changed with
+ * mdc->lock held, between __mdc_stat_write_begin() and
+ * __mdc_stat_write_end(). Readers do not take the lock, they retry if
+ * mdc->seq changed while they copied it.
+ */
+static inline void
+__mdc_stat_write_begin(struct md_cache *mdc)
+{
+    __atomic_store_n(&mdc->seq, mdc->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void
+__mdc_stat_write_end(struct md_cache *mdc)
+{
+    __atomic_store_n(&mdc->seq, mdc->seq + 1, __ATOMIC_RELEASE);
+}
+
 int
 __mdc_inode_ctx_get(xlator_t *this, inode_t *inode, struct md_cache **mdc_p)
 {
@@ -201,7 +270,9 @@ mdc_inc_generation(xlator_t *this, inode_t *inode)
     if (mdc) {
         LOCK(&mdc->lock);
         {
+            __mdc_stat_write_begin(mdc);
             gen = __mdc_inc_generation(this, mdc);
+            __mdc_stat_write_end(mdc);
         }
         UNLOCK(&mdc->lock);
     } else {
@@ -312,6 +383,7 @@ mdc_inode_wipe(xlator_t *this, inode_t *inode)
     int ret = 0;
     uint64_t mdc_int = 0;
     struct md_cache *mdc = NULL;
+    struct mdc_conf *conf = this->private;
 
     ret = inode_ctx_del(inode, this, &mdc_int);
     if (ret != 0)
@@ -319,10 +391,17 @@ mdc_inode_wipe(xlator_t *this, inode_t *inode)
 
     mdc = (void *)(long)mdc_int;
 
-    if (mdc->xattr)
-        dict_unref(mdc->xattr);
+    LOCK(&conf->lru_lock);
+    {
+        if (!list_empty(&mdc->lru)) {
+            list_del_init(&mdc->lru);
+            conf->lru_count--;
+            conf->cache_used -= mdc->footprint;
+        }
+    }
+    UNLOCK(&conf->lru_lock);
 
-    GF_FREE(mdc->linkname);
+    GF_FREE(mdc->xattr);
 
     GF_FREE(mdc);
 
@@ -351,6 +430,7 @@ mdc_inode_prep(xlator_t *this, inode_t *inode)
         }
 
         LOCK_INIT(&mdc->lock);
+        INIT_LIST_HEAD(&mdc->lru);
 
         ret = __mdc_inode_ctx_set(this, inode, mdc);
         if (ret) {
@@ -366,6 +446,100 @@ unlock:
     return mdc;
 }
 
+/* Accounts for what @mdc holds now and makes it the most recently updated.
+ * Called with mdc->lock held. */
+static void
+__mdc_lru_update(xlator_t *this, struct md_cache *mdc)
+{
+    struct mdc_conf *conf = this->private;
+    size_t footprint = sizeof(*mdc);
+
+    if (mdc->xattr)
+        footprint += sizeof(*mdc->xattr) + mdc->xattr->size;
+
+    /* Most updates only refresh the stat, do not contend on the lru lock
+     * for them */
+    if ((footprint == mdc->footprint) && !list_empty(&mdc->lru)) {
+        mdc->referenced = _gf_true;
+        return;
+    }
+
+    if (!conf->cache_size && list_empty(&mdc->lru))
+        return;
+
+    LOCK(&conf->lru_lock);
+    {
+        if (list_empty(&mdc->lru))
+            conf->lru_count++;
+        list_move_tail(&mdc->lru, &conf->lru);
+        conf->cache_used += footprint - mdc->footprint;
+        mdc->footprint = footprint;
+    }
+    UNLOCK(&conf->lru_lock);
+}
+
+/* Drops everything cached in @mdc. Called with mdc->lock and the lru lock
+ * held. */
+static void
+__mdc_evict(xlator_t *this, struct md_cache *mdc)
+{
+    struct mdc_conf *conf = this->private;
+
+    __mdc_stat_write_begin(mdc);
+    mdc->ia_time = 0;
+    mdc->valid = _gf_false;
+    __mdc_stat_write_end(mdc);
+
+    mdc->xa_time = 0;
+    mdc->xa_gen++;
+    GF_FREE(mdc->xattr);
+    mdc->xattr = NULL;
+
+    list_del_init(&mdc->lru);
+    conf->lru_count--;
+    conf->cache_used -= mdc->footprint;
+    mdc->footprint = 0;
+
+    GF_ATOMIC_INC(conf->mdc_counter.evictions);
+}
+
+/* Brings the cache back within md-cache-size, evicting the least recently
+ * updated inodes that were not read since the last time they were looked
+ * at. Must not be called with any mdc->lock held. */
+static void
+mdc_lru_prune(xlator_t *this)
+{
+    struct mdc_conf *conf = this->private;
+    struct md_cache *mdc = NULL;
+    uint64_t limit = conf->cache_size;
+    uint64_t budget = 0;
+
+    if (!limit || (conf->cache_used <= limit))
+        return;
+
+    LOCK(&conf->lru_lock);
+    {
+        /* every inode gets a second chance at most once */
+        budget = 2 * conf->lru_count;
+        while ((conf->cache_used > limit) && budget--) {
+            mdc = list_first_entry(&conf->lru, struct md_cache, lru);
+
+            /* mdc->lock comes before the lru lock, do not wait for
+             * it here */
+            if (mdc->referenced || TRY_LOCK(&mdc->lock)) {
+                mdc->referenced = _gf_false;
+                list_move_tail(&mdc->lru, &conf->lru);
+                continue;
+            }
+
+            __mdc_evict(this, mdc);
+
+            UNLOCK(&mdc->lock);
+        }
+    }
+    UNLOCK(&conf->lru_lock);
+}
+
 /* Cache is valid if:
  * - It is not cached before any brick was down. Brick down case is handled by
  *   invalidating all the cache when any brick went down.
@@ -416,7 +590,9 @@ is_md_cache_iatt_valid(xlator_t *this, struct md_cache *mdc)
         } else {
             ret = __is_cache_valid(this, mdc->ia_time);
             if (ret == _gf_false) {
+                __mdc_stat_write_begin(mdc);
                 mdc->ia_time = 0;
+                __mdc_stat_write_end(mdc);
                 mdc->generation = 0;
             }
         }
@@ -501,6 +677,8 @@ mdc_inode_iatt_set_validate(xlator_t *this, inode_t *inode, struct iatt *prebuf,
 
     LOCK(&mdc->lock);
     {
+        __mdc_stat_write_begin(mdc);
+
         if (!iatt || !iatt->ia_ctime) {
             gf_msg_callingfn("md-cache", GF_LOG_TRACE, 0, 0,
                              "invalidating iatt(NULL)"
@@ -580,6 +758,7 @@ mdc_inode_iatt_set_validate(xlator_t *this, inode_t *inode, struct iatt *prebuf,
                 if (mdc->xa_time && update_xa_time)
                     mdc->xa_time = mdc->ia_time;
             }
+            __mdc_lru_update(this, mdc);
 
             gf_msg_callingfn(
                 "md-cache", GF_LOG_TRACE, 0, MD_CACHE_MSG_CACHE_UPDATE,
@@ -600,8 +779,10 @@ mdc_inode_iatt_set_validate(xlator_t *this, inode_t *inode, struct iatt *prebuf,
         }
     }
 unlock:
+    __mdc_stat_write_end(mdc);
     UNLOCK(&mdc->lock);
 
+    mdc_lru_prune(this);
 out:
     return ret;
 }
@@ -619,6 +800,9 @@ mdc_inode_iatt_get(xlator_t *this, inode_t *inode, struct iatt *iatt)
 {
     int ret = -1;
     struct md_cache *mdc = NULL;
+    time_t ia_time = 0;
+    uint32_t seq = 0;
+    gf_boolean_t valid = _gf_false;
 
     if (mdc_inode_ctx_get(this, inode, &mdc) != 0) {
         gf_msg_trace("md-cache", 0, "mdc_inode_ctx_get failed (%s)",
@@ -626,18 +810,37 @@ mdc_inode_iatt_get(xlator_t *this, inode_t *inode, struct iatt *iatt)
         goto out;
     }
 
-    if (!is_md_cache_iatt_valid(this, mdc)) {
-        gf_msg_trace("md-cache", 0, "iatt cache not valid for (%s)",
-                     uuid_utoa(inode->gfid));
-        goto out;
+    seq = __atomic_load_n(&mdc->seq, __ATOMIC_ACQUIRE);
+    if (!(seq & 1)) {
+        valid = mdc->valid;
+        ia_time = mdc->ia_time;
+        mdc_to_iatt(mdc, iatt);
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&mdc->seq, __ATOMIC_RELAXED) == seq)
+            goto copied;
     }
 
+    /* raced with an update, wait for it */
     LOCK(&mdc->lock);
     {
+        valid = mdc->valid;
+        ia_time = mdc->ia_time;
         mdc_to_iatt(mdc, iatt);
     }
     UNLOCK(&mdc->lock);
 
+copied:
+    if (!valid || !__is_cache_valid(this, ia_time)) {
+        /* resets the expired cache */
+        is_md_cache_iatt_valid(this, mdc);
+        gf_msg_trace("md-cache", 0, "iatt cache not valid for (%s)",
+                     uuid_utoa(inode->gfid));
+        goto out;
+    }
+
+    mdc->referenced = _gf_true;
+
     gf_uuid_copy(iatt->ia_gfid, inode->gfid);
     iatt->ia_ino = gfid_to_ino(inode->gfid);
     iatt->ia_dev = 42;
@@ -648,11 +851,6 @@ out:
     return ret;
 }
 
-struct updatedict {
-    dict_t *dict;
-    int ret;
-};
-
 static int
 is_mdc_key_satisfied(xlator_t *this, const char *key)
 {
@@ -695,49 +893,223 @@ out:
     return ret;
 }
 
+static size_t
+mdc_xattr_rec_size(size_t key_len, size_t value_len)
+{
+    return (sizeof(struct mdc_xattr_rec) + key_len + value_len + 7) & ~7;
+}
+
+static char *
+mdc_xattr_key(struct mdc_xattr_rec *rec)
+{
+    return (char *)(rec + 1);
+}
+
+static void *
+mdc_xattr_value(struct mdc_xattr_rec *rec)
+{
+    return mdc_xattr_key(rec) + rec->key_len;
+}
+
+static struct mdc_xattr_rec *
+mdc_xattr_next(struct mdc_xattrs *xattrs, struct mdc_xattr_rec *rec)
+{
+    char *next = NULL;
+
+    if (!xattrs)
+        return NULL;
+
+    if (rec)
+        next = (char *)rec + mdc_xattr_rec_size(rec->key_len, rec->value_len);
+    else
+        next = xattrs->data;
+
+    if (next >= xattrs->data + xattrs->size)
+        return NULL;
+
+    return (struct mdc_xattr_rec *)next;
+}
+
+#define mdc_xattrs_foreach(xattrs, rec)                                        \
+    for (rec = mdc_xattr_next(xattrs, NULL); rec;                              \
+         rec = mdc_xattr_next(xattrs, rec))
+
+static struct mdc_xattr_rec *
+mdc_xattrs_find(struct mdc_xattrs *xattrs, const char *key)
+{
+    struct mdc_xattr_rec *rec = NULL;
+
+    mdc_xattrs_foreach(xattrs, rec)
+    {
+        if (!strcmp(mdc_xattr_key(rec), key))
+            return rec;
+    }
+
+    return NULL;
+}
+
 static int
-updatefn(dict_t *dict, char *key, data_t *value, void *data)
+mdc_xattrs_append(struct mdc_xattrs **xattrs, const char *key, uint8_t flags,
+                  uint8_t type, const void *value, uint32_t value_len)
 {
-    struct updatedict *u = data;
+    struct mdc_xattrs *new = NULL;
+    struct mdc_xattr_rec *rec = NULL;
+    size_t key_len = strlen(key) + 1;
+    size_t size = (*xattrs) ? (*xattrs)->size : 0;
+    size_t rec_size = 0;
 
-    if (is_mdc_key_satisfied(THIS, key)) {
-        if (!u->dict) {
-            u->dict = dict_new();
-            if (!u->dict) {
-                u->ret = -1;
-                return -1;
-            }
+    if (key_len > UINT16_MAX)
+        return -1;
+
+    rec_size = mdc_xattr_rec_size(key_len, value_len);
+
+    if (*xattrs)
+        new = GF_REALLOC(*xattrs, sizeof(*new) + size + rec_size);
+    else
+        new = GF_CALLOC(1, sizeof(*new) + rec_size, gf_mdc_mt_mdc_xattrs_t);
+    if (!new)
+        return -1;
+    *xattrs = new;
+
+    rec = (struct mdc_xattr_rec *)(new->data + size);
+    memset(rec, 0, rec_size);
+    rec->key_len = key_len;
+    rec->flags = flags;
+    rec->type = type;
+    rec->value_len = value_len;
+    memcpy(mdc_xattr_key(rec), key, key_len);
+    if (value_len)
+        memcpy(mdc_xattr_value(rec), value, value_len);
+
+    new->size = size + rec_size;
+    new->count++;
+    if (flags & MDC_XATTR_ABSENT)
+        new->absent++;
+
+    return 0;
+}
+
+#define MDC_KEEP_PRESENT 0x1
+#define MDC_KEEP_ABSENT 0x2
+#define MDC_DROP_OLDEST_ABSENT 0x4
+
+/* Copies the records of @src selected by @keep into *@dst, but those of @key
+ * and of the keys in @keys */
+static int
+mdc_xattrs_copy(struct mdc_xattrs *src, struct mdc_xattrs **dst, int keep,
+                dict_t *keys, const char *key)
+{
+    struct mdc_xattr_rec *rec = NULL;
+    gf_boolean_t absent = _gf_false;
+    gf_boolean_t dropped = _gf_false;
+
+    mdc_xattrs_foreach(src, rec)
+    {
+        absent = !!(rec->flags & MDC_XATTR_ABSENT);
+        if (!(keep & (absent ? MDC_KEEP_ABSENT : MDC_KEEP_PRESENT)))
+            continue;
+
+        if (key && !strcmp(mdc_xattr_key(rec), key))
+            continue;
+
+        if (keys && dict_get(keys, mdc_xattr_key(rec)))
+            continue;
+
+        if (absent && (keep & MDC_DROP_OLDEST_ABSENT) && !dropped) {
+            dropped = _gf_true;
+            continue;
         }
 
-        if (dict_set(u->dict, key, value) < 0) {
-            u->ret = -1;
+        if (mdc_xattrs_append(dst, mdc_xattr_key(rec), rec->flags, rec->type,
+                              mdc_xattr_value(rec), rec->value_len))
             return -1;
-        }
     }
+
+    return 0;
+}
+
+struct mdc_xattrs_fill {
+    struct mdc_xattrs *xattrs;
+    int ret;
+};
+
+static int
+mdc_xattrs_fill(dict_t *dict, char *key, data_t *value, void *data)
+{
+    struct mdc_xattrs_fill *fill = data;
+
+    if (!is_mdc_key_satisfied(THIS, key))
+        return 0;
+
+    if (mdc_xattrs_append(&fill->xattrs, key, 0, value->data_type,
+                          value->data, value->len)) {
+        fill->ret = -1;
+        return -1;
+    }
+
     return 0;
 }
 
+/* Replaces the xattrs cached in @mdc by those of @old selected by @keep, but
+ * the keys in @keys and @key, plus the xattrs in @keys to be cached. Called
+ * with mdc->lock held. */
 static int
-mdc_dict_update(dict_t **tgt, dict_t *src)
+__mdc_xattrs_rebuild(xlator_t *this, struct md_cache *mdc, int keep,
+                     dict_t *keys, const char *key)
 {
-    struct updatedict u = {
-        .dict = *tgt,
+    struct mdc_xattrs_fill fill = {
+        .xattrs = NULL,
         .ret = 0,
     };
 
-    dict_foreach(src, updatefn, &u);
+    if (mdc_xattrs_copy(mdc->xattr, &fill.xattrs, keep, keys, key))
+        goto err;
+
+    if (keys) {
+        dict_foreach(keys, mdc_xattrs_fill, &fill);
+        if (fill.ret < 0)
+            goto err;
+    }
+
+    GF_FREE(mdc->xattr);
+    mdc->xattr = fill.xattrs;
+    mdc->xa_gen++;
+
+    __mdc_lru_update(this, mdc);
 
-    if (*tgt)
-        return u.ret;
+    return 0;
+
+err:
+    GF_FREE(fill.xattrs);
+    return -1;
+}
+
+static int
+mdc_xattr_to_dict(dict_t *dict, struct mdc_xattr_rec *rec)
+{
+    data_t *data = NULL;
+    char *value = NULL;
+
+    /* NUL terminated, for the string values */
+    value = GF_MALLOC(rec->value_len + 1, gf_common_mt_char);
+    if (!value)
+        return -1;
+    memcpy(value, mdc_xattr_value(rec), rec->value_len);
+    value[rec->value_len] = '\0';
 
-    if ((u.ret < 0) && u.dict) {
-        dict_unref(u.dict);
-        return u.ret;
+    data = data_from_dynptr(value, rec->value_len);
+    if (!data) {
+        GF_FREE(value);
+        return -1;
     }
+    data->data_type = rec->type;
 
-    *tgt = u.dict;
+    if (dict_set(dict, mdc_xattr_key(rec), data)) {
+        data_destroy(data);
+        return -1;
+    }
 
-    return u.ret;
+    return 0;
 }
 
 int
@@ -745,7 +1117,6 @@ mdc_inode_xatt_set(xlator_t *this, inode_t *inode, dict_t *dict)
 {
     int ret = -1;
     struct md_cache *mdc = NULL;
-    dict_t *newdict = NULL;
 
     mdc = mdc_inode_prep(this, inode);
     if (!mdc)
@@ -761,29 +1132,20 @@ mdc_inode_xatt_set(xlator_t *this, inode_t *inode, dict_t *dict)
 
     LOCK(&mdc->lock);
     {
-        if (mdc->xattr) {
-            gf_msg_trace("md-cache", 0,
-                         "deleting the old xattr "
-                         "cache (%s)",
-                         uuid_utoa(inode->gfid));
-            dict_unref(mdc->xattr);
-            mdc->xattr = NULL;
-        }
-
-        ret = mdc_dict_update(&newdict, dict);
+        /* the keys found missing are not part of the xattrs loaded */
+        ret = __mdc_xattrs_rebuild(this, mdc, MDC_KEEP_ABSENT, dict, NULL);
         if (ret < 0) {
             UNLOCK(&mdc->lock);
             goto out;
         }
 
-        if (newdict)
-            mdc->xattr = newdict;
-
         mdc->xa_time = gf_time();
         gf_msg_trace("md-cache", 0, "xatt cache set for (%s) time:%lld",
                      uuid_utoa(inode->gfid), (long long)mdc->xa_time);
     }
     UNLOCK(&mdc->lock);
+
+    mdc_lru_prune(this);
     ret = 0;
 out:
     return ret;
@@ -804,7 +1166,9 @@ mdc_inode_xatt_update(xlator_t *this, inode_t *inode, dict_t *dict)
 
     LOCK(&mdc->lock);
     {
-        ret = mdc_dict_update(&mdc->xattr, dict);
+        ret = __mdc_xattrs_rebuild(this, mdc,
+                                   MDC_KEEP_PRESENT | MDC_KEEP_ABSENT, dict,
+                                   NULL);
         if (ret < 0) {
             UNLOCK(&mdc->lock);
             goto out;
@@ -812,6 +1176,7 @@ mdc_inode_xatt_update(xlator_t *this, inode_t *inode, dict_t *dict)
     }
     UNLOCK(&mdc->lock);
 
+    mdc_lru_prune(this);
     ret = 0;
 out:
     return ret;
@@ -827,12 +1192,14 @@ mdc_inode_xatt_unset(xlator_t *this, inode_t *inode, char *name)
     if (!mdc)
         goto out;
 
-    if (!name || !mdc->xattr)
+    if (!name)
         goto out;
 
     LOCK(&mdc->lock);
     {
-        dict_del(mdc->xattr, name);
+        if (mdc->xattr)
+            __mdc_xattrs_rebuild(this, mdc, MDC_KEEP_PRESENT | MDC_KEEP_ABSENT,
+                                 NULL, name);
     }
     UNLOCK(&mdc->lock);
 
@@ -841,11 +1208,16 @@ out:
     return ret;
 }
 
+/* Returns in @dict the xattrs cached for @inode, or only @key if it is not
+ * NULL. A NULL @dict returned only means none of them exist. */
 int
-mdc_inode_xatt_get(xlator_t *this, inode_t *inode, dict_t **dict)
+mdc_inode_xatt_get(xlator_t *this, inode_t *inode, const char *key,
+                   dict_t **dict)
 {
     int ret = -1;
     struct md_cache *mdc = NULL;
+    struct mdc_xattr_rec *rec = NULL;
+    dict_t *xattr = NULL;
 
     if (mdc_inode_ctx_get(this, inode, &mdc) != 0) {
         gf_msg_trace("md-cache", 0, "mdc_inode_ctx_get failed (%s)",
@@ -865,22 +1237,155 @@ mdc_inode_xatt_get(xlator_t *this, inode_t *inode, dict_t **dict)
         /* Missing xattr only means no keys were there, i.e
            a negative cache for the "loaded" keys
         */
-        if (!mdc->xattr) {
+        if (!mdc->xattr || (mdc->xattr->count == mdc->xattr->absent)) {
             gf_msg_trace("md-cache", 0, "xattr not present (%s)",
                          uuid_utoa(inode->gfid));
             goto unlock;
         }
 
-        if (dict)
-            *dict = dict_ref(mdc->xattr);
+        if (!dict)
+            goto unlock;
+
+        mdc_xattrs_foreach(mdc->xattr, rec)
+        {
+            if (rec->flags & MDC_XATTR_ABSENT)
+                continue;
+            if (key && strcmp(mdc_xattr_key(rec), key))
+                continue;
+
+            if (!xattr) {
+                xattr = dict_new();
+                if (!xattr) {
+                    ret = -1;
+                    goto unlock;
+                }
+            }
+
+            if (mdc_xattr_to_dict(xattr, rec)) {
+                ret = -1;
+                goto unlock;
+            }
+        }
     }
 unlock:
     UNLOCK(&mdc->lock);
 
+    if (ret < 0) {
+        if (xattr)
+            dict_unref(xattr);
+    } else if (dict) {
+        *dict = xattr;
+    }
+
+    if (ret == 0)
+        mdc->referenced = _gf_true;
 out:
     return ret;
 }
 
+/* Whether the absence of @key can be cached. Only the keys of the
+ * namespaces backed by the xattrs of the bricks are, the virtual ones may
+ * show up with no change to the inode. */
+static gf_boolean_t
+mdc_absent_cacheable(xlator_t *this, const char *key)
+{
+    struct mdc_conf *conf = this->private;
+
+    if (!conf->cache_absent_xattrs || !key)
+        return _gf_false;
+
+    return (!strncmp(key, "user.", SLEN("user.")) ||
+            !strncmp(key, "security.", SLEN("security.")) ||
+            !strncmp(key, "system.", SLEN("system.")));
+}
+
+/* Returns whether @key is known to be missing on @inode. @xa_gen is set for
+ * mdc_inode_xatt_absent_set() to tell whether the xattrs changed since. */
+static gf_boolean_t
+mdc_inode_xatt_absent_get(xlator_t *this, inode_t *inode, const char *key,
+                          uint32_t *xa_gen)
+{
+    struct md_cache *mdc = NULL;
+    struct mdc_xattr_rec *rec = NULL;
+    struct mdc_absent absent = {
+        0,
+    };
+    gf_boolean_t ret = _gf_false;
+
+    *xa_gen = 0;
+
+    if (mdc_inode_ctx_get(this, inode, &mdc) != 0)
+        goto out;
+
+    LOCK(&mdc->lock);
+    {
+        *xa_gen = mdc->xa_gen;
+
+        rec = mdc_xattrs_find(mdc->xattr, key);
+        if (!rec || !(rec->flags & MDC_XATTR_ABSENT))
+            goto unlock;
+
+        memcpy(&absent, mdc_xattr_value(rec), sizeof(absent));
+
+        /* Setting an xattr changes the ctime of the inode, this is as
+           up to date as the stat cached. */
+        ret = mdc->valid && __is_cache_valid(this, mdc->ia_time) &&
+              __is_cache_valid(this, absent.time) &&
+              (mdc->md_ctime == absent.ctime) &&
+              (mdc->md_ctime_nsec == absent.nsec);
+    }
+unlock:
+    UNLOCK(&mdc->lock);
+
+    if (ret)
+        mdc->referenced = _gf_true;
+out:
+    return ret;
+}
+
+static void
+mdc_inode_xatt_absent_set(xlator_t *this, inode_t *inode, const char *key,
+                          uint32_t xa_gen)
+{
+    struct md_cache *mdc = NULL;
+    struct mdc_absent absent = {
+        0,
+    };
+    int keep = MDC_KEEP_PRESENT | MDC_KEEP_ABSENT;
+
+    mdc = mdc_inode_prep(this, inode);
+    if (!mdc)
+        return;
+
+    LOCK(&mdc->lock);
+    {
+        /* changed while the getxattr was in flight, or nothing to tell
+           whether it is still missing later */
+        if ((mdc->xa_gen != xa_gen) || !mdc->valid)
+            goto unlock;
+
+        absent.time = gf_time();
+        absent.ctime = mdc->md_ctime;
+        absent.nsec = mdc->md_ctime_nsec;
+
+        if (mdc->xattr && (mdc->xattr->absent >= MDC_ABSENT_MAX) &&
+            !mdc_xattrs_find(mdc->xattr, key))
+            keep |= MDC_DROP_OLDEST_ABSENT;
+
+        if (__mdc_xattrs_rebuild(this, mdc, keep, NULL, key))
+            goto unlock;
+
+        /* rebuilt above, appending does not copy the rest again */
+        if (mdc_xattrs_append(&mdc->xattr, key, MDC_XATTR_ABSENT, 0, &absent,
+                              sizeof(absent)) == 0)
+            __mdc_lru_update(this, mdc);
+    }
+unlock:
+    UNLOCK(&mdc->lock);
+
+    mdc_lru_prune(this);
+}
+
 gf_boolean_t
 mdc_inode_reset_need_lookup(xlator_t *this, inode_t *inode)
 {
@@ -932,8 +1437,10 @@ mdc_inode_iatt_invalidate(xlator_t *this, inode_t *inode)
 
     LOCK(&mdc->lock);
     {
+        __mdc_stat_write_begin(mdc);
         mdc->ia_time = 0;
         mdc->valid = _gf_false;
+        __mdc_stat_write_end(mdc);
         mdc->generation = gen;
     }
     UNLOCK(&mdc->lock);
@@ -954,6 +1461,11 @@ mdc_inode_xatt_invalidate(xlator_t *this, inode_t *inode)
     LOCK(&mdc->lock);
     {
         mdc->xa_time = 0;
+        mdc->xa_gen++;
+
+        /* the keys found missing are not trusted past it either */
+        if (mdc->xattr && mdc->xattr->absent)
+            __mdc_xattrs_rebuild(this, mdc, MDC_KEEP_PRESENT, NULL, NULL);
     }
     UNLOCK(&mdc->lock);
 
@@ -1288,7 +1800,7 @@ mdc_lookup(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
     }
 
     if (xdata) {
-        ret = mdc_inode_xatt_get(this, loc->inode, &xattr_rsp);
+        ret = mdc_inode_xatt_get(this, loc->inode, NULL, &xattr_rsp);
         if (ret != 0) {
             GF_ATOMIC_INC(conf->mdc_counter.xattr_miss);
             goto uncached;
@@ -2454,6 +2966,9 @@ mdc_getxattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
     if (op_ret < 0) {
         if ((op_errno == ENOENT) || (op_errno == ESTALE))
             mdc_inode_iatt_invalidate(this, local->loc.inode);
+        else if ((op_errno == ENODATA) && local->key)
+            mdc_inode_xatt_absent_set(this, local->loc.inode, local->key,
+                                      local->xa_gen);
         goto out;
     }
 
@@ -2492,11 +3007,13 @@ mdc_getxattr(call_frame_t *frame, xlator_t *this, loc_t *loc, const char *key,
     loc_copy(&local->loc, loc);
 
     if (!is_mdc_key_satisfied(this, key)) {
+        if (mdc_absent_cacheable(this, key))
+            goto absent;
         goto uncached;
     }
     key_satisfied = _gf_true;
 
-    ret = mdc_inode_xatt_get(this, loc->inode, &xattr);
+    ret = mdc_inode_xatt_get(this, loc->inode, key, &xattr);
     if (ret != 0)
         goto uncached;
 
@@ -2513,6 +3030,17 @@ mdc_getxattr(call_frame_t *frame, xlator_t *this, loc_t *loc, const char *key,
 
     return 0;
 
+absent:
+    if (mdc_inode_xatt_absent_get(this, loc->inode, key, &local->xa_gen)) {
+        GF_ATOMIC_INC(conf->mdc_counter.xattr_hit);
+        GF_ATOMIC_INC(conf->mdc_counter.xattr_absent_hit);
+        MDC_STACK_UNWIND(getxattr, frame, -1, ENODATA, NULL, NULL);
+        return 0;
+    }
+
+    /* remembered as missing if it is */
+    local->key = gf_strdup(key);
+
 uncached:
     if (key_satisfied) {
         xdata = mdc_prepare_request(this, local, xdata);
@@ -2543,6 +3071,9 @@ mdc_fgetxattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
     if (op_ret < 0) {
         if ((op_errno == ENOENT) || (op_errno == ESTALE))
             mdc_inode_iatt_invalidate(this, local->fd->inode);
+        else if ((op_errno == ENODATA) && local->key)
+            mdc_inode_xatt_absent_set(this, local->fd->inode, local->key,
+                                      local->xa_gen);
         goto out;
     }
 
@@ -2581,10 +3112,12 @@ mdc_fgetxattr(call_frame_t *frame, xlator_t *this, fd_t *fd, const char *key,
 
     if (!is_mdc_key_satisfied(this, key)) {
         key_satisfied = _gf_false;
+        if (mdc_absent_cacheable(this, key))
+            goto absent;
         goto uncached;
     }
 
-    ret = mdc_inode_xatt_get(this, fd->inode, &xattr);
+    ret = mdc_inode_xatt_get(this, fd->inode, key, &xattr);
     if (ret != 0)
         goto uncached;
 
@@ -2601,6 +3134,17 @@ mdc_fgetxattr(call_frame_t *frame, xlator_t *this, fd_t *fd, const char *key,
 
     return 0;
 
+absent:
+    if (mdc_inode_xatt_absent_get(this, fd->inode, key, &local->xa_gen)) {
+        GF_ATOMIC_INC(conf->mdc_counter.xattr_hit);
+        GF_ATOMIC_INC(conf->mdc_counter.xattr_absent_hit);
+        MDC_STACK_UNWIND(fgetxattr, frame, -1, ENODATA, NULL, NULL);
+        return 0;
+    }
+
+    /* remembered as missing if it is */
+    local->key = gf_strdup(key);
+
 uncached:
     if (key_satisfied) {
         xdata = mdc_prepare_request(this, local, xdata);
@@ -2688,7 +3232,7 @@ mdc_removexattr(call_frame_t *frame, xlator_t *this, loc_t *loc,
     if (!is_mdc_key_satisfied(this, name))
         goto uncached;
 
-    ret = mdc_inode_xatt_get(this, loc->inode, &xattr);
+    ret = mdc_inode_xatt_get(this, loc->inode, name, &xattr);
     if (ret != 0)
         goto uncached;
 
@@ -2788,7 +3332,7 @@ mdc_fremovexattr(call_frame_t *frame, xlator_t *this, fd_t *fd,
     if (!is_mdc_key_satisfied(this, name))
         goto uncached;
 
-    ret = mdc_inode_xatt_get(this, fd->inode, &xattr);
+    ret = mdc_inode_xatt_get(this, fd->inode, name, &xattr);
     if (ret != 0)
         goto uncached;
 
@@ -3261,6 +3805,18 @@ mdc_priv_dump(xlator_t *this)
                        GF_ATOMIC_GET(conf->mdc_counter.stat_invals));
     gf_proc_dump_write("xattr_invalidations_received", "%" PRId64,
                        GF_ATOMIC_GET(conf->mdc_counter.xattr_invals));
+    gf_proc_dump_write("xattr_absent_hit_count", "%" PRId64,
+                       GF_ATOMIC_GET(conf->mdc_counter.xattr_absent_hit));
+    gf_proc_dump_write("evictions", "%" PRId64,
+                       GF_ATOMIC_GET(conf->mdc_counter.evictions));
+
+    LOCK(&conf->lru_lock);
+    {
+        gf_proc_dump_write("cache_size", "%" PRIu64, conf->cache_size);
+        gf_proc_dump_write("cache_used", "%" PRIu64, conf->cache_used);
+        gf_proc_dump_write("cached_inodes", "%" PRIu64, conf->lru_count);
+    }
+    UNLOCK(&conf->lru_lock);
 
     return 0;
 }
@@ -3290,6 +3846,11 @@ mdc_dump_metrics(xlator_t *this, int fd)
             this->name, GF_ATOMIC_GET(conf->mdc_counter.stat_invals));
     dprintf(fd, "%s.xattr_cache_invalidations_received %" PRId64 "\n",
             this->name, GF_ATOMIC_GET(conf->mdc_counter.xattr_invals));
+    dprintf(fd, "%s.xattr_cache_absent_hit_count %" PRId64 "\n", this->name,
+            GF_ATOMIC_GET(conf->mdc_counter.xattr_absent_hit));
+    dprintf(fd, "%s.cache_evictions %" PRId64 "\n", this->name,
+            GF_ATOMIC_GET(conf->mdc_counter.evictions));
+    dprintf(fd, "%s.cache_used %" PRIu64 "\n", this->name, conf->cache_used);
 out:
     return 0;
 }
@@ -3647,6 +4208,13 @@ mdc_reconfigure(xlator_t *this, dict_t *options)
 
     GF_OPTION_RECONF("md-cache-statfs", conf->cache_statfs, options, bool, out);
 
+    GF_OPTION_RECONF("cache-absent-xattrs", conf->cache_absent_xattrs, options,
+                     bool, out);
+
+    GF_OPTION_RECONF("md-cache-size", conf->cache_size, options, size_uint64,
+                     out);
+    mdc_lru_prune(this);
+
     GF_OPTION_RECONF("xattr-cache-list", tmp_str, options, str, out);
 
     ret = mdc_xattr_list_populate(conf, tmp_str);
@@ -3690,6 +4258,8 @@ mdc_init(xlator_t *this)
     }
 
     LOCK_INIT(&conf->lock);
+    LOCK_INIT(&conf->lru_lock);
+    INIT_LIST_HEAD(&conf->lru);
 
     GF_OPTION_INIT("md-cache-timeout", timeout, uint32, out);
 
@@ -3722,6 +4292,10 @@ mdc_init(xlator_t *this)
     pthread_mutex_init(&conf->statfs_cache.lock, NULL);
     GF_OPTION_INIT("md-cache-statfs", conf->cache_statfs, bool, out);
 
+    GF_OPTION_INIT("cache-absent-xattrs", conf->cache_absent_xattrs, bool, out);
+
+    GF_OPTION_INIT("md-cache-size", conf->cache_size, size_uint64, out);
+
     GF_OPTION_INIT("xattr-cache-list", tmp_str, str, out);
     mdc_xattr_list_populate(conf, tmp_str);
 
@@ -3738,6 +4312,8 @@ mdc_init(xlator_t *this)
     GF_ATOMIC_INIT(conf->mdc_counter.stat_invals, 0);
     GF_ATOMIC_INIT(conf->mdc_counter.xattr_invals, 0);
     GF_ATOMIC_INIT(conf->mdc_counter.need_lookup, 0);
+    GF_ATOMIC_INIT(conf->mdc_counter.xattr_absent_hit, 0);
+    GF_ATOMIC_INIT(conf->mdc_counter.evictions, 0);
     GF_ATOMIC_INIT(conf->generation, 0);
 
     /* If timeout is greater than 60s (default before the patch that added
@@ -3993,6 +4569,35 @@ struct volume_options mdc_options[] = {
         .description = "A comma separated list of xattrs that shall be "
                        "cached by md-cache. The only wildcard allowed is '*'",
     },
+    {
+        .key = {"cache-absent-xattrs"},
+        .type = GF_OPTION_TYPE_BOOL,
+        .default_value = "off",
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+        .tags = {"md-cache"},
+        .description = "Remember the user, security and system xattrs not "
+                       "in xattr-cache-list that a file was found not to "
+                       "have, and fail their getxattr with ENODATA without "
+                       "asking the bricks, as long as the ctime of the file "
+                       "cached is the same. Changes made to them from other "
+                       "clients are only seen once the ctime cached is "
+                       "refreshed.",
+    },
+    {
+        .key = {"md-cache-size"},
+        .type = GF_OPTION_TYPE_SIZET,
+        .min = 0,
+        .max = 32 * GF_UNIT_GB,
+        .default_value = "0",
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+        .tags = {"md-cache"},
+        .description = "Maximum memory used by the metadata and xattrs "
+                       "cached. The cache of the inodes least recently "
+                       "updated and not read since is dropped beyond it. "
+                       "0 for no limit.",
+    },
     {.key = {"pass-through"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "false",
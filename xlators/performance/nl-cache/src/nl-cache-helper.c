@@ -11,6 +11,7 @@
 #include "nl-cache.h"
 #include "timer-wheel.h"
 #include <glusterfs/statedump.h>
+#include <glusterfs/checksum.h>
 
 /* Caching guidelines:
  * This xlator serves negative lookup(ENOENT lookups) from the cache,
@@ -39,6 +40,15 @@
  *             Search - O(n)
  *             Add    - O(1)
  *             Delete - O(n) - as it has to be searched before deleting
+ *      With nl-cache-readdir-filter, a complete listing of the directory
+ *          read from offset 0 to the end through one fd is turned into a
+ *          bloom filter of the names in it, sized for the number of names.
+ *          Entries created since, here or by other clients (the upcall of
+ *          the parent carries the name), are added to it. Removed entries
+ *          stay, only costing a false positive. The listing is dropped if
+ *          entries may have been added while it was read (nlc_ctx->gen).
+ *             Search - O(1)
+ *             Add    - O(1)
  *      Positive entries are stored as a list, each list node has a pointer
  *          to the inode of the positive entry or the name of the entry.
  *          Since the client side inode table already will have inodes for
@@ -76,6 +86,8 @@ void
 __nlc_free_pe(xlator_t *this, nlc_ctx_t *nlc_ctx, nlc_pe_t *pe);
 void
 __nlc_free_ne(xlator_t *this, nlc_ctx_t *nlc_ctx, nlc_ne_t *ne);
+static void
+__nlc_free_filter(xlator_t *this, nlc_ctx_t *nlc_ctx);
 
 static int32_t
 nlc_get_cache_timeout(xlator_t *this)
@@ -224,6 +236,9 @@ __nlc_inode_clear_entries(xlator_t *this, nlc_ctx_t *nlc_ctx)
             __nlc_free_ne(this, nlc_ctx, ne);
         }
 
+    __nlc_free_filter(this, nlc_ctx);
+    nlc_ctx->gen++;
+
     nlc_ctx->cache_time = 0;
     nlc_ctx->state = 0;
     GF_ASSERT(nlc_ctx->cache_size == sizeof(*nlc_ctx));
@@ -308,6 +323,7 @@ nlc_inode_ctx_get_set(xlator_t *this, inode_t *inode, nlc_ctx_t **nlc_ctx_p)
         LOCK_INIT(&nlc_ctx->lock);
         INIT_LIST_HEAD(&nlc_ctx->pe);
         INIT_LIST_HEAD(&nlc_ctx->ne);
+        nlc_ctx->gen = 1;
 
         ret = __nlc_inode_ctx_timer_start(this, inode, nlc_ctx);
         if (ret < 0)
@@ -383,6 +399,9 @@ nlc_local_wipe(xlator_t *this, nlc_local_t *local)
 
     loc_wipe(&local->loc2);
 
+    if (local->fd)
+        fd_unref(local->fd);
+
     GF_FREE(local);
 out:
     return;
@@ -712,6 +731,107 @@ out:
     return;
 }
 
+uint64_t
+nlc_name_hash(const char *name)
+{
+    return gf_rsync_fast_checksum((unsigned char *)name, strlen(name));
+}
+
+/* A filter may take up to half of nl-cache-limit */
+uint64_t
+nlc_filter_max_entries(xlator_t *this)
+{
+    nlc_conf_t *conf = NULL;
+    uint64_t max_entries = 0;
+
+    conf = this->private;
+
+    max_entries = conf->cache_size / 2 * 8 / NLC_FILTER_BITS_PER_ENTRY;
+
+    return min(max_entries, UINT32_MAX / NLC_FILTER_BITS_PER_ENTRY);
+}
+
+static size_t
+nlc_filter_size(uint64_t nbits)
+{
+    return sizeof(nlc_filter_t) + nbits / 8;
+}
+
+/* Double hashing on the two halves of the hash of the name, scaled to
+ * [0, nbits) by a multiply rather than a modulo */
+static uint64_t
+nlc_filter_bit(nlc_filter_t *filter, uint64_t hash, int i)
+{
+    uint32_t h = (uint32_t)hash + i * (uint32_t)((hash >> 32) | 1);
+
+    return ((uint64_t)h * filter->nbits) >> 32;
+}
+
+static void
+__nlc_filter_add(nlc_filter_t *filter, uint64_t hash)
+{
+    uint64_t bit = 0;
+    int i = 0;
+
+    for (i = 0; i < NLC_FILTER_HASHES; i++) {
+        bit = nlc_filter_bit(filter, hash, i);
+        filter->bits[bit / 64] |= 1ULL << (bit % 64);
+    }
+    filter->entries++;
+}
+
+static gf_boolean_t
+__nlc_filter_test(nlc_filter_t *filter, uint64_t hash)
+{
+    uint64_t bit = 0;
+    int i = 0;
+
+    for (i = 0; i < NLC_FILTER_HASHES; i++) {
+        bit = nlc_filter_bit(filter, hash, i);
+        if (!(filter->bits[bit / 64] & (1ULL << (bit % 64))))
+            return _gf_false;
+    }
+
+    return _gf_true;
+}
+
+static void
+__nlc_free_filter(xlator_t *this, nlc_ctx_t *nlc_ctx)
+{
+    nlc_conf_t *conf = NULL;
+    size_t size = 0;
+
+    conf = this->private;
+
+    if (!nlc_ctx->filter)
+        return;
+
+    size = nlc_filter_size(nlc_ctx->filter->nbits);
+    nlc_ctx->cache_size -= size;
+    GF_ATOMIC_SUB(conf->current_cache_size, size);
+
+    GF_FREE(nlc_ctx->filter);
+    nlc_ctx->filter = NULL;
+}
+
+static void
+__nlc_filter_add_name(xlator_t *this, nlc_ctx_t *nlc_ctx, const char *name)
+{
+    nlc_filter_t *filter = nlc_ctx->filter;
+
+    if (!filter || !name)
+        return;
+
+    /* Names are never taken out, past twice the names it was sized for
+     * there are too many false positives for it to be worth keeping */
+    if (filter->entries >= 2 * filter->nbits / NLC_FILTER_BITS_PER_ENTRY) {
+        __nlc_free_filter(this, nlc_ctx);
+        return;
+    }
+
+    __nlc_filter_add(filter, nlc_name_hash(name));
+}
+
 static void
 __nlc_del_pe(xlator_t *this, nlc_ctx_t *nlc_ctx, inode_t *entry_ino,
              const char *name, gf_boolean_t multilink)
@@ -930,11 +1050,28 @@ out:
     return;
 }
 
+static void
+__nlc_add_entry(xlator_t *this, nlc_ctx_t *nlc_ctx, inode_t *entry_ino,
+                const char *name, gf_boolean_t add_pe)
+{
+    __nlc_del_ne(this, nlc_ctx, name);
+    if (add_pe) {
+        __nlc_add_pe(this, nlc_ctx, entry_ino, name);
+        if (!IS_PE_VALID(nlc_ctx->state))
+            __nlc_set_dir_state(nlc_ctx, NLC_PE_PARTIAL);
+    }
+    __nlc_filter_add_name(this, nlc_ctx, name);
+    nlc_ctx->gen++;
+}
+
 void
 nlc_dir_add_pe(xlator_t *this, inode_t *inode, inode_t *entry_ino,
                const char *name)
 {
     nlc_ctx_t *nlc_ctx = NULL;
+    nlc_conf_t *conf = NULL;
+
+    conf = this->private;
 
     if (inode->ia_type != IA_IFDIR) {
         gf_msg_callingfn(this->name, GF_LOG_ERROR, EINVAL, NLC_MSG_EINVAL,
@@ -948,16 +1085,107 @@ nlc_dir_add_pe(xlator_t *this, inode_t *inode, inode_t *entry_ino,
 
     LOCK(&nlc_ctx->lock);
     {
-        __nlc_del_ne(this, nlc_ctx, name);
-        __nlc_add_pe(this, nlc_ctx, entry_ino, name);
-        if (!IS_PE_VALID(nlc_ctx->state))
-            __nlc_set_dir_state(nlc_ctx, NLC_PE_PARTIAL);
+        __nlc_add_entry(this, nlc_ctx, entry_ino, name, IS_PEC_ENABLED(conf));
     }
     UNLOCK(&nlc_ctx->lock);
 out:
     return;
 }
 
+/* Another client created name in the directory. Only what is cached is kept
+ * up to date, nothing is started caching. */
+void
+nlc_dir_add_upcall_entry(xlator_t *this, inode_t *inode, const char *name)
+{
+    nlc_ctx_t *nlc_ctx = NULL;
+
+    nlc_inode_ctx_get(this, inode, &nlc_ctx);
+    if (!nlc_ctx)
+        goto out;
+
+    LOCK(&nlc_ctx->lock);
+    {
+        if (!__nlc_is_cache_valid(this, nlc_ctx))
+            goto unlock;
+
+        __nlc_add_entry(this, nlc_ctx, NULL, name,
+                        IS_PE_VALID(nlc_ctx->state));
+    }
+unlock:
+    UNLOCK(&nlc_ctx->lock);
+out:
+    return;
+}
+
+uint64_t
+nlc_dir_get_gen(xlator_t *this, inode_t *inode)
+{
+    nlc_ctx_t *nlc_ctx = NULL;
+    uint64_t gen = 0;
+
+    nlc_inode_ctx_get_set(this, inode, &nlc_ctx);
+    if (!nlc_ctx)
+        goto out;
+
+    LOCK(&nlc_ctx->lock);
+    {
+        gen = nlc_ctx->gen;
+    }
+    UNLOCK(&nlc_ctx->lock);
+out:
+    return gen;
+}
+
+/* Installs the filter of a complete listing of the directory, unless entries
+ * may have been added to it since the listing started */
+void
+nlc_dir_set_filter(xlator_t *this, inode_t *inode, uint64_t gen,
+                   uint64_t *hashes, uint64_t count)
+{
+    nlc_ctx_t *nlc_ctx = NULL;
+    nlc_conf_t *conf = NULL;
+    nlc_filter_t *filter = NULL;
+    uint64_t nbits = 0;
+    uint64_t i = 0;
+
+    conf = this->private;
+
+    nbits = max(count * NLC_FILTER_BITS_PER_ENTRY, 64);
+    nbits = (nbits + 63) & ~63ULL;
+
+    filter = GF_CALLOC(1, nlc_filter_size(nbits), gf_nlc_mt_nlc_filter_t);
+    if (!filter)
+        goto out;
+
+    filter->nbits = nbits;
+    for (i = 0; i < count; i++)
+        __nlc_filter_add(filter, hashes[i]);
+
+    nlc_inode_ctx_get(this, inode, &nlc_ctx);
+    if (!nlc_ctx)
+        goto out;
+
+    LOCK(&nlc_ctx->lock);
+    {
+        if ((nlc_ctx->gen != gen) || !__nlc_is_cache_valid(this, nlc_ctx))
+            goto unlock;
+
+        __nlc_free_filter(this, nlc_ctx);
+        nlc_ctx->filter = filter;
+        nlc_ctx->cache_size += nlc_filter_size(nbits);
+        GF_ATOMIC_ADD(conf->current_cache_size, nlc_filter_size(nbits));
+        GF_ATOMIC_INC(conf->nlc_counter.filters_built);
+        filter = NULL;
+    }
+unlock:
+    UNLOCK(&nlc_ctx->lock);
+
+    nlc_lru_prune(this, NULL);
+out:
+    GF_FREE(filter);
+    return;
+}
+
 gf_boolean_t
 __nlc_search_ne(nlc_ctx_t *nlc_ctx, const char *name)
 {
@@ -1036,8 +1264,12 @@ gf_boolean_t
 nlc_is_negative_lookup(xlator_t *this, loc_t *loc)
 {
     nlc_ctx_t *nlc_ctx = NULL;
+    nlc_conf_t *conf = NULL;
     inode_t *inode = NULL;
     gf_boolean_t neg_entry = _gf_false;
+    uint64_t hash = 0;
+
+    conf = this->private;
 
     inode = loc->parent;
     GF_VALIDATE_OR_GOTO(this->name, inode, out);
@@ -1052,11 +1284,21 @@ nlc_is_negative_lookup(xlator_t *this, loc_t *loc)
     if (!nlc_ctx)
         goto out;
 
+    if (IS_FILTER_ENABLED(conf))
+        hash = nlc_name_hash(loc->name);
+
     LOCK(&nlc_ctx->lock);
     {
         if (!__nlc_is_cache_valid(this, nlc_ctx))
             goto unlock;
 
+        if (nlc_ctx->filter && IS_FILTER_ENABLED(conf) &&
+            !__nlc_filter_test(nlc_ctx->filter, hash)) {
+            nlc_ctx->filter->hits++;
+            GF_ATOMIC_INC(conf->nlc_counter.filter_hit);
+            neg_entry = _gf_true;
+            goto unlock;
+        }
         if (__nlc_search_ne(nlc_ctx, loc->name)) {
             neg_entry = _gf_true;
             goto unlock;
@@ -1132,6 +1374,177 @@ out:
     return hit;
 }
 
+static nlc_fd_t *
+nlc_fd_ctx_get_set(xlator_t *this, fd_t *fd)
+{
+    nlc_fd_t *fd_ctx = NULL;
+    uint64_t value = 0;
+
+    LOCK(&fd->lock);
+    {
+        if (__fd_ctx_get(fd, this, &value) == 0) {
+            fd_ctx = (void *)(uintptr_t)value;
+            goto unlock;
+        }
+
+        fd_ctx = GF_CALLOC(1, sizeof(*fd_ctx), gf_nlc_mt_nlc_fd_t);
+        if (!fd_ctx)
+            goto unlock;
+
+        LOCK_INIT(&fd_ctx->lock);
+        if (__fd_ctx_set(fd, this, (uint64_t)(uintptr_t)fd_ctx)) {
+            LOCK_DESTROY(&fd_ctx->lock);
+            GF_FREE(fd_ctx);
+            fd_ctx = NULL;
+        }
+    }
+unlock:
+    UNLOCK(&fd->lock);
+
+    return fd_ctx;
+}
+
+static void
+__nlc_fd_listing_stop(nlc_fd_t *fd_ctx)
+{
+    fd_ctx->listing = _gf_false;
+    GF_FREE(fd_ctx->hashes);
+    fd_ctx->hashes = NULL;
+    fd_ctx->count = 0;
+    fd_ctx->max = 0;
+}
+
+static int
+__nlc_fd_listing_add(xlator_t *this, nlc_fd_t *fd_ctx, const char *name)
+{
+    uint64_t *hashes = NULL;
+    uint64_t max = 0;
+
+    if (fd_ctx->count == fd_ctx->max) {
+        max = fd_ctx->max ? fd_ctx->max * 2 : 1024;
+        if (max > nlc_filter_max_entries(this))
+            max = nlc_filter_max_entries(this);
+        if (fd_ctx->count >= max)
+            return -1;
+
+        if (fd_ctx->hashes)
+            hashes = GF_REALLOC(fd_ctx->hashes, max * sizeof(*hashes));
+        else
+            hashes = GF_MALLOC(max * sizeof(*hashes), gf_nlc_mt_nlc_fd_t);
+        if (!hashes)
+            return -1;
+
+        fd_ctx->hashes = hashes;
+        fd_ctx->max = max;
+    }
+
+    fd_ctx->hashes[fd_ctx->count++] = nlc_name_hash(name);
+
+    return 0;
+}
+
+/* A listing of the directory is followed while it starts at offset 0 and
+ * each readdir continues where the previous one ended */
+void
+nlc_readdir_begin(xlator_t *this, fd_t *fd, off_t offset)
+{
+    nlc_fd_t *fd_ctx = NULL;
+    uint64_t gen = 0;
+
+    fd_ctx = nlc_fd_ctx_get_set(this, fd);
+    if (!fd_ctx)
+        goto out;
+
+    if (offset == 0)
+        gen = nlc_dir_get_gen(this, fd->inode);
+
+    LOCK(&fd_ctx->lock);
+    {
+        if (offset == 0) {
+            __nlc_fd_listing_stop(fd_ctx);
+            fd_ctx->listing = (gen != 0);
+            fd_ctx->gen = gen;
+            fd_ctx->next = 0;
+        } else if (offset != fd_ctx->next) {
+            __nlc_fd_listing_stop(fd_ctx);
+        }
+    }
+    UNLOCK(&fd_ctx->lock);
+out:
+    return;
+}
+
+void
+nlc_readdir_end(xlator_t *this, fd_t *fd, off_t offset, int op_ret,
+                gf_dirent_t *entries)
+{
+    nlc_fd_t *fd_ctx = NULL;
+    gf_dirent_t *entry = NULL;
+    uint64_t *hashes = NULL;
+    uint64_t count = 0;
+    uint64_t gen = 0;
+    uint64_t value = 0;
+
+    if (fd_ctx_get(fd, this, &value) || !value)
+        goto out;
+    fd_ctx = (void *)(uintptr_t)value;
+
+    LOCK(&fd_ctx->lock);
+    {
+        if (!fd_ctx->listing || (offset != fd_ctx->next))
+            goto unlock;
+
+        if (op_ret < 0) {
+            __nlc_fd_listing_stop(fd_ctx);
+            goto unlock;
+        }
+
+        if (op_ret == 0) {
+            /* End of the directory */
+            hashes = fd_ctx->hashes;
+            count = fd_ctx->count;
+            gen = fd_ctx->gen;
+            fd_ctx->hashes = NULL;
+            __nlc_fd_listing_stop(fd_ctx);
+            goto unlock;
+        }
+
+        list_for_each_entry(entry, &entries->list, list)
+        {
+            if (__nlc_fd_listing_add(this, fd_ctx, entry->d_name)) {
+                __nlc_fd_listing_stop(fd_ctx);
+                goto unlock;
+            }
+            fd_ctx->next = entry->d_off;
+        }
+    }
+unlock:
+    UNLOCK(&fd_ctx->lock);
+
+    if (hashes) {
+        nlc_dir_set_filter(this, fd->inode, gen, hashes, count);
+        GF_FREE(hashes);
+    }
+out:
+    return;
+}
+
+void
+nlc_fd_ctx_free(xlator_t *this, fd_t *fd)
+{
+    nlc_fd_t *fd_ctx = NULL;
+    uint64_t value = 0;
+
+    fd_ctx_del(fd, this, &value);
+    fd_ctx = (void *)(uintptr_t)value;
+    if (!fd_ctx)
+        return;
+
+    GF_FREE(fd_ctx->hashes);
+    LOCK_DESTROY(&fd_ctx->lock);
+    GF_FREE(fd_ctx);
+}
+
 void
 nlc_dump_inodectx(xlator_t *this, inode_t *inode)
 {
@@ -1176,6 +1589,15 @@ nlc_dump_inodectx(xlator_t *this, inode_t *inode)
         gf_proc_dump_write("cache-time", "%ld", nlc_ctx->cache_time);
         gf_proc_dump_write("cache-size", "%zu", nlc_ctx->cache_size);
         gf_proc_dump_write("refd-inodes", "%" PRIu64, nlc_ctx->refd_inodes);
+        gf_proc_dump_write("gen", "%" PRIu64, nlc_ctx->gen);
+        if (nlc_ctx->filter) {
+            gf_proc_dump_write("filter-entries", "%" PRIu64,
+                               nlc_ctx->filter->entries);
+            gf_proc_dump_write("filter-bits", "%" PRIu64,
+                               nlc_ctx->filter->nbits);
+            gf_proc_dump_write("filter-hits", "%" PRIu64,
+                               nlc_ctx->filter->hits);
+        }
 
         if (IS_PE_VALID(nlc_ctx->state))
             list_for_each_entry_safe(pe, tmp, &nlc_ctx->pe, list)
@@ -16,12 +16,14 @@ static void
 nlc_dentry_op(call_frame_t *frame, xlator_t *this, gf_boolean_t multilink)
 {
     nlc_local_t *local = frame->local;
+    nlc_conf_t *conf = this->private;
 
     GF_VALIDATE_OR_GOTO(this->name, local, out);
 
     switch (local->fop) {
         case GF_FOP_MKDIR:
-            nlc_set_dir_state(this, local->loc.inode, NLC_PE_FULL);
+            if (IS_PEC_ENABLED(conf))
+                nlc_set_dir_state(this, local->loc.inode, NLC_PE_FULL);
             /*fall-through*/
         case GF_FOP_MKNOD:
         case GF_FOP_CREATE:
@@ -65,7 +67,7 @@ out:
                                                                                \
         conf = this->private;                                                  \
                                                                                \
-        if (!IS_PEC_ENABLED(conf))                                             \
+        if (!IS_DENTRY_TRACKED(conf))                                          \
             goto disabled;                                                     \
                                                                                \
         __local = nlc_local_init(frame, this, _op, loc1, loc2);                \
@@ -92,7 +94,7 @@ out:
                                                                                \
         conf = this->private;                                                  \
                                                                                \
-        if (op_ret < 0 || !IS_PEC_ENABLED(conf))                               \
+        if (op_ret < 0 || !IS_DENTRY_TRACKED(conf))                            \
             goto out;                                                          \
         nlc_dentry_op(frame, this, multilink);                                 \
     out:                                                                       \
@@ -417,7 +419,7 @@ nlc_unlink(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
 
     conf = this->private;
 
-    if (!IS_PEC_ENABLED(conf))
+    if (!IS_DENTRY_TRACKED(conf))
         goto do_fop;
 
     if (!xdata) {
@@ -440,6 +442,91 @@ do_fop:
     return 0;
 }
 
+static int32_t
+nlc_readdir_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                int32_t op_ret, int32_t op_errno, gf_dirent_t *entries,
+                dict_t *xdata)
+{
+    nlc_local_t *local = frame->local;
+
+    nlc_readdir_end(this, local->fd, local->offset, op_ret, entries);
+
+    NLC_STACK_UNWIND(readdir, frame, op_ret, op_errno, entries, xdata);
+    return 0;
+}
+
+static int32_t
+nlc_readdir(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+            off_t offset, dict_t *xdata)
+{
+    nlc_local_t *local = NULL;
+    nlc_conf_t *conf = NULL;
+
+    conf = this->private;
+
+    if (!IS_FILTER_ENABLED(conf))
+        goto wind;
+
+    /* Nothing is cached from the listing without a local */
+    local = nlc_local_init(frame, this, GF_FOP_READDIR, NULL, NULL);
+    if (!local)
+        goto wind;
+
+    local->fd = fd_ref(fd);
+    local->offset = offset;
+    nlc_readdir_begin(this, fd, offset);
+
+    STACK_WIND(frame, nlc_readdir_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->readdir, fd, size, offset, xdata);
+    return 0;
+wind:
+    STACK_WIND(frame, default_readdir_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->readdir, fd, size, offset, xdata);
+    return 0;
+}
+
+static int32_t
+nlc_readdirp_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, gf_dirent_t *entries,
+                 dict_t *xdata)
+{
+    nlc_local_t *local = frame->local;
+
+    nlc_readdir_end(this, local->fd, local->offset, op_ret, entries);
+
+    NLC_STACK_UNWIND(readdirp, frame, op_ret, op_errno, entries, xdata);
+    return 0;
+}
+
+static int32_t
+nlc_readdirp(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+             off_t offset, dict_t *xdata)
+{
+    nlc_local_t *local = NULL;
+    nlc_conf_t *conf = NULL;
+
+    conf = this->private;
+
+    if (!IS_FILTER_ENABLED(conf))
+        goto wind;
+
+    local = nlc_local_init(frame, this, GF_FOP_READDIRP, NULL, NULL);
+    if (!local)
+        goto wind;
+
+    local->fd = fd_ref(fd);
+    local->offset = offset;
+    nlc_readdir_begin(this, fd, offset);
+
+    STACK_WIND(frame, nlc_readdirp_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->readdirp, fd, size, offset, xdata);
+    return 0;
+wind:
+    STACK_WIND(frame, default_readdirp_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->readdirp, fd, size, offset, xdata);
+    return 0;
+}
+
 static int32_t
 nlc_invalidate(xlator_t *this, void *data)
 {
@@ -451,6 +538,7 @@ nlc_invalidate(xlator_t *this, void *data)
     int ret = 0;
     inode_table_t *itable = NULL;
     nlc_conf_t *conf = NULL;
+    char *name = NULL;
 
     up_data = (struct gf_upcall *)data;
 
@@ -478,6 +566,16 @@ nlc_invalidate(xlator_t *this, void *data)
         goto out;
     }
 
+    /* An entry was created in the directory, the rest of what is cached
+     * stays true */
+    if ((up_ci->flags == UP_TIMES) && (inode->ia_type == IA_IFDIR) &&
+        up_ci->dict &&
+        (dict_get_str(up_ci->dict, UP_ENTRY_CREATED, &name) == 0)) {
+        nlc_dir_add_upcall_entry(this, inode, name);
+        GF_ATOMIC_INC(conf->nlc_counter.upcall_updates);
+        goto out;
+    }
+
     if (!gf_uuid_is_null(up_ci->p_stat.ia_gfid)) {
         parent1 = inode_find(itable, up_ci->p_stat.ia_gfid);
         if (!parent1) {
@@ -494,8 +592,8 @@ nlc_invalidate(xlator_t *this, void *data)
         }
     }
 
-    /* TODO: get enough data in upcall so that we do not invalidate but
-     * update */
+    /* TODO: get enough data in upcall for the other changes too, so that
+     * we do not invalidate but update */
     if (inode && inode->ia_type == IA_IFDIR)
         nlc_inode_clear_cache(this, inode, NLC_NONE);
     if (parent1)
@@ -570,6 +668,13 @@ nlc_forget(xlator_t *this, inode_t *inode)
     return 0;
 }
 
+static int32_t
+nlc_releasedir(xlator_t *this, fd_t *fd)
+{
+    nlc_fd_ctx_free(this, fd);
+    return 0;
+}
+
 static int32_t
 nlc_inodectx(xlator_t *this, inode_t *inode)
 {
@@ -604,6 +709,12 @@ nlc_priv_dump(xlator_t *this)
                        GF_ATOMIC_GET(conf->nlc_counter.ne_inode_cnt));
     gf_proc_dump_write("dentry_invalidations_received", "%" PRId64,
                        GF_ATOMIC_GET(conf->nlc_counter.nlc_invals));
+    gf_proc_dump_write("dentry_updates_received", "%" PRId64,
+                       GF_ATOMIC_GET(conf->nlc_counter.upcall_updates));
+    gf_proc_dump_write("readdir_filters_built", "%" PRId64,
+                       GF_ATOMIC_GET(conf->nlc_counter.filters_built));
+    gf_proc_dump_write("readdir_filter_hit_count", "%" PRId64,
+                       GF_ATOMIC_GET(conf->nlc_counter.filter_hit));
     gf_proc_dump_write("cache_limit", "%" PRIu64, conf->cache_size);
     gf_proc_dump_write("consumed_cache_size", "%" PRId64,
                        GF_ATOMIC_GET(conf->current_cache_size));
@@ -637,6 +748,12 @@ nlc_dump_metrics(xlator_t *this, int fd)
             this->name, GF_ATOMIC_GET(conf->nlc_counter.ne_inode_cnt));
     dprintf(fd, "%s.dentry_invalidations_received %" PRId64 "\n", this->name,
             GF_ATOMIC_GET(conf->nlc_counter.nlc_invals));
+    dprintf(fd, "%s.dentry_updates_received %" PRId64 "\n", this->name,
+            GF_ATOMIC_GET(conf->nlc_counter.upcall_updates));
+    dprintf(fd, "%s.readdir_filters_built %" PRId64 "\n", this->name,
+            GF_ATOMIC_GET(conf->nlc_counter.filters_built));
+    dprintf(fd, "%s.readdir_filter_hit_count %" PRId64 "\n", this->name,
+            GF_ATOMIC_GET(conf->nlc_counter.filter_hit));
     dprintf(fd, "%s.cache_limit %" PRIu64 "\n", this->name, conf->cache_size);
     dprintf(fd, "%s.consumed_cache_size %" PRId64 "\n", this->name,
             GF_ATOMIC_GET(conf->current_cache_size));
@@ -682,6 +799,8 @@ nlc_reconfigure(xlator_t *this, dict_t *options)
                      options, bool, out);
     GF_OPTION_RECONF("nl-cache-limit", conf->cache_size, options, size_uint64,
                      out);
+    GF_OPTION_RECONF("nl-cache-readdir-filter", conf->readdir_filter, options,
+                     bool, out);
     GF_OPTION_RECONF("pass-through", this->pass_through, options, bool, out);
 
 out:
@@ -703,6 +822,7 @@ nlc_init(xlator_t *this)
     GF_OPTION_INIT("nl-cache-positive-entry", conf->positive_entry_cache, bool,
                    out);
     GF_OPTION_INIT("nl-cache-limit", conf->cache_size, size_uint64, out);
+    GF_OPTION_INIT("nl-cache-readdir-filter", conf->readdir_filter, bool, out);
     GF_OPTION_INIT("pass-through", this->pass_through, bool, out);
 
     /* Since the positive entries are stored as list of refs on
@@ -727,6 +847,9 @@ nlc_init(xlator_t *this)
     GF_ATOMIC_INIT(conf->nlc_counter.pe_inode_cnt, 0);
     GF_ATOMIC_INIT(conf->nlc_counter.ne_inode_cnt, 0);
     GF_ATOMIC_INIT(conf->nlc_counter.nlc_invals, 0);
+    GF_ATOMIC_INIT(conf->nlc_counter.filter_hit, 0);
+    GF_ATOMIC_INIT(conf->nlc_counter.filters_built, 0);
+    GF_ATOMIC_INIT(conf->nlc_counter.upcall_updates, 0);
 
     INIT_LIST_HEAD(&conf->lru);
     conf->last_child_down = gf_time();
@@ -759,15 +882,16 @@ struct xlator_fops nlc_fops = {
     .symlink = nlc_symlink,
     .link = nlc_link,
     .unlink = nlc_unlink,
+    .readdir = nlc_readdir,
+    .readdirp = nlc_readdirp,
     /* TODO:
-    .readdir              = nlc_readdir,
-    .readdirp             = nlc_readdirp,
     .seek                 = nlc_seek,
     .opendir              = nlc_opendir, */
 };
 
 struct xlator_cbks nlc_cbks = {
     .forget = nlc_forget,
+    .releasedir = nlc_releasedir,
 };
 
 struct xlator_dumpops nlc_dumpops = {
@@ -803,6 +927,17 @@ struct volume_options nlc_options[] = {
         .description = "the value over which caching will be disabled for"
                        "a while and the cache is cleared based on LRU",
     },
+    {
+        .key = {"nl-cache-readdir-filter"},
+        .type = GF_OPTION_TYPE_BOOL,
+        .default_value = "false",
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+        .description = "After a complete listing of a directory, keep a bloom"
+                       " filter of the names in it and serve the lookups of"
+                       " the names not in it from the cache. A filter can"
+                       " take up to half of nl-cache-limit.",
+    },
     {
         .key = {"nl-cache-timeout"},
         .type = GF_OPTION_TYPE_TIME,
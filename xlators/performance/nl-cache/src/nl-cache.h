@@ -28,6 +28,11 @@
 #define IS_NE_VALID(state) ((state != NLC_INVALID) && (state & NLC_NE_VALID))
 
 #define IS_PEC_ENABLED(conf) (conf->positive_entry_cache)
+#define IS_FILTER_ENABLED(conf) (conf->readdir_filter)
+/* Entries created and removed through this client are tracked if either
+ * needs them */
+#define IS_DENTRY_TRACKED(conf)                                                \
+    (IS_PEC_ENABLED(conf) || IS_FILTER_ENABLED(conf))
 #define IS_CACHE_ENABLED(conf) ((!conf->cache_disabled))
 
 #define NLC_STACK_UNWIND(fop, frame, params...)                                \
@@ -61,6 +66,32 @@ struct nlc_pe {
 };
 typedef struct nlc_pe nlc_pe_t;
 
+/* Bloom filter of the names in a directory, built from a complete listing of
+ * it and kept up to date with the entries created since. Names removed stay
+ * in it, a name that is not in it is known not to exist. */
+#define NLC_FILTER_BITS_PER_ENTRY 10 /* about 1% false positives */
+#define NLC_FILTER_HASHES 7
+
+struct nlc_filter {
+    uint64_t nbits;
+    uint64_t entries;
+    uint64_t hits;
+    uint64_t bits[];
+};
+typedef struct nlc_filter nlc_filter_t;
+
+/* A listing of the directory read through the fd, from offset 0 on */
+struct nlc_fd {
+    gf_lock_t lock;
+    uint64_t gen;     /* of the directory when the listing started */
+    off_t next;       /* offset the listing continues at */
+    uint64_t *hashes; /* of the names listed so far */
+    uint64_t count;
+    uint64_t max;
+    gf_boolean_t listing;
+};
+typedef struct nlc_fd nlc_fd_t;
+
 struct nlc_timer_data {
     inode_t *inode;
     xlator_t *this;
@@ -82,6 +113,8 @@ struct nlc_ctx {
     nlc_timer_data_t *timer_data;
     size_t cache_size;
     uint64_t refd_inodes;
+    nlc_filter_t *filter;
+    uint64_t gen; /* bumped when entries may have been added */
     gf_lock_t lock;
 };
 typedef struct nlc_ctx nlc_ctx_t;
@@ -93,6 +126,7 @@ struct nlc_local {
     inode_t *parent;
     fd_t *fd;
     char *linkname;
+    off_t offset;
     glusterfs_fop_t fop;
 };
 typedef struct nlc_local nlc_local_t;
@@ -107,6 +141,9 @@ struct nlc_statistics {
     gf_atomic_t pe_inode_cnt;
     gf_atomic_t ne_inode_cnt;
     gf_atomic_t nlc_invals; /* No. of invalidates received from upcall*/
+    gf_atomic_t filter_hit; /* No. of nlc_hit answered by a filter */
+    gf_atomic_t filters_built;
+    gf_atomic_t upcall_updates; /* invalidates applied to the cache */
 };
 
 struct nlc_conf {
@@ -114,6 +151,7 @@ struct nlc_conf {
     gf_boolean_t positive_entry_cache;
     gf_boolean_t negative_entry_cache;
     gf_boolean_t disable_cache;
+    gf_boolean_t readdir_filter;
     uint64_t cache_size;
     gf_atomic_t current_cache_size;
     uint64_t inode_limit;
@@ -147,6 +185,32 @@ nlc_dir_remove_pe(xlator_t *this, inode_t *inode, inode_t *entry_ino,
 void
 nlc_dir_add_ne(xlator_t *this, inode_t *inode, const char *name);
 
+void
+nlc_dir_add_upcall_entry(xlator_t *this, inode_t *inode, const char *name);
+
+uint64_t
+nlc_dir_get_gen(xlator_t *this, inode_t *inode);
+
+void
+nlc_dir_set_filter(xlator_t *this, inode_t *inode, uint64_t gen,
+                   uint64_t *hashes, uint64_t count);
+
+uint64_t
+nlc_name_hash(const char *name);
+
+uint64_t
+nlc_filter_max_entries(xlator_t *this);
+
+void
+nlc_readdir_begin(xlator_t *this, fd_t *fd, off_t offset);
+
+void
+nlc_readdir_end(xlator_t *this, fd_t *fd, off_t offset, int op_ret,
+                gf_dirent_t *entries);
+
+void
+nlc_fd_ctx_free(xlator_t *this, fd_t *fd);
+
 void
 nlc_local_wipe(xlator_t *this, nlc_local_t *local);
 
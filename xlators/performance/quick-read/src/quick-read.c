@@ -9,6 +9,7 @@
 */
 
 #include <math.h>
+#include <zlib.h>
 #include "quick-read.h"
 #include <glusterfs/statedump.h>
 #include "quick-read-messages.h"
@@ -249,11 +250,17 @@ __qr_inode_register(xlator_t *this, qr_inode_table_t *table,
     if (!priv)
         return;
 
-    if (list_empty(&qr_inode->lru))
+    if (list_empty(&qr_inode->lru)) {
         /* first time addition of this qr_inode into table */
-        table->cache_used += qr_inode->size;
-    else
+        table->cache_used += qr_inode->data_size;
+        if (qr_inode->compressed) {
+            table->compressed_used += qr_inode->data_size;
+            table->compressed_size += qr_inode->size;
+            table->compressed_files++;
+        }
+    } else {
         list_del_init(&qr_inode->lru);
+    }
 
     list_add_tail(&qr_inode->lru, &table->lru[qr_inode->priority]);
 
@@ -306,8 +313,15 @@ __qr_inode_prune_data(xlator_t *this, qr_inode_table_t *table,
     qr_inode->data = NULL;
 
     if (!list_empty(&qr_inode->lru)) {
-        table->cache_used -= qr_inode->size;
+        table->cache_used -= qr_inode->data_size;
+        if (qr_inode->compressed) {
+            table->compressed_used -= qr_inode->data_size;
+            table->compressed_size -= qr_inode->size;
+            table->compressed_files--;
+        }
         qr_inode->size = 0;
+        qr_inode->data_size = 0;
+        qr_inode->compressed = _gf_false;
 
         list_del_init(&qr_inode->lru);
 
@@ -414,6 +428,85 @@ out:
     return content;
 }
 
+/*
+ * Compress the content of a file, returns NULL when it is not worth it:
+ * the file is tiny or does not shrink by QR_COMPRESSION_MIN_SAVING.
+ */
+static void *
+qr_content_deflate(void *content, size_t size, size_t *data_size)
+{
+    void *data = NULL;
+    void *shrunk = NULL;
+    uLongf len = 0;
+
+    if (size < QR_COMPRESSION_MIN_SIZE)
+        return NULL;
+
+    len = compressBound(size);
+    data = GF_MALLOC(len, gf_qr_mt_content_t);
+    if (!data)
+        return NULL;
+
+    if ((compress2(data, &len, content, size, Z_BEST_SPEED) != Z_OK) ||
+        (len > size - size / QR_COMPRESSION_MIN_SAVING)) {
+        GF_FREE(data);
+        return NULL;
+    }
+
+    shrunk = GF_REALLOC(data, len);
+    if (shrunk)
+        data = shrunk;
+
+    *data_size = len;
+    return data;
+}
+
+/*
+ * Uncompress size bytes of the file at offset into out. The whole stream
+ * up to offset + size has to be inflated, the bytes before offset are
+ * inflated into out too and overwritten.
+ */
+static int
+qr_content_inflate(void *data, size_t data_size, off_t offset, char *out,
+                   size_t size)
+{
+    z_stream strm = {
+        0,
+    };
+    size_t skip = offset;
+    size_t chunk = 0;
+    int ret = -1;
+
+    if (!size)
+        return 0;
+
+    if (inflateInit(&strm) != Z_OK)
+        return -1;
+
+    strm.next_in = data;
+    strm.avail_in = data_size;
+
+    while (skip) {
+        chunk = min(skip, size);
+        strm.next_out = (Bytef *)out;
+        strm.avail_out = chunk;
+        if (inflate(&strm, Z_SYNC_FLUSH) != Z_OK)
+            goto out;
+        skip -= chunk - strm.avail_out;
+    }
+
+    strm.next_out = (Bytef *)out;
+    strm.avail_out = size;
+    ret = inflate(&strm, Z_SYNC_FLUSH);
+    if (((ret != Z_OK) && (ret != Z_STREAM_END)) || strm.avail_out)
+        ret = -1;
+    else
+        ret = 0;
+out:
+    inflateEnd(&strm);
+    return ret;
+}
+
 void
 qr_content_update(xlator_t *this, qr_inode_t *qr_inode, void *data,
                   struct iatt *buf, uint64_t gen)
@@ -421,6 +514,8 @@ qr_content_update(xlator_t *this, qr_inode_t *qr_inode, void *data,
     qr_private_t *priv = NULL;
     qr_inode_table_t *table = NULL;
     uint32_t rollover = 0;
+    void *compressed = NULL;
+    size_t data_size = buf->ia_size;
 
     rollover = gen >> 32;
     gen = gen & 0xffffffff;
@@ -428,6 +523,14 @@ qr_content_update(xlator_t *this, qr_inode_t *qr_inode, void *data,
     priv = this->private;
     table = &priv->table;
 
+    if (priv->conf.compression) {
+        compressed = qr_content_deflate(data, buf->ia_size, &data_size);
+        if (compressed) {
+            GF_FREE(data);
+            data = compressed;
+        }
+    }
+
     LOCK(&table->lock);
     {
         if ((rollover != qr_inode->gen_rollover) ||
@@ -442,6 +545,8 @@ qr_content_update(xlator_t *this, qr_inode_t *qr_inode, void *data,
         qr_inode->data = data;
         data = NULL;
         qr_inode->size = buf->ia_size;
+        qr_inode->data_size = data_size;
+        qr_inode->compressed = (compressed != NULL);
 
         qr_inode->ia_mtime = buf->ia_mtime;
         qr_inode->ia_mtime_nsec = buf->ia_mtime_nsec;
@@ -716,6 +821,8 @@ qr_readv_cached(call_frame_t *frame, qr_inode_t *qr_inode, size_t size,
     qr_private_t *priv = NULL;
     qr_inode_table_t *table = NULL;
     int op_ret = -1;
+    void *compressed = NULL;
+    size_t data_size = 0;
     struct iobuf *iobuf = NULL;
     struct iobref *iobref = NULL;
     struct iovec iov = {
@@ -756,7 +863,17 @@ qr_readv_cached(call_frame_t *frame, qr_inode_t *qr_inode, size_t size,
 
         iobref_add(iobref, iobuf);
 
-        memcpy(iobuf->ptr, qr_inode->data + offset, op_ret);
+        if (qr_inode->compressed) {
+            /* inflated once the table is unlocked */
+            compressed = gf_memdup(qr_inode->data, qr_inode->data_size);
+            if (!compressed) {
+                op_ret = -1;
+                goto unlock;
+            }
+            data_size = qr_inode->data_size;
+        } else {
+            memcpy(iobuf->ptr, qr_inode->data + offset, op_ret);
+        }
 
         buf = qr_inode->buf;
 
@@ -766,6 +883,18 @@ qr_readv_cached(call_frame_t *frame, qr_inode_t *qr_inode, size_t size,
 unlock:
     UNLOCK(&table->lock);
 
+    if (compressed) {
+        if (qr_content_inflate(compressed, data_size, offset, iobuf->ptr,
+                               op_ret) < 0) {
+            gf_msg(this->name, GF_LOG_WARNING, 0,
+                   QUICK_READ_MSG_DECOMPRESSION_FAILED,
+                   "could not uncompress cached content of %s",
+                   uuid_utoa(buf.ia_gfid));
+            op_ret = -1;
+        }
+        GF_FREE(compressed);
+    }
+
     if (op_ret >= 0) {
         iov.iov_base = iobuf->ptr;
         iov.iov_len = op_ret;
@@ -1035,6 +1164,7 @@ qr_inodectx_dump(xlator_t *this, inode_t *inode)
 
     gf_proc_dump_write("entire-file-cached", "%s",
                        qr_inode->data ? "yes" : "no");
+    gf_proc_dump_write("compressed", "%s", qr_inode->compressed ? "yes" : "no");
 
     if (qr_inode->last_refresh) {
         gf_time_fmt(buf, sizeof buf, qr_inode->last_refresh, gf_timefmt_FT);
@@ -1083,13 +1213,21 @@ qr_priv_dump(xlator_t *this)
             list_for_each_entry(curr, &table->lru[i], lru)
             {
                 file_count++;
-                total_size += curr->size;
+                total_size += curr->data_size;
             }
         }
     }
 
     gf_proc_dump_write("total_files_cached", "%d", file_count);
     gf_proc_dump_write("total_cache_used", "%" PRIu64, total_size);
+    gf_proc_dump_write("cache_compression", "%s",
+                       conf->compression ? "on" : "off");
+    gf_proc_dump_write("compressed_files_cached", "%" PRIu32,
+                       table->compressed_files);
+    gf_proc_dump_write("compressed_cache_used", "%" PRIu64,
+                       table->compressed_used);
+    gf_proc_dump_write("compressed_files_size", "%" PRIu64,
+                       table->compressed_size);
     gf_proc_dump_write("cache-hit", "%" GF_PRI_ATOMIC,
                        GF_ATOMIC_GET(priv->qr_counter.cache_hit));
     gf_proc_dump_write("cache-miss", "%" GF_PRI_ATOMIC,
@@ -1114,6 +1252,10 @@ qr_dump_metrics(xlator_t *this, int fd)
             GF_ATOMIC_GET(priv->qr_counter.files_cached));
     dprintf(fd, "%s.total_cache_used %" PRId64 "\n", this->name,
             table->cache_used);
+    dprintf(fd, "%s.compressed_cache_used %" PRId64 "\n", this->name,
+            table->compressed_used);
+    dprintf(fd, "%s.compressed_files_size %" PRId64 "\n", this->name,
+            table->compressed_size);
     dprintf(fd, "%s.cache-hit %" PRId64 "\n", this->name,
             GF_ATOMIC_GET(priv->qr_counter.cache_hit));
     dprintf(fd, "%s.cache-miss %" PRId64 "\n", this->name,
@@ -1207,6 +1349,9 @@ qr_reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("ctime-invalidation", conf->ctime_invalidation, options,
                      bool, out);
 
+    GF_OPTION_RECONF("cache-compression", conf->compression, options, bool,
+                     out);
+
     GF_OPTION_RECONF("cache-size", cache_size_new, options, size_uint64, out);
     if (!check_cache_size_ok(this, cache_size_new)) {
         ret = -1;
@@ -1363,6 +1508,8 @@ qr_init(xlator_t *this)
 
     GF_OPTION_INIT("ctime-invalidation", conf->ctime_invalidation, bool, out);
 
+    GF_OPTION_INIT("cache-compression", conf->compression, bool, out);
+
     INIT_LIST_HEAD(&conf->priority_list);
     conf->max_pri = 1;
     if (dict_get(this->options, "priority")) {
@@ -1625,6 +1772,19 @@ struct volume_options qr_options[] = {
                        "changes to file data. So, use this only when mtime "
                        "is not reliable",
     },
+    {
+        .key = {"cache-compression"},
+        .type = GF_OPTION_TYPE_BOOL,
+        .default_value = "off",
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+        .description = "When \"on\", the content of the files cached is kept "
+                       "compressed with zlib if it shrinks by a quarter or "
+                       "more, and uncompressed on every read served from "
+                       "the cache. cache-size counts the compressed bytes, "
+                       "so more files fit in it, at the cost of the CPU "
+                       "used to compress and uncompress them.",
+    },
     {.key = {NULL}}};
 
 xlator_api_t xlator_api = {
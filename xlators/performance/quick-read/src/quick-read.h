@@ -29,9 +29,16 @@
 #include <fnmatch.h>
 #include "quick-read-mem-types.h"
 
+/* Files smaller than this are never compressed */
+#define QR_COMPRESSION_MIN_SIZE 512
+/* Compressed data is kept only if it saves at least 1/4 of the file */
+#define QR_COMPRESSION_MIN_SAVING 4
+
 struct qr_inode {
     void *data;
     size_t size;
+    size_t data_size; /* bytes held in data, less than size if compressed */
+    gf_boolean_t compressed;
     int priority;
     uint32_t ia_mtime;
     uint32_t ia_mtime_nsec;
@@ -60,12 +67,16 @@ struct qr_conf {
     int max_pri;
     gf_boolean_t qr_invalidation;
     gf_boolean_t ctime_invalidation;
+    gf_boolean_t compression;
     struct list_head priority_list;
 };
 typedef struct qr_conf qr_conf_t;
 
 struct qr_inode_table {
     uint64_t cache_used;
+    uint64_t compressed_used; /* part of cache_used that is compressed */
+    uint64_t compressed_size; /* size of those files uncompressed */
+    uint32_t compressed_files;
     struct list_head *lru;
     gf_lock_t lock;
 };
@@ -12,6 +12,7 @@
 #include <glusterfs/logging.h>
 #include <glusterfs/dict.h>
 #include <glusterfs/xlator.h>
+#include <glusterfs/timespec.h>
 #include "read-ahead.h"
 #include <assert.h>
 #include "read-ahead-messages.h"
@@ -59,6 +60,7 @@ ra_page_create(ra_file_t *file, off_t offset)
         }
 
         newpage->offset = rounded_offset;
+        newpage->stream = -1;
         newpage->prev = page->prev;
         newpage->next = page;
         newpage->file = file;
@@ -135,6 +137,9 @@ ra_fault_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
     fd_t *fd = NULL;
     uint64_t tmp_file = 0;
     gf_boolean_t stale = _gf_false;
+    struct timespec now;
+    struct timespec delta;
+    uint64_t elapsed = 0;
 
     GF_ASSERT(frame);
 
@@ -155,10 +160,21 @@ ra_fault_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
         goto out;
     }
 
+    if (op_ret >= 0) {
+        timespec_now(&now);
+        timespec_sub(&local->start, &now, &delta);
+        elapsed = delta.tv_sec * 1000000 + delta.tv_nsec / 1000;
+    }
+
     ra_file_lock(file);
     {
-        if (op_ret >= 0)
+        if (op_ret >= 0) {
             file->stbuf = *stbuf;
+            /* feeds the read-ahead windows of the streams */
+            file->latency = file->latency
+                                ? (file->latency * 7 + elapsed) / 8
+                                : max(elapsed, 1);
+        }
 
         page = ra_page_get(file, pending_offset);
 
@@ -223,6 +239,7 @@ unlock:
     ra_file_unlock(file);
 
     if (stale) {
+        timespec_now(&local->start);
         STACK_WIND(frame, ra_fault_cbk, FIRST_CHILD(frame->this),
                    FIRST_CHILD(frame->this)->fops->readv, local->fd,
                    local->pending_size, local->pending_offset, 0, NULL);
@@ -274,6 +291,7 @@ ra_page_fault(ra_file_t *file, call_frame_t *frame, off_t offset)
     fault_local->pending_size = file->page_size;
 
     fault_local->fd = fd_ref(file->fd);
+    timespec_now(&fault_local->start);
 
     STACK_WIND(fault_frame, ra_fault_cbk, FIRST_CHILD(fault_frame->this),
                FIRST_CHILD(fault_frame->this)->fops->readv, file->fd,
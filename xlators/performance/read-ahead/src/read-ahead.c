@@ -21,12 +21,16 @@
 #include <glusterfs/xlator.h>
 #include "read-ahead.h"
 #include <glusterfs/statedump.h>
+#include <glusterfs/timespec.h>
 #include <assert.h>
 #include <sys/time.h>
 #include "read-ahead-messages.h"
 
-static void
-read_ahead(call_frame_t *frame, ra_file_t *file);
+enum {
+    RA_READ_HIT,  /* all the pages were ready */
+    RA_READ_WAIT, /* some were still being read ahead */
+    RA_READ_MISS, /* some had to be read */
+};
 
 int
 ra_open_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
@@ -57,7 +61,6 @@ ra_open_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
     if ((fd->flags & O_DIRECT) || ((fd->flags & O_ACCMODE) == O_WRONLY))
         file->disabled = 1;
 
-    file->offset = (unsigned long long)0;
     file->conf = conf;
     file->pages.next = &file->pages;
     file->pages.prev = &file->pages;
@@ -74,14 +77,9 @@ ra_open_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
     ra_conf_unlock(conf);
 
     file->fd = fd;
-    file->page_count = conf->page_count;
     file->page_size = conf->page_size;
     pthread_mutex_init(&file->file_lock, NULL);
 
-    if (!file->disabled) {
-        file->page_count = 1;
-    }
-
     ret = fd_ctx_set(fd, this, (uint64_t)(long)file);
     if (ret == -1) {
         gf_msg(frame->this->name, GF_LOG_WARNING, 0, READ_AHEAD_MSG_NO_MEMORY,
@@ -131,8 +129,6 @@ ra_create_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
     if ((fd->flags & O_DIRECT) || ((fd->flags & O_ACCMODE) == O_WRONLY))
         file->disabled = 1;
 
-    file->offset = (unsigned long long)0;
-    // file->size = fd->inode->buf.ia_size;
     file->conf = conf;
     file->pages.next = &file->pages;
     file->pages.prev = &file->pages;
@@ -149,7 +145,6 @@ ra_create_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
     ra_conf_unlock(conf);
 
     file->fd = fd;
-    file->page_count = conf->page_count;
     file->page_size = conf->page_size;
     pthread_mutex_init(&file->file_lock, NULL);
 
@@ -250,50 +245,309 @@ out:
     return 0;
 }
 
-void
-read_ahead(call_frame_t *frame, ra_file_t *file)
+/* Pages of a read of the stream */
+static uint32_t
+ra_stream_read_pages(ra_file_t *file, struct ra_stream *stream)
+{
+    return max(gf_roof(stream->size, file->page_size) / file->page_size, 1);
+}
+
+static int
+ra_stream_count(ra_conf_t *conf)
+{
+    return min(max(conf->stream_count, 1), RA_MAX_STREAMS);
+}
+
+/* The pages read ahead for the stream are not accounted to it anymore */
+static void
+__ra_stream_disown(ra_file_t *file, int index)
 {
-    off_t ra_offset = 0;
-    size_t ra_size = 0;
-    off_t trav_offset = 0;
     ra_page_t *trav = NULL;
-    off_t cap = 0;
-    char fault = 0;
 
-    GF_VALIDATE_OR_GOTO("read-ahead", frame, out);
-    GF_VALIDATE_OR_GOTO(frame->this->name, file, out);
+    for (trav = file->pages.next; trav != &file->pages; trav = trav->next) {
+        if (trav->stream == index)
+            trav->stream = -1;
+    }
+}
 
-    if (!file->page_count) {
-        goto out;
+static void
+__ra_streams_reset(ra_file_t *file)
+{
+    ra_page_t *trav = NULL;
+
+    memset(file->streams, 0, sizeof(file->streams));
+
+    for (trav = file->pages.next; trav != &file->pages; trav = trav->next)
+        trav->stream = -1;
+}
+
+/* Returns the stream the read belongs to, after accounting the read to it.
+ * A read that is not the next one of any stream starts a new stream, in place
+ * of the least recently read one, those whose pattern is not known yet going
+ * first. */
+static int
+__ra_stream_get(ra_file_t *file, off_t offset, size_t size)
+{
+    struct ra_stream *stream = NULL;
+    struct ra_stream *oldest = NULL;
+    struct timespec now;
+    struct timespec delta;
+    uint64_t interval = 0;
+    off_t distance = 0;
+    off_t nearest = 0;
+    int count = 0;
+    int found = -1;
+    int victim = -1;
+    int i = 0;
+
+    count = ra_stream_count(file->conf);
+    file->clock++;
+    timespec_now(&now);
+
+    /* The next read of a stream, as predicted */
+    for (i = 0; i < count; i++) {
+        stream = &file->streams[i];
+        if (!stream->active)
+            continue;
+
+        if ((offset == stream->last + (off_t)stream->size) ||
+            (stream->stride && (offset == stream->last + stream->stride))) {
+            found = i;
+            break;
+        }
     }
 
-    ra_size = file->page_size * file->page_count;
-    ra_offset = gf_floor(file->offset, file->page_size);
-    cap = file->size ? file->size : file->offset + ra_size;
+    /* Or the nearest read ahead of a stream whose pattern is not known, the
+     * distance to it is the stride to confirm with the next read */
+    if (found < 0) {
+        for (i = 0; i < count; i++) {
+            stream = &file->streams[i];
+            if (!stream->active || stream->confidence)
+                continue;
 
-    while (ra_offset < min(file->offset + ra_size, cap)) {
-        ra_file_lock(file);
-        {
-            trav = ra_page_get(file, ra_offset);
+            distance = offset - stream->last;
+            if ((distance <= 0) ||
+                (distance > (off_t)file->page_size * RA_MAX_STRIDE_PAGES))
+                continue;
+
+            if ((found < 0) || (distance < nearest)) {
+                found = i;
+                nearest = distance;
+            }
         }
-        ra_file_unlock(file);
+    }
 
-        if (!trav)
-            break;
+    if (found < 0) {
+        for (i = 0; i < count; i++) {
+            stream = &file->streams[i];
+            if (!stream->active) {
+                victim = i;
+                break;
+            }
+
+            if (victim < 0) {
+                victim = i;
+                continue;
+            }
+
+            oldest = &file->streams[victim];
+            if (stream->confidence && !oldest->confidence)
+                continue;
+            if ((!stream->confidence && oldest->confidence) ||
+                (stream->age < oldest->age))
+                victim = i;
+        }
+
+        __ra_stream_disown(file, victim);
+
+        stream = &file->streams[victim];
+        memset(stream, 0, sizeof(*stream));
+        stream->active = _gf_true;
+        stream->seen = now;
+        found = victim;
+    } else {
+        stream = &file->streams[found];
+        distance = offset - stream->last;
+
+        if (distance == (off_t)stream->size) {
+            if (!stream->sequential)
+                stream->confidence = 0;
+            stream->sequential = _gf_true;
+            stream->confidence++;
+        } else if (distance == stream->stride) {
+            if (stream->sequential)
+                stream->confidence = 0;
+            stream->sequential = _gf_false;
+            stream->confidence++;
+        } else {
+            stream->sequential = _gf_false;
+            stream->confidence = 0;
+        }
+        stream->stride = distance;
 
-        ra_offset += file->page_size;
+        if (!stream->confidence) {
+            /* what was read ahead was for another pattern */
+            stream->window = 0;
+            stream->ra_end = 0;
+        }
+
+        timespec_sub(&stream->seen, &now, &delta);
+        interval = delta.tv_sec * 1000000 + delta.tv_nsec / 1000;
+        stream->interval = stream->interval
+                               ? (stream->interval * 3 + interval) / 4
+                               : max(interval, 1);
+        stream->seen = now;
     }
 
-    if (trav) {
-        /* comfortable enough */
-        goto out;
+    stream->last = offset;
+    stream->size = size;
+    stream->ra_end = max(stream->ra_end, offset + (off_t)size);
+    stream->age = file->clock;
+    stream->reads++;
+
+    return found;
+}
+
+/* Sizes the window of the stream after one of its reads. It grows by a read
+ * for every read that found its pages ready, doubles when the read had to
+ * wait for them, and is never less than what keeps the stream busy while
+ * the pages are read, at the rate the stream is read. It is halved in
+ * ra_file_prune() when pages read ahead are dropped unused. */
+static void
+__ra_stream_adapt(ra_file_t *file, struct ra_stream *stream, int result)
+{
+    uint32_t limit = max(file->conf->page_count, 1);
+    uint32_t step = 1;
+    uint64_t need = 0;
+
+    if (!stream->confidence)
+        return;
+
+    if (stream->sequential)
+        step = ra_stream_read_pages(file, stream);
+
+    if (!stream->window) {
+        stream->window = step;
+    } else if (result == RA_READ_HIT) {
+        stream->hits++;
+        stream->window += step;
+    } else if (result == RA_READ_WAIT) {
+        stream->waits++;
+        stream->window *= 2;
+    }
+
+    if (file->latency && stream->interval) {
+        need = (file->latency / stream->interval + 1) * step;
+        if (need > stream->window)
+            stream->window = min(need, limit);
+    }
+
+    stream->window = min(stream->window, limit);
+}
+
+/* Pages starting in (start, end) are in use by a stream */
+struct ra_span {
+    off_t start;
+    off_t end;
+};
+
+/* Fills @spans with those of the active streams, sorted and merged where
+ * they overlap */
+static int
+__ra_file_spans(ra_file_t *file, int count, struct ra_span *spans)
+{
+    struct ra_stream *stream = NULL;
+    struct ra_span span;
+    int n = 0;
+    int i = 0;
+    int j = 0;
+
+    for (i = 0; i < count; i++) {
+        stream = &file->streams[i];
+        if (!stream->active)
+            continue;
+
+        span.start = stream->last - (off_t)file->page_size;
+        span.end = stream->ra_end;
+        for (j = n; (j > 0) && (spans[j - 1].start > span.start); j--)
+            spans[j] = spans[j - 1];
+        spans[j] = span;
+        n++;
     }
 
-    trav_offset = ra_offset;
+    for (i = 0, j = 0; i < n; i++) {
+        if (j && (spans[i].start < spans[j - 1].end))
+            spans[j - 1].end = max(spans[j - 1].end, spans[i].end);
+        else
+            spans[j++] = spans[i];
+    }
 
-    cap = file->size ? file->size : ra_offset + ra_size;
+    return j;
+}
 
-    while (trav_offset < min(ra_offset + ra_size, cap)) {
+/* Drops the pages behind all the streams of the file, and those read ahead
+ * for patterns given up. The pages are sorted by offset, as are the spans
+ * of the streams, so that both are walked once. */
+static void
+ra_file_prune(ra_file_t *file)
+{
+    struct ra_stream *stream = NULL;
+    struct ra_span spans[RA_MAX_STREAMS];
+    ra_page_t *trav = NULL;
+    ra_page_t *next = NULL;
+    gf_boolean_t shrunk[RA_MAX_STREAMS] = {
+        0,
+    };
+    int nspans = 0;
+    int count = 0;
+    int i = 0;
+
+    count = ra_stream_count(file->conf);
+
+    ra_file_lock(file);
+    {
+        nspans = __ra_file_spans(file, count, spans);
+
+        for (trav = file->pages.next; trav != &file->pages; trav = next) {
+            next = trav->next;
+            if (trav->waitq)
+                continue;
+
+            while ((i < nspans) && (spans[i].end <= trav->offset))
+                i++;
+            if ((i < nspans) && (trav->offset > spans[i].start))
+                continue;
+
+            if (trav->dirty && (trav->stream >= 0) &&
+                (trav->stream < count)) {
+                stream = &file->streams[trav->stream];
+                stream->wasted++;
+                if (!shrunk[trav->stream]) {
+                    stream->window = max(stream->window / 2, 1);
+                    shrunk[trav->stream] = _gf_true;
+                }
+            }
+
+            ra_page_purge(trav);
+        }
+    }
+    ra_file_unlock(file);
+}
+
+/* Reads ahead the pages of [offset, offset + size) not cached yet */
+static void
+ra_fault_range(call_frame_t *frame, ra_file_t *file, int index, off_t offset,
+               size_t size)
+{
+    off_t trav_offset = 0;
+    off_t end = 0;
+    ra_page_t *trav = NULL;
+    char fault = 0;
+
+    trav_offset = gf_floor(offset, file->page_size);
+    end = offset + size;
+
+    while (trav_offset < end) {
         fault = 0;
         ra_file_lock(file);
         {
@@ -301,9 +555,16 @@ read_ahead(call_frame_t *frame, ra_file_t *file)
             if (!trav) {
                 fault = 1;
                 trav = ra_page_create(file, trav_offset);
-                if (trav)
+                if (trav) {
                     trav->dirty = 1;
+                    trav->stream = index;
+                }
             }
+
+            if (trav)
+                file->streams[index].ra_end = max(
+                    file->streams[index].ra_end,
+                    trav_offset + (off_t)file->page_size);
         }
         ra_file_unlock(file);
 
@@ -313,12 +574,45 @@ read_ahead(call_frame_t *frame, ra_file_t *file)
         }
 
         if (fault) {
-            gf_msg_trace(frame->this->name, 0, "RA at offset=%" PRId64,
-                         trav_offset);
+            gf_msg_trace(frame->this->name, 0,
+                         "RA at offset=%" PRId64 " for stream %d",
+                         trav_offset, index);
             ra_page_fault(file, frame, trav_offset);
         }
         trav_offset += file->page_size;
     }
+}
+
+static void
+read_ahead(call_frame_t *frame, ra_file_t *file, int index)
+{
+    struct ra_stream stream;
+    uint32_t i = 0;
+
+    GF_VALIDATE_OR_GOTO("read-ahead", frame, out);
+    GF_VALIDATE_OR_GOTO(frame->this->name, file, out);
+
+    ra_file_lock(file);
+    {
+        stream = file->streams[index];
+    }
+    ra_file_unlock(file);
+
+    if (!stream.window) {
+        goto out;
+    }
+
+    if (stream.sequential) {
+        ra_fault_range(frame, file, index, stream.last + stream.size,
+                       stream.window * file->page_size);
+        goto out;
+    }
+
+    /* the next reads of the stream, not what is between them */
+    for (i = 1; i <= stream.window; i++) {
+        ra_fault_range(frame, file, index, stream.last + i * stream.stride,
+                       stream.size);
+    }
 
 out:
     return;
@@ -335,7 +629,7 @@ ra_need_atime_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
     return 0;
 }
 
-static void
+static int
 dispatch_requests(call_frame_t *frame, ra_file_t *file)
 {
     ra_local_t *local = NULL;
@@ -347,6 +641,7 @@ dispatch_requests(call_frame_t *frame, ra_file_t *file)
     call_frame_t *ra_frame = NULL;
     char need_atime_update = 1;
     char fault = 0;
+    int result = RA_READ_HIT;
 
     GF_VALIDATE_OR_GOTO("read-ahead", frame, out);
     GF_VALIDATE_OR_GOTO(frame->this->name, file, out);
@@ -374,6 +669,9 @@ dispatch_requests(call_frame_t *frame, ra_file_t *file)
                 }
                 fault = 1;
                 need_atime_update = 0;
+                result = RA_READ_MISS;
+            } else if (!trav->ready) {
+                result = max(result, trav->dirty ? RA_READ_WAIT : RA_READ_MISS);
             }
             trav->dirty = 0;
 
@@ -420,7 +718,7 @@ dispatch_requests(call_frame_t *frame, ra_file_t *file)
     }
 
 out:
-    return;
+    return result;
 }
 
 int
@@ -443,17 +741,15 @@ ra_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
 {
     ra_file_t *file = NULL;
     ra_local_t *local = NULL;
-    ra_conf_t *conf = NULL;
     int op_errno = EINVAL;
-    char expected_offset = 1;
     uint64_t tmp_file = 0;
+    int stream = 0;
+    int result = 0;
 
     GF_ASSERT(frame);
     GF_VALIDATE_OR_GOTO(frame->this->name, this, unwind);
     GF_VALIDATE_OR_GOTO(frame->this->name, fd, unwind);
 
-    conf = this->private;
-
     gf_msg_trace(this->name, 0,
                  "NEW REQ at offset=%" PRId64 " for size=%" GF_PRI_SIZET "",
                  offset, size);
@@ -465,29 +761,14 @@ ra_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
         goto disabled;
     }
 
-    if (file->offset != offset) {
-        gf_msg_trace(this->name, 0,
-                     "unexpected offset (%" PRId64 " != %" PRId64
-                     ") "
-                     "resetting",
-                     file->offset, offset);
-
-        expected_offset = file->expected = file->page_count = 0;
-    } else {
-        gf_msg_trace(this->name, 0,
-                     "expected offset (%" PRId64 ") when page_count=%d", offset,
-                     file->page_count);
-
-        if (file->expected < (file->page_size * conf->page_count)) {
-            file->expected += size;
-            file->page_count = min((file->expected / file->page_size),
-                                   conf->page_count);
-        }
+    ra_file_lock(file);
+    {
+        stream = __ra_stream_get(file, offset, size);
     }
+    ra_file_unlock(file);
 
-    if (!expected_offset) {
-        flush_region(frame, file, 0, file->pages.prev->offset + 1, 0);
-    }
+    gf_msg_trace(this->name, 0, "offset %" PRId64 " read by stream %d", offset,
+                 stream);
 
     local = mem_get0(this->local_pool);
     if (!local) {
@@ -507,13 +788,17 @@ ra_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
 
     frame->local = local;
 
-    dispatch_requests(frame, file);
+    result = dispatch_requests(frame, file);
 
-    flush_region(frame, file, 0, gf_floor(offset, file->page_size), 0);
+    ra_file_lock(file);
+    {
+        __ra_stream_adapt(file, &file->streams[stream], result);
+    }
+    ra_file_unlock(file);
 
-    read_ahead(frame, file);
+    ra_file_prune(file);
 
-    file->offset = offset + size;
+    read_ahead(frame, file, stream);
 
     ra_frame_return(frame);
 
@@ -641,8 +926,12 @@ ra_writev(call_frame_t *frame, xlator_t *this, fd_t *fd, struct iovec *vector,
 
             flush_region(frame, file, 0, file->pages.prev->offset + 1, 1);
 
-            /* reset the read-ahead counters too */
-            file->expected = file->page_count = 0;
+            /* and start the streams over */
+            ra_file_lock(file);
+            {
+                __ra_streams_reset(file);
+            }
+            ra_file_unlock(file);
         }
     }
     UNLOCK(&inode->lock);
@@ -767,6 +1056,8 @@ ra_fdctx_dump(xlator_t *this, fd_t *fd)
 {
     ra_file_t *file = NULL;
     ra_page_t *page = NULL;
+    struct ra_stream *stream = NULL;
+    const char *pattern = NULL;
     int32_t ret = 0, i = 0;
     uint64_t tmp_file = 0;
     char *path = NULL;
@@ -803,11 +1094,33 @@ ra_fdctx_dump(xlator_t *this, fd_t *fd)
 
     gf_proc_dump_write("page-size", "%" PRId64, file->page_size);
 
-    gf_proc_dump_write("page-count", "%u", file->page_count);
-
-    gf_proc_dump_write("next-expected-offset-for-sequential-reads", "%" PRId64,
-                       file->offset);
+    gf_proc_dump_write("latency-usec", "%" PRIu64, file->latency);
+
+    for (i = 0; i < RA_MAX_STREAMS; i++) {
+        stream = &file->streams[i];
+        if (!stream->active)
+            continue;
+
+        if (!stream->confidence)
+            pattern = "unknown";
+        else if (stream->sequential)
+            pattern = "sequential";
+        else
+            pattern = "strided";
+
+        gf_proc_dump_write("stream", "%d", i);
+        gf_proc_dump_write("pattern", "%s", pattern);
+        gf_proc_dump_write("offset", "%" PRId64, stream->last);
+        gf_proc_dump_write("stride", "%" PRId64, stream->stride);
+        gf_proc_dump_write("window", "%u", stream->window);
+        gf_proc_dump_write("interval-usec", "%" PRIu64, stream->interval);
+        gf_proc_dump_write("reads", "%" PRIu64, stream->reads);
+        gf_proc_dump_write("hits", "%" PRIu64, stream->hits);
+        gf_proc_dump_write("waits", "%" PRIu64, stream->waits);
+        gf_proc_dump_write("wasted-pages", "%" PRIu64, stream->wasted);
+    }
 
+    i = 0;
     for (page = file->pages.next; page != &file->pages; page = page->next) {
         gf_proc_dump_write("page", "%d: %p", i++, (void *)page);
         ra_page_dump(page);
@@ -1043,6 +1356,7 @@ ra_priv_dump(xlator_t *this)
     {
         gf_proc_dump_write("page_size", "%" PRIu64, conf->page_size);
         gf_proc_dump_write("page_count", "%d", conf->page_count);
+        gf_proc_dump_write("stream_count", "%d", conf->stream_count);
         gf_proc_dump_write("force_atime_update", "%d",
                            conf->force_atime_update);
     }
@@ -1091,6 +1405,8 @@ reconfigure(xlator_t *this, dict_t *options)
 
     GF_OPTION_RECONF("page-count", conf->page_count, options, uint32, out);
 
+    GF_OPTION_RECONF("stream-count", conf->stream_count, options, uint32, out);
+
     GF_OPTION_RECONF("page-size", conf->page_size, options, size_uint64, out);
 
     GF_OPTION_RECONF("pass-through", this->pass_through, options, bool, out);
@@ -1132,6 +1448,8 @@ init(xlator_t *this)
 
     GF_OPTION_INIT("page-count", conf->page_count, uint32, out);
 
+    GF_OPTION_INIT("stream-count", conf->stream_count, uint32, out);
+
     GF_OPTION_INIT("force-atime-update", conf->force_atime_update, bool, out);
 
     GF_OPTION_INIT("pass-through", this->pass_through, bool, out);
@@ -1237,7 +1555,18 @@ struct volume_options options[] = {
      .default_value = "4",
      .op_version = {1},
      .tags = {"read-ahead"},
-     .description = "Number of pages that will be pre-fetched"},
+     .description = "Number of pages that will be pre-fetched, at most, "
+                    "for a stream of reads"},
+    {.key = {"stream-count"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = RA_MAX_STREAMS,
+     .default_value = "4",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
+     .tags = {"read-ahead"},
+     .description = "Number of streams of sequential or strided reads "
+                    "tracked and read ahead of, per fd"},
     {.key = {"page-size"},
      .type = GF_OPTION_TYPE_SIZET,
      .min = 4096,
@@ -41,6 +41,7 @@ struct ra_fill {
 
 struct ra_local {
     mode_t mode;
+    struct timespec start; /* when a page fault was sent */
     struct ra_fill fill;
     off_t offset;
     size_t size;
@@ -67,6 +68,39 @@ struct ra_page {
     struct ra_waitq *waitq;
     struct iobref *iobref;
     char stale;
+    int stream; /* read ahead for this stream of the file, -1 if none */
+};
+
+/* Upper bound of the stream-count option */
+#define RA_MAX_STREAMS 16
+
+/* A read is taken for the next one of a stream if it starts at most this
+ * many pages after the last one */
+#define RA_MAX_STRIDE_PAGES 64
+
+/*
+ * A stream is a run of reads through the fd, each one starting at the end of
+ * the previous one (sequential), or the same distance after it (strided).
+ * A stream is only read ahead of once the pattern has been seen, and how far
+ * ahead (window) follows whether the reads find their pages ready, waiting
+ * on them or dropped unused, and how long the pages take to come back.
+ */
+struct ra_stream {
+    off_t last;        /* offset of the last read */
+    size_t size;       /* and its size */
+    off_t stride;      /* from the last read to the next, 0 if not known */
+    off_t ra_end;      /* end of what was read ahead for the stream */
+    uint64_t age;      /* file->clock at the last read */
+    uint64_t interval; /* usecs between two reads, averaged */
+    struct timespec seen;
+    uint32_t window; /* pages if sequential, reads if strided */
+    uint32_t confidence;
+    gf_boolean_t active;
+    gf_boolean_t sequential;
+    uint64_t reads;
+    uint64_t hits;   /* reads served from pages read ahead, ready */
+    uint64_t waits;  /* reads waiting on pages still being read ahead */
+    uint64_t wasted; /* pages read ahead and dropped unused */
 };
 
 struct ra_file {
@@ -75,20 +109,20 @@ struct ra_file {
     struct ra_conf *conf;
     fd_t *fd;
     int disabled;
-    size_t expected;
     struct ra_page pages;
-    off_t offset;
-    size_t size;
+    struct ra_stream streams[RA_MAX_STREAMS];
+    uint64_t clock;   /* reads through the fd */
+    uint64_t latency; /* usecs for a page to be read, averaged */
     int32_t refcount;
     pthread_mutex_t file_lock;
     struct iatt stbuf;
     uint64_t page_size;
-    uint32_t page_count;
 };
 
 struct ra_conf {
     uint64_t page_size;
     uint32_t page_count;
+    uint32_t stream_count;
     void *cache_block;
     struct ra_file files;
     gf_boolean_t force_atime_update;
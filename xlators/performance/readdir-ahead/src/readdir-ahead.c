@@ -21,12 +21,19 @@
  * The translator is currently designed to handle the simple, sequential case
  * only. If a non-sequential directory read occurs, readdir-ahead disables
  * preloads on the directory.
+ *
+ * With rda-listing-timeout set, the entries a preload reads from offset 0 to
+ * the end of a directory are kept as the listing of the directory, and the
+ * fds opened on it afterwards are served from that listing instead of
+ * reading the directory again, until an entry is created or removed in it.
  */
 
 #include <math.h>
 #include <glusterfs/glusterfs.h>
 #include <glusterfs/xlator.h>
 #include <glusterfs/call-stub.h>
+#include <glusterfs/statedump.h>
+#include <glusterfs/upcall-utils.h>
 #include "readdir-ahead.h"
 #include "readdir-ahead-mem-types.h"
 #include <glusterfs/defaults.h>
@@ -43,6 +50,8 @@ rda_local_wipe(struct rda_local *local)
         dict_unref(local->xattrs);
     if (local->inode)
         inode_unref(local->inode);
+    if (local->oldparent)
+        inode_unref(local->oldparent);
 }
 
 /*
@@ -64,6 +73,7 @@ get_rda_fd_ctx(fd_t *fd, xlator_t *this)
 
         LOCK_INIT(&ctx->lock);
         INIT_LIST_HEAD(&ctx->entries.list);
+        INIT_LIST_HEAD(&ctx->recorded.list);
         ctx->state = RDA_FD_NEW;
         /* ctx offset values initialized to 0 */
         ctx->xattrs = NULL;
@@ -181,6 +191,312 @@ rda_inode_ctx_update_iatts(inode_t *inode, xlator_t *this,
     return ret;
 }
 
+static void
+rda_listing_unref(xlator_t *this, struct rda_listing *listing)
+{
+    struct rda_priv *priv = this->private;
+
+    if (GF_ATOMIC_DEC(listing->refcount))
+        return;
+
+    gf_dirent_free(&listing->entries);
+    GF_ATOMIC_SUB(priv->rda_cache_size, listing->size);
+    inode_unref(listing->inode);
+    GF_FREE(listing);
+}
+
+/*
+ * Take the listing of the directory off its inode, the caller holds
+ * inode->lock and drops the reference the inode had.
+ */
+static struct rda_listing *
+__rda_listing_detach(xlator_t *this, rda_inode_ctx_t *ctx_p)
+{
+    struct rda_priv *priv = this->private;
+    struct rda_listing *listing = ctx_p->listing;
+
+    if (!listing)
+        return NULL;
+
+    ctx_p->listing = NULL;
+    LOCK(&priv->lock);
+    {
+        list_del_init(&listing->list);
+    }
+    UNLOCK(&priv->lock);
+
+    return listing;
+}
+
+/*
+ * Drop the least recently used listings while they are expired or the
+ * cache is over rda-cache-limit, or all of them.
+ */
+static void
+rda_listing_prune(xlator_t *this, gf_boolean_t all)
+{
+    struct rda_priv *priv = this->private;
+    struct rda_listing *listing = NULL;
+    rda_inode_ctx_t *ctx_p = NULL;
+    uint64_t ctx_uint = 0;
+    gf_boolean_t detached = _gf_false;
+    time_t now = gf_time();
+
+    for (;;) {
+        listing = NULL;
+        LOCK(&priv->lock);
+        {
+            if (!list_empty(&priv->listings)) {
+                listing = list_first_entry(&priv->listings, struct rda_listing,
+                                           list);
+                if (all ||
+                    (now - listing->time >= priv->listing_timeout) ||
+                    (GF_ATOMIC_GET(priv->rda_cache_size) >
+                     priv->rda_cache_limit))
+                    GF_ATOMIC_INC(listing->refcount);
+                else
+                    listing = NULL;
+            }
+        }
+        UNLOCK(&priv->lock);
+
+        if (!listing)
+            break;
+
+        detached = _gf_false;
+        LOCK(&listing->inode->lock);
+        {
+            ctx_uint = 0;
+            __inode_ctx_get1(listing->inode, this, &ctx_uint);
+            ctx_p = (rda_inode_ctx_t *)(uintptr_t)ctx_uint;
+            if (ctx_p && ctx_p->listing == listing) {
+                __rda_listing_detach(this, ctx_p);
+                detached = _gf_true;
+            }
+        }
+        UNLOCK(&listing->inode->lock);
+
+        if (detached)
+            rda_listing_unref(this, listing);
+        rda_listing_unref(this, listing);
+    }
+}
+
+/*
+ * Return a reference on the listing of the directory, if it has one that
+ * has not expired.
+ */
+static struct rda_listing *
+rda_listing_get(xlator_t *this, inode_t *inode)
+{
+    struct rda_priv *priv = this->private;
+    struct rda_listing *listing = NULL;
+    struct rda_listing *expired = NULL;
+    rda_inode_ctx_t *ctx_p = NULL;
+
+    LOCK(&inode->lock);
+    {
+        ctx_p = __rda_inode_ctx_get(inode, this);
+        if (ctx_p && ctx_p->listing) {
+            if (gf_time() - ctx_p->listing->time >= priv->listing_timeout) {
+                expired = __rda_listing_detach(this, ctx_p);
+            } else {
+                listing = ctx_p->listing;
+                GF_ATOMIC_INC(listing->refcount);
+                LOCK(&priv->lock);
+                {
+                    list_move_tail(&listing->list, &priv->listings);
+                }
+                UNLOCK(&priv->lock);
+            }
+        }
+    }
+    UNLOCK(&inode->lock);
+
+    if (expired)
+        rda_listing_unref(this, expired);
+    if (listing)
+        GF_ATOMIC_INC(priv->listing_hits);
+
+    return listing;
+}
+
+/*
+ * Make the entries read from offset 0 to the end of the directory its
+ * listing, unless an entry was created or removed in it since the read
+ * started, i.e. its generation is not the one the read started with.
+ */
+static void
+rda_listing_publish(xlator_t *this, inode_t *inode, gf_dirent_t *entries,
+                    size_t size, uint64_t generation, int op_errno)
+{
+    struct rda_priv *priv = this->private;
+    struct rda_listing *listing = NULL;
+    struct rda_listing *old = NULL;
+    rda_inode_ctx_t *ctx_p = NULL;
+    gf_boolean_t published = _gf_false;
+
+    listing = GF_CALLOC(1, sizeof(*listing), gf_rda_mt_rda_listing);
+    if (!listing) {
+        gf_dirent_free(entries);
+        GF_ATOMIC_SUB(priv->rda_cache_size, size);
+        return;
+    }
+
+    INIT_LIST_HEAD(&listing->list);
+    INIT_LIST_HEAD(&listing->entries.list);
+    list_splice_init(&entries->list, &listing->entries.list);
+    listing->inode = inode_ref(inode);
+    listing->size = size;
+    listing->time = gf_time();
+    listing->op_errno = op_errno;
+    GF_ATOMIC_INIT(listing->refcount, 1);
+
+    rda_listing_prune(this, _gf_false);
+    if (GF_ATOMIC_GET(priv->rda_cache_size) > priv->rda_cache_limit)
+        goto out;
+
+    LOCK(&inode->lock);
+    {
+        ctx_p = __rda_inode_ctx_get(inode, this);
+        if (ctx_p && ctx_p->dir_generation == generation) {
+            old = __rda_listing_detach(this, ctx_p);
+            ctx_p->listing = listing;
+            LOCK(&priv->lock);
+            {
+                list_add_tail(&listing->list, &priv->listings);
+            }
+            UNLOCK(&priv->lock);
+            published = _gf_true;
+        }
+    }
+    UNLOCK(&inode->lock);
+
+    if (old)
+        rda_listing_unref(this, old);
+
+out:
+    if (published)
+        GF_ATOMIC_INC(priv->listings_built);
+    else
+        rda_listing_unref(this, listing);
+}
+
+static uint64_t
+rda_dir_generation_get(xlator_t *this, inode_t *inode)
+{
+    rda_inode_ctx_t *ctx_p = NULL;
+    uint64_t generation = 0;
+
+    LOCK(&inode->lock);
+    {
+        ctx_p = __rda_inode_ctx_get(inode, this);
+        if (ctx_p)
+            generation = ctx_p->dir_generation;
+    }
+    UNLOCK(&inode->lock);
+
+    return generation;
+}
+
+/*
+ * An entry was created or removed in the directory: drop its listing, and
+ * the one being read, if any.
+ */
+static void
+rda_dir_changed(xlator_t *this, inode_t *inode)
+{
+    rda_inode_ctx_t *ctx_p = NULL;
+    struct rda_listing *listing = NULL;
+
+    LOCK(&inode->lock);
+    {
+        ctx_p = __rda_inode_ctx_get(inode, this);
+        if (ctx_p) {
+            ctx_p->dir_generation++;
+            listing = __rda_listing_detach(this, ctx_p);
+        }
+    }
+    UNLOCK(&inode->lock);
+
+    if (listing)
+        rda_listing_unref(this, listing);
+}
+
+/*
+ * Stop keeping a copy of the entries filled, the fd will not read the
+ * whole directory in order.
+ */
+static void
+__rda_stop_recording(xlator_t *this, struct rda_fd_ctx *ctx)
+{
+    struct rda_priv *priv = this->private;
+
+    if (!ctx->recording)
+        return;
+
+    gf_dirent_free(&ctx->recorded);
+    GF_ATOMIC_SUB(priv->rda_cache_size, ctx->recorded_size);
+    ctx->recorded_size = 0;
+    ctx->recording = _gf_false;
+}
+
+static void
+__rda_record_entry(xlator_t *this, struct rda_fd_ctx *ctx, gf_dirent_t *dirent)
+{
+    struct rda_priv *priv = this->private;
+    gf_dirent_t *copy = NULL;
+    size_t dirent_size = gf_dirent_size(dirent->d_name);
+
+    if (ctx->recorded_size + dirent_size > priv->rda_cache_limit / 2) {
+        __rda_stop_recording(this, ctx);
+        return;
+    }
+
+    copy = gf_dirent_for_name(dirent->d_name);
+    if (!copy) {
+        __rda_stop_recording(this, ctx);
+        return;
+    }
+
+    copy->d_off = dirent->d_off;
+    copy->d_ino = dirent->d_ino;
+    copy->d_type = dirent->d_type;
+    if (dirent->inode)
+        gf_uuid_copy(copy->d_stat.ia_gfid, dirent->inode->gfid);
+    else
+        gf_uuid_copy(copy->d_stat.ia_gfid, dirent->d_stat.ia_gfid);
+    copy->d_stat.ia_type = dirent->d_stat.ia_type;
+
+    list_add_tail(&copy->list, &ctx->recorded.list);
+    ctx->recorded_size += dirent_size;
+    GF_ATOMIC_ADD(priv->rda_cache_size, dirent_size);
+}
+
+/*
+ * Serve the fd from the listing of the directory if it has one. ctx must be
+ * locked.
+ */
+static gf_boolean_t
+__rda_share_listing(xlator_t *this, fd_t *fd, struct rda_fd_ctx *ctx)
+{
+    struct rda_priv *priv = this->private;
+    struct rda_listing *listing = NULL;
+
+    if (!priv->listing_timeout)
+        return _gf_false;
+
+    listing = rda_listing_get(this, fd->inode);
+    if (!listing)
+        return _gf_false;
+
+    ctx->listing = listing;
+    ctx->cursor = listing->entries.list.next;
+    ctx->state = RDA_FD_SHARED;
+
+    return _gf_true;
+}
+
 /*
  * Reset the tracking state of the context.
  */
@@ -191,6 +507,13 @@ rda_reset_ctx(xlator_t *this, struct rda_fd_ctx *ctx)
 
     priv = this->private;
 
+    __rda_stop_recording(this, ctx);
+    if (ctx->listing) {
+        rda_listing_unref(this, ctx->listing);
+        ctx->listing = NULL;
+        ctx->cursor = NULL;
+    }
+
     ctx->state = RDA_FD_NEW;
     ctx->cur_offset = 0;
     ctx->next_offset = 0;
@@ -374,6 +697,71 @@ __rda_serve_readdirp(xlator_t *this, struct rda_fd_ctx *ctx, size_t size,
     return ret;
 }
 
+/*
+ * Serve a request from the listing the fd shares. The entries carry the
+ * inodes still in the table and the stats readdir-ahead keeps for them.
+ * ctx must be locked.
+ */
+static int32_t
+__rda_serve_listing(xlator_t *this, fd_t *fd, struct rda_fd_ctx *ctx,
+                    size_t request_size, gf_dirent_t *entries, int *op_errno)
+{
+    struct list_head *end = &ctx->listing->entries.list;
+    gf_dirent_t *src = NULL;
+    gf_dirent_t *dirent = NULL;
+    size_t dirent_size, size = 0;
+    int32_t count = 0;
+
+    *op_errno = 0;
+
+    while (ctx->cursor != end) {
+        src = list_entry(ctx->cursor, gf_dirent_t, list);
+        dirent_size = gf_dirent_size(src->d_name);
+        if (size + dirent_size > request_size)
+            break;
+
+        dirent = gf_dirent_for_name(src->d_name);
+        if (!dirent)
+            break;
+
+        dirent->d_off = src->d_off;
+        dirent->d_ino = src->d_ino;
+        dirent->d_type = src->d_type;
+        dirent->d_stat = src->d_stat;
+
+        if (!((strcmp(src->d_name, ".") == 0) ||
+              (strcmp(src->d_name, "..") == 0)) &&
+            !gf_uuid_is_null(src->d_stat.ia_gfid)) {
+            dirent->inode = inode_find(fd->inode->table, src->d_stat.ia_gfid);
+            if (dirent->inode) {
+                rda_inode_ctx_get_iatt(dirent->inode, this, &dirent->d_stat);
+                /* The stat of the listing may be stale by now, the entry
+                 * goes without one so that it is looked up */
+                if (gf_uuid_is_null(dirent->d_stat.ia_gfid)) {
+                    inode_unref(dirent->inode);
+                    dirent->inode = NULL;
+                    memset(&dirent->d_stat, 0, sizeof(dirent->d_stat));
+                }
+            }
+        }
+
+        size += dirent_size;
+        list_add_tail(&dirent->list, &entries->list);
+        ctx->cur_offset = src->d_off;
+        ctx->cursor = ctx->cursor->next;
+        count++;
+    }
+
+    if (ctx->cursor == end) {
+        *op_errno = ctx->listing->op_errno;
+    } else if (!count && !dirent) {
+        *op_errno = ENOMEM;
+        return -1;
+    }
+
+    return count;
+}
+
 static int32_t
 rda_readdirp(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
              off_t off, dict_t *xdata)
@@ -403,20 +791,24 @@ rda_readdirp(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
 
     /*
      * If a new read comes in at offset 0 and the buffer has been
-     * completed, reset the context and kickstart the filler again.
+     * completed, reset the context and kickstart the filler again,
+     * unless the directory has a listing to share by then.
      */
-    if (!off && (ctx->state & RDA_FD_EOD) && (ctx->cur_size == 0)) {
+    if (!off && (((ctx->state & RDA_FD_SHARED) && ctx->cur_offset) ||
+                 ((ctx->state & RDA_FD_EOD) && (ctx->cur_size == 0)))) {
         rda_reset_ctx(this, ctx);
-        /*
-         * Unref and discard the 'list of xattrs to be fetched'
-         * stored during opendir call. This is done above - inside
-         * rda_reset_ctx().
-         * Now, ref the xdata passed by md-cache in actual readdirp()
-         * call and use that for all subsequent internal readdirp()
-         * requests issued by this xlator.
-         */
-        ctx->xattrs = dict_ref(xdata);
-        fill = 1;
+        if (!__rda_share_listing(this, fd, ctx)) {
+            /*
+             * Unref and discard the 'list of xattrs to be fetched'
+             * stored during opendir call. This is done above - inside
+             * rda_reset_ctx().
+             * Now, ref the xdata passed by md-cache in actual readdirp()
+             * call and use that for all subsequent internal readdirp()
+             * requests issued by this xlator.
+             */
+            ctx->xattrs = dict_ref(xdata);
+            fill = 1;
+        }
     }
 
     /*
@@ -429,6 +821,12 @@ rda_readdirp(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
         goto bypass;
     }
 
+    if (ctx->state & RDA_FD_SHARED) {
+        ret = __rda_serve_listing(this, fd, ctx, size, &entries, &op_errno);
+        serve = _gf_true;
+        goto unlock;
+    }
+
     /*
      * If we haven't bypassed the preload, this means we can either serve
      * the request out of the preload or the request that enables us to do
@@ -456,6 +854,7 @@ rda_readdirp(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
         }
     }
 
+unlock:
     UNLOCK(&ctx->lock);
 
     if (serve) {
@@ -499,8 +898,14 @@ rda_fill_fd_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
     };
     uint64_t generation = 0;
     call_frame_t *fill_frame = NULL;
+    gf_dirent_t recorded;
+    size_t recorded_size = 0;
+    uint64_t recorded_gen = 0;
+    int recorded_errno = 0;
+    gf_boolean_t publish = _gf_false;
 
     INIT_LIST_HEAD(&serve_entries.list);
+    INIT_LIST_HEAD(&recorded.list);
     LOCK(&ctx->lock);
 
     /* Verify that the preload buffer is still pending on this data. */
@@ -518,6 +923,9 @@ rda_fill_fd_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
         {
             list_del_init(&dirent->list);
 
+            if (ctx->recording)
+                __rda_record_entry(this, ctx, dirent);
+
             /* must preserve entry order */
             list_add_tail(&dirent->list, &ctx->entries.list);
             if (dirent->inode) {
@@ -569,6 +977,16 @@ rda_fill_fd_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
         ctx->state &= ~RDA_FD_RUNNING;
         ctx->state |= RDA_FD_EOD;
         ctx->op_errno = op_errno;
+
+        if (ctx->recording) {
+            list_splice_init(&ctx->recorded.list, &recorded.list);
+            recorded_size = ctx->recorded_size;
+            recorded_gen = ctx->recorded_gen;
+            recorded_errno = op_errno;
+            ctx->recorded_size = 0;
+            ctx->recording = _gf_false;
+            publish = _gf_true;
+        }
     } else if (op_ret == -1) {
         /* kill the preload and pend the error */
         ctx->state &= ~RDA_FD_RUNNING;
@@ -598,6 +1016,10 @@ out:
          GF_ATOMIC_GET(priv->rda_cache_size) > priv->rda_cache_limit))
         ctx->state &= ~RDA_FD_RUNNING;
 
+    if (!(ctx->state & RDA_FD_EOD) &&
+        (ctx->state & (RDA_FD_BYPASS | RDA_FD_ERROR)))
+        __rda_stop_recording(this, ctx);
+
     if (!(ctx->state & RDA_FD_RUNNING)) {
         fill = 0;
         if (ctx->xattrs) {
@@ -618,6 +1040,10 @@ out:
         op_errno = 0;
 
     UNLOCK(&ctx->lock);
+    if (publish)
+        rda_listing_publish(this, local->fd->inode, &recorded, recorded_size,
+                            recorded_gen, recorded_errno);
+
     if (fill_frame) {
         rda_local_wipe(fill_frame->local);
         STACK_DESTROY(fill_frame->root);
@@ -648,11 +1074,15 @@ rda_fill_fd(call_frame_t *frame, xlator_t *this, fd_t *fd)
     struct rda_fd_ctx *ctx;
     off_t offset;
     struct rda_priv *priv = this->private;
+    uint64_t generation = 0;
 
     ctx = get_rda_fd_ctx(fd, this);
     if (!ctx)
         goto err;
 
+    if (priv->listing_timeout)
+        generation = rda_dir_generation_get(this, fd->inode);
+
     LOCK(&ctx->lock);
 
     if (ctx->state & RDA_FD_NEW) {
@@ -660,6 +1090,12 @@ rda_fill_fd(call_frame_t *frame, xlator_t *this, fd_t *fd)
         ctx->state |= RDA_FD_RUNNING;
         if (priv->rda_low_wmark)
             ctx->state |= RDA_FD_PLUGGED;
+
+        /* keep what is read from the start as the listing to share */
+        if (priv->listing_timeout && !ctx->next_offset) {
+            ctx->recording = _gf_true;
+            ctx->recorded_gen = generation;
+        }
     }
 
     offset = ctx->next_offset;
@@ -716,8 +1152,23 @@ static int32_t
 rda_opendir_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
                 int32_t op_ret, int32_t op_errno, fd_t *fd, dict_t *xdata)
 {
-    if (!op_ret)
-        rda_fill_fd(frame, this, fd);
+    struct rda_fd_ctx *ctx = NULL;
+    gf_boolean_t shared = _gf_false;
+
+    if (!op_ret) {
+        ctx = get_rda_fd_ctx(fd, this);
+        if (ctx) {
+            LOCK(&ctx->lock);
+            {
+                if (ctx->state & RDA_FD_NEW)
+                    shared = __rda_share_listing(this, fd, ctx);
+            }
+            UNLOCK(&ctx->lock);
+        }
+
+        if (!shared)
+            rda_fill_fd(frame, this, fd);
+    }
 
     RDA_STACK_UNWIND(opendir, frame, op_ret, op_errno, fd, xdata);
     return 0;
@@ -1129,6 +1580,205 @@ rda_fremovexattr(call_frame_t *frame, xlator_t *this, fd_t *fd,
     return 0;
 }
 
+static int32_t
+rda_create_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, fd_t *fd, inode_t *inode,
+               struct iatt *buf, struct iatt *preparent,
+               struct iatt *postparent, dict_t *xdata)
+{
+    struct rda_local *local = frame->local;
+
+    if (op_ret >= 0)
+        rda_dir_changed(this, local->inode);
+
+    RDA_STACK_UNWIND(create, frame, op_ret, op_errno, fd, inode, buf,
+                     preparent, postparent, xdata);
+    return 0;
+}
+
+static int32_t
+rda_create(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
+           mode_t mode, mode_t umask, fd_t *fd, dict_t *xdata)
+{
+    RDA_ENTRY_FOP(create, frame, this, loc->parent, NULL, loc, flags, mode,
+                  umask, fd, xdata);
+    return 0;
+}
+
+static int32_t
+rda_mknod_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, inode_t *inode,
+              struct iatt *buf, struct iatt *preparent,
+              struct iatt *postparent, dict_t *xdata)
+{
+    struct rda_local *local = frame->local;
+
+    if (op_ret >= 0)
+        rda_dir_changed(this, local->inode);
+
+    RDA_STACK_UNWIND(mknod, frame, op_ret, op_errno, inode, buf, preparent,
+                     postparent, xdata);
+    return 0;
+}
+
+static int32_t
+rda_mknod(call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
+          dev_t rdev, mode_t umask, dict_t *xdata)
+{
+    RDA_ENTRY_FOP(mknod, frame, this, loc->parent, NULL, loc, mode, rdev,
+                  umask, xdata);
+    return 0;
+}
+
+static int32_t
+rda_mkdir_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, inode_t *inode,
+              struct iatt *buf, struct iatt *preparent,
+              struct iatt *postparent, dict_t *xdata)
+{
+    struct rda_local *local = frame->local;
+
+    if (op_ret >= 0)
+        rda_dir_changed(this, local->inode);
+
+    RDA_STACK_UNWIND(mkdir, frame, op_ret, op_errno, inode, buf, preparent,
+                     postparent, xdata);
+    return 0;
+}
+
+static int32_t
+rda_mkdir(call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
+          mode_t umask, dict_t *xdata)
+{
+    RDA_ENTRY_FOP(mkdir, frame, this, loc->parent, NULL, loc, mode, umask,
+                  xdata);
+    return 0;
+}
+
+static int32_t
+rda_symlink_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                int32_t op_ret, int32_t op_errno, inode_t *inode,
+                struct iatt *buf, struct iatt *preparent,
+                struct iatt *postparent, dict_t *xdata)
+{
+    struct rda_local *local = frame->local;
+
+    if (op_ret >= 0)
+        rda_dir_changed(this, local->inode);
+
+    RDA_STACK_UNWIND(symlink, frame, op_ret, op_errno, inode, buf, preparent,
+                     postparent, xdata);
+    return 0;
+}
+
+static int32_t
+rda_symlink(call_frame_t *frame, xlator_t *this, const char *linkpath,
+            loc_t *loc, mode_t umask, dict_t *xdata)
+{
+    RDA_ENTRY_FOP(symlink, frame, this, loc->parent, NULL, linkpath, loc,
+                  umask, xdata);
+    return 0;
+}
+
+static int32_t
+rda_link_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
+             int32_t op_errno, inode_t *inode, struct iatt *buf,
+             struct iatt *preparent, struct iatt *postparent, dict_t *xdata)
+{
+    struct rda_local *local = frame->local;
+
+    if (op_ret >= 0)
+        rda_dir_changed(this, local->inode);
+
+    RDA_STACK_UNWIND(link, frame, op_ret, op_errno, inode, buf, preparent,
+                     postparent, xdata);
+    return 0;
+}
+
+static int32_t
+rda_link(call_frame_t *frame, xlator_t *this, loc_t *oldloc, loc_t *newloc,
+         dict_t *xdata)
+{
+    RDA_ENTRY_FOP(link, frame, this, newloc->parent, NULL, oldloc, newloc,
+                  xdata);
+    return 0;
+}
+
+static int32_t
+rda_unlink_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, struct iatt *preparent,
+               struct iatt *postparent, dict_t *xdata)
+{
+    struct rda_local *local = frame->local;
+
+    if (op_ret >= 0)
+        rda_dir_changed(this, local->inode);
+
+    RDA_STACK_UNWIND(unlink, frame, op_ret, op_errno, preparent, postparent,
+                     xdata);
+    return 0;
+}
+
+static int32_t
+rda_unlink(call_frame_t *frame, xlator_t *this, loc_t *loc, int xflags,
+           dict_t *xdata)
+{
+    RDA_ENTRY_FOP(unlink, frame, this, loc->parent, NULL, loc, xflags, xdata);
+    return 0;
+}
+
+static int32_t
+rda_rmdir_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, struct iatt *preparent,
+              struct iatt *postparent, dict_t *xdata)
+{
+    struct rda_local *local = frame->local;
+
+    if (op_ret >= 0)
+        rda_dir_changed(this, local->inode);
+
+    RDA_STACK_UNWIND(rmdir, frame, op_ret, op_errno, preparent, postparent,
+                     xdata);
+    return 0;
+}
+
+static int32_t
+rda_rmdir(call_frame_t *frame, xlator_t *this, loc_t *loc, int xflags,
+          dict_t *xdata)
+{
+    RDA_ENTRY_FOP(rmdir, frame, this, loc->parent, NULL, loc, xflags, xdata);
+    return 0;
+}
+
+static int32_t
+rda_rename_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, struct iatt *buf,
+               struct iatt *preoldparent, struct iatt *postoldparent,
+               struct iatt *prenewparent, struct iatt *postnewparent,
+               dict_t *xdata)
+{
+    struct rda_local *local = frame->local;
+
+    if (op_ret >= 0) {
+        rda_dir_changed(this, local->inode);
+        if (local->oldparent)
+            rda_dir_changed(this, local->oldparent);
+    }
+
+    RDA_STACK_UNWIND(rename, frame, op_ret, op_errno, buf, preoldparent,
+                     postoldparent, prenewparent, postnewparent, xdata);
+    return 0;
+}
+
+static int32_t
+rda_rename(call_frame_t *frame, xlator_t *this, loc_t *oldloc, loc_t *newloc,
+           dict_t *xdata)
+{
+    RDA_ENTRY_FOP(rename, frame, this, newloc->parent, oldloc->parent, oldloc,
+                  newloc, xdata);
+    return 0;
+}
+
 static int32_t
 rda_releasedir(xlator_t *this, fd_t *fd)
 {
@@ -1173,6 +1823,97 @@ rda_forget(xlator_t *this, inode_t *inode)
     return 0;
 }
 
+static int
+rda_invalidate(xlator_t *this, void *data)
+{
+    struct gf_upcall *up_data = data;
+    struct gf_upcall_cache_invalidation *up_ci = NULL;
+    inode_table_t *itable = NULL;
+    inode_t *inode = NULL;
+
+    if (up_data->event_type != GF_UPCALL_CACHE_INVALIDATION)
+        return 0;
+
+    up_ci = (struct gf_upcall_cache_invalidation *)up_data->data;
+    itable = ((xlator_t *)this->graph->top)->itable;
+    if (!itable)
+        return 0;
+
+    inode = inode_find(itable, up_data->gfid);
+    if (inode) {
+        if (up_ci->flags & (IATT_UPDATE_FLAGS | UP_INVAL_ATTR | UP_FORGET))
+            rda_inode_ctx_update_iatts(inode, this, NULL, NULL, 0);
+        if ((inode->ia_type == IA_IFDIR) && (up_ci->flags & UP_TIMES))
+            rda_dir_changed(this, inode);
+        inode_unref(inode);
+    }
+
+    if (!gf_uuid_is_null(up_ci->p_stat.ia_gfid)) {
+        inode = inode_find(itable, up_ci->p_stat.ia_gfid);
+        if (inode) {
+            rda_dir_changed(this, inode);
+            inode_unref(inode);
+        }
+    }
+
+    if (!gf_uuid_is_null(up_ci->oldp_stat.ia_gfid)) {
+        inode = inode_find(itable, up_ci->oldp_stat.ia_gfid);
+        if (inode) {
+            rda_dir_changed(this, inode);
+            inode_unref(inode);
+        }
+    }
+
+    return 0;
+}
+
+static int
+rda_notify(xlator_t *this, int event, void *data, ...)
+{
+    struct rda_priv *priv = this->private;
+
+    if ((event == GF_EVENT_UPCALL) && priv && priv->listing_timeout)
+        rda_invalidate(this, data);
+
+    return default_notify(this, event, data);
+}
+
+static int
+rda_priv_dump(xlator_t *this)
+{
+    struct rda_priv *priv = this->private;
+    char key_prefix[GF_DUMP_MAX_BUF_LEN];
+    int listings = 0;
+    struct rda_listing *listing = NULL;
+
+    if (!priv)
+        return 0;
+
+    LOCK(&priv->lock);
+    {
+        list_for_each_entry(listing, &priv->listings, list)
+        {
+            listings++;
+        }
+    }
+    UNLOCK(&priv->lock);
+
+    snprintf(key_prefix, GF_DUMP_MAX_BUF_LEN, "%s.%s", this->type, this->name);
+    gf_proc_dump_add_section("%s", key_prefix);
+
+    gf_proc_dump_write("cache_limit", "%" PRIu64, priv->rda_cache_limit);
+    gf_proc_dump_write("cache_size", "%" PRId64,
+                       GF_ATOMIC_GET(priv->rda_cache_size));
+    gf_proc_dump_write("listing_timeout", "%" PRIu32, priv->listing_timeout);
+    gf_proc_dump_write("listings", "%d", listings);
+    gf_proc_dump_write("listings_built", "%" PRId64,
+                       GF_ATOMIC_GET(priv->listings_built));
+    gf_proc_dump_write("listing_hits", "%" PRId64,
+                       GF_ATOMIC_GET(priv->listing_hits));
+
+    return 0;
+}
+
 int32_t
 mem_acct_init(xlator_t *this)
 {
@@ -1208,6 +1949,11 @@ reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("parallel-readdir", priv->parallel_readdir, options, bool,
                      err);
     GF_OPTION_RECONF("pass-through", this->pass_through, options, bool, err);
+    GF_OPTION_RECONF("rda-listing-timeout", priv->listing_timeout, options,
+                     uint32, err);
+
+    if (!priv->listing_timeout)
+        rda_listing_prune(this, _gf_true);
 
     return 0;
 err:
@@ -1241,6 +1987,10 @@ init(xlator_t *this)
     this->private = priv;
 
     GF_ATOMIC_INIT(priv->rda_cache_size, 0);
+    GF_ATOMIC_INIT(priv->listings_built, 0);
+    GF_ATOMIC_INIT(priv->listing_hits, 0);
+    LOCK_INIT(&priv->lock);
+    INIT_LIST_HEAD(&priv->listings);
 
     this->local_pool = mem_pool_new(struct rda_local, 32);
     if (!this->local_pool)
@@ -1252,6 +2002,7 @@ init(xlator_t *this)
     GF_OPTION_INIT("rda-cache-limit", priv->rda_cache_limit, size_uint64, err);
     GF_OPTION_INIT("parallel-readdir", priv->parallel_readdir, bool, err);
     GF_OPTION_INIT("pass-through", this->pass_through, bool, err);
+    GF_OPTION_INIT("rda-listing-timeout", priv->listing_timeout, uint32, err);
 
     return 0;
 
@@ -1267,8 +2018,16 @@ err:
 void
 fini(xlator_t *this)
 {
+    struct rda_priv *priv = NULL;
+
     GF_VALIDATE_OR_GOTO("readdir-ahead", this, out);
 
+    priv = this->private;
+    if (priv) {
+        rda_listing_prune(this, _gf_true);
+        LOCK_DESTROY(&priv->lock);
+    }
+
     GF_FREE(this->private);
 
 out:
@@ -1295,6 +2054,19 @@ struct xlator_fops fops = {
     .fsetattr = rda_fsetattr,
     .removexattr = rda_removexattr,
     .fremovexattr = rda_fremovexattr,
+    /* entry */
+    .create = rda_create,
+    .mknod = rda_mknod,
+    .mkdir = rda_mkdir,
+    .symlink = rda_symlink,
+    .link = rda_link,
+    .unlink = rda_unlink,
+    .rmdir = rda_rmdir,
+    .rename = rda_rename,
+};
+
+struct xlator_dumpops dumpops = {
+    .priv = rda_priv_dump,
 };
 
 struct xlator_cbks cbks = {
@@ -1365,6 +2137,19 @@ struct volume_options options[] = {
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
      .tags = {"readdir-ahead"},
      .description = "Enable/Disable readdir ahead translator"},
+    {.key = {"rda-listing-timeout"},
+     .type = GF_OPTION_TYPE_TIME,
+     .min = 0,
+     .max = 600,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+     .tags = {"readdir-ahead"},
+     .description = "Time in seconds for which the complete listing of a "
+                    "directory read by one fd is kept and served to the fds "
+                    "opened on the directory later, as long as no entry is "
+                    "created or removed in it. The listings count against "
+                    "rda-cache-limit. 0 disables it."},
     {.key = {NULL}},
 };
 
@@ -1372,8 +2157,10 @@ xlator_api_t xlator_api = {
     .init = init,
     .fini = fini,
     .reconfigure = reconfigure,
+    .notify = rda_notify,
     .mem_acct_init = mem_acct_init,
     .op_version = {1}, /* Present from the initial version */
+    .dumpops = &dumpops,
     .fops = &fops,
     .cbks = &cbks,
     .options = options,
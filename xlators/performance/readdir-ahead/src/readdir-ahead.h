@@ -18,6 +18,7 @@
 #define RDA_FD_ERROR (1 << 3)
 #define RDA_FD_BYPASS (1 << 4)
 #define RDA_FD_PLUGGED (1 << 5)
+#define RDA_FD_SHARED (1 << 6) /* served from the listing of the directory */
 
 #define RDA_COMMON_MODIFICATION_FOP(name, frame, this, __inode, __xdata,       \
                                     args...)                                   \
@@ -56,6 +57,45 @@
         }                                                                      \
     } while (0)
 
+#define RDA_ENTRY_FOP(name, frame, this, __parent, __oldparent, args...)       \
+    do {                                                                       \
+        struct rda_local *__local = NULL;                                      \
+        struct rda_priv *__priv = this->private;                               \
+                                                                               \
+        if (!__priv->listing_timeout) {                                        \
+            default_##name##_resume(frame, this, args);                        \
+            break;                                                             \
+        }                                                                      \
+                                                                               \
+        __local = mem_get0(this->local_pool);                                  \
+        if (!__local) {                                                        \
+            default_##name##_failure_cbk(frame, ENOMEM);                       \
+            break;                                                             \
+        }                                                                      \
+        __local->inode = inode_ref(__parent);                                  \
+        if (__oldparent)                                                       \
+            __local->oldparent = inode_ref(__oldparent);                       \
+        frame->local = __local;                                                \
+                                                                               \
+        STACK_WIND(frame, rda_##name##_cbk, FIRST_CHILD(this),                 \
+                   FIRST_CHILD(this)->fops->name, args);                       \
+    } while (0)
+
+/* A complete listing of a directory, read from offset 0 to the end by one
+ * fd and shared by the fds opened on the directory afterwards, until an
+ * entry is created or removed in it or rda-listing-timeout passes. It keeps
+ * the names, offsets and gfids of the entries only, and is never changed
+ * once published. */
+struct rda_listing {
+    struct list_head list; /* in priv->listings, least recently used first */
+    inode_t *inode;        /* of the directory */
+    gf_dirent_t entries;
+    size_t size;
+    time_t time;
+    int op_errno; /* returned with the last entries */
+    gf_atomic_t refcount;
+};
+
 struct rda_fd_ctx {
     off_t cur_offset;  /* current head of the ctx */
     size_t cur_size;   /* current size of the preload */
@@ -69,6 +109,12 @@ struct rda_fd_ctx {
     dict_t *xattrs; /* md-cache keys to be sent in readdirp() */
     dict_t *writes_during_prefetch;
     gf_atomic_t prefetching;
+    struct rda_listing *listing; /* with RDA_FD_SHARED */
+    struct list_head *cursor;    /* next entry of the listing to serve */
+    gf_dirent_t recorded;        /* copy of what is filled from offset 0 */
+    size_t recorded_size;
+    uint64_t recorded_gen;
+    gf_boolean_t recording;
 };
 
 struct rda_local {
@@ -76,6 +122,7 @@ struct rda_local {
     fd_t *fd;
     dict_t *xattrs; /* md-cache keys to be sent in readdirp() */
     inode_t *inode;
+    inode_t *oldparent;
     off_t offset;
     uint64_t generation;
     int32_t skip_dir;
@@ -88,11 +135,19 @@ struct rda_priv {
     uint64_t rda_cache_limit;
     gf_atomic_t rda_cache_size;
     gf_boolean_t parallel_readdir;
+    uint32_t listing_timeout;
+    gf_lock_t lock;
+    struct list_head listings;
+    gf_atomic_t listings_built;
+    gf_atomic_t listing_hits;
 };
 
 typedef struct rda_inode_ctx {
     struct iatt statbuf;
     gf_atomic_t generation;
+    /* of the entries of a directory, under inode->lock */
+    uint64_t dir_generation;
+    struct rda_listing *listing;
 } rda_inode_ctx_t;
 
 #endif /* __READDIR_AHEAD_H */
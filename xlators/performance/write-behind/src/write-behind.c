@@ -26,6 +26,13 @@
 #define WB_AGGREGATE_SIZE 131072 /* 128 KB */
 #define WB_WINDOW_SIZE 1048576   /* 1MB */
 
+/* Sequences of writes collapsed at the same time, see
+ * __wb_preprocess_winds() */
+#define WB_MAX_HOLDERS 4
+
+/* Write sizes counted up to 512B, 1KB, ... 1MB, and above */
+#define WB_SIZE_BUCKETS 13
+
 typedef struct list_head list_head_t;
 struct wb_conf;
 struct wb_inode;
@@ -124,6 +131,14 @@ typedef struct wb_inode {
     gf_atomic_int32_t readdirps;
     gf_atomic_int8_t invalidate;
 
+    size_t aggregate_size; /* grows for streaming writers, up to
+                              conf->aggregate_max */
+
+    list_head_t fsyncs;     /* stubs of fsyncs waiting for the one
+                               in flight to complete. They are all
+                               sent as a single fsync after it */
+    list_head_t fsyncs_wip; /* answered by the fsync in flight */
+    gf_boolean_t fsync_busy;
 } wb_inode_t;
 
 typedef struct wb_request {
@@ -147,6 +162,8 @@ typedef struct wb_request {
                            STACK_WIND to server and therefore the
                            amount by which we shrink the window.
                         */
+    size_t capacity;    /* of the buffer in @iobref that smaller
+                           writes are collapsed into */
 
     int op_ret;
     int op_errno;
@@ -183,15 +200,33 @@ typedef struct wb_request {
 
 typedef struct wb_conf {
     uint64_t aggregate_size;
-    uint64_t page_size;
+    uint64_t aggregate_max;
     uint64_t window_size;
     gf_boolean_t flush_behind;
     gf_boolean_t trickling_writes;
     gf_boolean_t strict_write_ordering;
     gf_boolean_t strict_O_DIRECT;
     gf_boolean_t resync_after_fsync;
+    gf_atomic_t writes_received[WB_SIZE_BUCKETS];
+    gf_atomic_t writes_sent[WB_SIZE_BUCKETS];
+    gf_atomic_t fsyncs_received;
+    gf_atomic_t fsyncs_sent;
 } wb_conf_t;
 
+static int
+wb_size_bucket(size_t size)
+{
+    size_t limit = 512;
+    int bucket = 0;
+
+    while ((bucket < WB_SIZE_BUCKETS - 1) && (size > limit)) {
+        limit <<= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
 wb_inode_t *
 __wb_inode_ctx_get(xlator_t *this, inode_t *inode)
 {
@@ -674,10 +709,13 @@ __wb_inode_create(xlator_t *this, inode_t *inode)
     INIT_LIST_HEAD(&wb_inode->temptation);
     INIT_LIST_HEAD(&wb_inode->wip);
     INIT_LIST_HEAD(&wb_inode->invalidate_list);
+    INIT_LIST_HEAD(&wb_inode->fsyncs);
+    INIT_LIST_HEAD(&wb_inode->fsyncs_wip);
 
     wb_inode->this = this;
 
     wb_inode->window_conf = conf->window_size;
+    wb_inode->aggregate_size = conf->aggregate_size;
     wb_inode->inode = inode;
 
     LOCK_INIT(&wb_inode->lock);
@@ -1127,6 +1165,7 @@ wb_fulfill_head(wb_inode_t *wb_inode, wb_request_t *head)
     int count = 0;
     wb_request_t *req = NULL;
     call_frame_t *frame = NULL;
+    wb_conf_t *conf = wb_inode->this->private;
 
     /* make sure head->total_size is updated before we run into any
      * errors
@@ -1146,6 +1185,8 @@ wb_fulfill_head(wb_inode_t *wb_inode, wb_request_t *head)
     if (!frame)
         goto err;
 
+    GF_ATOMIC_INC(conf->writes_sent[wb_size_bucket(head->total_size)]);
+
     frame->root->lk_owner = head->lk_owner;
     frame->root->pid = head->client_pid;
     frame->local = head;
@@ -1169,71 +1210,98 @@ err:
     return ENOMEM;
 }
 
-#define NEXT_HEAD(head, req)                                                   \
-    do {                                                                       \
-        if (head)                                                              \
-            ret |= wb_fulfill_head(wb_inode, head);                            \
-        head = req;                                                            \
-        expected_offset = req->stub->args.offset + req->write_size;            \
-        curr_aggregate = 0;                                                    \
-        vector_count = 0;                                                      \
-    } while (0)
+/* A run of contiguous liabilities, sent as a single writev */
+struct wb_run {
+    wb_request_t *head;
+    off_t expected_offset;
+    size_t curr_aggregate;
+    size_t vector_count;
+};
+
+static gf_boolean_t
+wb_run_continues(struct wb_run *run, wb_request_t *req, size_t aggregate_size)
+{
+    wb_request_t *head = run->head;
+
+    if (req->fd != head->fd)
+        return _gf_false;
+
+    if (!is_same_lkowner(&req->lk_owner, &head->lk_owner))
+        return _gf_false;
+
+    if (run->expected_offset != req->stub->args.offset)
+        return _gf_false;
+
+    if ((run->curr_aggregate + req->write_size) > aggregate_size)
+        return _gf_false;
+
+    if (run->vector_count + req->stub->args.count > MAX_VECTOR_COUNT)
+        return _gf_false;
+
+    return _gf_true;
+}
 
 int
 wb_fulfill(wb_inode_t *wb_inode, list_head_t *liabilities)
 {
+    struct wb_run runs[WB_MAX_HOLDERS];
+    struct wb_run *run = NULL;
     wb_request_t *req = NULL;
-    wb_request_t *head = NULL;
     wb_request_t *tmp = NULL;
-    wb_conf_t *conf = NULL;
-    off_t expected_offset = 0;
-    size_t curr_aggregate = 0;
-    size_t vector_count = 0;
+    size_t aggregate_size = 0;
+    int nruns = 0;
     int ret = 0;
+    int i = 0;
 
-    conf = wb_inode->this->private;
+    LOCK(&wb_inode->lock);
+    {
+        aggregate_size = wb_inode->aggregate_size;
+    }
+    UNLOCK(&wb_inode->lock);
 
+    /* Liabilities picked together never overlap (see wb_wip_has_conflict),
+       so a request can join the run of any request before it, not only
+       the one right before it. Interleaved sequences of writes go out as
+       one writev per sequence. Appends only ever join the last run.
+    */
     list_for_each_entry_safe(req, tmp, liabilities, winds)
     {
         list_del_init(&req->winds);
 
-        if (!head) {
-            NEXT_HEAD(head, req);
-            continue;
-        }
-
-        if (req->fd != head->fd) {
-            NEXT_HEAD(head, req);
-            continue;
-        }
+        run = NULL;
+        for (i = nruns - 1; i >= 0; i--) {
+            if (wb_run_continues(&runs[i], req, aggregate_size)) {
+                run = &runs[i];
+                break;
+            }
 
-        if (!is_same_lkowner(&req->lk_owner, &head->lk_owner)) {
-            NEXT_HEAD(head, req);
-            continue;
+            if (req->ordering.append)
+                break;
         }
 
-        if (expected_offset != req->stub->args.offset) {
-            NEXT_HEAD(head, req);
+        if (run) {
+            list_add_tail(&req->winds, &run->head->winds);
+            run->expected_offset += req->write_size;
+            run->curr_aggregate += req->write_size;
+            run->vector_count += req->stub->args.count;
             continue;
         }
 
-        if ((curr_aggregate + req->write_size) > conf->aggregate_size) {
-            NEXT_HEAD(head, req);
-            continue;
+        if (nruns == WB_MAX_HOLDERS) {
+            ret |= wb_fulfill_head(wb_inode, runs[0].head);
+            memmove(&runs[0], &runs[1], (nruns - 1) * sizeof(runs[0]));
+            nruns--;
         }
 
-        if (vector_count + req->stub->args.count > MAX_VECTOR_COUNT) {
-            NEXT_HEAD(head, req);
-            continue;
-        }
-
-        list_add_tail(&req->winds, &head->winds);
-        curr_aggregate += req->write_size;
-        vector_count += req->stub->args.count;
+        run = &runs[nruns++];
+        run->head = req;
+        run->expected_offset = req->stub->args.offset + req->write_size;
+        run->curr_aggregate = 0;
+        run->vector_count = req->stub->args.count;
     }
 
-    if (head)
-        ret |= wb_fulfill_head(wb_inode, head);
+    for (i = 0; i < nruns; i++)
+        ret |= wb_fulfill_head(wb_inode, runs[i].head);
 
     return ret;
 }
@@ -1307,7 +1375,7 @@ __wb_pick_unwinds(wb_inode_t *wb_inode, list_head_t *lies)
 }
 
 int
-__wb_collapse_small_writes(wb_conf_t *conf, wb_request_t *holder,
+__wb_collapse_small_writes(wb_inode_t *wb_inode, wb_request_t *holder,
                            wb_request_t *req)
 {
     char *ptr = NULL;
@@ -1323,7 +1391,8 @@ __wb_collapse_small_writes(wb_conf_t *conf, wb_request_t *holder,
                                 holder->stub->args.count);
         req_len = iov_length(req->stub->args.vector, req->stub->args.count);
 
-        required_size = max((conf->page_size), (holder_len + req_len));
+        required_size = max((wb_inode->aggregate_size),
+                            (holder_len + req_len));
         iobuf = iobuf_get2(req->wb_inode->this->ctx->iobuf_pool, required_size);
         if (iobuf == NULL) {
             goto out;
@@ -1356,6 +1425,7 @@ __wb_collapse_small_writes(wb_conf_t *conf, wb_request_t *holder,
         iobuf_unref(iobuf);
 
         holder->iobref = iobref_ref(iobref);
+        holder->capacity = required_size;
     }
 
     ptr = holder->stub->args.vector[0].iov_base + holder->write_size;
@@ -1371,17 +1441,107 @@ out:
     return ret;
 }
 
+/* A writer filling up holders faster than they are sent is streaming, send
+ * its writes in larger chunks */
+static void
+__wb_aggregate_grow(wb_inode_t *wb_inode)
+{
+    wb_conf_t *conf = wb_inode->this->private;
+    size_t limit = 0;
+
+    limit = min(conf->aggregate_max, (uint64_t)wb_inode->window_conf / 2);
+    limit = max(limit, conf->aggregate_size);
+
+    wb_inode->aggregate_size = min(wb_inode->aggregate_size * 2, limit);
+}
+
+static void
+__wb_aggregate_shrink(wb_inode_t *wb_inode)
+{
+    wb_conf_t *conf = wb_inode->this->private;
+
+    wb_inode->aggregate_size = max(wb_inode->aggregate_size / 2,
+                                   conf->aggregate_size);
+}
+
+static void
+__wb_holder_go(wb_inode_t *wb_inode, wb_request_t *holder)
+{
+    if (holder->ordering.go)
+        return;
+
+    holder->ordering.go = 1;
+
+    /* sent well before it was full, the writer is not streaming */
+    if (holder->write_size < wb_inode->aggregate_size / 2)
+        __wb_aggregate_shrink(wb_inode);
+}
+
+static gf_boolean_t
+wb_fop_modifies_data(glusterfs_fop_t fop)
+{
+    switch (fop) {
+        case GF_FOP_WRITE:
+        case GF_FOP_TRUNCATE:
+        case GF_FOP_FTRUNCATE:
+        case GF_FOP_FALLOCATE:
+        case GF_FOP_DISCARD:
+        case GF_FOP_ZEROFILL:
+            return _gf_true;
+        default:
+            return _gf_false;
+    }
+}
+
+/* Whether @req continues @holder and can be collapsed into it. @holder is not
+ * necessarily the last write queued before @req, nothing queued in between
+ * may modify what @req writes, or the data of @req would be overwritten by
+ * older data. */
+static gf_boolean_t
+__wb_holder_continues(wb_request_t *holder, wb_request_t *req,
+                      wb_request_t *last)
+{
+    wb_request_t *each = NULL;
+
+    if (req->stub->args.offset !=
+        holder->stub->args.offset + holder->write_size)
+        return _gf_false;
+
+    if (!is_same_lkowner(&req->lk_owner, &holder->lk_owner))
+        return _gf_false;
+
+    if (req->fd != holder->fd)
+        return _gf_false;
+
+    if (holder == last)
+        return _gf_true;
+
+    for (each = list_next_entry(holder, todo); each != req;
+         each = list_next_entry(each, todo)) {
+        if (wb_fop_modifies_data(each->fop) && wb_requests_overlap(each, req))
+            return _gf_false;
+    }
+
+    return _gf_true;
+}
+
 void
 __wb_preprocess_winds(wb_inode_t *wb_inode)
 {
-    off_t offset_expected = 0;
+    wb_request_t *holders[WB_MAX_HOLDERS] = {
+        NULL,
+    };
     ssize_t space_left = 0;
+    ssize_t capacity = 0;
+    size_t held = 0;
     wb_request_t *req = NULL;
     wb_request_t *tmp = NULL;
     wb_request_t *holder = NULL;
+    wb_request_t *last = NULL;
     wb_conf_t *conf = NULL;
+    int nholders = 0;
     int ret = 0;
-    ssize_t page_size = 0;
+    int i = 0;
     char gfid[64] = {
         0,
     };
@@ -1391,12 +1551,14 @@ __wb_preprocess_winds(wb_inode_t *wb_inode)
        of the file. But individual (broken down) IO requests
        can arrive interleaved.
 
-       TODO: cycle for each such sequence sifting
-       through the interleaved ops
+       Up to WB_MAX_HOLDERS such sequences are collapsed at the same
+       time, each into its own holder. A new sequence pushes the oldest
+       one out. Writes arriving out of order, leaving small gaps, are
+       collapsed as well once the gaps are filled, and the holders that
+       end up contiguous go out together from wb_fulfill().
     */
 
     conf = wb_inode->this->private;
-    page_size = conf->page_size;
 
     list_for_each_entry_safe(req, tmp, &wb_inode->todo, todo)
     {
@@ -1422,49 +1584,51 @@ __wb_preprocess_winds(wb_inode_t *wb_inode)
         }
 
         if (!req->ordering.tempted) {
-            if (holder) {
-                if (wb_requests_conflict(holder, req))
+            for (i = 0; i < nholders; i++) {
+                if (wb_requests_conflict(holders[i], req))
                     /* do not hold on write if a
                        dependent write is in queue */
-                    holder->ordering.go = 1;
+                    __wb_holder_go(wb_inode, holders[i]);
             }
             /* collapse only non-sync writes */
             continue;
-        } else if (!holder) {
-            /* holder is always a non-sync write */
-            holder = req;
-            continue;
         }
 
-        offset_expected = holder->stub->args.offset + holder->write_size;
-
-        if (req->stub->args.offset != offset_expected) {
-            holder->ordering.go = 1;
-            holder = req;
-            continue;
-        }
-
-        if (!is_same_lkowner(&req->lk_owner, &holder->lk_owner)) {
-            holder->ordering.go = 1;
-            holder = req;
-            continue;
+        holder = NULL;
+        for (i = nholders - 1; i >= 0; i--) {
+            if (__wb_holder_continues(holders[i], req, last)) {
+                holder = holders[i];
+                break;
+            }
         }
 
-        if (req->fd != holder->fd) {
-            holder->ordering.go = 1;
-            holder = req;
+        if (!holder) {
+            /* holder is always a non-sync write */
+            if (nholders == WB_MAX_HOLDERS) {
+                __wb_holder_go(wb_inode, holders[0]);
+                memmove(&holders[0], &holders[1],
+                        (nholders - 1) * sizeof(holders[0]));
+                nholders--;
+            }
+            holders[nholders++] = req;
+            last = req;
             continue;
         }
 
-        space_left = page_size - holder->write_size;
+        capacity = wb_inode->aggregate_size;
+        if (holder->iobref)
+            capacity = min(capacity, (ssize_t)holder->capacity);
+        space_left = capacity - holder->write_size;
 
         if (space_left < req->write_size) {
             holder->ordering.go = 1;
-            holder = req;
+            __wb_aggregate_grow(wb_inode);
+            holders[i] = req;
+            last = req;
             continue;
         }
 
-        ret = __wb_collapse_small_writes(conf, holder, req);
+        ret = __wb_collapse_small_writes(wb_inode, holder, req);
         if (ret)
             continue;
 
@@ -1474,12 +1638,12 @@ __wb_preprocess_winds(wb_inode_t *wb_inode)
         list_del_init(&req->todo);
         __wb_fulfill_request(req);
 
-        /* Only the last @holder in queue which
+        /* Only the @holders in queue which
 
-           - does not have any non-buffered-writes following it
-           - has not yet filled its capacity
+           - do not have any non-buffered-writes following them
+           - have not yet filled their capacity
 
-           does not get its 'go' set, in anticipation of the arrival
+           do not get their 'go' set, in anticipation of the arrival
            of consecutive smaller writes.
         */
     }
@@ -1488,8 +1652,22 @@ __wb_preprocess_winds(wb_inode_t *wb_inode)
        writes if there are no outstanding requests
     */
 
-    if (conf->trickling_writes && !wb_inode->transit && holder)
-        holder->ordering.go = 1;
+    for (i = 0; i < nholders; i++) {
+        if (conf->trickling_writes && !wb_inode->transit)
+            holders[i]->ordering.go = 1;
+        else if (!holders[i]->ordering.go)
+            held += holders[i]->write_size;
+    }
+
+    /* The window must not fill up with writes held back, nothing would
+       send them then */
+    for (i = 0; (i < nholders) && (held > (size_t)wb_inode->window_conf / 2);
+         i++) {
+        if (!holders[i]->ordering.go) {
+            holders[i]->ordering.go = 1;
+            held -= holders[i]->write_size;
+        }
+    }
 
     if (wb_inode->dontsync > 0)
         wb_inode->dontsync--;
@@ -1837,6 +2015,10 @@ wb_writev_helper(call_frame_t *frame, xlator_t *this, fd_t *fd,
                  struct iovec *vector, int32_t count, off_t offset,
                  uint32_t flags, struct iobref *iobref, dict_t *xdata)
 {
+    wb_conf_t *conf = this->private;
+
+    GF_ATOMIC_INC(conf->writes_sent[wb_size_bucket(iov_length(vector, count))]);
+
     STACK_WIND(frame, wb_writev_cbk, FIRST_CHILD(this),
                FIRST_CHILD(this)->fops->writev, fd, vector, count, offset,
                flags, iobref, xdata);
@@ -1858,6 +2040,9 @@ wb_writev(call_frame_t *frame, xlator_t *this, fd_t *fd, struct iovec *vector,
 
     conf = this->private;
 
+    GF_ATOMIC_INC(
+        conf->writes_received[wb_size_bucket(iov_length(vector, count))]);
+
     wb_inode = wb_inode_create(this, fd->inode);
     if (!wb_inode) {
         op_errno = ENOMEM;
@@ -2037,10 +2222,165 @@ noqueue:
     return 0;
 }
 
+/* Answers the fsyncs the one in flight was sent for */
+static void
+wb_fsync_unwind(wb_inode_t *wb_inode, int32_t op_ret, int32_t op_errno,
+                struct iatt *prebuf, struct iatt *postbuf, dict_t *xdata)
+{
+    call_stub_t *stub = NULL;
+    call_stub_t *tmp = NULL;
+    struct iatt pre = {
+        0,
+    };
+    struct iatt post = {
+        0,
+    };
+    list_head_t done;
+
+    INIT_LIST_HEAD(&done);
+
+    LOCK(&wb_inode->lock);
+    {
+        list_splice_init(&wb_inode->fsyncs_wip, &done);
+    }
+    UNLOCK(&wb_inode->lock);
+
+    /* every waiter gets its own copy of the attributes to play with */
+    list_for_each_entry_safe(stub, tmp, &done, list)
+    {
+        list_del_init(&stub->list);
+
+        if (prebuf)
+            pre = *prebuf;
+        if (postbuf)
+            post = *postbuf;
+
+        STACK_UNWIND_STRICT(fsync, stub->frame, op_ret, op_errno,
+                            prebuf ? &pre : NULL, postbuf ? &post : NULL,
+                            xdata);
+        stub->frame = NULL;
+        call_stub_destroy(stub);
+    }
+}
+
+static void
+wb_fsync_sync(xlator_t *this, wb_inode_t *wb_inode);
+
+int
+wb_fsync_sync_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                  struct iatt *postbuf, dict_t *xdata)
+{
+    wb_inode_t *wb_inode = NULL;
+
+    wb_inode = frame->local;
+    frame->local = NULL;
+
+    wb_fsync_unwind(wb_inode, op_ret, op_errno, prebuf, postbuf, xdata);
+
+    STACK_DESTROY(frame->root);
+
+    wb_fsync_sync(this, wb_inode);
+
+    return 0;
+}
+
+/* Sends a single fsync for all the fsyncs that arrived while the previous
+   one was in flight. Each of them was issued after that one was sent, and
+   is satisfied by one sent after it completed. */
+static void
+wb_fsync_sync(xlator_t *this, wb_inode_t *wb_inode)
+{
+    wb_conf_t *conf = this->private;
+    call_stub_t *stub = NULL;
+    call_stub_t *tmp = NULL;
+    call_frame_t *frame = NULL;
+    int32_t datasync = 1;
+    gf_boolean_t idle = _gf_false;
+
+    do {
+        LOCK(&wb_inode->lock);
+        {
+            if (list_empty(&wb_inode->fsyncs)) {
+                wb_inode->fsync_busy = _gf_false;
+                idle = _gf_true;
+            } else {
+                list_splice_init(&wb_inode->fsyncs, &wb_inode->fsyncs_wip);
+                datasync = 1;
+                list_for_each_entry(tmp, &wb_inode->fsyncs_wip, list)
+                {
+                    /* a data only sync does not do for a full one */
+                    if (!tmp->args.datasync)
+                        datasync = 0;
+                }
+                stub = list_first_entry(&wb_inode->fsyncs_wip, call_stub_t,
+                                        list);
+            }
+        }
+        UNLOCK(&wb_inode->lock);
+
+        if (idle) {
+            /* taken in wb_fsync_helper() when the first fsync was sent */
+            inode_unref(wb_inode->inode);
+            return;
+        }
+
+        frame = copy_frame(stub->frame);
+        if (!frame) {
+            gf_msg(this->name, GF_LOG_ERROR, ENOMEM, WRITE_BEHIND_MSG_NO_MEMORY,
+                   "failed to create frame for fsync");
+            wb_fsync_unwind(wb_inode, -1, ENOMEM, NULL, NULL, NULL);
+        }
+    } while (!frame);
+
+    GF_ATOMIC_INC(conf->fsyncs_sent);
+
+    frame->local = wb_inode;
+    STACK_WIND(frame, wb_fsync_sync_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->fsync, stub->args.fd, datasync, NULL);
+}
+
 int
 wb_fsync_helper(call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t datasync,
                 dict_t *xdata)
 {
+    wb_conf_t *conf = this->private;
+    wb_inode_t *wb_inode = NULL;
+    call_stub_t *stub = NULL;
+    gf_boolean_t busy = _gf_false;
+
+    /* fsyncs carrying xdata are not merged, it may mean something
+       different for each of them */
+    if (xdata)
+        goto wind;
+
+    wb_inode = wb_inode_ctx_get(this, fd->inode);
+    if (!wb_inode)
+        goto wind;
+
+    stub = fop_fsync_stub(frame, NULL, fd, datasync, NULL);
+    if (!stub)
+        goto wind;
+
+    LOCK(&wb_inode->lock);
+    {
+        list_add_tail(&stub->list, &wb_inode->fsyncs);
+        busy = wb_inode->fsync_busy;
+        wb_inode->fsync_busy = _gf_true;
+    }
+    UNLOCK(&wb_inode->lock);
+
+    if (!busy) {
+        /* keeps wb_inode around until the last fsync completes */
+        inode_ref(wb_inode->inode);
+        wb_fsync_sync(this, wb_inode);
+    }
+
+    return 0;
+
+wind:
+    GF_ATOMIC_INC(conf->fsyncs_sent);
+
     STACK_WIND(frame, default_fsync_cbk, FIRST_CHILD(this),
                FIRST_CHILD(this)->fops->fsync, fd, datasync, xdata);
     return 0;
@@ -2050,10 +2390,13 @@ int
 wb_fsync(call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t datasync,
          dict_t *xdata)
 {
+    wb_conf_t *conf = this->private;
     wb_inode_t *wb_inode = NULL;
     call_stub_t *stub = NULL;
     int32_t op_errno = EINVAL;
 
+    GF_ATOMIC_INC(conf->fsyncs_received);
+
     wb_inode = wb_inode_ctx_get(this, fd->inode);
     if (!wb_inode)
         goto noqueue;
@@ -2077,6 +2420,8 @@ unwind:
     return 0;
 
 noqueue:
+    GF_ATOMIC_INC(conf->fsyncs_sent);
+
     STACK_WIND(frame, default_fsync_cbk, FIRST_CHILD(this),
                FIRST_CHILD(this)->fops->fsync, fd, datasync, xdata);
     return 0;
@@ -2844,6 +3189,28 @@ wb_release(xlator_t *this, fd_t *fd)
     return 0;
 }
 
+static void
+wb_dump_write_sizes(const char *name, gf_atomic_t *counters)
+{
+    char key[GF_DUMP_MAX_BUF_LEN] = {
+        0,
+    };
+    size_t limit = 512;
+    int i = 0;
+
+    for (i = 0; i < WB_SIZE_BUCKETS; i++, limit <<= 1) {
+        if (i == WB_SIZE_BUCKETS - 1)
+            snprintf(key, sizeof(key), "%s_over_%zuKB", name,
+                     (limit >> 1) / 1024);
+        else if (limit < 1024)
+            snprintf(key, sizeof(key), "%s_upto_%zuB", name, limit);
+        else
+            snprintf(key, sizeof(key), "%s_upto_%zuKB", name, limit / 1024);
+
+        gf_proc_dump_write(key, "%" PRIu64, GF_ATOMIC_GET(counters[i]));
+    }
+}
+
 int
 wb_priv_dump(xlator_t *this)
 {
@@ -2864,10 +3231,21 @@ wb_priv_dump(xlator_t *this)
     gf_proc_dump_add_section("%s", key_prefix);
 
     gf_proc_dump_write("aggregate_size", "%" PRIu64, conf->aggregate_size);
+    gf_proc_dump_write("aggregate_max", "%" PRIu64, conf->aggregate_max);
     gf_proc_dump_write("window_size", "%" PRIu64, conf->window_size);
     gf_proc_dump_write("flush_behind", "%d", conf->flush_behind);
     gf_proc_dump_write("trickling_writes", "%d", conf->trickling_writes);
 
+    /* sizes of the writes as they came in, and as they were sent out
+       after aggregation */
+    wb_dump_write_sizes("writes_received", conf->writes_received);
+    wb_dump_write_sizes("writes_sent", conf->writes_sent);
+
+    gf_proc_dump_write("fsyncs_received", "%" PRIu64,
+                       GF_ATOMIC_GET(conf->fsyncs_received));
+    gf_proc_dump_write("fsyncs_sent", "%" PRIu64,
+                       GF_ATOMIC_GET(conf->fsyncs_sent));
+
     ret = 0;
 out:
     return ret;
@@ -2983,6 +3361,12 @@ wb_inode_dump(xlator_t *this, inode_t *inode)
 
     gf_proc_dump_write("transit-size", "%" GF_PRI_SIZET, wb_inode->transit);
 
+    gf_proc_dump_write("aggregate-size", "%" GF_PRI_SIZET,
+                       wb_inode->aggregate_size);
+
+    gf_proc_dump_write("fsync-in-progress", "%s",
+                       wb_inode->fsync_busy ? "yes" : "no");
+
     gf_proc_dump_write("dontsync", "%d", wb_inode->dontsync);
 
     ret = TRY_LOCK(&wb_inode->lock);
@@ -3036,6 +3420,9 @@ reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("cache-size", conf->window_size, options, size_uint64,
                      out);
 
+    GF_OPTION_RECONF("aggregate-size-max", conf->aggregate_max, options,
+                     size_uint64, out);
+
     GF_OPTION_RECONF("flush-behind", conf->flush_behind, options, bool, out);
 
     GF_OPTION_RECONF("trickling-writes", conf->trickling_writes, options, bool,
@@ -3067,6 +3454,7 @@ init(xlator_t *this)
 {
     wb_conf_t *conf = NULL;
     int32_t ret = -1;
+    int i = 0;
 
     if ((this->children == NULL) || this->children->next) {
         gf_msg(this->name, GF_LOG_ERROR, 0, WRITE_BEHIND_MSG_INIT_FAILED,
@@ -3089,7 +3477,11 @@ init(xlator_t *this)
 
     /* configure 'options aggregate-size <size>' */
     GF_OPTION_INIT("aggregate-size", conf->aggregate_size, size_uint64, out);
-    conf->page_size = conf->aggregate_size;
+
+    /* aggregate-size is where the aggregation of a file starts from, it
+       grows up to aggregate-size-max for streaming writers */
+    GF_OPTION_INIT("aggregate-size-max", conf->aggregate_max, size_uint64,
+                   out);
 
     /* configure 'option window-size <size>' */
     GF_OPTION_INIT("cache-size", conf->window_size, size_uint64, out);
@@ -3126,6 +3518,13 @@ init(xlator_t *this)
 
     GF_OPTION_INIT("pass-through", this->pass_through, bool, out);
 
+    for (i = 0; i < WB_SIZE_BUCKETS; i++) {
+        GF_ATOMIC_INIT(conf->writes_received[i], 0);
+        GF_ATOMIC_INIT(conf->writes_sent[i], 0);
+    }
+    GF_ATOMIC_INIT(conf->fsyncs_received, 0);
+    GF_ATOMIC_INIT(conf->fsyncs_sent, 0);
+
     this->private = conf;
     ret = 0;
 
@@ -3278,6 +3677,20 @@ struct volume_options options[] = {
                        " so that writes are aggregated till a max of "
                        "\"aggregate-size\" bytes",
     },
+    {
+        .key = {"aggregate-size-max"},
+        .type = GF_OPTION_TYPE_SIZET,
+        .default_value = "1MB",
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
+        .tags = {"write-behind"},
+        .description = "Writes of a file are aggregated up to "
+                       "\"aggregate-size\" bytes at first. As long as the "
+                       "writer keeps filling them up faster than they are "
+                       "sent, the aggregates of the file double, up to this "
+                       "size and half of the window-size. Set it to "
+                       "\"aggregate-size\" to keep them at that size.",
+    },
     {.key = {NULL}},
 };
 
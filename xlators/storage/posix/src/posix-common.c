@@ -119,6 +119,10 @@ posix_priv(xlator_t *this)
     gf_proc_dump_write("max_read", "%" PRId64, GF_ATOMIC_GET(priv->read_value));
     gf_proc_dump_write("max_write", "%" PRId64,
                        GF_ATOMIC_GET(priv->write_value));
+    gf_proc_dump_write("shard_bulk_deleted", "%" PRId64,
+                       GF_ATOMIC_GET(priv->shard_bulk_deleted));
+    gf_proc_dump_write("shard_bulk_pending", "%" PRId64,
+                       GF_ATOMIC_GET(priv->shard_bulk_pending));
 
     return 0;
 }
@@ -899,6 +903,8 @@ posix_init(xlator_t *this)
     LOCK_INIT(&_private->lock);
     GF_ATOMIC_INIT(_private->read_value, 0);
     GF_ATOMIC_INIT(_private->write_value, 0);
+    GF_ATOMIC_INIT(_private->shard_bulk_deleted, 0);
+    GF_ATOMIC_INIT(_private->shard_bulk_pending, 0);
 
     _private->export_statfs = 1;
     tmp_data = dict_get(this->options, "export-statfs-size");
@@ -1154,6 +1160,9 @@ posix_init(xlator_t *this)
     pthread_cond_init(&_private->janitor_cond, NULL);
     pthread_cond_init(&_private->fd_cond, NULL);
     INIT_LIST_HEAD(&_private->fsyncs);
+    pthread_mutex_init(&_private->shard_delete_mutex, NULL);
+    pthread_cond_init(&_private->shard_delete_cond, NULL);
+    INIT_LIST_HEAD(&_private->shard_deletes);
     _private->rel_fdcount = 0;
     ret = posix_spawn_ctx_janitor_thread(this);
     if (ret)
@@ -1168,6 +1177,17 @@ posix_init(xlator_t *this)
         goto out;
     }
 
+    for (i = 0; i < POSIX_SHARD_DELETERS; i++) {
+        ret = gf_thread_create(&_private->shard_deleters[i], NULL,
+                               posix_shard_deleter, this, "posixshd%d", i);
+        if (ret) {
+            gf_msg(this->name, GF_LOG_ERROR, errno,
+                   P_MSG_SHARD_DELETER_THREAD_CREATE_FAILED,
+                   "shard deleter thread creation failed");
+            goto out;
+        }
+    }
+
     GF_OPTION_INIT("batch-fsync-mode", batch_fsync_mode_str, str, out);
 
     if (set_batch_fsync_mode(_private, batch_fsync_mode_str) != 0) {
@@ -1344,6 +1364,13 @@ posix_fini(xlator_t *this)
         priv->fsyncer = 0;
     }
 
+    for (i = 0; i < POSIX_SHARD_DELETERS; i++) {
+        if (priv->shard_deleters[i]) {
+            (void)gf_thread_cleanup_xint(priv->shard_deleters[i]);
+            priv->shard_deleters[i] = 0;
+        }
+    }
+
     /*unlock brick dir*/
     if (priv->mount_lock >= 0) {
         (void)sys_close(priv->mount_lock);
@@ -1354,6 +1381,8 @@ posix_fini(xlator_t *this)
     LOCK_DESTROY(&priv->lock);
     pthread_mutex_destroy(&priv->fsync_mutex);
     pthread_cond_destroy(&priv->fsync_cond);
+    pthread_mutex_destroy(&priv->shard_delete_mutex);
+    pthread_cond_destroy(&priv->shard_delete_cond);
     pthread_mutex_destroy(&priv->janitor_mutex);
     pthread_cond_destroy(&priv->janitor_cond);
     GF_FREE(priv->hostname);
@@ -46,6 +46,7 @@
 #include <glusterfs/statedump.h>
 #include <glusterfs/locking.h>
 #include <glusterfs/timer.h>
+#include <glusterfs/timespec.h>
 #include "glusterfs3-xdr.h"
 #include "posix-aio.h"
 #include <glusterfs/glusterfs-acl.h>
@@ -1434,6 +1435,333 @@ out:
     return 0;
 }
 
+/* Bulk deletion of the shards of a deleted file, requested by shard with a
+ * GF_XATTR_SHARD_BULK_DELETE setxattr on /.shard instead of a lookup and an
+ * unlink per shard through the whole graph. The range of blocks of a request
+ * is split in parts queued to the shard deleter threads, so that no
+ * io-thread waits for the disk. Each thread backs off when the brick gets
+ * slow to answer, and the last part done unwinds the request. */
+
+#define POSIX_SHARD_BULK_DELETE_BATCH 256
+
+typedef struct _posix_shard_delete posix_shard_delete_t;
+
+typedef struct {
+    struct list_head list; /* in priv->shard_deletes */
+    posix_shard_delete_t *job;
+    uint64_t first;
+    uint64_t last;
+    uint64_t deleted;
+    uint64_t busy; /* open or hard-linked, left to shard */
+    int op_errno;
+} posix_shard_delete_part_t;
+
+struct _posix_shard_delete {
+    call_frame_t *frame;
+    inode_t *parent; /* of the shards, /.shard */
+    char *dir;       /* real path of /.shard */
+    char base_gfid[GF_UUID_BUF_SIZE];
+    uint64_t first;
+    uint64_t last;
+    /* Summed up from the parts, under priv->shard_delete_mutex */
+    uint64_t deleted;
+    uint64_t busy;
+    int op_errno;
+    int pending; /* parts not done yet */
+    posix_shard_delete_part_t parts[];
+};
+
+static void
+posix_shard_delete_one(xlator_t *this, posix_shard_delete_part_t *part,
+                       uint64_t block)
+{
+    posix_shard_delete_t *job = part->job;
+    struct posix_private *priv = this->private;
+    char path[PATH_MAX];
+    struct stat stbuf = {
+        0,
+    };
+    uuid_t gfid = {
+        0,
+    };
+    inode_t *inode = NULL;
+    gf_boolean_t has_gfid = _gf_false;
+    gf_boolean_t open = _gf_false;
+    char *name = NULL;
+    int len = 0;
+
+    len = snprintf(path, sizeof(path), "%s/%s.%" PRIu64, job->dir,
+                   job->base_gfid, block);
+    if ((len < 0) || (len >= sizeof(path))) {
+        part->op_errno = ENAMETOOLONG;
+        return;
+    }
+    name = path + strlen(job->dir) + 1;
+
+    if (sys_lstat(path, &stbuf) != 0) {
+        /* On another subvolume, or never written to */
+        if (errno != ENOENT)
+            part->op_errno = errno;
+        return;
+    }
+
+    /* Anything but a file only linked from its gfid handle is left to the
+     * regular unlink */
+    if (!S_ISREG(stbuf.st_mode) || (stbuf.st_nlink > 2)) {
+        part->busy++;
+        return;
+    }
+
+    if (sys_lgetxattr(path, GFID_XATTR_KEY, gfid, sizeof(gfid)) ==
+        sizeof(gfid)) {
+        has_gfid = _gf_true;
+        inode = inode_find(this->itable, gfid);
+        if (inode) {
+            LOCK(&inode->lock);
+            {
+                open = (inode->fd_count > 0);
+            }
+            UNLOCK(&inode->lock);
+            if (open) {
+                inode_unref(inode);
+                part->busy++;
+                return;
+            }
+        }
+    }
+
+    /* The handle goes last, a shard is never left without one */
+    if (sys_unlink(path) != 0) {
+        if (errno != ENOENT) {
+            gf_msg(this->name, GF_LOG_ERROR, errno, P_MSG_UNLINK_FAILED,
+                   "unlink of %s failed", path);
+            part->op_errno = errno;
+        }
+    } else {
+        if (has_gfid)
+            posix_handle_unset(this, gfid, NULL);
+        part->deleted++;
+        GF_ATOMIC_INC(priv->shard_bulk_deleted);
+    }
+
+    if (inode) {
+        inode_unlink(inode, job->parent, name);
+        inode_unref(inode);
+    }
+}
+
+static void
+posix_shard_delete_range(xlator_t *this, posix_shard_delete_part_t *part)
+{
+    struct posix_private *priv = this->private;
+    struct timespec start = {
+        0,
+    };
+    struct timespec now = {
+        0,
+    };
+    struct timespec delta = {
+        0,
+    };
+    uint64_t block = 0;
+    uint64_t usec = 0;
+    uint64_t best = 0;
+    int batch = 0;
+
+    timespec_now(&start);
+    for (block = part->first; block <= part->last; block++) {
+        posix_shard_delete_one(this, part, block);
+        GF_ATOMIC_DEC(priv->shard_bulk_pending);
+        if (part->op_errno)
+            break;
+
+        if (++batch < POSIX_SHARD_BULK_DELETE_BATCH)
+            continue;
+        batch = 0;
+
+        /* A batch taking more than twice as long as the fastest one means
+         * the disk is busy with something else: give it as much time as
+         * the batch took, at most a second */
+        timespec_now(&now);
+        timespec_sub(&start, &now, &delta);
+        usec = delta.tv_sec * 1000000 + delta.tv_nsec / 1000;
+        if (!best || (usec < best))
+            best = usec;
+        else if (usec > 2 * best)
+            usleep(min(usec, 1000000));
+        timespec_now(&start);
+    }
+
+    /* Blocks not scanned because of an error */
+    while (++block <= part->last)
+        GF_ATOMIC_DEC(priv->shard_bulk_pending);
+}
+
+static void
+posix_shard_delete_done(xlator_t *this, posix_shard_delete_part_t *part)
+{
+    struct posix_private *priv = this->private;
+    posix_shard_delete_t *job = part->job;
+    dict_t *rsp = NULL;
+    int32_t op_ret = 0;
+    int32_t op_errno = 0;
+    int pending = 0;
+
+    pthread_mutex_lock(&priv->shard_delete_mutex);
+    {
+        job->deleted += part->deleted;
+        job->busy += part->busy;
+        if (part->op_errno && !job->op_errno)
+            job->op_errno = part->op_errno;
+        pending = --job->pending;
+    }
+    pthread_mutex_unlock(&priv->shard_delete_mutex);
+
+    if (pending)
+        return;
+
+    gf_msg(this->name, GF_LOG_INFO, job->op_errno, P_MSG_SHARD_BULK_DELETE,
+           "deleted %" PRIu64 " shards of %s in blocks %" PRIu64 "-%" PRIu64
+           ", %" PRIu64 " left to unlink",
+           job->deleted, job->base_gfid, job->first, job->last, job->busy);
+
+    /* Shard unlinks what is left one by one. The key in the answer tells it
+     * that the request was understood, rather than stored as an xattr. */
+    if (job->op_errno || job->busy) {
+        op_ret = -1;
+        op_errno = job->op_errno ? job->op_errno : EBUSY;
+    } else {
+        rsp = dict_new();
+        if (!rsp || dict_set_int32_sizen(rsp, GF_XATTR_SHARD_BULK_DELETE, 1)) {
+            op_ret = -1;
+            op_errno = ENOMEM;
+        }
+    }
+
+    STACK_UNWIND_STRICT(setxattr, job->frame, op_ret, op_errno, rsp);
+
+    if (rsp)
+        dict_unref(rsp);
+    inode_unref(job->parent);
+    GF_FREE(job->dir);
+    GF_FREE(job);
+}
+
+void *
+posix_shard_deleter(void *d)
+{
+    xlator_t *this = d;
+    struct posix_private *priv = this->private;
+    posix_shard_delete_part_t *part = NULL;
+
+    THIS = this;
+
+    for (;;) {
+        pthread_mutex_lock(&priv->shard_delete_mutex);
+        {
+            while (list_empty(&priv->shard_deletes))
+                pthread_cond_wait(&priv->shard_delete_cond,
+                                  &priv->shard_delete_mutex);
+
+            part = list_first_entry(&priv->shard_deletes,
+                                    posix_shard_delete_part_t, list);
+            list_del_init(&part->list);
+        }
+        pthread_mutex_unlock(&priv->shard_delete_mutex);
+
+        posix_shard_delete_range(this, part);
+        posix_shard_delete_done(this, part);
+    }
+
+    return NULL;
+}
+
+int
+posix_shard_bulk_delete(call_frame_t *frame, xlator_t *this, loc_t *loc,
+                        const char *real_path, data_t *value,
+                        int32_t *op_errno)
+{
+    struct posix_private *priv = this->private;
+    posix_shard_delete_t *job = NULL;
+    char base_gfid[GF_UUID_BUF_SIZE] = {
+        0,
+    };
+    uuid_t shard_root = {
+        0,
+    };
+    uuid_t gfid = {
+        0,
+    };
+    uint64_t first = 0;
+    uint64_t last = 0;
+    uint64_t count = 0;
+    uint64_t size = 0;
+    char *str = NULL;
+    int nparts = 0;
+    int i = 0;
+
+    /* "<base gfid>:<first block>:<last block>", only on /.shard */
+    gf_uuid_parse(SHARD_ROOT_GFID, shard_root);
+    if (!loc->inode || gf_uuid_compare(loc->inode->gfid, shard_root))
+        goto inval;
+
+    str = alloca(value->len + 1);
+    memcpy(str, value->data, value->len);
+    str[value->len] = '\0';
+    if ((sscanf(str, "%36[0-9a-fA-F-]:%" SCNu64 ":%" SCNu64, base_gfid, &first,
+                &last) != 3) ||
+        gf_uuid_parse(base_gfid, gfid) || !first || (first > last))
+        goto inval;
+
+    /* A part per thread, none of them smaller than a batch */
+    count = last - first + 1;
+    nparts = min(POSIX_SHARD_DELETERS,
+                 (count + POSIX_SHARD_BULK_DELETE_BATCH - 1) /
+                     POSIX_SHARD_BULK_DELETE_BATCH);
+    size = (count + nparts - 1) / nparts;
+
+    job = GF_CALLOC(1, sizeof(*job) + nparts * sizeof(job->parts[0]),
+                    gf_posix_mt_shard_delete_t);
+    if (!job)
+        goto nomem;
+    job->dir = gf_strdup(real_path);
+    if (!job->dir) {
+        GF_FREE(job);
+        goto nomem;
+    }
+    job->frame = frame;
+    job->parent = inode_ref(loc->inode);
+    uuid_utoa_r(gfid, job->base_gfid);
+    job->first = first;
+    job->last = last;
+    job->pending = nparts;
+    for (i = 0; i < nparts; i++) {
+        INIT_LIST_HEAD(&job->parts[i].list);
+        job->parts[i].job = job;
+        job->parts[i].first = first + i * size;
+        job->parts[i].last = min(last, job->parts[i].first + size - 1);
+    }
+
+    GF_ATOMIC_ADD(priv->shard_bulk_pending, count);
+
+    pthread_mutex_lock(&priv->shard_delete_mutex);
+    {
+        for (i = 0; i < nparts; i++)
+            list_add_tail(&job->parts[i].list, &priv->shard_deletes);
+        pthread_cond_broadcast(&priv->shard_delete_cond);
+    }
+    pthread_mutex_unlock(&priv->shard_delete_mutex);
+
+    return 0;
+
+inval:
+    *op_errno = EINVAL;
+    return -1;
+nomem:
+    *op_errno = ENOMEM;
+    return -1;
+}
+
 int
 posix_rmdir(call_frame_t *frame, xlator_t *this, loc_t *loc, int flags,
             dict_t *xdata)
@@ -2811,6 +2811,18 @@ posix_setxattr(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *dict,
         goto out;
     }
 
+    tdata = dict_get_sizen(dict, GF_XATTR_SHARD_BULK_DELETE);
+    if (tdata) {
+        op_ret = posix_shard_bulk_delete(frame, this, loc, real_path, tdata,
+                                         &op_errno);
+        if (op_ret == 0) {
+            /* Unwound by the shard deleter thread */
+            SET_TO_OLD_FS_ID();
+            return 0;
+        }
+        goto out;
+    }
+
     posix_pstat(this, loc->inode, loc->gfid, real_path, &preop, _gf_false);
 
     op_ret = -1;
@@ -5866,6 +5878,67 @@ posix_readdirp(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
     return 0;
 }
 
+/* Fill rsp_xdata with the fast checksum of every block_size sized block of
+ * buf and, if asked for, whether each of those blocks is all zeroes. The
+ * checksums are stored in network byte order. The block size is sent back
+ * so that the client can tell the request was understood even when the
+ * range is past the end of the file. */
+static int
+posix_rchecksum_fast(char *buf, ssize_t len, uint32_t block_size,
+                     gf_boolean_t zerofillcheck, dict_t *rsp_xdata)
+{
+    uint64_t *sums = NULL;
+    char *zeroes = NULL;
+    size_t count = 0;
+    size_t size = 0;
+    size_t i = 0;
+    int ret = 0;
+
+    ret = dict_set_uint32(rsp_xdata, GF_RCHECKSUM_FAST_BLOCK_SIZE, block_size);
+    if (ret)
+        return ret;
+
+    count = (len + block_size - 1) / block_size;
+    if (!count)
+        return 0;
+
+    ret = -ENOMEM;
+    sums = GF_MALLOC(count * sizeof(*sums), gf_common_mt_char);
+    if (!sums)
+        goto out;
+
+    if (zerofillcheck) {
+        zeroes = GF_MALLOC(count, gf_common_mt_char);
+        if (!zeroes)
+            goto out;
+    }
+
+    for (i = 0; i < count; i++) {
+        size = min(block_size, len - i * block_size);
+        sums[i] = hton64(gf_rsync_fast_checksum(
+            (unsigned char *)buf + i * block_size, size));
+        if (zeroes)
+            zeroes[i] = !mem_0filled(buf + i * block_size, size);
+    }
+
+    ret = dict_set_bin(rsp_xdata, GF_RCHECKSUM_FAST_SUMS, sums,
+                       count * sizeof(*sums));
+    if (ret)
+        goto out;
+    sums = NULL;
+
+    if (zeroes) {
+        ret = dict_set_bin(rsp_xdata, GF_RCHECKSUM_FAST_ZEROES, zeroes, count);
+        if (ret)
+            goto out;
+        zeroes = NULL;
+    }
+out:
+    GF_FREE(sums);
+    GF_FREE(zeroes);
+    return ret;
+}
+
 int32_t
 posix_rchecksum(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
                 int32_t len, dict_t *xdata)
@@ -5880,6 +5953,7 @@ posix_rchecksum(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
     ssize_t bytes_read = 0;
     int32_t weak_checksum = 0;
     int32_t zerofillcheck = 0;
+    uint32_t fast_block_size = 0;
     /* Protocol version 4 uses 32 bytes i.e SHA256_DIGEST_LENGTH,
        so this is used. */
     unsigned char md5_checksum[SHA256_DIGEST_LENGTH] = {0};
@@ -5970,6 +6044,28 @@ posix_rchecksum(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
             goto out;
         }
     }
+
+    /* Self-heal asks for the checksums of many blocks at once. The weak and
+     * strong checksums of the whole range are of no use to it, so skip them
+     * as they cost far more CPU than the fast ones. */
+    if (xdata &&
+        dict_get_uint32(xdata, GF_RCHECKSUM_FAST_BLOCK_SIZE,
+                        &fast_block_size) == 0 &&
+        fast_block_size) {
+        ret = posix_rchecksum_fast(buf, bytes_read, fast_block_size,
+                                   zerofillcheck, rsp_xdata);
+        if (ret) {
+            gf_msg(this->name, GF_LOG_WARNING, -ret, P_MSG_DICT_SET_FAILED,
+                   "%s: Failed to set dictionary value for key: %s",
+                   uuid_utoa(fd->inode->gfid), GF_RCHECKSUM_FAST_SUMS);
+            op_errno = -ret;
+            goto out;
+        }
+        checksum = md5_checksum;
+        op_ret = 0;
+        goto done;
+    }
+
     weak_checksum = gf_rsync_weak_checksum((unsigned char *)buf,
                                            (size_t)bytes_read);
 
@@ -5992,6 +6088,7 @@ posix_rchecksum(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
     }
     op_ret = 0;
 
+done:
     posix_set_ctime(frame, this, NULL, _fd, fd->inode, NULL);
 
 out:
@@ -70,6 +70,7 @@ GLFS_MSGID(POSIX, P_MSG_XATTR_FAILED, P_MSG_NULL_GFID, P_MSG_FCNTL_FAILED,
            P_MSG_SETMDATA_FAILED, P_MSG_FRESHFILE, P_MSG_MUTEX_FAILED,
            P_MSG_COPY_FILE_RANGE_FAILED, P_MSG_TIMER_DELETE_FAILED, P_MSG_NOMEM,
            P_MSG_PSTAT_FAILED, P_MSG_FDSTAT_FAILED, P_MSG_POSIX_IO_URING,
-           P_MSG_PTHREAD_CANCEL_FAILED);
+           P_MSG_PTHREAD_CANCEL_FAILED, P_MSG_SHARD_BULK_DELETE,
+           P_MSG_SHARD_DELETER_THREAD_CREATE_FAILED);
 
 #endif /* !_GLUSTERD_MESSAGES_H_ */
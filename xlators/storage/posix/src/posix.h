@@ -63,6 +63,9 @@
 #define GF_UNLINK_TRUE 0x0000000000000001
 #define GF_UNLINK_FALSE 0x0000000000000000
 
+/* Threads serving the bulk deletions of shards */
+#define POSIX_SHARD_DELETERS 4
+
 #define DISK_SPACE_CHECK_AND_GOTO(frame, priv, xdata, op_ret, op_errno, out)   \
     do {                                                                       \
         if (frame->root->pid >= 0 && priv->disk_space_full &&                  \
@@ -156,6 +159,9 @@ struct posix_private {
     gf_atomic_t read_value;  /* Total read, from init */
     gf_atomic_t write_value; /* Total write, from init */
 
+    gf_atomic_t shard_bulk_deleted; /* Shards removed by bulk deletions */
+    gf_atomic_t shard_bulk_pending; /* Shards left to scan by them */
+
     /* janitor task which cleans up /.trash (created by replicate) */
     struct gf_tw_timer_list *janitor;
 
@@ -182,6 +188,12 @@ struct posix_private {
     pthread_cond_t fd_cond;
     pthread_cond_t disk_cond;
     int fsync_queue_count;
+
+    /* bulk deletions of shards, see posix_shard_bulk_delete() */
+    pthread_t shard_deleters[POSIX_SHARD_DELETERS];
+    struct list_head shard_deletes;
+    pthread_mutex_t shard_delete_mutex;
+    pthread_cond_t shard_delete_cond;
     int32_t janitor_sleep_duration;
 
     enum {
@@ -421,6 +433,14 @@ posix_fdget_objectsignature(int, dict_t *);
 gf_boolean_t
 posix_is_bulk_removexattr(char *name, dict_t *dict);
 
+int
+posix_shard_bulk_delete(call_frame_t *frame, xlator_t *this, loc_t *loc,
+                        const char *real_path, data_t *value,
+                        int32_t *op_errno);
+
+void *
+posix_shard_deleter(void *);
+
 int32_t
 posix_set_iatt_in_dict(dict_t *, struct iatt *, struct iatt *);
 